@@ -0,0 +1,119 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/frame_stats.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+class AudioFramePool;
+
+/**
+ * One pool-owned capture frame
+ * Filled once by the capture task, then shared read-only with consumers.
+ */
+struct AudioFrame {
+    int16_t* samples;
+    size_t sample_count;
+    uint32_t sequence;                 // Capture order, monotonic
+    int64_t timestamp_us;              // esp_timer time when the read completed
+    FrameStats stats;                  // Energy, ZCR and peak, taken once at capture
+    std::atomic<uint32_t> refs;
+    AudioFramePool* pool;
+    uint8_t index;
+};
+
+/**
+ * Reference-counted view of an AudioFrame
+ * Copying retains the frame, destruction releases it; the last release
+ * returns the frame to its pool. Consumers that need samples beyond the
+ * callback keep a copy of the ref instead of copying samples.
+ */
+class AudioFrameRef {
+public:
+    AudioFrameRef() : frame_(nullptr) {}
+    explicit AudioFrameRef(AudioFrame* frame) : frame_(frame) {}  // Adopts one reference
+    AudioFrameRef(const AudioFrameRef& other);
+    AudioFrameRef(AudioFrameRef&& other) noexcept : frame_(other.frame_) { other.frame_ = nullptr; }
+    AudioFrameRef& operator=(const AudioFrameRef& other);
+    AudioFrameRef& operator=(AudioFrameRef&& other) noexcept;
+    ~AudioFrameRef() { reset(); }
+    
+    void reset();
+    
+    // Give up ownership without releasing, e.g. to pass through a FreeRTOS
+    // queue; re-adopt with AudioFrameRef(frame)
+    AudioFrame* detach() { AudioFrame* frame = frame_; frame_ = nullptr; return frame; }
+    
+    explicit operator bool() const { return frame_ != nullptr; }
+    const int16_t* data() const { return frame_ ? frame_->samples : nullptr; }
+    size_t size() const { return frame_ ? frame_->sample_count : 0; }
+    uint32_t sequence() const { return frame_ ? frame_->sequence : 0; }
+    int64_t timestamp_us() const { return frame_ ? frame_->timestamp_us : 0; }
+    const FrameStats& stats() const;
+    
+    // Producer access to fill the frame before it is shared
+    AudioFrame* get() const { return frame_; }
+
+private:
+    AudioFrame* frame_;
+};
+
+/**
+ * Contiguous run of frame refs inside a ring (e.g. the back buffer)
+ * A wrapped ring is lent as two spans, oldest first; the refs stay owned
+ * by the ring and are only valid for the duration of the call.
+ */
+struct AudioFrameSpan {
+    const AudioFrameRef* frames;
+    size_t count;
+};
+
+/**
+ * Fixed pool of capture frames in internal (DMA-capable) RAM
+ * Lock-free: the free list is a bitmask updated with atomic CAS, so any
+ * task on either core may release a frame.
+ */
+class AudioFramePool {
+public:
+    static constexpr size_t MAX_FRAMES = 32;
+    
+    AudioFramePool();
+    ~AudioFramePool();
+    
+    // Non-copyable
+    AudioFramePool(const AudioFramePool&) = delete;
+    AudioFramePool& operator=(const AudioFramePool&) = delete;
+    
+    /**
+     * @brief Allocate the frames
+     * @param frame_samples Samples per frame
+     * @param frame_count Number of frames (<= MAX_FRAMES)
+     * @return Error code
+     */
+    ErrorCode initialize(size_t frame_samples, size_t frame_count);
+    
+    // Take a free frame with one reference; empty ref when exhausted
+    AudioFrameRef acquire();
+    
+    // Status
+    size_t frame_samples() const { return frame_samples_; }
+    size_t frame_count() const { return frame_count_; }
+    size_t free_count() const;
+    uint32_t get_exhausted_count() const { return exhausted_count_.load(std::memory_order_relaxed); }
+
+private:
+    friend class AudioFrameRef;
+    void release(AudioFrame* frame);
+    
+    int16_t* storage_;
+    AudioFrame frames_[MAX_FRAMES];
+    size_t frame_samples_;
+    size_t frame_count_;
+    std::atomic<uint32_t> free_mask_;  // Bit i set = frames_[i] free
+    std::atomic<uint32_t> exhausted_count_;
+};
+
+} // namespace irene
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/audio_frame_pool.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Shared history of recent capture frames
+ *
+ * One ring of AudioFrameRefs that every consumer of past audio reads: the
+ * wake word backfill, the streaming pre-roll and the back buffer. It holds
+ * refs, not samples, so the history costs no copies and no memory beyond
+ * the pool frames it keeps alive.
+ *
+ * Readers keep their own Cursor, the push index of the next frame to read,
+ * so they never consume frames from one another. A cursor that falls
+ * behind the ring skips forward to the oldest retained frame.
+ *
+ * Not synchronised: the capture task is the only writer, and may read
+ * freely; readers on other tasks must hold the owner's lock.
+ */
+class AudioHistory {
+public:
+    using Cursor = uint32_t;
+
+    AudioHistory();
+    ~AudioHistory();
+
+    // Non-copyable
+    AudioHistory(const AudioHistory&) = delete;
+    AudioHistory& operator=(const AudioHistory&) = delete;
+
+    /**
+     * @brief Allocate the ring
+     * @param capacity Frames retained
+     * @return Error code
+     */
+    ErrorCode initialize(size_t capacity);
+
+    // Writer side; a full ring releases its oldest frame
+    void push(const AudioFrameRef& frame);
+    void drop_oldest();
+    void clear();
+
+    // Cursors: [begin(), end()) are retained
+    Cursor begin() const { return end_ - static_cast<Cursor>(count_); }
+    Cursor end() const { return end_; }
+    Cursor rewind(size_t frames) const;  // Start of the newest frames
+
+    // Frame at cursor, nullptr if evicted or not yet captured
+    const AudioFrameRef* at(Cursor cursor) const;
+
+    // Frame at cursor (skipping evicted frames) and advance; nullptr when caught up
+    const AudioFrameRef* next(Cursor& cursor) const;
+
+    // Newest count frames as up to two spans, oldest first; returns frames lent
+    size_t newest_spans(size_t count, AudioFrameSpan& first, AudioFrameSpan& second) const;
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return count_; }
+
+private:
+    size_t slot(Cursor cursor) const;
+    void destroy();
+
+    AudioFrameRef* frames_;            // Constructed in memory plan storage
+    size_t capacity_;
+    size_t head_;                      // Next slot to fill
+    size_t count_;
+    Cursor end_;                       // Frames pushed so far
+};
+
+} // namespace irene
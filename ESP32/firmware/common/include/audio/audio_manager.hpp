@@ -1,6 +1,9 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "audio/audio_frame_pool.hpp"
+#include "audio/audio_history.hpp"
+#include "utils/memory_plan.hpp"
 #include <functional>
 #include <memory>
 
@@ -8,16 +11,32 @@ namespace irene {
 
 class I2SDriver;
 class VADProcessor;
-class RingBuffer;
+class AudioPlayback;
+class EchoReference;
+class EchoCanceller;
 
 /**
  * Manages audio capture, VAD, and streaming
  * Coordinates I2S DMA, voice activity detection, and audio buffering
+ *
+ * Capture is zero-copy past the I2S read: each frame is read straight into
+ * a pool-owned AudioFrame and handed to consumers as a reference-counted
+ * AudioFrameRef. Recent frames are kept as refs in one AudioHistory that
+ * the back buffer, the streaming pre-roll and capture-task consumers (the
+ * wake word backfill) all read through their own cursors.
+ *
+ * With AudioConfig::playback_enabled the same full-duplex I2S port plays
+ * server audio through an AudioPlayback, running while capture runs.
+ * With barge_in_enabled as well, every TX frame is kept as an echo
+ * reference and an EchoCanceller removes the speaker from each mic frame
+ * as it is read, before the frame statistics, VAD and wake word see it.
  */
 class AudioManager {
 public:
     using AudioDataCallback = std::function<void(const int16_t* data, size_t samples)>;
     using VADCallback = std::function<void(bool voice_detected)>;
+    using FrameCallback = std::function<void(const AudioFrameRef& frame)>;
+    using PrerollCallback = std::function<void(const AudioFrameSpan& first, const AudioFrameSpan& second)>;
 
     AudioManager();
     ~AudioManager();
@@ -28,19 +47,33 @@ public:
     // Control
     ErrorCode start_capture();
     ErrorCode stop_capture();
-    ErrorCode start_streaming();
+    ErrorCode start_streaming(uint32_t preroll_ms = 0);  // Pre-roll: back-buffer audio sent ahead of live frames
     ErrorCode stop_streaming();
     
     // Configuration
     void set_gain(int8_t gain_db);  // -6 to +18 dB range
     void set_vad_sensitivity(float sensitivity);
     
+    // Adaptive VAD input: one hop of log10 mel energies, capture task
+    void process_vad_spectrum(const float* log_mel, size_t bands);
+    bool uses_spectral_vad() const { return config_.vad_mode == VADMode::ADAPTIVE; }
+    
     // Callbacks
-    void set_audio_data_callback(AudioDataCallback callback);
+    void set_audio_data_callback(FrameCallback callback);    // Streaming frames, capture task, must not block
+    void set_capture_callback(FrameCallback callback);  // Every frame, capture task, no lock held
+    void set_preroll_callback(PrerollCallback callback);    // Once per stream, capture task, spans valid for the call
     void set_vad_callback(VADCallback callback);
     
-    // Back buffer for wake word context (300ms)
-    size_t get_back_buffer_samples(int16_t* buffer, size_t max_samples);
+    // Back buffer for wake word context (300ms), newest audio, oldest first
+    size_t get_back_buffer_samples(int16_t* buffer, size_t max_samples);  // Copies
+    size_t get_back_buffer_frames(AudioFrameRef* frames, size_t max_frames);  // Lends refs
+    
+    // Shared history, for capture-callback consumers only (no lock taken)
+    const AudioHistory& get_history() const { return history_; }
+    
+    // Downlink playback, nullptr when disabled
+    AudioPlayback* get_playback() const { return playback_.get(); }
+    const EchoCanceller* get_echo_canceller() const { return echo_canceller_.get(); }  // nullptr without barge-in
     
     // Status
     bool is_capturing() const { return is_capturing_; }
@@ -52,10 +85,19 @@ public:
     uint32_t get_samples_captured() const;
     uint32_t get_samples_streamed() const;
     float get_audio_level() const;  // Current RMS level
+    float get_peak_level(uint32_t window_ms);  // Loudest frame RMS in the newest window_ms, any task
+    uint32_t get_overrun_count() const;        // DMA buffers lost before they were read
+    uint32_t get_underrun_count() const;       // DMA stalls and short reads
+    uint32_t get_dropped_frame_count() const;  // Read but discarded, no free pool frame
+    uint32_t get_pool_exhausted_count() const { return frame_pool_.get_exhausted_count(); }
     
 private:
     void audio_task();
-    void process_audio_frame(const int16_t* data, size_t samples);
+    bool capture_frame(size_t frame_size_bytes);
+    void process_audio_frame(const AudioFrameRef& frame);
+    void cancel_echo(int16_t* samples, size_t count, int64_t captured_us);
+    void drop_oldest_back_frame();
+    void send_preroll();
     static void audio_task_wrapper(void* arg);
     
     AudioConfig config_;
@@ -65,11 +107,25 @@ private:
     // Components
     std::unique_ptr<I2SDriver> i2s_driver_;
     std::unique_ptr<VADProcessor> vad_processor_;
-    std::unique_ptr<RingBuffer> audio_buffer_;
-    std::unique_ptr<RingBuffer> back_buffer_;
+    std::unique_ptr<AudioPlayback> playback_;
+    std::unique_ptr<EchoReference> echo_reference_;
+    std::unique_ptr<EchoCanceller> echo_canceller_;
+    
+    // Capture frames and the history of retained refs (written by the
+    // capture task; other tasks read under audio_mutex_)
+    static constexpr uint32_t kBackBufferMs = 300;
+    static constexpr size_t kInFlightFrames = 16;  // Uplink queue plus other consumers, beyond the history
+    AudioFramePool frame_pool_;
+    PlanArray<int16_t> discard_frame_; // Drains DMA when the pool is exhausted
+    AudioHistory history_;
+    size_t back_buffer_frames_;        // kBackBufferMs worth of frames
+    size_t preroll_frames_;            // Back-buffer frames to send before the next live frame
+    uint32_t capture_sequence_;
     
     // Callbacks
-    AudioDataCallback audio_data_callback_;
+    FrameCallback audio_data_callback_;
+    FrameCallback capture_callback_;
+    PrerollCallback preroll_callback_;
     VADCallback vad_callback_;
     
     // Task management
@@ -79,5 +135,8 @@ private:
     // Statistics
     uint32_t samples_captured_;
     uint32_t samples_streamed_;
+    uint32_t underrun_count_;
+    uint32_t dropped_frame_count_;
     float current_audio_level_;
-}; 
\ No newline at end of file
+}; 
+} // namespace irene 
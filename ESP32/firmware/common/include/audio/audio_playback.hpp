@@ -0,0 +1,100 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/jitter_buffer.hpp"
+#include "utils/memory_plan.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <memory>
+
+namespace irene {
+
+class I2SDriver;
+class AudioDecoder;
+
+/**
+ * Downlink playback statistics
+ */
+struct PlaybackStats {
+    uint32_t streams;
+    uint32_t messages;          // Binary payloads decoded
+    uint32_t decode_errors;
+    uint32_t oversize_drops;    // Payloads larger than the reassembly buffer
+    uint32_t cancels;           // Streams cut short (barge-in)
+    uint32_t underruns;
+    uint32_t overrun_samples;   // Dropped on a full jitter buffer
+    uint32_t played_samples;
+    uint32_t buffered_samples;  // Right now
+};
+
+/**
+ * Streaming playback of server audio (TTS) over I2S TX
+ *
+ * The WebSocket task hands in binary messages; each one is reassembled if
+ * the client delivered it in pieces, decoded with the codec the stream
+ * announced (the uplink framings: PCM16, IMA-ADPCM, Opus) and queued in a
+ * JitterBuffer. A playback task, on core 1 by default, writes whole frames
+ * to the I2S TX DMA ring; its blocking write is paced by the DMA clock, and
+ * while nothing plays the TX descriptors auto-clear to silence.
+ *
+ * Stream calls (begin_stream, push, end_stream) come from one task;
+ * cancel() may come from any other.
+ */
+class AudioPlayback {
+public:
+    AudioPlayback();
+    ~AudioPlayback();
+
+    // Non-copyable
+    AudioPlayback(const AudioPlayback&) = delete;
+    AudioPlayback& operator=(const AudioPlayback&) = delete;
+
+    // Allocate the buffers; i2s must outlive the playback
+    ErrorCode initialize(const AudioConfig& config, I2SDriver* i2s);
+
+    // Playback task, while the I2S clock runs
+    ErrorCode start();
+    void stop();
+
+    // Stream side (WebSocket task)
+    bool begin_stream(AudioCodec codec, uint32_t sample_rate);  // false: cannot play this format
+    void push(const uint8_t* data, size_t length, size_t offset, size_t total);  // One message, maybe in pieces
+    void end_stream();   // Play out what is buffered
+    void cancel();       // Drop what is buffered and the rest of the stream
+
+    // Status
+    bool is_playing() const { return jitter_.is_playing(); }
+    bool is_active() const { return jitter_.is_playing() || jitter_.buffered() > 0; }  // Playing or buffering
+    void get_stats(PlaybackStats& stats) const;
+
+private:
+    static void playback_task_wrapper(void* arg);
+    void playback_task();
+    void decode_message(const uint8_t* payload, size_t bytes);
+
+    AudioConfig config_;
+    I2SDriver* i2s_;
+    JitterBuffer jitter_;
+    std::unique_ptr<AudioDecoder> decoder_;
+    std::atomic<bool> stream_valid_;   // The announced format can be played, not cancelled
+
+    PlanArray<uint8_t> message_;       // Reassembly of a message delivered in pieces
+    size_t message_capacity_;
+    size_t message_bytes_;
+    PlanArray<int16_t> decoded_;       // One message of decoded PCM
+    size_t decoded_capacity_;
+    PlanArray<int16_t> frame_;         // Playback task's I2S frame
+
+    TaskHandle_t task_handle_;
+    std::atomic<bool> running_;
+
+    // Statistics
+    uint32_t streams_;
+    uint32_t messages_;
+    uint32_t decode_errors_;
+    uint32_t oversize_drops_;
+    std::atomic<uint32_t> cancels_;
+};
+
+} // namespace irene
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "utils/memory_plan.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Lightweight acoustic echo canceller for the capture path
+ *
+ * A time-domain NLMS filter models the speaker-to-mic path over a short
+ * tail (the EchoReference already removes the DMA bulk delay) and
+ * subtracts its echo estimate from each mic frame in place, ahead of the
+ * VAD, the wake word gate and the MFCC front end.
+ *
+ * Near-end speech is told apart by the residual: once the filter has
+ * converged, the error-to-mic energy ratio of a far-end-only frame settles
+ * at a floor (the inverse ERLE), and talk over the playback pushes it well
+ * above that. Such double-talk frames slow adaptation to a crawl and skip
+ * the residual echo suppressor, which otherwise attenuates far-end-only
+ * frames so what leaks through cannot trigger the VAD or the wake word.
+ *
+ * With no reference (nothing playing) the frame passes through untouched.
+ */
+class EchoCanceller {
+public:
+    EchoCanceller();
+
+    // Non-copyable
+    EchoCanceller(const EchoCanceller&) = delete;
+    EchoCanceller& operator=(const EchoCanceller&) = delete;
+
+    /**
+     * @brief Allocate the filter
+     * @param taps Filter length in samples (the echo tail covered)
+     * @param max_frame Largest frame passed to process()
+     * @return Error code
+     */
+    ErrorCode initialize(size_t taps, size_t max_frame);
+
+    // Cancel the echo of reference (count samples, nullptr = silence) in mic
+    void process(int16_t* mic, const int16_t* reference, size_t count);
+
+    // Forget the echo path
+    void reset();
+
+    // Status
+    bool is_double_talk() const { return double_talk_; }
+    float get_erle_db() const;                 // From the converged residual floor
+    uint32_t get_active_frames() const { return active_frames_; }
+    uint32_t get_double_talk_frames() const { return double_talk_frames_; }
+
+private:
+    PlanArray<float> weights_;       // Oldest tap first, matching the history window
+    PlanArray<float> history_;       // taps - 1 previous reference samples, then the frame
+    size_t taps_;
+    size_t max_frame_;
+    size_t tail_samples_;            // Non-zero reference still in the history
+
+    float residual_floor_;           // Smoothed error/mic energy ratio, far end only
+    float gain_;                     // Suppressor gain at the end of the last frame
+    bool double_talk_;
+    uint32_t double_talk_run_;       // Consecutive double-talk frames
+
+    uint32_t active_frames_;
+    uint32_t double_talk_frames_;
+};
+
+} // namespace irene
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "utils/memory_plan.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Echo reference: the TX frames, in step with the capture frames they echo in
+ *
+ * I2SDriver::write_frame() pushes every frame it queues for the speaker,
+ * stamped with the time it was queued; the capture task takes one frame
+ * back per captured mic frame. RX and TX run one DMA ring on one clock, so
+ * as long as both sides move a frame per DMA period this queue holds
+ * exactly the frames still queued in the TX ring, and the oldest one is
+ * the frame that played while the mic frame was recorded.
+ *
+ * Only the start of a run needs the timestamps: a frame queued to an idle
+ * TX ring plays from the next DMA period, so it is first matched to the
+ * mic frame whose window begins after it was queued. Once the queue runs
+ * dry (playback stopped, the TX ring is back to silence), the next push
+ * starts a new run.
+ *
+ * Lock-free single producer (the playback task) / single consumer (the
+ * capture task); a full queue drops the new frame.
+ */
+class EchoReference {
+public:
+    EchoReference();
+
+    // Non-copyable
+    EchoReference(const EchoReference&) = delete;
+    EchoReference& operator=(const EchoReference&) = delete;
+
+    // frames: at least the TX DMA ring depth
+    ErrorCode initialize(size_t frame_size, size_t frames);
+
+    // Producer: one TX frame of frame_size samples, just queued at timestamp_us
+    void push(const int16_t* samples, size_t count, int64_t timestamp_us);
+
+    // Consumer: reference for the mic frame recorded from window_start_us,
+    // nullptr when the speaker was silent. Valid until pop().
+    const int16_t* peek(int64_t window_start_us);
+    void pop();         // After a non-null peek()
+    void reset();       // Consumer side: drop everything queued
+
+    // Status
+    bool is_active() const { return active_; }
+    size_t frame_size() const { return frame_size_; }
+    uint32_t get_dropped_frames() const { return dropped_frames_.load(std::memory_order_relaxed); }
+    uint32_t get_runs() const { return runs_; }
+
+private:
+    PlanArray<int16_t> samples_;
+    PlanArray<int64_t> timestamps_;
+    size_t frame_size_;
+    size_t frames_;
+    std::atomic<size_t> head_;      // Next slot to write (producer)
+    std::atomic<size_t> tail_;      // Next slot to read (consumer)
+    bool active_;                   // Consumer: inside a run of TX frames
+    uint32_t runs_;
+    std::atomic<uint32_t> dropped_frames_;
+};
+
+} // namespace irene
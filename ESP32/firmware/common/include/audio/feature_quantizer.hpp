@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace irene {
+
+// Affine INT8 quantization used by the model input and output tensors.
+// Kept free of TFLite types so host tools run the exact firmware path.
+
+// q = round(f / scale) + zero_point, saturated to [-128, 127]
+inline int8_t quantize_int8(float value, float scale, int32_t zero_point) {
+    const int32_t quantized = static_cast<int32_t>(lroundf(value / scale)) + zero_point;
+    return static_cast<int8_t>(std::min<int32_t>(127, std::max<int32_t>(-128, quantized)));
+}
+
+// f = (q - zero_point) * scale
+inline float dequantize_int8(int8_t value, float scale, int32_t zero_point) {
+    return (static_cast<int32_t>(value) - zero_point) * scale;
+}
+
+// Quantize count features into an output of output_count elements; the
+// remainder is padded with zero_point (the quantized 0.0f)
+inline void quantize_features_int8(const float* features, size_t count,
+                                   int8_t* output, size_t output_count,
+                                   float scale, int32_t zero_point) {
+    const size_t copy_count = std::min(count, output_count);
+    for (size_t i = 0; i < copy_count; i++) {
+        output[i] = quantize_int8(features[i], scale, zero_point);
+    }
+    std::fill(output + copy_count, output + output_count, static_cast<int8_t>(zero_point));
+}
+
+} // namespace irene
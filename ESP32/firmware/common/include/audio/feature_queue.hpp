@@ -0,0 +1,74 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Lock-free single-producer/single-consumer queue of feature blocks
+ *
+ * Joins the capture/MFCC stage (producer) to the inference stage (consumer)
+ * across cores. Slots are preallocated fixed-size buffers that the producer
+ * fills in place and the consumer reads in place; with depth 2 this is a
+ * double-buffered feature matrix. Indices are monotonic counters published
+ * with release/acquire ordering, so neither side ever blocks or locks.
+ *
+ * A full queue never overwrites a slot the consumer may be reading; the new
+ * block is dropped and the next committed block is flagged as a
+ * discontinuity so stateful consumers can resynchronise.
+ */
+class FeatureQueue {
+public:
+    FeatureQueue();
+    ~FeatureQueue();
+
+    // Non-copyable
+    FeatureQueue(const FeatureQueue&) = delete;
+    FeatureQueue& operator=(const FeatureQueue&) = delete;
+
+    /**
+     * @brief Allocate the slots
+     * @param slot_bytes Size of one feature block
+     * @param depth Number of slots (>= 2)
+     * @param use_psram Allocate slots in PSRAM instead of internal RAM
+     * @return Error code
+     */
+    ErrorCode initialize(size_t slot_bytes, size_t depth, bool use_psram);
+
+    // Producer side
+    uint8_t* acquire_write();          // nullptr when full (counted as a drop)
+    void commit_write();
+    void mark_discontinuity();         // Flag the next committed block (e.g. after a reset)
+
+    // Consumer side
+    const uint8_t* acquire_read(bool* discontinuity = nullptr);  // nullptr when empty
+    void release_read();
+
+    // Status
+    size_t slot_bytes() const { return slot_bytes_; }
+    size_t depth() const { return depth_; }
+    size_t size() const;
+    uint32_t get_dropped_count() const { return dropped_count_.load(std::memory_order_relaxed); }
+    uint32_t get_high_water() const { return high_water_; }
+
+private:
+    uint8_t* slot_data(size_t index) const { return storage_ + (index % depth_) * slot_bytes_; }
+
+    uint8_t* storage_;
+    bool* discontinuity_;              // Per-slot flag, written before commit
+    size_t slot_bytes_;
+    size_t depth_;
+
+    std::atomic<size_t> head_;         // Next slot to write (producer-owned)
+    std::atomic<size_t> tail_;         // Next slot to read (consumer-owned)
+
+    // Producer-local state
+    bool pending_discontinuity_;
+    uint32_t high_water_;
+    std::atomic<uint32_t> dropped_count_;
+};
+
+} // namespace irene
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * @brief Real-input FFT engine for the MFCC frontend
+ *
+ * Computes the power spectrum of an N-point real frame (N even) through an
+ * N/2-point mixed-radix complex FFT (radix 2/3/4/5) plus a split step, using
+ * precomputed twiddle tables held in internal RAM.
+ *
+ * The frontend runs at N = 480 (30 ms at 16 kHz), so the complex core works
+ * on 240 = 4*4*3*5 points. The esp-dsp radix-2/4 kernels only cover
+ * power-of-two sizes, and a zero-padded 512-point transform would move the
+ * bin centres away from the 480-point spectrum the model was trained on, so
+ * the mixed-radix path is used on every target.
+ */
+class FFTEngine {
+public:
+    FFTEngine();
+    ~FFTEngine();
+
+    // Non-copyable
+    FFTEngine(const FFTEngine&) = delete;
+    FFTEngine& operator=(const FFTEngine&) = delete;
+
+    /**
+     * @brief Build twiddle tables and the factor plan
+     * @param fft_size Real transform length (even, N/2 must factor into 2/3/4/5)
+     * @return Error code
+     */
+    ErrorCode initialize(size_t fft_size);
+
+    /**
+     * @brief Compute |X[k]|^2 for k = 0..N/2
+     * @param input Real input frame (fft_size samples, already windowed)
+     * @param power_spec Output power spectrum (fft_size/2 + 1 bins)
+     */
+    void compute_power_spectrum(const float* input, float* power_spec);
+
+    size_t size() const { return fft_size_; }
+    size_t num_bins() const { return fft_size_ / 2 + 1; }
+    bool is_initialized() const { return initialized_; }
+
+private:
+    struct Complex {
+        float re;
+        float im;
+    };
+
+    static constexpr size_t MAX_FACTORS = 16;
+
+    bool factorize(size_t n);
+    void transform(Complex* out, const Complex* in, size_t fstride, const size_t* factors);
+
+    void butterfly2(Complex* out, size_t fstride, size_t m);
+    void butterfly3(Complex* out, size_t fstride, size_t m);
+    void butterfly4(Complex* out, size_t fstride, size_t m);
+    void butterfly5(Complex* out, size_t fstride, size_t m);
+
+    bool initialized_;
+    size_t fft_size_;       // Real length N
+    size_t complex_size_;   // N/2
+
+    // Factor plan: pairs of (radix, remaining length)
+    size_t factors_[2 * MAX_FACTORS];
+
+    Complex* twiddles_;        // exp(-2*pi*i*k/(N/2)), k < N/2
+    Complex* split_twiddles_;  // exp(-2*pi*i*k/N), k < N/2
+    Complex* packed_input_;    // N/2 complex (even/odd interleave)
+    Complex* spectrum_;        // N/2 complex
+};
+
+} // namespace irene
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Per-frame signal statistics, computed once at capture
+ *
+ * compute_frame_stats() walks the samples a single time for the energy,
+ * zero crossings and peak. The result travels with the AudioFrame so the
+ * level meter, the stream VAD, the wake word gate and the arbitration peak
+ * level read it instead of walking the frame again.
+ */
+struct FrameStats {
+    uint64_t sum_squares = 0;          // Sum of sample^2
+    uint32_t zero_crossings = 0;       // Sign changes between neighbouring samples
+    uint16_t peak = 0;                 // Largest |sample|
+    uint32_t sample_count = 0;
+
+    float rms() const;                 // Full scale = 1.0
+    float zcr() const;                 // Crossings per sample pair, 0..1
+    float peak_level() const { return peak / 32768.0f; }
+};
+
+/**
+ * @brief RMS, zero crossings and peak of a frame in one pass
+ *
+ * The loop works on sample pairs: two 16x16-bit products summed in 32 bits
+ * (at most 2^31, so no overflow) before the 64-bit accumulate, and
+ * branchless sign and magnitude tests, which keeps the body free of
+ * data-dependent branches for the compiler to unroll and schedule.
+ */
+FrameStats compute_frame_stats(const int16_t* samples, size_t count);
+
+} // namespace irene
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "utils/spsc_ring_buffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace irene {
+
+/**
+ * Jitter buffer between the downlink decoder and the playback task
+ *
+ * Decoded PCM goes into a lock-free SPSC ring carved from the memory plan
+ * (the WebSocket task writes, the playback task reads whole frames). A
+ * stream starts playing once prebuffer samples are queued, so network
+ * jitter up to that depth never reaches the speaker. Running dry
+ * mid-stream counts an underrun and re-buffers to the same depth; the end
+ * of a stream plays out whatever is left, padded to a full frame.
+ */
+class JitterBuffer {
+public:
+    JitterBuffer();
+
+    // Non-copyable
+    JitterBuffer(const JitterBuffer&) = delete;
+    JitterBuffer& operator=(const JitterBuffer&) = delete;
+
+    /**
+     * @brief Allocate the ring
+     * @param capacity_samples Samples held at most (rounded up to a power of two)
+     * @param prebuffer_samples Samples queued before playback starts
+     * @param use_psram Ring in PSRAM instead of internal RAM
+     * @return Error code
+     */
+    ErrorCode initialize(size_t capacity_samples, size_t prebuffer_samples, bool use_psram);
+
+    // Producer: queue samples; the excess of a full ring is dropped and counted
+    size_t write(const int16_t* samples, size_t count);
+    void end_of_stream();   // Play out the rest without waiting for the prebuffer
+    void flush();           // Discard everything queued, at the consumer's next read
+
+    // Consumer: one frame of count samples; false (and out untouched) while
+    // buffering or idle
+    bool read(int16_t* out, size_t count);
+
+    // Status
+    bool is_playing() const { return playing_.load(std::memory_order_relaxed); }
+    size_t buffered() const { return ring_ ? ring_->available() : 0; }
+    size_t capacity() const { return ring_ ? ring_->capacity() : 0; }
+    size_t prebuffer() const { return prebuffer_; }
+    uint32_t get_underrun_count() const { return underruns_.load(std::memory_order_relaxed); }
+    uint32_t get_overrun_samples() const { return overrun_samples_.load(std::memory_order_relaxed); }
+    uint32_t get_played_samples() const { return played_samples_.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<SPSCRingBuffer<int16_t>> ring_;
+    size_t prebuffer_;
+    std::atomic<bool> end_of_stream_;  // Set by the producer, cleared by its next write
+    std::atomic<bool> flush_requested_;
+    std::atomic<bool> playing_;        // Consumer-owned
+
+    std::atomic<uint32_t> underruns_;
+    std::atomic<uint32_t> overrun_samples_;
+    std::atomic<uint32_t> played_samples_;
+};
+
+} // namespace irene
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/posterior_smoother.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// TensorFlow Lite Micro includes
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_resource_variable.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace irene {
+
+class FeatureQueue;
+class MFCCFrontend;
+
+/**
+ * One keyword model scored by WakeWordDetector
+ *
+ * Owns the TFLite interpreter for one INT8 model, built in a slice of the
+ * detector's TensorArena pool, the FeatureQueue the shared MFCC stage
+ * publishes into, and the keyword's detection state. The model weights are
+ * read in place from the flash-mapped flatbuffer.
+ *
+ * Two model layouts are accepted, chosen from the input tensor shape:
+ * - windowed: input is the full 49x40 matrix, scored at most once per
+ *   publish interval; a backlog is skipped to the newest matrix
+ * - streaming: input is N < 49 new frames; the model keeps its own state in
+ *   resource variables (VAR_HANDLE/ASSIGN_VARIABLE) and/or external state
+ *   tensors (input[i] <- output[i] for i >= 1), and is invoked exactly once
+ *   per N frames
+ *
+ * Raw scores go through a PosteriorSmoother; the hops each scored block
+ * covers (including skipped windowed blocks) drive its timing.
+ *
+ * Setup runs load(), then create_interpreter()/allocate_tensors() (again
+ * after destroy_interpreter() if the arena is resized), then configure().
+ * publish() belongs to the capture task, score_next() to the inference task.
+ */
+class KeywordModel {
+public:
+    KeywordModel(const KeywordConfig& config, const uint8_t* model_data, size_t model_size);
+    ~KeywordModel();
+
+    // Non-copyable
+    KeywordModel(const KeywordModel&) = delete;
+    KeywordModel& operator=(const KeywordModel&) = delete;
+
+    // Setup
+    bool load();
+    bool create_interpreter(uint8_t* arena, size_t arena_size);
+    bool allocate_tensors();
+    void destroy_interpreter();
+    size_t arena_used_bytes() const;
+    const TfLiteTensor* input() const;
+
+    /**
+     * @brief Validate the input layout and create the feature queue
+     * @param int8_features Frontend publishes INT8 features in this model's input quantization
+     * @param use_psram Float feature slots in PSRAM
+     * @param publish_interval_frames Windowed models: hops between published matrices
+     * @return Error code
+     */
+    ErrorCode configure(bool int8_features, bool use_psram, uint32_t publish_interval_frames);
+    void perform_sanity_checks(size_t arena_size, bool arena_internal);
+
+    // Producer side (capture task): publish whatever the frontend has ready
+    bool publish(const MFCCFrontend& frontend);
+    void restart();  // Frontend was reset; state continues from unrelated audio
+
+    // Consumer side (inference task)
+    bool has_pending() const;
+    bool score_next(float& confidence);  // false when nothing was queued
+
+    // Detection state: true at the peak of the smoothed posterior
+    bool update_detection(float confidence);
+    float get_detection_confidence() const { return smoother_.peak(); }
+
+    // Configuration and status
+    const KeywordConfig& config() const { return config_; }
+    const char* name() const { return config_.name; }
+    void set_threshold(float threshold) {
+        config_.threshold = threshold;
+        smoother_.set_threshold(threshold);
+    }
+    bool is_streaming() const { return streaming_model_; }
+    size_t input_frames() const { return model_input_frames_; }
+    size_t model_size() const { return model_size_; }
+    const uint8_t* model_data() const { return model_data_; }
+    float get_last_confidence() const { return last_confidence_; }
+    uint32_t get_inference_count() const { return inference_count_; }
+    uint32_t get_detection_count() const { return detection_count_; }
+    const FeatureQueue* feature_queue() const { return feature_queue_.get(); }
+
+private:
+    bool configure_model_input(const TfLiteTensor* input);
+    void reset_model_state();
+    float run_inference(const float* mfcc_features, size_t feature_count);
+    float invoke_model();
+    bool publish_frames(const MFCCFrontend& frontend, uint32_t first_frame, size_t n_frames);
+
+    KeywordConfig config_;
+    const uint8_t* model_data_;
+    size_t model_size_;
+
+    // TensorFlow Lite Micro components
+    const tflite::Model* model_;
+    tflite::MicroInterpreter* interpreter_;
+    static constexpr int kOpResolverSize = 17;
+    tflite::MicroMutableOpResolver<kOpResolverSize>* resolver_;
+    tflite::MicroResourceVariables* resource_variables_;
+    uint8_t* variable_arena_;          // Resource variable storage (streaming models)
+    static constexpr size_t kVariableArenaSize = 1024;
+
+    // Streaming model state
+    bool streaming_model_;
+    size_t model_input_frames_;        // Frames per invoke (N_FRAMES when windowed)
+    size_t external_state_count_;      // input[i]/output[i] state pairs, i >= 1
+
+    // Pipeline: MFCC stage (producer) -> inference stage (consumer)
+    std::unique_ptr<FeatureQueue> feature_queue_;
+    bool int8_features_;
+    uint32_t next_publish_frame_;      // Producer: next frontend frame to publish
+    uint32_t publish_interval_frames_;
+
+    // Detection state, in hops rather than wall-clock time
+    PosteriorSmoother smoother_;
+    uint32_t last_block_hops_;         // Hops covered by the last scored block
+    float last_confidence_;
+    uint32_t inference_count_;
+    uint32_t detection_count_;
+};
+
+} // namespace irene
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "audio/fft_engine.hpp"
+#include "utils/memory_plan.hpp"
 #include <cstdint>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -18,9 +21,25 @@ namespace irene {
  * - Mel filters: 40
  * - MFCC coefficients: 40
  * - Output: 49x40 feature matrix for each inference
+ * 
+ * Frames are computed incrementally: each 10 ms hop that completes a window
+ * produces one MFCC frame, stored in a circular 49-frame store that
+ * get_features() linearizes oldest-first.
+ * 
+ * The Hann window, mel filterbank (sparse per-filter runs) and DCT matrix are
+ * built at compile time from the parameters below and never touch the heap.
+ * 
+ * With enable_int8_output() the frontend quantizes each frame with the
+ * model's input scale/zero-point and keeps an INT8 store instead, which
+ * get_features_int8() copies straight into the input tensor.
+ * 
+ * A mel tap sees each frame's log10 mel energies on the way to the DCT, so
+ * spectral consumers such as the adaptive VAD need no FFT of their own.
  */
 class MFCCFrontend {
 public:
+    using MelTap = std::function<void(const float* log_mel, size_t bands)>;  // Once per hop
+
     // MFCC parameters matching training
     static constexpr size_t SAMPLE_RATE = 16000;
     static constexpr size_t WINDOW_SIZE_MS = 30;
@@ -34,7 +53,7 @@ public:
     // Total feature matrix size
     static constexpr size_t FEATURE_SIZE = N_FRAMES * N_MFCC;
     
-    // Input buffer size (enough for N_FRAMES with overlap)
+    // Audio span covered by one feature matrix (N_FRAMES with overlap)
     static constexpr size_t INPUT_BUFFER_SIZE = (N_FRAMES - 1) * HOP_SAMPLES + WINDOW_SAMPLES;  // 8160 samples
 
     MFCCFrontend();
@@ -49,9 +68,12 @@ public:
 
     /**
      * @brief Process audio samples and extract MFCC features
+     * 
+     * Computes one MFCC frame for every completed hop; earlier frames are kept.
+     * 
      * @param audio_data Input audio samples (int16_t PCM)
      * @param samples Number of samples
-     * @return True if new features are available
+     * @return True if at least one new frame was added to a full feature matrix
      */
     bool process_samples(const int16_t* audio_data, size_t samples);
 
@@ -62,6 +84,55 @@ public:
      */
     bool get_features(float* features) const;
 
+    /**
+     * @brief Get the latest features quantized for an INT8 model input
+     * @param features Output buffer [N_FRAMES][N_MFCC] = int8_t[49*40]
+     *                 (typically interpreter->input(0)->data.int8)
+     * @return True if valid features are available and INT8 output is enabled
+     */
+    bool get_features_int8(int8_t* features) const;
+
+    /**
+     * @brief Get a run of frames by absolute frame number (for streaming models)
+     * 
+     * Frames are numbered from 0 since the last reset(); the newest is
+     * get_frame_count() - 1 and the oldest retained is N_FRAMES older.
+     * 
+     * @param first_frame Absolute number of the first frame to copy
+     * @param n_frames Number of consecutive frames
+     * @param features Output buffer [n_frames][N_MFCC]
+     * @return True if all requested frames are still in the store
+     */
+    bool get_frames(uint32_t first_frame, size_t n_frames, float* features) const;
+    bool get_frames_int8(uint32_t first_frame, size_t n_frames, int8_t* features) const;
+
+    /**
+     * @brief Total frames computed since the last reset()
+     */
+    uint32_t get_frame_count() const { return frame_counter_; }
+
+    /**
+     * @brief Switch the frontend to INT8 output
+     * 
+     * Each frame is quantized as q = round(f / scale) + zero_point during the
+     * DCT; the float feature store is released. Resets the frame store.
+     * 
+     * @param scale Model input quantization scale
+     * @param zero_point Model input quantization zero point
+     * @return Error code
+     */
+    ErrorCode enable_int8_output(float scale, int32_t zero_point);
+
+    /**
+     * @brief Observe every frame's log10 mel energies (N_MELS, valid for the call)
+     */
+    void set_mel_tap(MelTap tap) { mel_tap_ = std::move(tap); }
+
+    /**
+     * @brief Check whether frames are stored as INT8
+     */
+    bool is_int8_output() const { return int8_output_; }
+
     /**
      * @brief Reset the frontend state
      */
@@ -73,64 +144,113 @@ public:
      */
     bool has_sufficient_data() const;
 
+    // Individual stages on caller-owned buffers, for kernel benchmarks;
+    // process_samples() runs them in this order
+
+    /**
+     * @brief Compute FFT and power spectrum
+     * @param windowed_samples Input windowed samples
+     * @param power_spec Output power spectrum
+     */
+    void compute_power_spectrum(const float* windowed_samples, float* power_spec);
+
+    /**
+     * @brief Apply mel filterbank to power spectrum
+     * @param power_spec Input power spectrum
+     * @param mel_energies Output log10 mel energies
+     */
+    void apply_mel_filterbank(const float* power_spec, float* mel_energies);
+
+    /**
+     * @brief Compute MFCC coefficients from mel energies
+     * @param mel_energies Input mel energies
+     * @param mfcc_coeffs Output MFCC coefficients
+     */
+    void compute_mfcc(const float* mel_energies, float* mfcc_coeffs);
+
 private:
     bool initialized_;
     bool use_psram_;
     
-    // Audio input buffer (ring buffer for overlapping windows)
-    std::unique_ptr<int16_t[]> audio_buffer_;
+    // Audio input buffer (ring of WINDOW_SAMPLES for the current window)
+    PlanArray<int16_t> audio_buffer_;
     size_t buffer_write_pos_;
     size_t samples_available_;
+    size_t samples_until_frame_;                   // New samples needed before next frame
     
     // MFCC computation buffers
-    std::unique_ptr<float[]> windowed_samples_;     // WINDOW_SAMPLES
-    std::unique_ptr<float[]> fft_buffer_;          // For FFT computation
-    std::unique_ptr<float[]> power_spectrum_;      // WINDOW_SAMPLES/2 + 1
-    std::unique_ptr<float[]> mel_energies_;        // N_MELS
-    std::unique_ptr<float[]> log_mel_energies_;    // N_MELS
-    std::unique_ptr<float[]> mfcc_coeffs_;         // N_MFCC
+    PlanArray<float> windowed_samples_;     // WINDOW_SAMPLES (Hann-windowed FFT input)
+    PlanArray<float> power_spectrum_;      // WINDOW_SAMPLES/2 + 1
+    PlanArray<float> mel_energies_;        // N_MELS
+    PlanArray<float> log_mel_energies_;    // N_MELS
+    PlanArray<float> mfcc_coeffs_;         // N_MFCC
     
-    // Feature output buffer
-    std::unique_ptr<float[]> features_;            // N_FRAMES * N_MFCC
+    // Feature output buffer (circular frame store)
+    PlanArray<float> features_;            // N_FRAMES * N_MFCC
+    size_t feature_write_index_;                   // Next slot (= oldest frame once full)
     size_t feature_frame_count_;
+    uint32_t frame_counter_;                       // Frames computed since reset
+    
+    // INT8 output mode
+    bool int8_output_;
+    float output_scale_;
+    int32_t output_zero_point_;
+    PlanArray<int8_t> features_int8_;      // N_FRAMES * N_MFCC
+    PlanArray<float> dct_quant_matrix_;    // dct_matrix_ / output_scale_
+    
+    // Real FFT (mixed-radix, twiddles in internal RAM)
+    FFTEngine fft_engine_;
     
-    // Precomputed tables
-    std::unique_ptr<float[]> hann_window_;         // WINDOW_SAMPLES
-    std::unique_ptr<float[]> mel_filterbank_;      // N_MELS * (WINDOW_SAMPLES/2 + 1)
-    std::unique_ptr<float[]> dct_matrix_;          // N_MFCC * N_MELS
+    MelTap mel_tap_;
 
     /**
-     * @brief Initialize precomputed tables
+     * @brief Convert, normalise and Hann-window a contiguous run of samples
+     * @param samples Input samples
+     * @param offset Position of samples[0] within the window
+     * @param count Number of samples
+     * @param windowed_output Output windowed frame (WINDOW_SAMPLES)
      */
-    bool setup_tables();
+    void apply_window(const int16_t* samples, size_t offset, size_t count, float* windowed_output);
+
+
 
     /**
-     * @brief Apply Hann window to audio samples
-     * @param samples Input samples
-     * @param windowed_output Output windowed samples
+     * @brief Compute MFCC coefficients and quantize them to INT8
+     * @param mel_energies Input log mel energies
+     * @param quantized_coeffs Output INT8 coefficients (N_MFCC)
      */
-    void apply_window(const int16_t* samples, float* windowed_output);
+    void compute_mfcc_int8(const float* mel_energies, int8_t* quantized_coeffs);
 
     /**
-     * @brief Compute FFT and power spectrum
-     * @param windowed_samples Input windowed samples
-     * @param power_spec Output power spectrum
+     * @brief Fast log10 approximation (|error| ~1e-5) for the INT8 path
      */
-    void compute_power_spectrum(const float* windowed_samples, float* power_spec);
+    static float fast_log10f(float x);
 
     /**
-     * @brief Apply mel filterbank to power spectrum
-     * @param power_spec Input power spectrum
-     * @param mel_energies Output mel energies
+     * @brief Map an absolute frame number to its store slot
+     * @param first_frame Absolute frame number of the run start
+     * @param n_frames Run length
+     * @param slot Output slot of first_frame
+     * @return True if the whole run is retained
      */
-    void apply_mel_filterbank(const float* power_spec, float* mel_energies);
+    bool locate_frames(uint32_t first_frame, size_t n_frames, size_t& slot) const;
 
     /**
-     * @brief Compute MFCC coefficients from mel energies
-     * @param mel_energies Input mel energies
-     * @param mfcc_coeffs Output MFCC coefficients
+     * @brief Advance the circular frame store by one frame
      */
-    void compute_mfcc(const float* mel_energies, float* mfcc_coeffs);
+    void advance_frame_store();
+
+    /**
+     * @brief Append samples to the window ring
+     * @param audio_data Input samples
+     * @param samples Number of samples (<= WINDOW_SAMPLES)
+     */
+    void write_samples(const int16_t* audio_data, size_t samples);
+
+    /**
+     * @brief Compute one MFCC frame from the current window
+     */
+    void compute_frame();
 
     /**
      * @brief Update feature matrix with new MFCC frame
@@ -139,9 +259,9 @@ private:
     void update_feature_matrix(const float* mfcc_coeffs);
 
     /**
-     * @brief Allocate buffer with specified memory caps
+     * @brief Allocate a buffer from the memory plan (PSRAM or internal)
      * @param size Size in bytes
-     * @return Allocated pointer or nullptr
+     * @return Allocated pointer or nullptr; free with MemoryPlan::release
      */
     void* allocate_buffer(size_t size) const;
 };
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Posterior smoothing and peak picking for one keyword's scores
+ *
+ * Replaces the wall-clock "above threshold for N ms" rule. The raw model
+ * posterior is averaged over the last window inferences; once the full
+ * window's average crosses the threshold, a detection is raised at its
+ * peak, i.e. at the first inference where it stops rising, or after one
+ * window of rising when the peak is broad. A refractory period then
+ * suppresses further detections so one utterance fires once.
+ *
+ * Everything is counted in MFCC hops (10 ms) carried by each update, never
+ * in esp_timer time, so the trigger point does not move with scheduling
+ * jitter or CPU load; hops skipped by a windowed model that fell behind
+ * still count towards the refractory period.
+ */
+class PosteriorSmoother {
+public:
+    static constexpr size_t MAX_WINDOW = 16;
+
+    PosteriorSmoother();
+
+    /**
+     * @brief Set the detection parameters; clears all state
+     * @param threshold Smoothed posterior that arms the peak picker
+     * @param window Inferences averaged (1 = raw posterior, clamped to MAX_WINDOW)
+     * @param refractory_hops Hops after a detection during which no other fires
+     */
+    void configure(float threshold, size_t window, uint32_t refractory_hops);
+    void set_threshold(float threshold) { threshold_ = threshold; }
+
+    /**
+     * @brief Add one inference
+     * @param posterior Raw model score
+     * @param hops MFCC hops since the previous inference
+     * @return true when this inference is a detection; peak() holds its score
+     */
+    bool update(float posterior, uint32_t hops);
+
+    // Forget the window and any pending peak, e.g. after a gap in the audio;
+    // a running refractory period is kept
+    void reset();
+
+    // Status
+    float smoothed() const { return count_ > 0 ? sum_ / count_ : 0.0f; }
+    float peak() const { return peak_; }
+    size_t window() const { return window_; }
+    bool in_refractory() const { return refractory_remaining_ > 0; }
+
+private:
+    float threshold_;
+    size_t window_;
+    uint32_t refractory_hops_;
+
+    // Moving average over the last window_ posteriors
+    float history_[MAX_WINDOW];
+    size_t head_;
+    size_t count_;
+    float sum_;
+
+    // Peak picker
+    bool armed_;                       // Smoothed score is above threshold
+    float peak_;
+    size_t rising_count_;              // Inferences since arming
+    uint32_t refractory_remaining_;
+};
+
+} // namespace irene
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace irene {
+
+class ConfigManager;
+
+/**
+ * Right-sized TFLite Micro tensor arena pool
+ *
+ * One allocation is split into one slice per model. The first boot with a
+ * given model gives it a generous measurement slice in PSRAM, and the
+ * caller reports arena_used_bytes() once AllocateTensors has run. That
+ * need is persisted per model slot (hash + size) through ConfigManager,
+ * and every later allocation sizes the slice to the measured need plus a
+ * margin. A right-sized pool holds only tensor metadata and activation
+ * scratch (weights stay in the memory-mapped flash models), so it is
+ * placed in internal SRAM whenever that still leaves the configured
+ * reserve free for LVGL, Wi-Fi and task stacks; otherwise it falls back
+ * to PSRAM.
+ *
+ * A stale record (AllocateTensors fails at the stored size, e.g. after a
+ * TFLM upgrade) is dropped with invalidate() and the next allocation
+ * measures that slice again.
+ */
+class TensorArena {
+public:
+    static constexpr size_t MAX_MODELS = 4;
+    static constexpr size_t MEASURE_SIZE = 160 * 1024;  // Measurement slice
+    static constexpr size_t ALIGNMENT = 16;             // TFLM buffer alignment
+
+    TensorArena();
+    ~TensorArena();
+
+    // Non-copyable
+    TensorArena(const TensorArena&) = delete;
+    TensorArena& operator=(const TensorArena&) = delete;
+
+    /**
+     * @brief Open the record store
+     * @param margin_bytes Headroom added to each measured need
+     * @param internal_reserve Internal RAM that must stay free after placement
+     * @return Error code
+     */
+    ErrorCode initialize(size_t margin_bytes, size_t internal_reserve);
+
+    /**
+     * @brief Give a model the next slice and load its stored need
+     * @param model_data Model flatbuffer
+     * @param model_size Model size in bytes
+     * @return Slice index, or -1 when the pool is full
+     */
+    int add_model(const uint8_t* model_data, size_t model_size);
+
+    // Allocate every slice at its planned size in one block; nullptr on failure
+    uint8_t* allocate();
+    void release();
+
+    // Report a slice's arena_used_bytes() after AllocateTensors
+    void record_usage(size_t index, size_t used_bytes);
+
+    // Any slice larger than its measured need, i.e. worth allocating again
+    bool is_oversized() const;
+
+    // Forget a slice's stored need; the next allocate() measures it again
+    void invalidate(size_t index);
+
+    uint8_t* slice(size_t index) const { return data_ ? data_ + offsets_[index] : nullptr; }
+    size_t slice_size(size_t index) const { return slice_sizes_[index]; }
+    size_t slice_used(size_t index) const { return used_bytes_[index]; }
+    size_t model_count() const { return model_count_; }
+    size_t size() const { return size_; }
+    bool is_internal() const { return internal_; }
+    bool is_measuring(size_t index) const { return records_[index].used_bytes == 0; }
+    bool is_measuring() const;
+
+private:
+    static uint32_t hash_model(const uint8_t* data, size_t size);
+    size_t planned_size(size_t index) const;
+
+    std::unique_ptr<ConfigManager> config_store_;
+    TensorArenaRecord records_[MAX_MODELS];
+    size_t model_count_;
+    size_t margin_bytes_;
+    size_t internal_reserve_;
+
+    uint8_t* data_;
+    size_t size_;
+    size_t offsets_[MAX_MODELS];
+    size_t slice_sizes_[MAX_MODELS];
+    size_t used_bytes_[MAX_MODELS];
+    bool internal_;
+};
+
+} // namespace irene
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "audio/frame_stats.hpp"
 #include <cstdint>
 
 namespace irene {
@@ -8,6 +9,15 @@ namespace irene {
 /**
  * Voice Activity Detection processor
  * Uses energy-based and spectral features to detect speech
+ *
+ * VADMode::ENERGY compares the smoothed frame RMS (with a ZCR assist) to a
+ * fixed threshold. VADMode::ADAPTIVE decides per 10 ms hop from the log mel
+ * energies the MFCC frontend already computes: each band's noise floor is
+ * tracked by minimum statistics (the minimum of the smoothed band energy
+ * over about 1.5 s), and speech is declared when the mean SNR of the
+ * loudest quarter of the bands clears a sensitivity-dependent margin. A steady fan or
+ * dishwasher raises the floor instead of holding the VAD open. Frames
+ * that arrive without fresh mel energies fall back to the energy rule.
  */
 class VADProcessor {
 public:
@@ -19,17 +29,26 @@ public:
     
     // Process audio frame and return voice detection result
     bool process_frame(const int16_t* audio_data, size_t samples);
+    bool process_frame(const FrameStats& stats);  // Statistics already taken at capture
+    
+    // Adaptive mode: one hop of log10 mel band energies; process_frame()
+    // then reports the decision made here
+    bool process_spectrum(const float* log_mel, size_t bands, uint32_t hop_ms);
     
     // Configuration
     void set_sensitivity(float sensitivity);  // 0.0 to 1.0
     void set_energy_threshold(float threshold);
     void set_silence_duration_ms(uint32_t duration_ms);
     void set_voice_duration_ms(uint32_t duration_ms);
+    void set_mode(VADMode mode);
     
     // Status
     bool is_voice_detected() const { return voice_detected_; }
     float get_current_energy() const { return current_energy_; }
     float get_sensitivity() const { return sensitivity_; }
+    VADMode get_mode() const { return mode_; }
+    float get_snr_db() const { return current_snr_db_; }  // Adaptive mode, loudest quarter of bands
+    float get_noise_floor_db() const;                      // Adaptive mode, mean over bands
     
     // Statistics
     uint32_t get_voice_frames() const { return voice_frames_; }
@@ -37,11 +56,13 @@ public:
     void reset_stats();
 
 private:
-    float calculate_energy(const int16_t* audio_data, size_t samples);
-    float calculate_zero_crossing_rate(const int16_t* audio_data, size_t samples);
     bool apply_hysteresis(bool current_detection);
+    void update_decision_frames();
+    void update_noise_floor(const float* log_mel, size_t bands);
+    bool apply_spectral_hysteresis(bool current_detection, uint32_t hop_ms);
     
     uint32_t sample_rate_;
+    uint32_t frame_ms_;        // Duration of the frames being fed
     float sensitivity_;
     float energy_threshold_;
     uint32_t silence_duration_ms_;
@@ -57,6 +78,24 @@ private:
     uint32_t frames_for_voice_decision_;
     uint32_t frames_for_silence_decision_;
     
+    // Adaptive mode: per-band minimum statistics in log10 power
+    static constexpr size_t MAX_BANDS = 40;
+    static constexpr size_t MIN_SUBWINDOWS = 5;
+    static constexpr uint32_t MIN_SUBWINDOW_HOPS = 30;  // 5 x 300 ms of floor memory
+    VADMode mode_;
+    size_t bands_;
+    float smoothed_[MAX_BANDS];
+    float current_min_[MAX_BANDS];                      // Minimum in the running sub-window
+    float subwindow_min_[MIN_SUBWINDOWS][MAX_BANDS];    // Minima of the completed sub-windows
+    float noise_floor_[MAX_BANDS];
+    size_t subwindow_index_;
+    uint32_t subwindow_hops_;
+    uint32_t spectral_hops_;
+    bool spectrum_fresh_;              // A hop arrived since the last process_frame()
+    uint32_t voice_run_ms_;
+    uint32_t silence_run_ms_;
+    float current_snr_db_;
+    
     // Statistics
     uint32_t voice_frames_;
     uint32_t silence_frames_;
@@ -1,124 +1,174 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "core/power_manager.hpp"
 #include "audio/mfcc_frontend.hpp"
+#include "audio/frame_stats.hpp"
 #include <functional>
 #include <memory>
-
-// TensorFlow Lite Micro includes
-#include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/schema/schema_generated.h"
-#include "tensorflow/lite/version.h"
+#include <vector>
 
 namespace irene {
 
+class AudioHistory;
+class KeywordModel;
+
 /**
- * Wake word detection using INT8 quantized TensorFlow Lite model
+ * Wake word detection using INT8 quantized TensorFlow Lite models
  * Features MFCC frontend (49x40) and INT8 inference for optimal performance
- * Runs on PSRAM-resident model with per-node training
+ * Runs on flash-resident models with per-node training
+ *
+ * The detector is a multi-keyword engine: the wake word passed to
+ * initialize() is keyword 0, and further models ("stop", "cancel", a
+ * second wake word) registered with add_keyword() run beside it. All
+ * keywords share one MFCC frontend, so each extra keyword costs only its
+ * inference, and one TensorArena pool holds every interpreter. Windowed
+ * and streaming layouts may be mixed; see KeywordModel.
+ *
+ * With WakeWordConfig::vad_cascade the detector runs as a cascade: a cheap
+ * energy/ZCR gate (VADProcessor) sees every frame, and MFCC extraction and
+ * inference only run while it is open plus a hangover. On opening, the
+ * frontend is backfilled from the capture AudioHistory so the word onset is
+ * not lost; the detector keeps no audio buffer of its own.
+ *
+ * The detector is a two-stage pipeline: process_frame() (gate + MFCC) runs
+ * in the caller's capture task, and TFLite inference runs in wake_word_task
+ * on WakeWordConfig::inference_core. The stages share only lock-free SPSC
+ * FeatureQueues (one per keyword), so inference never contends with
+ * capture for a core or lock. Each inference pass scores one block per
+ * keyword per round, highest KeywordConfig::priority first, until the
+ * queues are empty or the pass has used the 30 ms inference interval.
  */
 class WakeWordDetector {
 public:
     using DetectionCallback = std::function<void(float confidence, uint32_t latency_ms)>;
+    using PrearmCallback = std::function<void(float confidence)>;  // Likely wake word, not yet confirmed
+    using KeywordCallback = std::function<void(size_t keyword, const char* name, float confidence)>;
+
+    static constexpr uint8_t WAKE_WORD_PRIORITY = 255;
 
     WakeWordDetector();
     ~WakeWordDetector();
 
-    // Initialize with node-specific model data
-    ErrorCode initialize(const WakeWordConfig& config, 
-                        const uint8_t* model_data, 
+    // Register an extra keyword model before initialize(); index returned via keyword
+    ErrorCode add_keyword(const KeywordConfig& config, const uint8_t* model_data,
+                          size_t model_size, size_t* keyword = nullptr);
+
+    // Initialize with node-specific model data (the wake word, keyword 0)
+    ErrorCode initialize(const WakeWordConfig& config,
+                        const uint8_t* model_data,
                         size_t model_size);
 
-    // Process audio frame (typically 480 samples = 30ms at 16kHz)
-    bool process_frame(const int16_t* audio_data, size_t samples);
+    // Process audio frame (typically 480 samples = 30ms at 16kHz); stats, when
+    // given, are the frame's capture statistics and spare the gate a pass
+    bool process_frame(const int16_t* audio_data, size_t samples,
+                       const FrameStats* stats = nullptr);
+    
+    // Run only the MFCC frontend, for its mel tap, while not listening; the
+    // next process_frame() restarts detection on fresh audio
+    void analyze_frame(const int16_t* audio_data, size_t samples);
+    void set_mel_tap(MFCCFrontend::MelTap tap) { mel_tap_ = std::move(tap); }  // Live hops only, capture task
+
+    // Backfill source; read from the capture task, which must have pushed
+    // each frame before process_frame() sees it
+    void set_audio_history(const AudioHistory* history) { history_ = history; }
 
     // Configure detection
     void set_threshold(float threshold);
     void set_detection_callback(DetectionCallback callback);
-    
+    void set_prearm_callback(PrearmCallback callback);  // Once per rise above prearm_threshold
+    void set_keyword_callback(KeywordCallback callback);  // Every confirmed keyword, inference task
+
     // Control
     void enable();
     void disable();
     void reset();
-    
+
     // Status
     bool is_enabled() const { return enabled_; }
+    bool is_streaming_model() const;
+    bool is_gate_open() const { return gate_open_; }
     float get_threshold() const { return config_.threshold; }
     float get_last_confidence() const { return last_confidence_; }
     uint32_t get_last_latency_ms() const { return last_latency_ms_; }
-    
+    size_t get_keyword_count() const { return keywords_.size(); }
+    const char* get_keyword_name(size_t keyword) const;
+
     // Statistics
     uint32_t get_detection_count() const { return detection_count_; }
     uint32_t get_false_positive_count() const { return false_positive_count_; }
     float get_average_latency_ms() const;
-    
+    uint32_t get_gate_open_count() const { return gate_open_count_; }
+    uint64_t get_gated_samples() const { return gated_samples_; }
+    uint32_t get_budget_overrun_count() const { return budget_overrun_count_; }
+
     // Debugging
     void log_inference_stats() const;
 
 private:
     void wake_word_task();
+    bool update_gate(const int16_t* audio_data, size_t samples, const FrameStats* stats);
+    void open_gate();
+    void feed_frontend(const int16_t* audio_data, size_t samples);
     void process_inference();
-    bool validate_detection(float confidence);
+    void report_inference(size_t keyword, float confidence, uint32_t start_time);
     static void wake_word_task_wrapper(void* arg);
-    
-    // TensorFlow Lite inference methods
-    bool setup_tf_lite_model();
-    float run_inference(const float* mfcc_features, size_t feature_count);
-    void cleanup_tf_lite_model();
-    void perform_sanity_checks();
-    
-    // MFCC processing methods
-    bool process_mfcc_features();
-    
+
+    // TensorFlow Lite setup: every keyword in one arena pool
+    bool setup_tf_lite_models();
+    bool use_int8_frontend() const;
+    void cleanup_tf_lite_models();
+
     WakeWordConfig config_;
     bool enabled_;
     bool initialized_;
-    
-    // Model data (stored in PSRAM)
-    const uint8_t* model_data_;
-    size_t model_size_;
-    
-    // TensorFlow Lite Micro components
-    const tflite::Model* model_;
-    tflite::MicroInterpreter* interpreter_;
-    tflite::MicroMutableOpResolver<9>* resolver_;
-    uint8_t* tensor_arena_;
-    static constexpr size_t kTensorArenaSize = 160 * 1024; // 160KB initial size for INT8 model
-                                                                       // Can be reduced gradually (128KB->96KB) after validation
-    
-    // MFCC frontend for feature extraction
+
+    // Keyword models, wake word first, and the scoring order by priority
+    std::vector<std::unique_ptr<KeywordModel>> keywords_;
+    std::vector<size_t> schedule_;
+    std::unique_ptr<class TensorArena> tensor_arena_;  // Measured slices, internal RAM when they fit
+
+    // MFCC frontend for feature extraction, shared by every keyword
     std::unique_ptr<MFCCFrontend> mfcc_frontend_;
-    
-    // Audio buffering (legacy - now handled by MFCC frontend)
-    std::unique_ptr<class RingBuffer> audio_buffer_;
-    int16_t* inference_buffer_;
-    size_t inference_buffer_size_;
-    
-    // Feature buffers for INT8 processing
-    std::unique_ptr<float[]> mfcc_features_;       // 49x40 MFCC features
-    std::unique_ptr<int8_t[]> quantized_features_; // Quantized input for model
-    
-    // Detection state
+
+    // Cascade gate (stage 1)
+    std::unique_ptr<class VADProcessor> gate_;
+    bool gate_open_;
+    size_t hangover_samples_;          // Hangover length
+    size_t hangover_remaining_;        // Samples left before the gate closes
+    size_t backfill_samples_;
+    const AudioHistory* history_;      // Shared capture history, not owned
+    bool backfilling_;                 // Replayed audio is kept from the mel tap
+    bool analyzing_;                   // analyze_frame() ran since the last process_frame()
+    MFCCFrontend::MelTap mel_tap_;
+
+    // Wake word state
     float last_confidence_;
     uint32_t last_latency_ms_;
-    uint32_t detection_start_time_;
-    uint32_t consecutive_detections_;
-    
-    // Callback
+    bool prearmed_;
+
+    // Callbacks
     DetectionCallback detection_callback_;
-    
+    PrearmCallback prearm_callback_;
+    KeywordCallback keyword_callback_;
+
     // Task management
-    TaskHandle_t wake_word_task_handle_;
-    QueueHandle_t audio_queue_;
+    TaskHandle_t volatile wake_word_task_handle_;
     
+    // Full clock while the MFCC stage (capture task) and inference (own task) run
+    PowerLock frontend_lock_;
+    PowerLock inference_lock_;
+
     // Statistics
     uint32_t detection_count_;
     uint32_t false_positive_count_;
     uint32_t total_latency_ms_;
     uint32_t inference_count_;
-    
+    uint32_t gate_open_count_;
+    uint64_t gated_samples_;           // Samples skipped while the gate was closed
+    uint32_t budget_overrun_count_;    // Passes that ended with blocks still queued
+
     // Timing
-    uint32_t last_inference_time_;
     uint32_t inference_interval_us_;
-}; 
\ No newline at end of file
+};
+} // namespace irene
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+
+namespace irene {
+
+// What the capture callback does with a frame
+enum class CaptureRoute : uint8_t {
+    NONE,       // Nothing downstream wants it
+    DETECT,     // WakeWordDetector::process_frame(): gate, MFCC, inference
+    ANALYZE     // WakeWordDetector::analyze_frame(): MFCC only, for the VAD's mel tap
+};
+
+/**
+ * Routing decision of StateMachine's capture callback, kept free of the
+ * components so host tests can check it.
+ *
+ * Detection needs an enabled detector: process_frame() drops every frame
+ * otherwise. While idle without one, and while streaming, the frontend
+ * still runs for the adaptive VAD when it uses mel energies.
+ */
+inline CaptureRoute route_capture_frame(SystemState state, bool detector_enabled, bool spectral_vad) {
+    if (state == SystemState::IDLE_LISTENING && detector_enabled) {
+        return CaptureRoute::DETECT;
+    }
+    if (spectral_vad && (state == SystemState::IDLE_LISTENING || state == SystemState::STREAMING)) {
+        return CaptureRoute::ANALYZE;
+    }
+    return CaptureRoute::NONE;
+}
+
+} // namespace irene
@@ -3,13 +3,24 @@
 #include "core/types.hpp"
 #include "nvs_flash.h"
 #include <string>
-#include <map>
 
 namespace irene {
 
 /**
  * Configuration manager for persistent settings storage
  * Uses NVS (Non-Volatile Storage) for configuration persistence
+ *
+ * All instances share one RAM cache of the namespace, filled by the first
+ * initialize() in a single pass over its NVS entries; reads never touch
+ * flash. A set that changes a value marks the entry dirty (storing the
+ * same value again costs nothing), and commit() does not write: it opens
+ * a batch window of COMMIT_DELAY_MS, and when it closes every dirty entry
+ * is written with a single nvs_commit(). Commits can be held while the
+ * node is busy (the StateMachine holds them from the wake word to the end
+ * of cooldown); releasing the hold writes what accumulated. flush() writes
+ * at once, for the moments that cannot wait, such as a restart.
+ *
+ * NVS keys are at most 15 characters; set rejects longer ones.
  */
 class ConfigManager {
 public:
@@ -47,9 +58,23 @@ public:
     ErrorCode remove_key(const std::string& key);
     ErrorCode clear_all();
     
-    // Commit changes
+    // Queue the changes for the next batched write
     ErrorCode commit();
     
+    // Batched writes, shared by every instance
+    static constexpr uint32_t COMMIT_DELAY_MS = 3000;
+    static ErrorCode flush();                // Write dirty entries now
+    static void hold_commits(bool hold);     // Releasing writes what is pending
+    
+    struct CacheStats {
+        size_t entries;
+        size_t dirty;
+        uint32_t flushes;            // nvs_commit() calls
+        uint32_t nvs_writes;         // Entries written or erased
+        uint32_t unchanged_sets;     // Sets that matched the cached value
+    };
+    static CacheStats get_cache_stats();
+    
     // Configuration presets
     ErrorCode load_audio_config(AudioConfig& config);
     ErrorCode save_audio_config(const AudioConfig& config);
@@ -62,14 +87,22 @@ public:
     
     ErrorCode load_ui_config(UIConfig& config);
     ErrorCode save_ui_config(const UIConfig& config);
+    
+    // Wi-Fi fast reconnect cache
+    ErrorCode load_wifi_cache(WiFiConnectCache& cache);
+    ErrorCode save_wifi_cache(const WiFiConnectCache& cache);
+    ErrorCode clear_wifi_cache();
+    ErrorCode load_arena_record(size_t slot, TensorArenaRecord& record);
+    ErrorCode save_arena_record(size_t slot, const TensorArenaRecord& record);
+    ErrorCode clear_arena_record(size_t slot);
+    
+    // Interrupted firmware download
+    ErrorCode load_ota_record(OTAResumeRecord& record);
+    ErrorCode save_ota_record(const OTAResumeRecord& record);
+    ErrorCode clear_ota_record();
 
 private:
-    nvs_handle_t nvs_handle_;
     bool initialized_;
-    std::string namespace_;
-    
-    ErrorCode open_nvs();
-    void close_nvs();
 };
 
 } // namespace irene 
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/audio_frame_pool.hpp"
+#include "audio/mfcc_frontend.hpp"
+#include "utils/memory_plan.hpp"
+#include "freertos/FreeRTOS.h"
+#include <cstdint>
+
+namespace irene {
+
+// Where a task runs: core (-1 = no affinity), priority, stack bytes
+struct TaskSlot {
+    int8_t core;
+    uint8_t priority;
+    uint32_t stack_size;
+};
+
+/**
+ * Defaults of a node spec
+ * A node derives its spec from NodeSpec and redefines the constants that
+ * differ; the rest keep these values.
+ */
+struct NodeSpec {
+    // Capture format
+    static constexpr uint32_t sample_rate = 16000;
+    static constexpr uint8_t channels = 1;
+    static constexpr uint8_t bits_per_sample = 16;
+    static constexpr uint32_t frame_ms = 20;
+    static constexpr uint32_t dma_buffers = 8;
+
+    // Feature geometry and input shape the wake word model was trained with
+    static constexpr uint32_t mfcc_window_ms = 30;
+    static constexpr uint32_t mfcc_hop_ms = 10;
+    static constexpr uint32_t mfcc_bands = 40;
+    static constexpr uint32_t mfcc_coefficients = 40;
+    static constexpr uint32_t model_input_frames = 49;    // Fewer: streaming model
+    static constexpr uint32_t model_input_features = 40;
+
+    // Panel and LVGL draw buffers
+    static constexpr uint16_t display_width = 412;
+    static constexpr uint16_t display_height = 412;
+    static constexpr uint16_t draw_buffer_lines = 42;
+
+    // Task map: capture + MFCC on one core, inference on the other
+    static constexpr TaskSlot capture = {0, 10, 6144};
+    static constexpr TaskSlot inference = {1, 9, 8192};
+    static constexpr TaskSlot uplink = {1, 8, 8192};
+    static constexpr TaskSlot playback = {1, 10, 4096};
+};
+
+/**
+ * Compile-time node profile
+ *
+ * Checks a node spec against itself and against what the common code is
+ * built for: the MFCC tables (MFCCFrontend's constants), the capture
+ * frame sizes AudioManager accepts, the task ordering the pipeline relies
+ * on, and the DMA region of the MemoryPlan. Any mismatch is a build error
+ * instead of an initialize() failure on the device. apply() then copies
+ * the spec into the runtime config structs, leaving their other fields
+ * alone.
+ *
+ * The model itself is a blob read at runtime, so KeywordModel still
+ * checks its input tensor. It now checks against the shape declared
+ * here, through WakeWordConfig::model_input_frames.
+ */
+template <typename Spec>
+struct NodeProfile {
+    static constexpr uint32_t frame_samples = Spec::sample_rate * Spec::frame_ms / 1000;
+    static constexpr uint32_t frame_bytes = frame_samples * Spec::channels * Spec::bits_per_sample / 8;
+    static constexpr uint32_t model_input_elements = Spec::model_input_frames * Spec::model_input_features;
+    static constexpr size_t draw_buffer_bytes =
+        static_cast<size_t>(Spec::display_width) * Spec::draw_buffer_lines * 2;  // RGB565
+
+    // Capture format
+    static_assert(Spec::channels == 1 && Spec::bits_per_sample == 16,
+                  "Capture frames are mono int16_t");
+    static_assert(Spec::frame_ms == 10 || Spec::frame_ms == 20 || Spec::frame_ms == 30,
+                  "Capture frames are 10, 20 or 30 ms");
+    static_assert(Spec::sample_rate * Spec::frame_ms % 1000 == 0,
+                  "A capture frame must be a whole number of samples");
+
+    // Features: the frontend's window, filterbank and DCT tables are built for one geometry
+    static_assert(Spec::sample_rate == MFCCFrontend::SAMPLE_RATE,
+                  "Sample rate differs from the MFCC frontend's");
+    static_assert(Spec::mfcc_window_ms == MFCCFrontend::WINDOW_SIZE_MS &&
+                  Spec::mfcc_hop_ms == MFCCFrontend::HOP_SIZE_MS,
+                  "MFCC window or hop differs from the frontend's");
+    static_assert(Spec::mfcc_bands == MFCCFrontend::N_MELS &&
+                  Spec::mfcc_coefficients == MFCCFrontend::N_MFCC,
+                  "MFCC band or coefficient count differs from the frontend's");
+
+    // Model input: whole MFCC frames, at most one feature window
+    static_assert(Spec::model_input_features == Spec::mfcc_coefficients,
+                  "Model input features must be the MFCC coefficients");
+    static_assert(Spec::model_input_frames >= 1 && model_input_elements <= MFCCFrontend::FEATURE_SIZE,
+                  "Model input must be 1 to N_FRAMES MFCC frames");
+
+    // Tasks
+    static_assert(Spec::capture.core < 0 || Spec::capture.core != Spec::inference.core,
+                  "MFCC (capture core) and inference must run on different cores");
+    static_assert(Spec::capture.priority > Spec::inference.priority &&
+                  Spec::capture.priority > Spec::uplink.priority,
+                  "Capture must preempt inference and the uplink: a late I2S read drops audio");
+    static_assert(Spec::capture.priority < configMAX_PRIORITIES &&
+                  Spec::inference.priority < configMAX_PRIORITIES &&
+                  Spec::uplink.priority < configMAX_PRIORITIES &&
+                  Spec::playback.priority < configMAX_PRIORITIES,
+                  "Task priority out of range");
+
+    // DMA region: the largest capture frame pool, its drain frame and both draw buffers
+    static_assert(Spec::draw_buffer_lines >= 1 && Spec::draw_buffer_lines <= Spec::display_height,
+                  "Draw buffer lines out of range");
+    static_assert((AudioFramePool::MAX_FRAMES + 1) * frame_bytes + 2 * draw_buffer_bytes <=
+                  MemoryPlan::DMA_BUDGET,
+                  "Capture frames and draw buffers exceed MemoryPlan::DMA_BUDGET");
+
+    static void apply(AudioConfig& config) {
+        config.sample_rate = Spec::sample_rate;
+        config.channels = Spec::channels;
+        config.bits_per_sample = Spec::bits_per_sample;
+        config.frame_ms = Spec::frame_ms;
+        config.frame_size = frame_samples;
+        config.buffer_count = Spec::dma_buffers;
+        config.capture_core = Spec::capture.core;
+        config.capture_priority = Spec::capture.priority;
+        config.capture_stack_size = Spec::capture.stack_size;
+        config.playback_core = Spec::playback.core;
+        config.playback_priority = Spec::playback.priority;
+        config.playback_stack_size = Spec::playback.stack_size;
+    }
+
+    static void apply(WakeWordConfig& config) {
+        config.model_input_frames = Spec::model_input_frames;
+        config.inference_core = Spec::inference.core;
+        config.inference_priority = Spec::inference.priority;
+        config.inference_stack_size = Spec::inference.stack_size;
+    }
+
+    static void apply(NetworkConfig& config) {
+        config.uplink_core = Spec::uplink.core;
+        config.uplink_priority = Spec::uplink.priority;
+        config.uplink_stack_size = Spec::uplink.stack_size;
+    }
+
+    static void apply(UIConfig& config) {
+        config.display_width = Spec::display_width;
+        config.display_height = Spec::display_height;
+        config.draw_buffer_lines = Spec::draw_buffer_lines;
+    }
+};
+
+} // namespace irene
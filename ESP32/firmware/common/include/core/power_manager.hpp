@@ -0,0 +1,75 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "esp_pm.h"
+#include <cstdint>
+
+namespace irene {
+
+/**
+ * Clock scaling and light sleep for the always-listening path (esp_pm)
+ *
+ * initialize() enables dynamic frequency scaling between
+ * PowerConfig::min_cpu_mhz and max_cpu_mhz, plus automatic light sleep.
+ * When no PowerLock is held, the CPUs drop to the minimum clock and sit in
+ * the idle task between the 20 ms I2S DMA interrupts. Tickless idle skips
+ * the tick interrupts in between, and whenever no driver lock is held the
+ * chip light-sleeps until the next interrupt. While capture runs, the I2S
+ * driver keeps its own APB lock, so the chip stays out of light sleep but
+ * still runs at the 80 MHz APB clock instead of 240 MHz.
+ *
+ * The work that needs the full clock holds a PowerLock: each MFCC burst and
+ * inference pass of the wake word detector (with the cascade they only run
+ * while its gate is open), and the StateMachine from ARBITRATING through
+ * STREAMING. Taking a lock switches the clock within microseconds, so the
+ * backfill that the opening gate replays already runs at full speed.
+ *
+ * Builds without CONFIG_PM_ENABLE keep the boot clock; initialize() logs
+ * it, and PowerLock calls do nothing.
+ */
+class PowerManager {
+public:
+    // Once, before the components that take PowerLocks
+    static ErrorCode initialize(const PowerConfig& config);
+
+    // Clock scaling is configured
+    static bool is_active();
+};
+
+/**
+ * Named hold on the full CPU clock
+ * acquire()/release() nest, counted by esp_pm; hold() is the idempotent
+ * form for a condition such as "gate open". One owning task per lock.
+ */
+class PowerLock {
+public:
+    explicit PowerLock(const char* name);
+    ~PowerLock();
+
+    PowerLock(const PowerLock&) = delete;
+    PowerLock& operator=(const PowerLock&) = delete;
+
+    void acquire();
+    void release();
+    void hold(bool on);
+    bool is_held() const { return held_; }
+
+    // Full clock for the enclosing scope
+    class Scope {
+    public:
+        explicit Scope(PowerLock& lock) : lock_(lock) { lock_.acquire(); }
+        ~Scope() { lock_.release(); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PowerLock& lock_;
+    };
+
+private:
+    esp_pm_lock_handle_t handle_;  // nullptr without power management
+    bool held_;
+};
+
+} // namespace irene
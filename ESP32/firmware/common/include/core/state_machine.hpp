@@ -1,19 +1,46 @@
 #pragma once
 
 #include "types.hpp"
+#include "power_manager.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include <atomic>
 #include <functional>
 #include <memory>
 
 namespace irene {
 
 class AudioManager;
-class NetworkManager; 
+class NetworkManager;
+class OTAManager;
 class UIController;
 class WakeWordDetector;
 
 /**
  * Main state machine that coordinates all firmware components
  * Implements the state transitions defined in the specification
+ *
+ * The state machine is an actor: the on_*() handlers and post_event() only
+ * queue an event, from any task or (post_event_from_isr) an ISR, and run()
+ * handles them one at a time in the task that calls it. State timeouts are
+ * FreeRTOS software timers that post events as well, so the owning task
+ * sleeps until something happens and current_state_ has a single writer.
+ *
+ * With NetworkConfig::wake_arbitration a wake word does not stream at once:
+ * the node bids and waits in ARBITRATING while the history keeps filling,
+ * then streams the back buffer plus the wait if the server picks it, or
+ * returns to IDLE_LISTENING if another node won. Push-to-talk skips the bid.
+ *
+ * initialize() only brings up what listening needs: audio capture and the
+ * wake word detector, so a node is listening well within a second of power
+ * returning. Network (Wi-Fi, TLS, the WebSocket connect) with OTA, and the
+ * UI, are built by two bring-up tasks on the core opposite capture; each
+ * posts NETWORK_READY / UI_READY and run() adopts the component then. Until
+ * the network is adopted a wake word is dropped. The model sanity checks
+ * run only with WakeWordConfig::sanity_checks or on the first boot of a new
+ * firmware image.
  */
 class StateMachine {
 public:
@@ -23,18 +50,27 @@ public:
     StateMachine();
     ~StateMachine();
 
-    // Initialize all components
+    // Bring up audio and the wake word (model_data: the node's wake word
+    // model), then start the network and UI in the background
     ErrorCode initialize(const AudioConfig& audio_cfg,
                         const NetworkConfig& network_cfg,
                         const WakeWordConfig& ww_cfg,
                         const UIConfig& ui_cfg,
-                        const TLSConfig& tls_cfg);
+                        const TLSConfig& tls_cfg,
+                        const uint8_t* ww_model_data = nullptr,
+                        size_t ww_model_size = 0);
 
-    // Main state machine loop (called from main task)
+    // Main state machine loop (called from main task): blocks until an
+    // event arrives, then handles everything queued
     void run();
 
-    // Event handlers
-    void on_wake_word_detected();
+    // Queue an event for run(); false when the queue is full
+    bool post_event(SystemEvent event, int32_t payload = 0);
+    bool post_event_from_isr(SystemEvent event, int32_t payload,
+                             BaseType_t* higher_priority_task_woken);
+
+    // Event handlers (queue only, safe from any task)
+    void on_wake_word_detected(float confidence = 1.0f);
     void on_voice_activity_detected(bool active);
     void on_stream_connected();
     void on_stream_disconnected();
@@ -44,11 +80,11 @@ public:
     void on_ota_event(SystemEvent event, int progress = 0);
 
     // State queries
-    SystemState get_current_state() const { return current_state_; }
-    bool is_streaming() const { return current_state_ == SystemState::STREAMING; }
-    bool is_listening() const { return current_state_ == SystemState::IDLE_LISTENING; }
+    SystemState get_current_state() const { return current_state_.load(std::memory_order_acquire); }
+    bool is_streaming() const { return get_current_state() == SystemState::STREAMING; }
+    bool is_listening() const { return get_current_state() == SystemState::IDLE_LISTENING; }
 
-    // Callbacks
+    // Callbacks (invoked from the run() task)
     void set_state_change_callback(StateChangeCallback callback);
     void set_event_callback(EventCallback callback);
 
@@ -56,37 +92,107 @@ public:
     void trigger_push_to_talk();
     void trigger_cooldown();
 
+    // Statistics
+    uint32_t get_dropped_event_count() const { return dropped_events_.load(std::memory_order_relaxed); }
+
 private:
+    struct Event {
+        SystemEvent event;
+        int32_t payload;
+    };
+
+    // One-shot software timer; stale expiries are filtered by generation
+    struct StateTimer {
+        TimerHandle_t handle = nullptr;
+        uint32_t armed = 0;              // Timer service task: generation of the running period
+        uint32_t generation = 0;         // run() task: bumped on every arm and cancel
+        bool pending = false;            // run() task: armed, expiry not yet consumed
+    };
+
+    void dispatch(const Event& event);
     void transition_to(SystemState new_state);
     void handle_state_timeout();
     void update_ui_for_state();
+    void setup_audio_callbacks();
+    void setup_network_callbacks();
     
-    // State handlers
+    // Background bring-up (posts NETWORK_READY / UI_READY) and adoption in run()
+    ErrorCode start_bring_up(BaseType_t core);
+    static void network_bring_up_task(void* arg);
+    static void ui_bring_up_task(void* arg);
+    void handle_network_ready(ErrorCode result);
+    void handle_ui_ready(ErrorCode result);
+    void finish_bring_up();
+
+    // Event handlers (run() task only)
+    void handle_wake_word(float confidence, bool arbitrate);
+    void handle_arbitration_result(bool won);
+    void begin_streaming(uint32_t preroll_ms);
+    void handle_voice_activity(bool active);
+    void handle_stream_connected();
+    void handle_stream_disconnected();
+    void handle_tls_error();
+    void handle_wifi_disconnected();
+    void handle_wifi_connected();
+    void handle_ota(SystemEvent event, int progress);
+
+    // State entry actions
     void handle_idle_listening();
+    void handle_arbitrating();
     void handle_streaming();
     void handle_cooldown();
     void handle_wifi_retry();
     void handle_error();
 
-    SystemState current_state_;
+    // Timers
+    void arm_timer(StateTimer& timer, uint32_t timeout_ms);
+    void cancel_timer(StateTimer& timer);
+    static bool consume_expiry(StateTimer& timer, int32_t payload);
+    static bool is_pending(const StateTimer& timer);
+    static void stamp_generation(void* timer, uint32_t generation);
+    static void timer_callback(TimerHandle_t handle);
+
+    std::atomic<SystemState> current_state_;
     uint32_t state_entry_time_;
-    
+
+    // Event queue
+    QueueHandle_t event_queue_;
+    std::atomic<uint32_t> dropped_events_;
+    StateTimer state_timer_;
+    StateTimer silence_timer_;
+
     // Component managers
     std::unique_ptr<AudioManager> audio_manager_;
     std::unique_ptr<NetworkManager> network_manager_;
     std::unique_ptr<UIController> ui_controller_;
     std::unique_ptr<WakeWordDetector> wake_word_detector_;
+    std::unique_ptr<OTAManager> ota_manager_;
+    
+    // Built by the bring-up tasks, handed over through the event queue
+    std::unique_ptr<NetworkManager> pending_network_;
+    std::unique_ptr<OTAManager> pending_ota_;
+    std::unique_ptr<UIController> pending_ui_;
+    TaskHandle_t network_bring_up_handle_;
+    std::atomic<NetworkManager*> capture_network_;  // network_manager_, published for the capture task
+    uint8_t bring_ups_pending_;  // run() task only
+    
+    // Full clock from ARBITRATING through STREAMING
+    PowerLock session_lock_;
 
     // Callbacks
     StateChangeCallback state_change_callback_;
     EventCallback event_callback_;
 
     // Timing
-    uint32_t silence_start_time_;
     uint32_t stream_start_time_;
+    uint32_t arbitration_start_time_;
     bool voice_detected_;
-    
+
     // Configuration
     WakeWordConfig ww_config_;
     NetworkConfig network_config_;
-}; 
\ No newline at end of file
+    NetworkConfig uplink_config_;  // network_config_ with the pre-roll sized uplink
+    UIConfig ui_config_;
+    TLSConfig tls_config_;
+};
+} // namespace irene
@@ -5,63 +5,152 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace irene {
 
+class JsonWriter;
+
+// Per-task runtime figures from one profiling period
+struct TaskMetrics {
+    char name[configMAX_TASK_NAME_LEN];
+    int8_t core;                  // -1 = no affinity
+    uint8_t priority;
+    uint8_t state;                // eTaskState
+    bool managed;                 // Created through TaskManager
+    float cpu_percent;            // Of one core over the last period
+    uint32_t stack_size;          // Bytes, 0 when not managed
+    uint32_t stack_free_min;      // Bytes, high-water mark
+};
+
+// Heap figures for one capability class
+struct HeapMetrics {
+    uint32_t free_bytes;
+    uint32_t total_bytes;
+    uint32_t largest_free_block;
+    uint32_t minimum_free_bytes;  // Since boot
+};
+
+// One profiling sample of the whole system
+struct SystemMetrics {
+    static constexpr size_t MAX_TASKS = 32;
+    static constexpr size_t MAX_CORES = 2;
+
+    uint32_t timestamp_ms = 0;
+    uint32_t period_ms = 0;
+    float core_load_percent[MAX_CORES] = {};  // 100 - IDLE task share
+    HeapMetrics heap_internal = {};
+    HeapMetrics heap_psram = {};
+    HeapMetrics heap_dma = {};
+    size_t task_count = 0;
+    TaskMetrics tasks[MAX_TASKS] = {};
+    bool cpu_stats_available = false;       // Needs FreeRTOS run-time stats
+};
+
 /**
  * Task management and coordination for the firmware
  * Handles FreeRTOS task creation, monitoring, and cleanup
+ *
+ * Every firmware task is created through the shared instance(), so the
+ * profiler can attribute stack use against the configured size. The
+ * profiler samples FreeRTOS run-time stats (CONFIG_FREERTOS_USE_TRACE_FACILITY
+ * and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS) every period for all tasks,
+ * including system ones, plus heap by capability; get_metrics() returns
+ * the latest sample and metrics_to_json() is the upstream form.
  */
 class TaskManager {
 public:
     using TaskFunction = std::function<void()>;
-    
+
     TaskManager();
     ~TaskManager();
-    
+
+    // Shared instance used by all components
+    static TaskManager& instance();
+
     // Task creation
     ErrorCode create_task(const std::string& name,
                          TaskFunction task_func,
                          uint32_t stack_size,
                          UBaseType_t priority,
-                         BaseType_t core_id = tskNO_AFFINITY);
-    
+                         BaseType_t core_id = tskNO_AFFINITY,
+                         TaskHandle_t* handle_out = nullptr);
+
+    // Plain FreeRTOS entry point (static wrapper + arg); the task may end
+    // itself with delete_task(nullptr)
+    ErrorCode create_task(const std::string& name,
+                         TaskFunction_t entry,
+                         void* arg,
+                         uint32_t stack_size,
+                         UBaseType_t priority,
+                         BaseType_t core_id,
+                         TaskHandle_t* handle_out);
+
     // Task control
     void delete_task(const std::string& name);
+    void delete_task(TaskHandle_t handle);  // nullptr = calling task, does not return
     void suspend_task(const std::string& name);
     void resume_task(const std::string& name);
-    
+
     // Task monitoring
     bool is_task_running(const std::string& name) const;
     uint32_t get_task_stack_free(const std::string& name) const;
     UBaseType_t get_task_priority(const std::string& name) const;
-    
+
     // System monitoring
     void print_task_list() const;
     void print_heap_stats() const;
     uint32_t get_free_heap_size() const;
     uint32_t get_minimum_free_heap_size() const;
-    
+
+    // Profiling
+    ErrorCode start_profiling(uint32_t period_ms);
+    void stop_profiling();
+    bool get_metrics(SystemMetrics& metrics) const;  // false before the first sample
+    static bool metrics_to_json(const SystemMetrics& metrics, JsonWriter& json);  // false: did not fit
+
     // Cleanup
     void cleanup_all_tasks();
 
 private:
     struct TaskInfo {
+        TaskManager* owner;
         std::string name;
         TaskHandle_t handle;
         TaskFunction function;
+        TaskFunction_t entry;
+        void* arg;
         uint32_t stack_size;
         UBaseType_t priority;
         BaseType_t core_id;
         bool is_running;
     };
-    
+
+    // Run-time counter of one task at the previous sample
+    struct RuntimeSample {
+        TaskHandle_t handle;
+        uint32_t runtime;
+    };
+
+    ErrorCode spawn(std::unique_ptr<TaskInfo> info, TaskHandle_t* handle_out);
+    void forget_task(TaskHandle_t handle);
+    void profiler_task();
+    void sample_metrics();
+    static void fill_heap_metrics(uint32_t caps, HeapMetrics& metrics);
     static void task_wrapper(void* param);
-    
-    std::vector<TaskInfo> tasks_;
+
+    std::vector<std::unique_ptr<TaskInfo>> tasks_;
     SemaphoreHandle_t tasks_mutex_;
+
+    // Profiler (profiler task only, except the published sample)
+    TaskHandle_t profiler_handle_;
+    uint32_t profile_period_ms_;
+    std::vector<RuntimeSample> last_runtime_;
+    uint32_t last_total_runtime_;
+    SystemMetrics metrics_;           // Guarded by tasks_mutex_
+    bool metrics_valid_;
 };
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
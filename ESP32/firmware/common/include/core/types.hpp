@@ -11,7 +11,14 @@ enum class SystemState {
     STREAMING,
     COOLDOWN,
     WIFI_RETRY,
-    ERROR
+    ERROR,
+    ARBITRATING     // Wake word heard, waiting for the server to pick one node
+};
+
+// Voice activity detection: fixed threshold, or tracked noise floor
+enum class VADMode : uint8_t {
+    ENERGY,    // RMS/ZCR against a fixed threshold
+    ADAPTIVE   // Per-band SNR over a minimum-statistics noise floor, from the MFCC mel energies
 };
 
 // Audio configuration
@@ -19,8 +26,94 @@ struct AudioConfig {
     uint32_t sample_rate = 16000;
     uint8_t channels = 1;
     uint8_t bits_per_sample = 16;
-    uint32_t frame_size = 320;  // 20ms at 16kHz
-    uint32_t buffer_count = 8;
+    uint32_t frame_ms = 20;     // Capture granularity: 10, 20 or 30 ms
+    uint32_t frame_size = 320;  // Samples per frame, derived from frame_ms at init
+    uint32_t buffer_count = 8;  // DMA buffers, one frame each
+    uint32_t history_ms = 300;  // Shared capture history, at least the 300 ms back buffer
+    
+    // Voice activity detection
+    VADMode vad_mode = VADMode::ADAPTIVE;  // Falls back to ENERGY while no mel energies arrive
+    uint32_t vad_idle_hangover_ms = 200;   // Silence before speech is reported over, while idle
+    uint32_t vad_stream_hangover_ms = 300; // ... and while streaming (bridges pauses in a phrase)
+    
+    // Capture stage (I2S read, VAD, wake word gate + MFCC)
+    int8_t capture_core = 0;          // -1 = no affinity
+    uint8_t capture_priority = 10;
+    uint32_t capture_stack_size = 6144;
+    
+    // Downlink playback: server audio (TTS) -> jitter buffer -> I2S TX
+    bool playback_enabled = true;
+    uint32_t playback_prebuffer_ms = 120;     // Queued before a stream starts playing
+    uint32_t playback_buffer_ms = 2000;       // Jitter buffer capacity
+    uint32_t playback_message_bytes = 4096;   // Largest downlink audio message
+    int8_t playback_core = 1;         // -1 = no affinity
+    uint8_t playback_priority = 10;
+    uint32_t playback_stack_size = 4096;
+    
+    // Barge-in: echo-cancel the mic against the TX samples so the wake word
+    // can interrupt playback; off, detections during playback are ignored
+    bool barge_in_enabled = true;
+    uint32_t aec_filter_taps = 128;           // Echo tail covered, 8 ms at 16 kHz
+};
+
+// What the audio uplink does when the network falls behind capture
+enum class UplinkOverflowPolicy : uint8_t {
+    DROP_OLDEST,   // Keep the newest audio
+    DROP_NEWEST,   // Keep what is already queued
+    BLOCK          // Wait up to uplink_block_timeout_ms, then drop the newest
+};
+
+// Uplink audio encoding, announced in the session config message
+enum class AudioCodec : uint8_t {
+    PCM16,      // Raw 16-bit PCM, 256 kbps at 16 kHz
+    IMA_ADPCM,  // 4:1, 64 kbps
+    OPUS        // 16-24 kbps, needs an Opus build; falls back to IMA-ADPCM
+};
+
+// Wi-Fi power save while the radio is otherwise idle
+enum class WiFiPowerProfile : uint8_t {
+    PERFORMANCE,  // WIFI_PS_NONE, lowest latency
+    BALANCED,     // WIFI_PS_MIN_MODEM, wake every DTIM
+    LOW_POWER     // WIFI_PS_MAX_MODEM, wake every wifi_listen_interval beacons
+};
+
+// Last good association, cached in NVS for a directed reconnect
+struct WiFiConnectCache {
+    uint32_t credentials_hash = 0;  // SSID + passphrase the entry was made with
+    uint8_t bssid[6] = {};
+    uint8_t channel = 0;
+    bool pmk_valid = false;         // WPA/WPA2-PSK only
+    uint8_t pmk[32] = {};
+};
+
+// Measured TFLite tensor arena need, cached in NVS per model
+struct TensorArenaRecord {
+    uint32_t model_hash = 0;        // FNV-1a over the model flatbuffer
+    uint32_t model_size = 0;
+    uint32_t used_bytes = 0;        // arena_used_bytes() after AllocateTensors
+};
+
+// Streaming delta patch decoder position (see DeltaPatcher)
+struct DeltaPatchState {
+    uint8_t stage = 0;
+    uint8_t pending_length = 0;     // Header bytes assembled in pending
+    uint8_t pending[48] = {};       // Patch header, then each op header
+    uint8_t source_sha256[32] = {}; // Image the patch applies to
+    uint32_t source_size = 0;
+    uint32_t target_size = 0;
+    uint32_t written = 0;           // Target bytes produced
+    uint32_t op_remaining = 0;      // INSERT bytes still to come
+};
+
+// Interrupted firmware download, checkpointed in NVS
+struct OTAResumeRecord {
+    uint32_t url_hash = 0;          // FNV-1a over the image URL
+    uint32_t partition_address = 0; // Update partition being written
+    uint32_t image_size = 0;        // Download size (the patch for delta images)
+    uint32_t received = 0;          // Download bytes consumed
+    char etag[48] = {};             // Server validator, sent back as If-Range
+    bool delta = false;
+    DeltaPatchState patch;
 };
 
 // Network configuration
@@ -31,14 +124,71 @@ struct NetworkConfig {
     std::string node_id;
     uint32_t reconnect_delay_ms = 5000;
     uint32_t max_retry_count = 10;
+    
+    // Wi-Fi association and power save
+    bool wifi_fast_reconnect = true;   // Directed connect from the cached BSSID/channel/PMK
+    WiFiPowerProfile wifi_idle_profile = WiFiPowerProfile::LOW_POWER;  // While IDLE_LISTENING
+    uint8_t wifi_listen_interval = 3;  // Beacons, LOW_POWER only
+    uint32_t wifi_ip_timeout_ms = 10000;  // connect() waits this long for an address
+    
+    // Connection warm-up: keep the TLS WebSocket open between utterances
+    bool keep_warm = true;
+    uint32_t keepalive_ping_ms = 15000;      // Idle ping, 0 = off
+    uint32_t session_connect_wait_ms = 1500; // A session waits this long for a handshake in flight
+    
+    // Multi-node wake arbitration: bid first, stream only if the server picks this node
+    bool wake_arbitration = true;
+    uint32_t arbitration_timeout_ms = 250;   // No verdict by then: stream anyway
+    
+    // Audio uplink (capture -> network task)
+    uint32_t uplink_queue_depth = 12;  // Frames, 240ms at 20ms
+    UplinkOverflowPolicy uplink_overflow_policy = UplinkOverflowPolicy::DROP_OLDEST;
+    uint32_t uplink_block_timeout_ms = 5;
+    uint32_t uplink_preroll_frames = 30;  // Extra slots for the wake word pre-roll, 300ms at 10ms
+    uint32_t uplink_batch_ms = 60;     // Audio per WebSocket message, 0 = one frame each
+    uint32_t uplink_batch_bytes = 0;   // Flush early at this size, 0 = window only
+    AudioCodec uplink_codec = AudioCodec::PCM16;
+    uint32_t uplink_opus_bitrate = 24000;
+    int8_t uplink_core = 1;            // -1 = no affinity
+    uint8_t uplink_priority = 8;
+    uint32_t uplink_stack_size = 8192;
+    
+    // Background firmware download, held while STREAMING or playing a reply
+    uint32_t ota_rate_limit = 65536;         // Bytes/s, 0 = unthrottled
+    uint32_t ota_checkpoint_bytes = 65536;   // Resume point saved to NVS this often
 };
 
 // Wake word configuration
 struct WakeWordConfig {
     float threshold = 0.9f;
-    uint32_t trigger_duration_ms = 450;
+    uint32_t smoothing_ms = 150;    // Posterior moving average before peak picking
+    uint32_t refractory_ms = 1000;  // No second detection this soon after one
+    float prearm_threshold = 0.5f;  // Warm the connection up from this confidence, 0 = off
     uint32_t back_buffer_ms = 300;
     bool use_psram = true;
+    bool int8_frontend = true;  // MFCC frontend quantizes straight into INT8 model input
+    bool vad_cascade = true;    // Run MFCC + inference only while the energy/ZCR gate is open
+    uint32_t cascade_hangover_ms = 1000;  // Keep the gate open after the last voiced frame
+    uint32_t cascade_backfill_ms = 510;   // Audio replayed on gate open (one 49x40 window)
+    uint32_t arena_margin_bytes = 2048;       // Headroom over the measured tensor arena need
+    uint32_t arena_internal_reserve = 65536;  // Internal RAM left free when placing the arena there
+    bool sanity_checks = false;   // Model checklist and a zero-input inference at startup
+    uint32_t model_input_frames = 0;  // Wake word model input, from the node profile; 0 = any
+    
+    // Inference stage (TFLite invoke), normally opposite the capture core
+    int8_t inference_core = 1;        // -1 = no affinity
+    uint8_t inference_priority = 9;
+    uint32_t inference_stack_size = 8192;
+};
+
+// Extra keyword ("stop", "cancel", ...) scored beside the wake word
+struct KeywordConfig {
+    const char* name = "";                // Static string, used in logs and callbacks
+    float threshold = 0.9f;
+    uint32_t smoothing_ms = 0;            // Posterior moving average, 0 = raw score
+    uint32_t refractory_ms = 1000;        // No second detection this soon after one
+    uint8_t priority = 0;                 // Higher is scored first when the inference budget is short
+    uint32_t input_frames = 0;            // Expected model input in MFCC frames, 0 = any
 };
 
 // UI configuration
@@ -48,6 +198,25 @@ struct UIConfig {
     uint8_t brightness = 80;
     uint32_t idle_timeout_ms = 30000;
     bool show_debug_info = false;
+    
+    // Panel on SPI through esp_lcd; -1 = not wired
+    uint8_t display_spi_host = 1;      // SPI2_HOST
+    int8_t display_mosi_io = 11;
+    int8_t display_sclk_io = 12;
+    int8_t display_cs_io = 10;
+    int8_t display_dc_io = 13;
+    int8_t display_rst_io = 14;
+    int8_t display_backlight_io = 15;
+    uint32_t display_pclk_hz = 40000000;
+    uint16_t draw_buffer_lines = 42;   // Per LVGL draw buffer (two, DMA-capable): ~1/10 screen
+};
+
+// Power management (esp_pm), applied by PowerManager::initialize()
+struct PowerConfig {
+    bool low_power_listening = true;  // Scale the clock down while nothing needs it
+    uint16_t max_cpu_mhz = 240;       // Under a PowerLock: MFCC, inference, sessions
+    uint16_t min_cpu_mhz = 40;        // Otherwise; I2S capture holds APB, so 80 in practice
+    bool light_sleep = true;          // When no lock is held; needs tickless idle
 };
 
 // TLS configuration
@@ -69,7 +238,18 @@ enum class SystemEvent {
     OTA_STARTED,
     OTA_PROGRESS,
     OTA_FINISHED,
-    OTA_ERROR
+    OTA_ERROR,
+    
+    // StateMachine internal events
+    VOICE_ACTIVITY,      // Payload: 1 = speech, 0 = silence
+    WAKE_WORD_PREARMED,
+    ARBITRATION_RESULT,  // Payload: 1 = this node won, 0 = lost
+    PUSH_TO_TALK,
+    COOLDOWN_REQUESTED,
+    STATE_TIMEOUT,       // Payload: timer generation
+    SILENCE_TIMEOUT,     // Payload: timer generation
+    NETWORK_READY,       // Payload: ErrorCode of the background bring-up
+    UI_READY             // Payload: ErrorCode of the background bring-up
 };
 
 // Error codes
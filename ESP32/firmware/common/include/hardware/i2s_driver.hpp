@@ -2,12 +2,19 @@
 
 #include "core/types.hpp"
 #include "driver/i2s.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 
 namespace irene {
 
+class EchoReference;
+
 /**
  * I2S driver for audio capture from ES8311 codec
- * Handles DMA-based audio streaming with configurable parameters
+ * Handles DMA-based audio streaming with configurable parameters.
+ * Each DMA buffer holds exactly one frame, and the driver's event queue
+ * reports every completed buffer, so capture is paced by the DMA clock.
+ * Frames written to TX can be copied to an EchoReference for the AEC.
  */
 class I2SDriver {
 public:
@@ -22,17 +29,22 @@ public:
     ErrorCode stop();
     
     // Audio I/O
-    esp_err_t read_frame(uint8_t* data, size_t length, size_t* bytes_read);
-    esp_err_t write_frame(const uint8_t* data, size_t length);
+    bool wait_for_rx(TickType_t timeout);  // Blocks until a DMA buffer completes
+    esp_err_t read_frame(uint8_t* data, size_t length, size_t* bytes_read,
+                         TickType_t timeout = portMAX_DELAY);
+    esp_err_t write_frame(const uint8_t* data, size_t length);  // Copied to the echo reference once queued
     
     // Configuration
     void set_gain(int8_t gain_db);
     void set_sample_rate(uint32_t sample_rate);
+    void set_echo_reference(EchoReference* reference) { echo_reference_ = reference; }
     
     // Status
     bool is_running() const { return is_running_; }
     uint32_t get_sample_rate() const { return sample_rate_; }
     size_t get_frame_size() const { return frame_size_; }
+    uint32_t get_rx_overflow_count() const { return rx_overflow_count_; }  // DMA overwrote an unread buffer
+    uint32_t get_dma_error_count() const { return dma_error_count_; }
 
 private:
     ErrorCode configure_i2s_pins();
@@ -46,6 +58,11 @@ private:
     uint32_t sample_rate_;
     size_t frame_size_;
     i2s_port_t i2s_port_;
+    QueueHandle_t event_queue_;
+    EchoReference* echo_reference_;
+    
+    uint32_t rx_overflow_count_;
+    uint32_t dma_error_count_;
 };
 
 } // namespace irene 
\ No newline at end of file
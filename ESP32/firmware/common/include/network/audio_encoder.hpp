@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace irene {
+
+/**
+ * Uplink audio encoder
+ * Turns one batch of 16-bit PCM into one WebSocket message payload. Each
+ * payload decodes on its own, so a dropped message never corrupts the
+ * next one. Encoders hold no per-call allocations.
+ */
+class AudioEncoder {
+public:
+    virtual ~AudioEncoder() = default;
+
+    // Encode samples into out; returns payload bytes, 0 on error
+    virtual size_t encode(const int16_t* pcm, size_t samples, uint8_t* out, size_t out_capacity) = 0;
+
+    // Worst-case payload size for a batch of samples
+    virtual size_t max_encoded_bytes(size_t samples) const = 0;
+
+    // Start a new stream (new session)
+    virtual void reset() {}
+
+    virtual AudioCodec codec() const = 0;
+};
+
+/**
+ * Downlink audio decoder
+ * The inverse of AudioEncoder for one WebSocket message payload of the
+ * same framing; like the encoders it holds no per-call allocations.
+ */
+class AudioDecoder {
+public:
+    virtual ~AudioDecoder() = default;
+
+    // Decode payload into pcm; returns samples, 0 on a malformed payload
+    virtual size_t decode(const uint8_t* payload, size_t bytes, int16_t* pcm, size_t max_samples) = 0;
+
+    // Largest number of samples a payload of bytes can produce
+    virtual size_t max_decoded_samples(size_t bytes) const = 0;
+
+    // Start a new stream
+    virtual void reset() {}
+
+    virtual AudioCodec codec() const = 0;
+};
+
+// Codec name used in the session config JSON ("pcm16", "ima_adpcm", "opus")
+const char* audio_codec_name(AudioCodec codec);
+bool audio_codec_from_name(std::string_view name, AudioCodec& codec);
+
+// Codec actually used for a request (Opus downgrades when not compiled in)
+AudioCodec resolve_audio_codec(AudioCodec requested);
+
+// Build an encoder; falls back to IMA-ADPCM when Opus is not compiled in
+std::unique_ptr<AudioEncoder> create_audio_encoder(AudioCodec codec, uint32_t sample_rate, uint32_t bitrate);
+
+// Build a decoder; nullptr when the codec is not compiled in
+std::unique_ptr<AudioDecoder> create_audio_decoder(AudioCodec codec, uint32_t sample_rate);
+
+} // namespace irene
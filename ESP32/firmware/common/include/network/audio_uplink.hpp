@@ -0,0 +1,141 @@
+#pragma once
+
+#include "core/types.hpp"
+#include "audio/audio_frame_pool.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace irene {
+
+class AudioEncoder;
+
+/**
+ * Audio uplink statistics
+ */
+struct UplinkStats {
+    uint32_t enqueued;
+    uint32_t sent;              // Frames
+    uint32_t messages;          // WebSocket messages (batches)
+    uint32_t preroll;           // Back-buffer frames sent ahead of live audio
+    uint32_t dropped_oldest;
+    uint32_t dropped_newest;
+    uint32_t send_failures;
+    uint32_t pcm_bytes;         // Before encoding
+    uint32_t encoded_bytes;     // On the wire
+    uint32_t depth;             // Frames waiting right now
+    uint32_t high_water;        // Deepest the queue has been
+    uint32_t last_latency_us;   // Oldest frame in a batch, capture to send complete
+    uint32_t max_latency_us;
+    uint32_t avg_latency_us;    // Per message
+};
+
+/**
+ * Bounded queue between capture and the WebSocket
+ * The capture task enqueues frame refs (no copy, no allocation: frames
+ * stay in the capture pool) and a dedicated network task sends them, so a
+ * Wi-Fi stall fills the queue instead of stalling capture.
+ *
+ * Frames are aggregated into one binary message per batch window (or byte
+ * threshold) so the stream costs a few TLS records per second instead of
+ * one per frame. drain() flushes the partial batch at end of utterance.
+ * The wake word pre-roll rides the same queue as refs lent from the
+ * capture back buffer, in slots of its own so it never pushes out live audio.
+ * Each batch is encoded (PCM, IMA-ADPCM or Opus) in this task, on core 1,
+ * into a buffer allocated once at startup.
+ */
+class AudioUplink {
+public:
+    using SendCallback = std::function<ErrorCode(const uint8_t* data, size_t length)>;
+    
+    static constexpr uint32_t kStreamSampleRate = 16000;  // PCM rate announced to the server
+
+    AudioUplink();
+    ~AudioUplink();
+
+    // Non-copyable
+    AudioUplink(const AudioUplink&) = delete;
+    AudioUplink& operator=(const AudioUplink&) = delete;
+
+    // Create the queue and start the network task
+    ErrorCode initialize(const NetworkConfig& config, SendCallback send);
+
+    // Codec for the next session; the encoder restarts at the next batch
+    void begin_session(AudioCodec codec);
+    AudioCodec get_codec() const { return static_cast<AudioCodec>(requested_codec_.load()); }
+
+    // Capture side: never waits unless the policy is BLOCK
+    bool enqueue(const AudioFrameRef& frame);
+    
+    // Capture side, once per session before live frames: queue the newest
+    // back-buffer refs into slots reserved for them; returns frames queued
+    size_t enqueue_preroll(const AudioFrameSpan& first, const AudioFrameSpan& second);
+
+    // Send everything queued plus the partial batch, then return
+    ErrorCode drain(TickType_t timeout);
+    
+    // Drop everything queued (connection lost)
+    void flush();
+
+    // Statistics
+    void get_stats(UplinkStats& stats) const;
+    uint32_t get_depth() const;
+    void reset_stats();
+
+private:
+    void uplink_task();
+    static void uplink_task_wrapper(void* arg);
+    void append_to_batch(const AudioFrameRef& frame);
+    void send_batch();
+    void prepare_encoder();
+    bool take_preroll_slot();
+
+    NetworkConfig config_;
+    SendCallback send_;
+    QueueHandle_t queue_;       // AudioFrame*, each holding one reference; nullptr = drain
+    TaskHandle_t task_handle_;
+    SemaphoreHandle_t drain_done_;
+    
+    // Batch being aggregated (uplink task only)
+    uint8_t* batch_buffer_;
+    size_t batch_capacity_;     // Bytes
+    size_t batch_threshold_;    // Bytes that trigger a send
+    size_t batch_bytes_;
+    uint32_t batch_frames_;
+    int64_t batch_first_timestamp_us_;  // Capture time of the oldest frame
+    int64_t batch_window_us_;
+    bool batch_has_preroll_;    // Old capture times, kept out of the latency stats
+    
+    // Pre-roll frames still queued; they sit ahead of every live frame
+    std::atomic<uint32_t> preroll_pending_;
+    
+    // Encoder (uplink task only) and the session it was set up for
+    std::unique_ptr<AudioEncoder> encoder_;
+    uint8_t* encode_buffer_;
+    size_t encode_capacity_;
+    std::atomic<uint8_t> requested_codec_;
+    std::atomic<uint32_t> session_generation_;
+    uint32_t encoder_generation_;
+    uint32_t traced_generation_;        // Session whose first message was traced
+
+    // Statistics
+    uint32_t enqueued_;
+    uint32_t preroll_frames_;
+    uint32_t sent_;
+    uint32_t messages_;
+    uint32_t dropped_oldest_;
+    uint32_t dropped_newest_;
+    uint32_t send_failures_;
+    uint32_t pcm_bytes_;
+    uint32_t encoded_bytes_;
+    uint32_t high_water_;
+    uint32_t last_latency_us_;
+    uint32_t max_latency_us_;
+    uint64_t total_latency_us_;
+};
+
+} // namespace irene
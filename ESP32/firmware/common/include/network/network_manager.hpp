@@ -1,24 +1,51 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "utils/memory_plan.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <string_view>
 
 namespace irene {
 
 class WiFiManager;
 class TLSManager;
 class WebSocketClient;
+class AudioUplink;
+class AudioFrameRef;
+struct AudioFrameSpan;
+struct UplinkStats;
 
 /**
  * Manages network connectivity and secure audio streaming
  * Coordinates WiFi, TLS mutual authentication, and WebSocket communication
+ *
+ * With NetworkConfig::keep_warm the authenticated WebSocket stays open
+ * between utterances (idle pings, socket-only reconnect while Wi-Fi is up),
+ * and warm_up() lets early cues (VAD onset, a wake word pre-threshold)
+ * start a handshake before the wake word is confirmed.
+ *
+ * With NetworkConfig::wake_arbitration, nodes that hear the same wake word
+ * bid before streaming: request_arbitration() sends the detection score and
+ * the peak audio level, and only the node the server picks opens an audio
+ * session. The verdict ({"arbitration":"won"|"lost"}) arrives through the
+ * arbitration callback.
  */
 class NetworkManager {
 public:
     using ConnectionCallback = std::function<void(bool connected)>;
-    using MessageCallback = std::function<void(const std::string& message)>;
+    using MessageCallback = std::function<void(std::string_view message)>;  // Valid for the call
     using ErrorCallback = std::function<void(ErrorCode error, const std::string& details)>;
+    using ArbitrationCallback = std::function<void(bool won)>;
+    // Server audio: {"tts":{...}} starts a stream (start = true), {"tts":"end"} ends it
+    using PlaybackControlCallback = std::function<void(bool start, AudioCodec codec, uint32_t sample_rate)>;
+    using PlaybackDataCallback = std::function<void(const uint8_t* data, size_t length, size_t offset, size_t total)>;
+    // Firmware update offer: {"ota":{"url":...}}
+    using OTACallback = std::function<void(std::string_view url)>;
 
     NetworkManager();
     ~NetworkManager();
@@ -29,16 +56,25 @@ public:
     // Connection management
     ErrorCode connect();
     void disconnect();
-    ErrorCode reconnect();
+    ErrorCode reconnect();  // Non-blocking, any task: the monitor task does the work
+    void warm_up();  // Non-blocking, any task: handshake now if the socket is down
+    void set_power_profile(WiFiPowerProfile profile);
 
     // Audio streaming
     ErrorCode start_audio_session(const std::string& room_id);
-    ErrorCode send_audio_data(const uint8_t* data, size_t length);
+    ErrorCode send_audio_data(const uint8_t* data, size_t length);    // Blocking, network task only
+    bool queue_audio_frame(const AudioFrameRef& frame);              // Non-blocking, any task
+    size_t queue_preroll(const AudioFrameSpan& first, const AudioFrameSpan& second);  // Before live frames
     ErrorCode end_audio_session();
+    
+    // Multi-node arbitration: bid for the session this wake word would open
+    ErrorCode request_arbitration(float confidence, float peak_level);  // Blocking
 
     // Configuration messages
     ErrorCode send_config_message(const std::string& room_id, uint32_t sample_rate);
     ErrorCode send_eof_message();
+    ErrorCode send_trace_dump();  // LatencyTrace ring, blocking
+    ErrorCode send_metrics();     // Latest TaskManager profiling sample
 
     // Status
     bool is_wifi_connected() const;
@@ -49,37 +85,62 @@ public:
 
     // Callbacks
     void set_connection_callback(ConnectionCallback callback);
+    void set_wifi_callback(ConnectionCallback callback);  // Station got an address; Wi-Fi event task
     void set_message_callback(MessageCallback callback);
     void set_error_callback(ErrorCallback callback);
+    void set_arbitration_callback(ArbitrationCallback callback);  // WebSocket task
+    void set_playback_callbacks(PlaybackControlCallback control, PlaybackDataCallback data);  // WebSocket task
+    void set_ota_callback(OTACallback callback);  // WebSocket task
 
     // Statistics
     uint32_t get_bytes_sent() const { return bytes_sent_; }
     uint32_t get_bytes_received() const { return bytes_received_; }
     uint32_t get_connection_attempts() const { return connection_attempts_; }
     uint32_t get_reconnection_count() const { return reconnection_count_; }
+    uint32_t get_warmup_count() const { return warmup_connects_; }
+    uint32_t get_arbitration_count() const { return arbitration_requests_; }
+    uint32_t get_arbitration_loss_count() const { return arbitration_losses_; }
+    void get_uplink_stats(UplinkStats& stats) const;
 
 private:
     void connection_monitor_task();
-    void handle_websocket_message(const std::string& message);
+    void handle_websocket_message(std::string_view message);
     void handle_connection_error(ErrorCode error);
+    ErrorCode connect_websocket();
+    bool wait_for_websocket(TickType_t timeout) const;
+    bool wait_for_ip(TickType_t timeout) const;
+    void run_reconnect();
+    void send_keepalive();
     static void connection_monitor_task_wrapper(void* arg);
+    void setup_callbacks();
+    void log_connection_stats() const;
 
     NetworkConfig config_;
     TLSConfig tls_config_;
-    bool audio_session_active_;
+    std::atomic<bool> audio_session_active_;  // Read by the capture task
 
     // Component managers
     std::unique_ptr<WiFiManager> wifi_manager_;
     std::unique_ptr<TLSManager> tls_manager_;
     std::unique_ptr<WebSocketClient> websocket_client_;
+    std::unique_ptr<AudioUplink> uplink_;
+    PlanArray<char> report_buffer_;     // Trace dump and metrics messages (monitor task)
 
     // Callbacks
     ConnectionCallback connection_callback_;
+    ConnectionCallback wifi_callback_;
     MessageCallback message_callback_;
     ErrorCallback error_callback_;
+    ArbitrationCallback arbitration_callback_;
+    PlaybackControlCallback playback_control_callback_;
+    PlaybackDataCallback playback_data_callback_;
+    OTACallback ota_callback_;
 
     // Task management
     TaskHandle_t monitor_task_handle_;
+    EventGroupHandle_t ws_events_;      // WS_CONNECTED_BIT mirrors the socket, WIFI_GOT_IP_BIT the address
+    std::atomic<bool> ws_connecting_;   // A handshake is in flight
+    std::atomic<bool> reconnect_requested_;  // For the monitor task: link up, or reconnect()
 
     // Statistics
     uint32_t bytes_sent_;
@@ -87,9 +148,19 @@ private:
     uint32_t connection_attempts_;
     uint32_t reconnection_count_;
     uint32_t last_reconnect_time_;
-
-    // Connection state
-    bool wifi_connected_;
-    bool websocket_connected_;
+    uint32_t last_ping_time_;
+    uint32_t warmup_requests_;
+    uint32_t warmup_connects_;
+    uint32_t keepalive_failures_;
+    uint32_t arbitration_requests_;
+    uint32_t arbitration_losses_;
+    std::atomic<bool> trace_dump_requested_;  // Server asked with {"trace_dump":1}
+    std::atomic<bool> metrics_requested_;     // Server asked with {"metrics_request":1}
+
+    // Connection state; written by the actor, the monitor and the event callbacks
+    std::atomic<bool> wifi_connected_;
+    std::atomic<bool> websocket_connected_;
     uint32_t connection_start_time_;
-}; 
\ No newline at end of file
+};
+
+} // namespace irene
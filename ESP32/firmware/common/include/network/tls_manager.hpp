@@ -1,6 +1,8 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string>
 
 namespace irene {
@@ -8,49 +10,87 @@ namespace irene {
 /**
  * TLS manager for mutual authentication with local CA
  * Handles certificate validation and secure connections
+ *
+ * Credentials are parsed once at initialize(): the CA goes into the esp-tls
+ * global CA store, and the client certificate and key are kept parsed and
+ * re-encoded as DER, so a handshake never decodes PEM again.
+ *
+ * connect() resumes the last session (ticket or session ID) when
+ * CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS is enabled, falling back to a full
+ * handshake when the server declines. The session lives in RAM, which light
+ * sleep retains, so reconnects after Wi-Fi blips or light sleep skip the
+ * ECC/RSA work.
  */
 class TLSManager {
 public:
     TLSManager();
     ~TLSManager();
-    
+
     // Initialize with certificates
     ErrorCode initialize(const TLSConfig& config);
-    
+
     // Certificate management
     ErrorCode load_ca_certificate(const char* ca_cert_pem);
     ErrorCode load_client_certificate(const char* client_cert_pem);
     ErrorCode load_client_private_key(const char* client_key_pem);
-    
+
     // Validation
     bool validate_certificates() const;
     bool is_certificate_valid(const char* cert_pem) const;
-    
+
     // TLS context for connections
     void* get_tls_context() const { return tls_context_; }
-    
+
+    // Open a TLS connection (esp_tls_t*), resuming the cached session if any;
+    // nullptr on failure. Release with close().
+    void* connect(const char* host, int port, uint32_t timeout_ms);
+    void close(void* connection);
+    void clear_session();
+    bool has_session() const { return session_ != nullptr; }
+
     // Configuration
     void set_handshake_timeout(uint32_t timeout_ms);
     void set_verify_mode(bool verify_peer);
-    
+
     // Status
     bool is_initialized() const { return initialized_; }
     const char* get_last_error() const { return last_error_.c_str(); }
 
+    // Statistics
+    uint32_t get_handshake_count() const { return handshake_count_; }
+    uint32_t get_resumption_attempts() const { return resumption_attempts_; }
+    uint32_t get_last_handshake_ms() const { return last_handshake_ms_; }
+
 private:
+    ErrorCode parse_credentials();
     ErrorCode setup_tls_context();
     void cleanup_tls_context();
-    
+
     TLSConfig config_;
     void* tls_context_;
     bool initialized_;
     uint32_t handshake_timeout_ms_;
     bool verify_peer_;
-    
+
     std::string ca_cert_;
     std::string client_cert_;
     std::string client_key_;
     std::string last_error_;
+
+    // Parsed client credentials (mbedtls_x509_crt / mbedtls_pk_context), live until cleanup
+    void* client_chain_;
+    void* client_pk_;
+    uint8_t* client_key_der_;
+    size_t client_key_der_len_;
+
+    // Resumable session (esp_tls_client_session_t), guarded by session_mutex_
+    void* session_;
+    SemaphoreHandle_t session_mutex_;
+
+    // Statistics
+    uint32_t handshake_count_;
+    uint32_t resumption_attempts_;
+    uint32_t last_handshake_ms_;
 };
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
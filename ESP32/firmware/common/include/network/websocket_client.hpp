@@ -3,6 +3,7 @@
 #include "core/types.hpp"
 #include "network/tls_manager.hpp"
 #include <string>
+#include <string_view>
 #include <functional>
 
 namespace irene {
@@ -10,10 +11,21 @@ namespace irene {
 /**
  * WebSocket client with TLS support for audio streaming
  * Handles secure WebSocket connections with mutual TLS authentication
+ *
+ * For wss the WebSocket layer runs on our own transport whose handshakes go
+ * through TLSManager::connect(), so reconnects resume the cached session
+ * and reuse the parsed credentials.
+ *
+ * Received text messages are handed over as views: straight into the
+ * client's receive buffer when a message arrives whole, or into a fixed
+ * reassembly buffer when it arrives in pieces. No message is copied to
+ * the heap.
  */
 class WebSocketClient {
 public:
-    using MessageCallback = std::function<void(const std::string& message)>;
+    using MessageCallback = std::function<void(std::string_view message)>;  // Valid for the call
+    // One piece of a binary message: length bytes at offset of total
+    using BinaryCallback = std::function<void(const uint8_t* data, size_t length, size_t offset, size_t total)>;
     using ErrorCallback = std::function<void(const std::string& error)>;
     using ConnectionCallback = std::function<void(bool connected)>;
     
@@ -29,12 +41,13 @@ public:
     void disconnect();
     
     // Send data
-    ErrorCode send_text(const std::string& message);
+    ErrorCode send_text(std::string_view message);
     ErrorCode send_binary(const uint8_t* data, size_t length);
     ErrorCode send_ping();
     
     // Callbacks
     void set_message_callback(MessageCallback callback);
+    void set_binary_callback(BinaryCallback callback);
     void set_error_callback(ErrorCallback callback);
     void set_connection_callback(ConnectionCallback callback);
     
@@ -53,15 +66,21 @@ private:
     static void websocket_event_handler(void* handler_args, esp_event_base_t base,
                                        int32_t event_id, void* event_data);
     void handle_websocket_event(int32_t event_id, void* event_data);
+    void handle_text_piece(const char* data, size_t length, size_t offset, size_t total);
+    bool create_tls_transport(TLSManager* tls_manager);
+    void destroy_tls_transport();
     
     std::string uri_;
     void* websocket_handle_;
+    void* tls_transport_;       // esp_transport over TLSManager connections
+    void* ws_transport_;        // WebSocket layer on top, lent to the client
     TLSManager* tls_manager_;
     bool connected_;
     bool tls_enabled_;
     
     // Callbacks
     MessageCallback message_callback_;
+    BinaryCallback binary_callback_;
     ErrorCallback error_callback_;
     ConnectionCallback connection_callback_;
     
@@ -70,6 +89,11 @@ private:
     uint32_t connection_timeout_ms_;
     size_t max_message_size_;
     
+    // Text message delivered in pieces (control messages are small)
+    static constexpr size_t MAX_TEXT_MESSAGE = 1024;
+    char text_message_[MAX_TEXT_MESSAGE];
+    size_t text_bytes_;
+    
     // Statistics
     uint32_t bytes_sent_;
     uint32_t bytes_received_;
@@ -1,13 +1,31 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <atomic>
 #include <string>
 #include <functional>
+#include <memory>
 
 namespace irene {
 
+class ConfigManager;
+
 /**
  * WiFi connection manager with automatic reconnection
+ *
+ * The last good association (BSSID, channel and, for WPA/WPA2-PSK, the
+ * derived PMK) is cached in NVS through ConfigManager. With fast reconnect
+ * enabled, connects and link-loss retries go straight to that AP on that
+ * channel with the PMK, skipping the all-channel scan and the PBKDF2 key
+ * derivation; a directed attempt that fails drops the cache and falls back
+ * to a full scan.
+ *
+ * The event handler only marks the cache for refreshing after a connect:
+ * the PBKDF2 derivation and the NVS write would stall the default event
+ * loop for hundreds of ms. A worker task (NetworkManager's monitor) runs
+ * them through refresh_connect_cache().
  */
 class WiFiManager {
 public:
@@ -34,19 +52,34 @@ public:
     void set_auto_reconnect(bool enable);
     void set_reconnect_interval(uint32_t interval_ms);
     void set_max_retry_count(uint32_t max_retries);
+    void set_fast_reconnect(bool enable);
+    void set_listen_interval(uint8_t beacons);      // Applies at the next connect
+    ErrorCode set_power_profile(WiFiPowerProfile profile);
+    WiFiPowerProfile get_power_profile() const { return power_profile_; }
     
     // Callbacks
     void set_status_callback(StatusCallback callback);
     
+    // Worker task: store the association a connect left pending, if any
+    void refresh_connect_cache();
+    
     // Statistics
     uint32_t get_connection_count() const { return connection_count_; }
     uint32_t get_disconnection_count() const { return disconnection_count_; }
     uint32_t get_retry_count() const { return retry_count_; }
+    uint32_t get_fast_connect_count() const { return fast_connect_count_; }
+    uint32_t get_fast_connect_fallbacks() const { return fast_connect_fallbacks_; }
+    uint32_t get_last_connect_ms() const { return last_connect_ms_; }  // connect() to IP
 
 private:
     static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                                   int32_t event_id, void* event_data);
     void handle_wifi_event(int32_t event_id, void* event_data);
+    bool apply_station_config(bool directed);
+    void update_connect_cache();
+    void invalidate_connect_cache();
+    bool derive_pmk(uint8_t* pmk) const;
+    uint32_t credentials_hash() const;
     
     std::string ssid_;
     std::string password_;
@@ -56,6 +89,21 @@ private:
     uint32_t reconnect_interval_ms_;
     uint32_t max_retry_count_;
     
+    // Fast reconnect
+    std::unique_ptr<ConfigManager> config_store_;
+    WiFiConnectCache cache_;             // Guarded by cache_mutex_
+    std::atomic<bool> cache_valid_;
+    std::atomic<bool> cache_refresh_pending_;  // Set at GOT_IP, cleared by the worker
+    SemaphoreHandle_t cache_mutex_;
+    bool fast_reconnect_;
+    bool directed_attempt_;            // Current attempt uses cache_, no IP yet
+    int64_t connect_start_us_;
+    
+    // Power save
+    WiFiPowerProfile power_profile_;
+    uint8_t listen_interval_;
+    bool started_;
+    
     StatusCallback status_callback_;
     
     // Statistics
@@ -63,6 +111,9 @@ private:
     uint32_t disconnection_count_;
     uint32_t retry_count_;
     uint32_t last_disconnect_time_;
+    uint32_t fast_connect_count_;
+    uint32_t fast_connect_fallbacks_;
+    uint32_t last_connect_ms_;
 };
 
 } // namespace irene 
\ No newline at end of file
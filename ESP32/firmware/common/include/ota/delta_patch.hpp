@@ -0,0 +1,80 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace irene {
+
+/**
+ * Streaming decoder for binary delta firmware images
+ *
+ * A patch rebuilds the new image from the one running now, so only what
+ * changed crosses the network. Layout, little-endian:
+ *
+ *   header  "IRDP", version (1), 3 reserved bytes, source size (u32),
+ *           target size (u32), SHA-256 of the source image (32 bytes)
+ *   ops     0x01 COPY   source offset (u32), length (u32)
+ *           0x02 INSERT length (u32), then length literal bytes
+ *           0x00 END    target must be complete
+ *
+ * tools/make_delta.py writes these. The patch is fed in whatever pieces the
+ * download delivers; the target is produced strictly in order through the
+ * writer, and COPY reads the source through the reader. The whole decoder
+ * position is the plain DeltaPatchState, so a download checkpoint can save
+ * it next to the byte offset and restore() picks up at the same place.
+ */
+class DeltaPatcher {
+public:
+    static constexpr size_t HEADER_SIZE = 48;
+    static constexpr uint8_t OP_END = 0x00;
+    static constexpr uint8_t OP_COPY = 0x01;
+    static constexpr uint8_t OP_INSERT = 0x02;
+
+    enum class Result : uint8_t {
+        NEED_MORE,         // All input used, the target is not complete yet
+        DONE,              // END reached; input after it is ignored
+        BAD_PATCH,         // Malformed, or an op outside the source or target
+        SOURCE_MISMATCH,   // Rejected by the header check
+        IO_ERROR           // Reader or writer failed
+    };
+
+    using SourceReader = std::function<bool(uint32_t offset, uint8_t* data, size_t length)>;
+    using TargetWriter = std::function<bool(const uint8_t* data, size_t length)>;
+    // Once the header is in: false if the patch does not apply to this device
+    using HeaderCheck = std::function<bool(const DeltaPatchState& state)>;
+
+    DeltaPatcher(SourceReader reader, TargetWriter writer, HeaderCheck check = nullptr);
+
+    // Non-copyable
+    DeltaPatcher(const DeltaPatcher&) = delete;
+    DeltaPatcher& operator=(const DeltaPatcher&) = delete;
+
+    // Continue from a saved position (the header check is not repeated)
+    void restore(const DeltaPatchState& state) { state_ = state; }
+    const DeltaPatchState& state() const { return state_; }
+    bool is_done() const { return state_.stage == DONE; }
+    static bool has_header(const DeltaPatchState& state) { return state.stage != HEADER; }
+
+    // Decode the next piece of the patch
+    Result feed(const uint8_t* data, size_t length);
+
+    // True if the first byte of a download starts a patch rather than an app image
+    static bool is_patch(uint8_t first_byte) { return first_byte == 'I'; }
+
+private:
+    enum Stage : uint8_t { HEADER, OP, INSERT, DONE };
+
+    Result parse_header();
+    Result run_op();
+    Result copy(uint32_t offset, uint32_t length);
+
+    SourceReader reader_;
+    TargetWriter writer_;
+    HeaderCheck check_;
+    DeltaPatchState state_;
+    uint8_t copy_buffer_[256];   // COPY source bytes in transit
+};
+
+} // namespace irene
@@ -1,31 +1,60 @@
 #pragma once
 
 #include "core/types.hpp"
+#include "utils/rate_limiter.hpp"
+#include "esp_partition.h"
+#include <atomic>
 #include <string>
 #include <functional>
+#include <memory>
 
 namespace irene {
 
+class ConfigManager;
+class DeltaPatcher;
+
 /**
  * OTA (Over-The-Air) firmware update manager
  * Handles secure firmware updates via HTTPS
+ *
+ * The download is written straight into the next update partition, one
+ * 4 kB sector erase at a time, and a resume point (byte offset, server
+ * ETag, delta decoder position) is checkpointed in NVS through
+ * ConfigManager every NetworkConfig::ota_checkpoint_bytes. A dropped
+ * connection, a cancel or a reboot therefore costs at most one checkpoint
+ * interval: the next attempt for the same URL asks for the rest with an
+ * HTTP Range request (If-Range on the ETag, so a changed image starts
+ * over).
+ *
+ * Downloads are background traffic: reads go through a token bucket at
+ * NetworkConfig::ota_rate_limit, and stop altogether while the hold check
+ * is true (the StateMachine holds while streaming, arbitrating or playing
+ * a reply). With the socket unread, TCP flow control throttles the server
+ * as well.
+ *
+ * An image that starts with the DeltaPatcher magic is a delta against the
+ * running partition: it is applied on the fly, COPY ops reading the
+ * running image, after its SHA-256 is checked against the patch header.
+ * esp_ota_set_boot_partition() verifies the result either way before the
+ * node restarts into it.
  */
 class OTAManager {
 public:
     using ProgressCallback = std::function<void(int percentage)>;
     using CompleteCallback = std::function<void(bool success, const std::string& error)>;
+    using HoldCheck = std::function<bool()>;   // True: leave the air to foreground traffic
     
     OTAManager();
     ~OTAManager();
     
     // Initialize OTA subsystem
-    ErrorCode initialize();
+    ErrorCode initialize(const NetworkConfig& config);
     
-    // Start OTA update
+    // Start OTA update (resumes an interrupted download of the same URL)
     ErrorCode start_update(const std::string& url,
                           const char* server_cert = nullptr);
     
-    // Cancel ongoing update
+    // Stop the download; the resume point is kept
     void cancel_update();
     
     // Check for updates
@@ -37,26 +66,62 @@ public:
     std::string get_current_app_description() const;
     
     // Get update status
-    bool is_update_in_progress() const { return update_in_progress_; }
+    bool is_update_in_progress() const { return update_in_progress_.load(std::memory_order_acquire); }
     int get_update_progress() const { return update_progress_; }
+    bool is_held() const { return held_.load(std::memory_order_relaxed); }
+    uint32_t get_resume_count() const { return resumes_; }
+    
+    // Mutual TLS, as the WebSocket uses (static PEM strings)
+    void set_client_certificate(const char* cert_pem, const char* key_pem);
     
-    // Callbacks
+    // Callbacks (invoked from the OTA task)
     void set_progress_callback(ProgressCallback callback);
     void set_complete_callback(CompleteCallback callback);
+    void set_hold_check(HoldCheck check);
     
     // Partition info
     void print_partition_info() const;
     bool validate_current_partition() const;
 
 private:
-    bool update_in_progress_;
+    // How one download attempt ended
+    enum class Attempt : uint8_t { COMPLETE, RETRY, CANCELLED, FATAL };
+    
+    Attempt download(const std::string& url, const char* cert, std::string& error);
+    void begin_image(uint32_t size, const char* etag);
+    bool consume(const uint8_t* data, size_t length, std::string& error);
+    bool write_target(const uint8_t* data, size_t length);
+    bool check_source(const DeltaPatchState& state) const;
+    void wait_while_held();
+    void save_checkpoint();
+    void discard_resume_point();
+    
+    std::atomic<bool> update_in_progress_;
+    std::atomic<bool> cancel_requested_;
+    std::atomic<bool> held_;
     int update_progress_;
+    uint32_t resumes_;
+    
+    // Download state (OTA task)
+    std::unique_ptr<ConfigManager> config_store_;
+    OTAResumeRecord record_;
+    uint32_t checkpoint_received_;   // record_.received at the last checkpoint
+    uint32_t written_;               // Bytes in the update partition
+    uint32_t erased_;                // Erased prefix of the update partition
+    const esp_partition_t* target_;
+    DeltaPatcher* patcher_;          // On the OTA task stack while a download runs
+    RateLimiter limiter_;
+    uint32_t checkpoint_bytes_;
+    
+    const char* client_cert_pem_;
+    const char* client_key_pem_;
     
     ProgressCallback progress_callback_;
     CompleteCallback complete_callback_;
+    HoldCheck hold_check_;
     
     void ota_task(const std::string url, const char* cert);
     static void ota_task_wrapper(void* param);
 };
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
@@ -2,14 +2,40 @@
 
 #include "core/types.hpp"
 #include "lvgl.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace irene {
 
+class DisplayManager;
+
 /**
  * Controls the LVGL-based circular UI on 1.46" round display
  * Manages state ring, clock, weather, WiFi status, and OTA progress
+ *
+ * Rendering is partial (see DisplayManager), so the cost of a frame is the
+ * area invalidated, and every update here keeps that area small: labels are
+ * only touched when their text changes, and the state ring, which spans
+ * the whole screen, is drawn by hand and invalidated as RING_SEGMENTS
+ * boxes hugging the annulus rather than as its full-screen bounding box.
+ * A colour fade or pulse therefore redraws about a quarter of the screen.
+ *
+ * LVGL is not thread-safe: the public methods are called from other tasks
+ * and take the LVGL mutex, which the LVGL task holds while it renders.
+ *
+ * The LVGL task runs only as often as the screen needs it. While an
+ * animation runs or an area is waiting to be rendered it follows LVGL's
+ * refresh period; otherwise it wakes once a second (or for a pending
+ * popup timer), and every update from another task wakes it at once.
+ * After UIConfig::idle_timeout_ms without activity in IDLE_LISTENING the
+ * backlight and panel go off and the task blocks until wake_screen(),
+ * a state change or an input interrupt (wake_screen_from_isr()). The LVGL
+ * tick is advanced from esp_timer_get_time() whenever LVGL is entered, so
+ * no periodic tick interrupt runs either.
  */
 class UIController {
 public:
@@ -40,6 +66,8 @@ public:
     void set_brightness(uint8_t percentage);
     void enable_screen_timeout(bool enable);
     void wake_screen();
+    // Touch and button interrupt handlers
+    void wake_screen_from_isr(BaseType_t* higher_priority_task_woken);
 
     // Touch and button handling
     void set_touch_callback(TouchCallback callback);
@@ -59,6 +87,7 @@ public:
     bool is_initialized() const { return initialized_; }
     uint8_t get_brightness() const { return current_brightness_; }
     SystemState get_displayed_state() const { return current_state_; }
+    bool is_screen_on() const { return !screen_asleep_.load(std::memory_order_relaxed); }
 
 private:
     void create_ui_elements();
@@ -68,12 +97,27 @@ private:
     void create_wifi_status();
     void create_ota_progress_bar();
     
+    void compute_ring_segments();
+    void invalidate_ring();
+    void lock();
+    void unlock();
+    uint32_t next_wait_ms(bool rendering, uint32_t until_next_timer_ms);
+    void sleep_screen();
+    
     void update_animations();
     void handle_touch_event(lv_event_t* event);
     void handle_button_event(int button_id, bool pressed);
     
     static void lvgl_task_wrapper(void* arg);
     static void touch_event_callback(lv_event_t* event);
+    static void ring_draw_callback(lv_event_t* event);
+    static void ring_color_anim_callback(void* var, int32_t value);
+    static void ring_opa_anim_callback(void* var, int32_t value);
+    static void popup_timer_callback(lv_timer_t* timer);
+    
+    static constexpr size_t RING_SEGMENTS = 16;   // Well inside LVGL's 32-area invalidation buffer
+    static constexpr lv_coord_t RING_WIDTH = 12;
+    static constexpr lv_coord_t RING_MARGIN = 4;
     
     UIConfig config_;
     bool initialized_;
@@ -81,6 +125,7 @@ private:
     uint8_t current_brightness_;
     
     // LVGL objects
+    std::unique_ptr<DisplayManager> display_manager_;
     lv_disp_t* display_;
     lv_obj_t* screen_;
     lv_obj_t* state_ring_;
@@ -90,11 +135,18 @@ private:
     lv_obj_t* wifi_icon_;
     lv_obj_t* ota_progress_bar_;
     lv_obj_t* keyword_popup_;
+    lv_timer_t* popup_timer_;
+    
+    // State ring, drawn by ring_draw_callback
+    lv_color_t ring_color_;
+    lv_color_t ring_from_;
+    lv_color_t ring_to_;
+    lv_opa_t ring_opa_;
+    lv_area_t ring_segments_[RING_SEGMENTS];
     
     // Animations
     lv_anim_t ring_anim_;
     lv_anim_t pulse_anim_;
-    lv_anim_t keyword_anim_;
     
     // Callbacks
     TouchCallback touch_callback_;
@@ -102,17 +154,29 @@ private:
     
     // Task management
     TaskHandle_t lvgl_task_handle_;
+    SemaphoreHandle_t lvgl_mutex_;      // Recursive
+    int64_t last_tick_us_;              // esp_timer time of the last lv_tick_inc()
     
     // State tracking
     bool screen_timeout_enabled_;
     uint32_t last_activity_time_;
+    std::atomic<bool> wake_requested_;
+    std::atomic<bool> screen_asleep_;
     bool ota_progress_visible_;
     int last_ota_percentage_;
     
+    // Last values shown, so unchanged updates invalidate nothing
+    int shown_minute_of_day_;
+    int shown_temperature_;
+    bool shown_temperature_stale_;
+    int shown_rssi_;
+    int shown_signal_level_;
+    
     // Color scheme
     lv_color_t color_idle_;
     lv_color_t color_listening_;
     lv_color_t color_streaming_;
     lv_color_t color_error_;
     lv_color_t color_background_;
-}; 
\ No newline at end of file
+}; 
+} // namespace irene
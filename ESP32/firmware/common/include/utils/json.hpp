@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace irene {
+
+/**
+ * JSON writer over a caller-owned buffer
+ *
+ * Builds one control message in place: no heap, no iostreams. Commas are
+ * placed from the nesting; a key is given inside objects and omitted for
+ * array elements. Writing past the buffer stops the writer, and ok() is
+ * false from then on, so callers check once at the end instead of per
+ * field. The text is kept NUL-terminated for logging.
+ */
+class JsonWriter {
+public:
+    static constexpr size_t MAX_DEPTH = 8;
+
+    JsonWriter(char* buffer, size_t capacity);
+
+    JsonWriter& begin_object(const char* key = nullptr);
+    JsonWriter& end_object();
+    JsonWriter& begin_array(const char* key = nullptr);
+    JsonWriter& end_array();
+
+    JsonWriter& field(const char* key, std::string_view value);  // Escaped string
+    JsonWriter& field(const char* key, const char* value) { return field(key, std::string_view(value ? value : "")); }
+    JsonWriter& field(const char* key, uint32_t value) { return field(key, static_cast<uint64_t>(value)); }
+    JsonWriter& field(const char* key, uint64_t value);
+    JsonWriter& field(const char* key, int32_t value);
+    JsonWriter& field(const char* key, float value, int decimals);
+    JsonWriter& field(const char* key, bool value);
+
+    bool ok() const { return ok_ && depth_ == 0; }   // Complete and not truncated
+    const char* data() const { return buffer_; }
+    size_t size() const { return length_; }
+    std::string_view view() const { return std::string_view(buffer_, length_); }
+
+private:
+    void separator(const char* key);
+    void put(char c);
+    void put(std::string_view text);
+    void put_escaped(std::string_view text);
+    JsonWriter& open(const char* key, char bracket);
+    JsonWriter& close(char bracket);
+
+    char* buffer_;
+    size_t capacity_;
+    size_t length_;
+    size_t depth_;
+    bool first_[MAX_DEPTH + 1];   // No member written yet at this depth
+    bool ok_;
+};
+
+/**
+ * One JSON value inside a received message, as a view
+ *
+ * Strings are the raw text between the quotes: escapes are not decoded,
+ * which the control vocabulary (keys, enum values, numbers) never needs.
+ */
+class JsonValue {
+public:
+    enum class Type : uint8_t { NONE, OBJECT, ARRAY, STRING, NUMBER, BOOL, NUL };
+
+    JsonValue() : type_(Type::NONE) {}
+    JsonValue(Type type, std::string_view text) : type_(type), text_(text) {}
+
+    Type type() const { return type_; }
+    bool is_valid() const { return type_ != Type::NONE; }
+    bool is_object() const { return type_ == Type::OBJECT; }
+    bool is_string() const { return type_ == Type::STRING; }
+
+    std::string_view text() const { return text_; }   // Without quotes for strings
+    bool equals(std::string_view value) const { return type_ == Type::STRING && text_ == value; }
+
+    // Member lookup in an object; NONE when absent or not an object
+    JsonValue operator[](std::string_view key) const;
+
+    bool as_uint32(uint32_t& value) const;
+    bool as_float(float& value) const;
+    bool as_bool(bool& value) const;
+
+private:
+    Type type_;
+    std::string_view text_;   // Whole value for objects and arrays
+};
+
+// The top-level value of a message; NONE when malformed
+JsonValue json_parse(std::string_view message);
+
+} // namespace irene
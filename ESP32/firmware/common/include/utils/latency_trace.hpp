@@ -0,0 +1,103 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace irene {
+
+// Trace points along the wake -> session -> uplink -> EOF path
+enum class TraceEvent : uint8_t {
+    I2S_FRAME_READY,     // arg: capture sequence (low 16 bits)
+    MFCC_FRAME_READY,    // arg: frames published to inference
+    INFERENCE_START,
+    INFERENCE_END,       // arg: confidence x1000
+    WAKE_CONFIRMED,      // arg: confidence x1000
+    STATE_TRANSITION,    // arg: old state << 8 | new state
+    SESSION_START,
+    TLS_CONNECTED,       // arg: handshake ms
+    FIRST_UPLINK_FRAME,  // arg: payload bytes
+    EOF_SENT,
+    COUNT
+};
+
+// Latency stages tracked from event pairs
+enum class TraceStage : uint8_t {
+    CAPTURE_TO_MFCC,         // I2S_FRAME_READY -> MFCC_FRAME_READY
+    MFCC_TO_INFERENCE,       // MFCC_FRAME_READY -> INFERENCE_START
+    INFERENCE,               // INFERENCE_START -> INFERENCE_END
+    WAKE_TO_SESSION,         // WAKE_CONFIRMED -> SESSION_START
+    SESSION_TO_FIRST_AUDIO,  // SESSION_START -> FIRST_UPLINK_FRAME
+    WAKE_TO_FIRST_AUDIO,     // WAKE_CONFIRMED -> FIRST_UPLINK_FRAME
+    FIRST_AUDIO_TO_EOF,      // FIRST_UPLINK_FRAME -> EOF_SENT
+    COUNT
+};
+
+// One trace record as dumped; little-endian, 12 bytes
+struct TraceRecord {
+    uint32_t time_us;    // Low 32 bits of esp_timer_get_time()
+    uint32_t sequence;   // Record number, monotonic
+    uint16_t arg;
+    uint8_t event;       // TraceEvent
+    uint8_t core;
+};
+
+// Latency distribution of one stage; percentiles are bucket upper bounds (~25%)
+struct TraceStageStats {
+    uint32_t count = 0;
+    uint32_t p50_us = 0;
+    uint32_t p95_us = 0;
+    uint32_t p99_us = 0;
+    uint32_t max_us = 0;
+};
+
+/**
+ * Lightweight latency tracing
+ * A fixed ring of timestamped (event, arg) records. record() is lock-free
+ * and safe from any task: writers claim a slot with one atomic increment,
+ * and readers drop slots that were overwritten mid-copy.
+ *
+ * Per-frame events fill the ring within seconds, so stage latencies are
+ * also folded into log-scale histograms as events arrive: each stage's end
+ * pairs with the latest start before it, and p50/p95/p99 cover the whole
+ * uptime rather than the ring window.
+ *
+ * Dump format (serialize()): a 16-byte header, magic "IRTR", version,
+ * record size, record count and the 64-bit esp_timer time of the dump,
+ * followed by TraceRecords oldest first.
+ */
+class LatencyTrace {
+public:
+    static constexpr size_t CAPACITY = 512;  // Records, power of two
+    static constexpr uint8_t FORMAT_VERSION = 1;
+    static constexpr size_t HEADER_BYTES = 16;
+
+    using DumpWriter = std::function<bool(const uint8_t* data, size_t length)>;
+
+    static void record(TraceEvent event, uint16_t arg = 0);
+    static void set_enabled(bool enable);
+    static bool is_enabled();
+    static void clear();
+
+    // Copy the live records oldest first; returns the count
+    static size_t snapshot(TraceRecord* records, size_t max_records);
+
+    // Binary dump; returns bytes written, 0 if the buffer is too small
+    static size_t serialize(uint8_t* buffer, size_t capacity);
+    static size_t serialized_size() { return HEADER_BYTES + CAPACITY * sizeof(TraceRecord); }
+
+    // Dump in chunks of at most chunk_bytes; stops when writer returns false
+    static ErrorCode dump(const DumpWriter& writer, size_t chunk_bytes);
+    static void dump_to_log();  // Base64 lines on the console
+
+    // Stage latency since boot or the last reset
+    static void get_stage_stats(TraceStage stage, TraceStageStats& stats);
+    static void reset_stage_stats();
+    static void log_stage_stats();
+
+    static const char* event_name(TraceEvent event);
+    static const char* stage_name(TraceStage stage);
+};
+
+} // namespace irene
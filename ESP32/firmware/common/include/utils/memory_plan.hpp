@@ -0,0 +1,95 @@
+#pragma once
+
+#include "core/types.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace irene {
+
+// Where a planned buffer lives
+enum class MemoryRegion : uint8_t {
+    INTERNAL,   // Internal RAM, 8-bit accessible (hot tables, scratch)
+    DMA,        // Internal, DMA-capable (I2S capture frames, LVGL draw buffers)
+    PSRAM,      // External RAM (feature stores, ring buffers)
+    COUNT
+};
+
+/**
+ * Boot-time memory plan for the audio, wake word and network buffers
+ *
+ * Each region is reserved from the heap once, at its compile-time budget,
+ * and long-lived buffers are carved from it instead of from the general
+ * heap, so the footprint is fixed at boot and long uptimes cannot
+ * fragment it. Blocks are placed by bump allocation; a released block is
+ * kept and handed to the next request it fits (a component re-initialised
+ * with the same geometry gets its block back), and releasing the newest
+ * block gives the space back to the region.
+ *
+ * A request that does not fit, arrives before initialize() or names a
+ * region that could not be reserved (no PSRAM fitted) falls back to
+ * heap_caps_malloc() and is counted as an overflow in the report, so a
+ * budget that is too small shows up in the boot log rather than as a
+ * failure. release() takes either kind of pointer.
+ */
+class MemoryPlan {
+public:
+    // Budgets: the sum of what the buffers need at the largest supported
+    // configuration, rounded up
+    static constexpr size_t DMA_BUDGET = 100 * 1024;      // 32 x 30 ms capture frames, 2 x 412 x 42 draw buffers
+    static constexpr size_t INTERNAL_BUDGET = 48 * 1024;  // FFT, uplink batches, codec state, model variables
+    static constexpr size_t PSRAM_BUDGET = 160 * 1024;    // MFCC buffers, feature queues, playback jitter buffer
+    static constexpr size_t MAX_BLOCKS = 64;
+    static constexpr size_t ALIGNMENT = 16;
+
+    // Internal RAM left to Wi-Fi, lwIP/TLS and the tensor arena. The draw
+    // buffers have to be here: SPI DMA out of PSRAM cannot keep the panel fed.
+    static_assert(DMA_BUDGET + INTERNAL_BUDGET <= 160 * 1024,
+                  "Internal memory plan leaves too little for the network stack");
+
+    /**
+     * @brief Reserve every region; call once at boot before the buffers are created
+     * @return MEMORY_ERROR if an internal region cannot be reserved
+     */
+    static ErrorCode initialize();
+
+    // Block of at least bytes, ALIGNMENT-aligned; nullptr only when the heap
+    // fallback fails too. owner is a static string for the report.
+    static void* allocate(MemoryRegion region, size_t bytes, const char* owner);
+
+    template <typename T>
+    static T* allocate_array(MemoryRegion region, size_t count, const char* owner) {
+        return static_cast<T*>(allocate(region, count * sizeof(T), owner));
+    }
+
+    // Return a block from allocate(); nullptr is ignored
+    static void release(void* ptr);
+
+    // True if ptr is a block inside one of the reserved regions
+    static bool owns(const void* ptr);
+
+    struct RegionStats {
+        bool reserved;
+        size_t budget;
+        size_t used;                   // Bytes in live blocks
+        size_t high_water;             // Furthest the region has been carved
+        size_t blocks;
+        uint32_t overflow_count;       // Requests served by the heap instead
+        size_t overflow_bytes;
+    };
+    static RegionStats get_region_stats(MemoryRegion region);
+
+    // Per-region totals and every block with its owner
+    static void log_report();
+};
+
+// Deleter for unique_ptr over planned memory
+struct PlanDeleter {
+    void operator()(void* ptr) const { MemoryPlan::release(ptr); }
+};
+
+// Owning array of trivial elements in a planned region
+template <typename T>
+using PlanArray = std::unique_ptr<T[], PlanDeleter>;
+
+} // namespace irene
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace irene {
+
+/**
+ * Token bucket for background transfers
+ *
+ * The bucket fills at the configured rate up to burst bytes. consume()
+ * takes what was just transferred, letting the bucket go into debt, and
+ * returns how long to wait before the next transfer so the average stays
+ * at the rate. Rate 0 means unlimited.
+ */
+class RateLimiter {
+public:
+    RateLimiter();
+
+    // burst 0 = one second at the rate
+    void configure(uint32_t bytes_per_second, uint32_t burst_bytes = 0);
+
+    // Start over with a full bucket
+    void reset(int64_t now_us);
+
+    // Take bytes just transferred; microseconds to wait before the next transfer
+    int64_t consume(size_t bytes, int64_t now_us);
+
+    uint32_t get_rate() const { return rate_; }
+
+private:
+    void refill(int64_t now_us);
+
+    uint32_t rate_;          // Bytes per second
+    int64_t capacity_;       // Burst, in byte-microseconds
+    int64_t tokens_;         // Byte-microseconds, negative = debt
+    int64_t last_us_;
+};
+
+} // namespace irene
@@ -24,6 +24,7 @@ struct RingBufferStats {
  * Thread-safe circular buffer implementation
  * Supports both internal RAM and PSRAM allocation
  * Automatically overwrites oldest data when full
+ * For one producer and one consumer, prefer the lock-free SPSCRingBuffer
  */
 class RingBuffer {
 public:
@@ -89,6 +90,8 @@ public:
     void get_stats(RingBufferStats& stats) const;
 
 private:
+    size_t copy_out(uint8_t* data, size_t length, size_t offset) const;
+    
     uint8_t* buffer_;
     size_t capacity_;
     volatile size_t head_;
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "utils/memory_plan.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+namespace irene {
+
+/**
+ * Lock-free single-producer/single-consumer ring buffer of T
+ *
+ * Capacity is rounded up to a power of two so positions wrap with a mask.
+ * head_ and tail_ are free-running element counters: the producer only
+ * stores head_, the consumer only stores tail_, and every operation moves
+ * data with at most two memcpy calls.
+ *
+ * Unlike RingBuffer, a full buffer rejects the excess instead of
+ * overwriting the oldest data. A producer that is also the only consumer
+ * can make room first with skip().
+ */
+template <typename T>
+class SPSCRingBuffer {
+public:
+    /**
+     * Create ring buffer with at least the requested capacity
+     * @param min_capacity Minimum capacity in elements (rounded up to a power of two)
+     * @param use_psram If true, allocate in PSRAM, otherwise in internal RAM
+     */
+    explicit SPSCRingBuffer(size_t min_capacity, bool use_psram = false)
+        : buffer_(nullptr)
+        , capacity_(round_up_pow2(min_capacity))
+        , mask_(capacity_ - 1)
+        , head_(0)
+        , tail_(0) {
+
+        buffer_ = MemoryPlan::allocate_array<T>(use_psram ? MemoryRegion::PSRAM : MemoryRegion::INTERNAL,
+                                                capacity_, "SPSCRingBuffer");
+        if (!buffer_) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~SPSCRingBuffer() {
+        MemoryPlan::release(buffer_);
+    }
+
+    // Non-copyable
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    // Producer: append up to count elements, returns the number written
+    size_t write(const T* data, size_t count) {
+        if (!data || count == 0) {
+            return 0;
+        }
+
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t n = std::min(count, capacity_ - (head - tail));
+
+        copy_in(head & mask_, data, n);
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: remove up to count elements into data
+    size_t read(T* data, size_t count) {
+        const size_t n = peek(data, count, 0);
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: copy up to count elements starting offset past the oldest
+    size_t peek(T* data, size_t count, size_t offset = 0) const {
+        if (!data || count == 0) {
+            return 0;
+        }
+
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t used = head_.load(std::memory_order_acquire) - tail;
+        if (offset >= used) {
+            return 0;
+        }
+
+        const size_t n = std::min(count, used - offset);
+        copy_out(data, (tail + offset) & mask_, n);
+        return n;
+    }
+
+    // Consumer: drop up to count of the oldest elements
+    size_t skip(size_t count) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t n = std::min(count, head_.load(std::memory_order_acquire) - tail);
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer: drop everything written so far
+    void clear() {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Status queries (exact from the owning side, a snapshot from the other)
+    size_t available() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    size_t free_space() const { return capacity_ - available(); }
+    bool empty() const { return available() == 0; }
+    bool full() const { return available() == capacity_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t round_up_pow2(size_t n) {
+        size_t capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    void copy_in(size_t pos, const T* data, size_t n) {
+        const size_t first = std::min(n, capacity_ - pos);
+        std::memcpy(buffer_ + pos, data, first * sizeof(T));
+        std::memcpy(buffer_, data + first, (n - first) * sizeof(T));
+    }
+
+    void copy_out(T* data, size_t pos, size_t n) const {
+        const size_t first = std::min(n, capacity_ - pos);
+        std::memcpy(data, buffer_ + pos, first * sizeof(T));
+        std::memcpy(data + first, buffer_, (n - first) * sizeof(T));
+    }
+
+    T* buffer_;
+    const size_t capacity_;
+    const size_t mask_;
+
+    std::atomic<size_t> head_;  // Written by the producer only
+    std::atomic<size_t> tail_;  // Written by the consumer only
+};
+
+} // namespace irene
@@ -0,0 +1,141 @@
+#include "audio/audio_frame_pool.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <cstring>
+
+static const char* TAG = "AudioFramePool";
+
+namespace irene {
+
+namespace {
+
+const FrameStats kEmptyStats;
+
+} // namespace
+
+AudioFrameRef::AudioFrameRef(const AudioFrameRef& other)
+    : frame_(other.frame_) {
+    if (frame_) {
+        frame_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AudioFrameRef& AudioFrameRef::operator=(const AudioFrameRef& other) {
+    if (this != &other) {
+        if (other.frame_) {
+            other.frame_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        reset();
+        frame_ = other.frame_;
+    }
+    return *this;
+}
+
+AudioFrameRef& AudioFrameRef::operator=(AudioFrameRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        frame_ = other.frame_;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+void AudioFrameRef::reset() {
+    if (!frame_) {
+        return;
+    }
+    
+    // The last reference hands the frame back; acq_rel orders all reads
+    // of the samples before the frame can be refilled
+    if (frame_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        frame_->pool->release(frame_);
+    }
+    frame_ = nullptr;
+}
+
+const FrameStats& AudioFrameRef::stats() const {
+    return frame_ ? frame_->stats : kEmptyStats;
+}
+
+AudioFramePool::AudioFramePool()
+    : storage_(nullptr)
+    , frame_samples_(0)
+    , frame_count_(0)
+    , free_mask_(0)
+    , exhausted_count_(0) {
+    for (size_t i = 0; i < MAX_FRAMES; i++) {
+        frames_[i].samples = nullptr;
+        frames_[i].sample_count = 0;
+        frames_[i].sequence = 0;
+        frames_[i].timestamp_us = 0;
+        frames_[i].stats = FrameStats();
+        frames_[i].refs.store(0, std::memory_order_relaxed);
+        frames_[i].pool = this;
+        frames_[i].index = static_cast<uint8_t>(i);
+    }
+}
+
+AudioFramePool::~AudioFramePool() {
+    MemoryPlan::release(storage_);
+}
+
+ErrorCode AudioFramePool::initialize(size_t frame_samples, size_t frame_count) {
+    if (frame_samples == 0 || frame_count == 0 || frame_count > MAX_FRAMES) {
+        ESP_LOGE(TAG, "Invalid pool geometry: %u frames x %u samples", 
+                 (unsigned)frame_count, (unsigned)frame_samples);
+        return ErrorCode::INIT_FAILED;
+    }
+    
+    // Internal RAM: frames are touched by every consumer, keep them off the PSRAM cache
+    const size_t bytes = frame_samples * frame_count * sizeof(int16_t);
+    storage_ = MemoryPlan::allocate_array<int16_t>(MemoryRegion::DMA, frame_samples * frame_count,
+                                                   "AudioFramePool");
+    if (!storage_) {
+        ESP_LOGE(TAG, "Failed to allocate frame pool (%u bytes)", (unsigned)bytes);
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    for (size_t i = 0; i < frame_count; i++) {
+        frames_[i].samples = storage_ + i * frame_samples;
+        frames_[i].sample_count = frame_samples;
+    }
+    
+    frame_samples_ = frame_samples;
+    frame_count_ = frame_count;
+    free_mask_.store(frame_count == MAX_FRAMES ? 0xFFFFFFFFu : ((1u << frame_count) - 1),
+                     std::memory_order_release);
+    
+    ESP_LOGI(TAG, "Frame pool: %u frames x %u samples (%u bytes)", 
+             (unsigned)frame_count, (unsigned)frame_samples, (unsigned)bytes);
+    return ErrorCode::SUCCESS;
+}
+
+AudioFrameRef AudioFramePool::acquire() {
+    uint32_t mask = free_mask_.load(std::memory_order_acquire);
+    
+    while (mask != 0) {
+        const uint32_t bit = mask & (~mask + 1);  // Lowest free frame
+        if (free_mask_.compare_exchange_weak(mask, mask & ~bit, 
+                                             std::memory_order_acq_rel, 
+                                             std::memory_order_acquire)) {
+            AudioFrame* frame = &frames_[__builtin_ctz(bit)];
+            frame->sample_count = frame_samples_;
+            frame->refs.store(1, std::memory_order_relaxed);
+            return AudioFrameRef(frame);
+        }
+    }
+    
+    exhausted_count_.fetch_add(1, std::memory_order_relaxed);
+    return AudioFrameRef();
+}
+
+void AudioFramePool::release(AudioFrame* frame) {
+    free_mask_.fetch_or(1u << frame->index, std::memory_order_release);
+}
+
+size_t AudioFramePool::free_count() const {
+    return __builtin_popcount(free_mask_.load(std::memory_order_relaxed));
+}
+
+} // namespace irene
@@ -0,0 +1,126 @@
+#include "audio/audio_history.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <algorithm>
+#include <new>
+
+static const char* TAG = "AudioHistory";
+
+namespace irene {
+
+AudioHistory::AudioHistory()
+    : frames_(nullptr)
+    , capacity_(0)
+    , head_(0)
+    , count_(0)
+    , end_(0) {
+}
+
+AudioHistory::~AudioHistory() {
+    destroy();
+}
+
+ErrorCode AudioHistory::initialize(size_t capacity) {
+    if (capacity == 0) {
+        ESP_LOGE(TAG, "History needs at least one frame");
+        return ErrorCode::INIT_FAILED;
+    }
+
+    destroy();
+    frames_ = MemoryPlan::allocate_array<AudioFrameRef>(MemoryRegion::INTERNAL, capacity, "AudioHistory");
+    if (!frames_) {
+        ESP_LOGE(TAG, "Failed to allocate %u frame history", (unsigned)capacity);
+        return ErrorCode::MEMORY_ERROR;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        new (&frames_[i]) AudioFrameRef();
+    }
+
+    capacity_ = capacity;
+    head_ = 0;
+    count_ = 0;
+    end_ = 0;
+    return ErrorCode::SUCCESS;
+}
+
+void AudioHistory::destroy() {
+    if (!frames_) {
+        return;
+    }
+
+    // Releases whatever frames are still retained
+    for (size_t i = 0; i < capacity_; i++) {
+        frames_[i].~AudioFrameRef();
+    }
+    MemoryPlan::release(frames_);
+    frames_ = nullptr;
+    capacity_ = 0;
+    count_ = 0;
+}
+
+void AudioHistory::push(const AudioFrameRef& frame) {
+    // Overwriting a slot releases the oldest frame
+    frames_[head_] = frame;
+    head_ = (head_ + 1) % capacity_;
+    count_ = std::min(count_ + 1, capacity_);
+    end_++;
+}
+
+void AudioHistory::drop_oldest() {
+    if (count_ == 0) {
+        return;
+    }
+
+    frames_[slot(begin())].reset();
+    count_--;
+}
+
+void AudioHistory::clear() {
+    while (count_ > 0) {
+        drop_oldest();
+    }
+}
+
+AudioHistory::Cursor AudioHistory::rewind(size_t frames) const {
+    return end_ - static_cast<Cursor>(std::min(frames, count_));
+}
+
+const AudioFrameRef* AudioHistory::at(Cursor cursor) const {
+    // Unsigned distance keeps this correct across counter wrap
+    const Cursor age = end_ - cursor;
+    if (age == 0 || age > count_) {
+        return nullptr;
+    }
+
+    return &frames_[slot(cursor)];
+}
+
+const AudioFrameRef* AudioHistory::next(Cursor& cursor) const {
+    if (end_ - cursor > count_) {
+        cursor = begin();
+    }
+
+    const AudioFrameRef* frame = at(cursor);
+    if (frame) {
+        cursor++;
+    }
+    return frame;
+}
+
+size_t AudioHistory::newest_spans(size_t count, AudioFrameSpan& first, AudioFrameSpan& second) const {
+    count = std::min(count, count_);
+    const size_t start = slot(end_ - static_cast<Cursor>(count));
+    const size_t first_count = std::min(count, capacity_ - start);
+
+    first = { &frames_[start], first_count };
+    second = { &frames_[0], count - first_count };
+    return count;
+}
+
+size_t AudioHistory::slot(Cursor cursor) const {
+    const size_t age = static_cast<Cursor>(end_ - cursor);
+    return (head_ + capacity_ - age % capacity_) % capacity_;
+}
+
+} // namespace irene
@@ -1,7 +1,13 @@
 #include "audio/audio_manager.hpp"
+#include "core/task_manager.hpp"
 #include "hardware/i2s_driver.hpp"
 #include "audio/vad_processor.hpp"
-#include "utils/ring_buffer.hpp"
+#include "audio/frame_stats.hpp"
+#include "audio/mfcc_frontend.hpp"
+#include "audio/audio_playback.hpp"
+#include "audio/echo_canceller.hpp"
+#include "audio/echo_reference.hpp"
+#include "utils/latency_trace.hpp"
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
@@ -15,13 +21,28 @@ static const char* TAG = "AudioManager";
 
 namespace irene {
 
+namespace {
+
+// Longest supported frame (30 ms at 16 kHz): a full pool and the discard
+// frame must fit the DMA plan
+constexpr size_t kMaxFrameSamples = 16000 * 30 / 1000;
+static_assert((AudioFramePool::MAX_FRAMES + 1) * kMaxFrameSamples * sizeof(int16_t) <= MemoryPlan::DMA_BUDGET,
+              "Capture frames exceed the DMA memory plan");
+
+} // namespace
+
 AudioManager::AudioManager()
     : is_capturing_(false)
     , is_streaming_(false)
     , audio_task_handle_(nullptr)
     , audio_mutex_(nullptr)
+    , back_buffer_frames_(0)
+    , preroll_frames_(0)
+    , capture_sequence_(0)
     , samples_captured_(0)
     , samples_streamed_(0)
+    , underrun_count_(0)
+    , dropped_frame_count_(0)
     , current_audio_level_(0.0f) {
 }
 
@@ -38,6 +59,13 @@ ErrorCode AudioManager::initialize(const AudioConfig& config) {
     
     config_ = config;
     
+    // Frame granularity drives the DMA buffer size and the capture cadence
+    if (config.frame_ms != 10 && config.frame_ms != 20 && config.frame_ms != 30) {
+        ESP_LOGE(TAG, "Unsupported frame duration: %u ms (use 10, 20 or 30)", config.frame_ms);
+        return ErrorCode::INIT_FAILED;
+    }
+    config_.frame_size = (config.sample_rate * config.frame_ms) / 1000;
+    
     // Create mutex for thread safety
     audio_mutex_ = xSemaphoreCreateMutex();
     if (!audio_mutex_) {
@@ -48,7 +76,7 @@ ErrorCode AudioManager::initialize(const AudioConfig& config) {
     try {
         // Initialize I2S driver
         i2s_driver_ = std::make_unique<I2SDriver>();
-        ErrorCode result = i2s_driver_->initialize(config);
+        ErrorCode result = i2s_driver_->initialize(config_);
         if (result != ErrorCode::SUCCESS) {
             ESP_LOGE(TAG, "Failed to initialize I2S driver");
             return result;
@@ -61,18 +89,63 @@ ErrorCode AudioManager::initialize(const AudioConfig& config) {
             ESP_LOGE(TAG, "Failed to initialize VAD processor");
             return result;
         }
+        vad_processor_->set_mode(config.vad_mode);
+        vad_processor_->set_silence_duration_ms(config.vad_idle_hangover_ms);
         
-        // Create audio buffers
-        size_t buffer_size_samples = config.frame_size * config.buffer_count;
-        audio_buffer_ = std::make_unique<RingBuffer>(buffer_size_samples * sizeof(int16_t));
+        // History of frame refs: the 300 ms back buffer, or longer for
+        // consumers such as the wake word backfill
+        const uint32_t history_ms = std::max(kBackBufferMs, config.history_ms);
+        const size_t history_frames = (history_ms + config.frame_ms - 1) / config.frame_ms;
+        back_buffer_frames_ = (kBackBufferMs + config.frame_ms - 1) / config.frame_ms;
+        result = history_.initialize(history_frames);
+        if (result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to initialize audio history");
+            return result;
+        }
         
-        // Back buffer for wake word context (300ms)
-        size_t back_buffer_samples = (config.sample_rate * 300) / 1000; // 300ms
-        back_buffer_ = std::make_unique<RingBuffer>(back_buffer_samples * sizeof(int16_t));
+        // Capture frames: the history plus whatever consumers hold in flight;
+        // when the pool runs dry the oldest history frame is given up
+        const size_t pool_frames = std::min(history_frames + kInFlightFrames,
+                                            AudioFramePool::MAX_FRAMES);
+        result = frame_pool_.initialize(config_.frame_size, pool_frames);
+        if (result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to initialize capture frame pool");
+            return result;
+        }
+        discard_frame_.reset(MemoryPlan::allocate_array<int16_t>(MemoryRegion::DMA, config_.frame_size,
+                                                                 "AudioManager"));
+        if (!discard_frame_) {
+            ESP_LOGE(TAG, "Failed to allocate discard frame");
+            return ErrorCode::MEMORY_ERROR;
+        }
+        
+        if (config.playback_enabled) {
+            playback_ = std::make_unique<AudioPlayback>();
+            result = playback_->initialize(config_, i2s_driver_.get());
+            if (result != ErrorCode::SUCCESS) {
+                ESP_LOGE(TAG, "Failed to initialize playback");
+                return result;
+            }
+            
+            // A TX frame stays queued for at most the DMA ring
+            if (config.barge_in_enabled) {
+                echo_reference_ = std::make_unique<EchoReference>();
+                result = echo_reference_->initialize(config_.frame_size, config.buffer_count + 2);
+                if (result == ErrorCode::SUCCESS) {
+                    echo_canceller_ = std::make_unique<EchoCanceller>();
+                    result = echo_canceller_->initialize(config.aec_filter_taps, config_.frame_size);
+                }
+                if (result != ErrorCode::SUCCESS) {
+                    ESP_LOGE(TAG, "Failed to initialize echo cancellation");
+                    return result;
+                }
+                i2s_driver_->set_echo_reference(echo_reference_.get());
+            }
+        }
         
         ESP_LOGI(TAG, "Audio manager initialized successfully");
-        ESP_LOGI(TAG, "Sample rate: %u Hz, Frame size: %u samples", 
-                config.sample_rate, config.frame_size);
+        ESP_LOGI(TAG, "Sample rate: %u Hz, Frame: %u ms (%u samples)", 
+                config_.sample_rate, config_.frame_ms, config_.frame_size);
         
         return ErrorCode::SUCCESS;
         
@@ -96,24 +169,35 @@ ErrorCode AudioManager::start_capture() {
         return result;
     }
     
-    // Create audio processing task
-    BaseType_t task_result = xTaskCreatePinnedToCore(
-        audio_task_wrapper,
+    // Frames queued while capture was stopped no longer line up
+    if (echo_reference_) {
+        echo_reference_->reset();
+    }
+    
+    // Create audio processing task (capture stage of the wake word pipeline)
+    ErrorCode task_result = TaskManager::instance().create_task(
         "audio_task",
-        4096,  // Stack size
+        audio_task_wrapper,
         this,
-        10,    // Priority
-        &audio_task_handle_,
-        0      // Core 0 for real-time audio
+        config_.capture_stack_size,
+        config_.capture_priority,
+        config_.capture_core < 0 ? tskNO_AFFINITY : config_.capture_core,
+        &audio_task_handle_
     );
     
-    if (task_result != pdPASS) {
+    if (task_result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to create audio task");
         i2s_driver_->stop();
         return ErrorCode::AUDIO_FAILED;
     }
     
     is_capturing_ = true;
+    
+    // TX runs on the same clock; a playback failure leaves capture running
+    if (playback_ && playback_->start() != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "Playback unavailable");
+    }
+    
     ESP_LOGI(TAG, "Audio capture started");
     
     return ErrorCode::SUCCESS;
@@ -129,9 +213,13 @@ ErrorCode AudioManager::stop_capture() {
     is_capturing_ = false;
     is_streaming_ = false;
     
+    if (playback_) {
+        playback_->stop();
+    }
+    
     // Delete audio task
     if (audio_task_handle_) {
-        vTaskDelete(audio_task_handle_);
+        TaskManager::instance().delete_task(audio_task_handle_);
         audio_task_handle_ = nullptr;
     }
     
@@ -144,20 +232,34 @@ ErrorCode AudioManager::stop_capture() {
     return ErrorCode::SUCCESS;
 }
 
-ErrorCode AudioManager::start_streaming() {
+ErrorCode AudioManager::start_streaming(uint32_t preroll_ms) {
     xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    // The capture task sends the pre-roll just ahead of the next live frame,
+    // so the hand-over has no gap and no duplicate
+    preroll_frames_ = std::min<size_t>((preroll_ms + config_.frame_ms - 1) / config_.frame_ms,
+                                       history_.capacity());
     is_streaming_ = true;
     xSemaphoreGive(audio_mutex_);
     
-    ESP_LOGI(TAG, "Audio streaming started");
+    // Longer hangover while streaming: a pause inside the phrase is not its end
+    if (vad_processor_) {
+        vad_processor_->set_silence_duration_ms(config_.vad_stream_hangover_ms);
+    }
+    
+    ESP_LOGI(TAG, "Audio streaming started (pre-roll %u frames)", (unsigned)preroll_frames_);
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode AudioManager::stop_streaming() {
     xSemaphoreTake(audio_mutex_, portMAX_DELAY);
     is_streaming_ = false;
+    preroll_frames_ = 0;
     xSemaphoreGive(audio_mutex_);
     
+    if (vad_processor_) {
+        vad_processor_->set_silence_duration_ms(config_.vad_idle_hangover_ms);
+    }
+    
     ESP_LOGI(TAG, "Audio streaming stopped");
     return ErrorCode::SUCCESS;
 }
@@ -174,31 +276,73 @@ void AudioManager::set_vad_sensitivity(float sensitivity) {
     }
 }
 
-void AudioManager::set_audio_data_callback(AudioDataCallback callback) {
+void AudioManager::set_audio_data_callback(FrameCallback callback) {
     audio_data_callback_ = callback;
 }
 
+void AudioManager::set_capture_callback(FrameCallback callback) {
+    capture_callback_ = callback;
+}
+
+void AudioManager::set_preroll_callback(PrerollCallback callback) {
+    preroll_callback_ = callback;
+}
+
+void AudioManager::process_vad_spectrum(const float* log_mel, size_t bands) {
+    // Next process_audio_frame() reports the decision
+    if (vad_processor_) {
+        vad_processor_->process_spectrum(log_mel, bands, MFCCFrontend::HOP_SIZE_MS);
+    }
+}
+
 void AudioManager::set_vad_callback(VADCallback callback) {
     vad_callback_ = callback;
 }
 
 size_t AudioManager::get_back_buffer_samples(int16_t* buffer, size_t max_samples) {
-    if (!back_buffer_ || !buffer) {
+    if (!buffer) {
         return 0;
     }
     
     xSemaphoreTake(audio_mutex_, portMAX_DELAY);
     
-    size_t available_bytes = back_buffer_->available();
-    size_t available_samples = available_bytes / sizeof(int16_t);
-    size_t samples_to_copy = std::min(available_samples, max_samples);
+    // Newest max_samples of the back buffer, copied out oldest first
+    AudioHistory::Cursor cursor = history_.rewind(back_buffer_frames_);
+    size_t available = 0;
+    for (AudioHistory::Cursor c = cursor; c != history_.end(); c++) {
+        available += history_.at(c)->size();
+    }
+    size_t skip = available > max_samples ? available - max_samples : 0;
+    
+    size_t copied = 0;
+    while (const AudioFrameRef* frame = history_.next(cursor)) {
+        const size_t offset = std::min(skip, frame->size());
+        skip -= offset;
+        memcpy(buffer + copied, frame->data() + offset, (frame->size() - offset) * sizeof(int16_t));
+        copied += frame->size() - offset;
+    }
+    
+    xSemaphoreGive(audio_mutex_);
     
-    size_t bytes_read = back_buffer_->read(reinterpret_cast<uint8_t*>(buffer), 
-                                          samples_to_copy * sizeof(int16_t));
+    return copied;
+}
+
+size_t AudioManager::get_back_buffer_frames(AudioFrameRef* frames, size_t max_frames) {
+    if (!frames) {
+        return 0;
+    }
+    
+    xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    
+    AudioHistory::Cursor cursor = history_.rewind(std::min(back_buffer_frames_, max_frames));
+    size_t count = 0;
+    while (const AudioFrameRef* frame = history_.next(cursor)) {
+        frames[count++] = *frame;
+    }
     
     xSemaphoreGive(audio_mutex_);
     
-    return bytes_read / sizeof(int16_t);
+    return count;
 }
 
 bool AudioManager::is_voice_detected() const {
@@ -217,6 +361,35 @@ float AudioManager::get_audio_level() const {
     return current_audio_level_;
 }
 
+float AudioManager::get_peak_level(uint32_t window_ms) {
+    xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    
+    const size_t frames = (window_ms + config_.frame_ms - 1) / config_.frame_ms;
+    AudioHistory::Cursor cursor = history_.rewind(frames);
+    float peak = 0.0f;
+    while (const AudioFrameRef* frame = history_.next(cursor)) {
+        if (frame->size() > 0) {
+            peak = std::max(peak, frame->stats().rms());
+        }
+    }
+    
+    xSemaphoreGive(audio_mutex_);
+    
+    return peak;
+}
+
+uint32_t AudioManager::get_overrun_count() const {
+    return i2s_driver_ ? i2s_driver_->get_rx_overflow_count() : 0;
+}
+
+uint32_t AudioManager::get_underrun_count() const {
+    return underrun_count_;
+}
+
+uint32_t AudioManager::get_dropped_frame_count() const {
+    return dropped_frame_count_;
+}
+
 void AudioManager::audio_task_wrapper(void* arg) {
     static_cast<AudioManager*>(arg)->audio_task();
 }
@@ -225,65 +398,93 @@ void AudioManager::audio_task() {
     ESP_LOGI(TAG, "Audio task started");
     
     const size_t frame_size_bytes = config_.frame_size * sizeof(int16_t);
-    int16_t* audio_frame = static_cast<int16_t*>(malloc(frame_size_bytes));
     
-    if (!audio_frame) {
-        ESP_LOGE(TAG, "Failed to allocate audio frame buffer");
-        return;
-    }
-    
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t frame_period = pdMS_TO_TICKS(20); // 20ms frame period
+    // Paced by DMA completions only; no event for several periods means the
+    // I2S clock stalled
+    const TickType_t event_timeout = pdMS_TO_TICKS(config_.frame_ms * 4);
     
     while (is_capturing_) {
-        // Read audio frame from I2S
-        size_t bytes_read = 0;
-        esp_err_t result = i2s_driver_->read_frame(
-            reinterpret_cast<uint8_t*>(audio_frame), 
-            frame_size_bytes, 
-            &bytes_read
-        );
-        
-        if (result == ESP_OK && bytes_read == frame_size_bytes) {
-            size_t samples_read = bytes_read / sizeof(int16_t);
-            process_audio_frame(audio_frame, samples_read);
-            
-            samples_captured_ += samples_read;
-        } else {
-            ESP_LOGW(TAG, "I2S read failed or incomplete: %s, bytes: %d/%d", 
-                    esp_err_to_name(result), bytes_read, frame_size_bytes);
+        if (!i2s_driver_->wait_for_rx(event_timeout)) {
+            underrun_count_++;
+            ESP_LOGW(TAG, "No I2S DMA completion for %u ms (underruns: %u)",
+                    config_.frame_ms * 4, underrun_count_);
+            continue;
         }
         
-        // Maintain frame timing
-        vTaskDelayUntil(&last_wake_time, frame_period);
+        // Drain every completed buffer so a late wake-up never leaves frames behind
+        while (is_capturing_ && capture_frame(frame_size_bytes)) {
+        }
     }
     
-    free(audio_frame);
     ESP_LOGI(TAG, "Audio task ended");
 }
 
-void AudioManager::process_audio_frame(const int16_t* data, size_t samples) {
-    if (!data || samples == 0) return;
+bool AudioManager::capture_frame(size_t frame_size_bytes) {
+    AudioFrameRef frame = frame_pool_.acquire();
+    if (!frame) {
+        // Consumers hold every other frame; give up the oldest context frame
+        drop_oldest_back_frame();
+        frame = frame_pool_.acquire();
+    }
     
-    xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    // Read straight into the pool frame; this is the only sample copy. With
+    // no frame to spare, the DMA buffer is still drained so it cannot overrun.
+    int16_t* target = frame ? frame.get()->samples : discard_frame_.get();
+    size_t bytes_read = 0;
+    esp_err_t result = i2s_driver_->read_frame(
+        reinterpret_cast<uint8_t*>(target), 
+        frame_size_bytes, 
+        &bytes_read,
+        0
+    );
+    
+    if (result != ESP_OK || bytes_read == 0) {
+        return false;  // DMA ring drained
+    }
     
-    // Calculate audio level (RMS)
-    int64_t sum_squares = 0;
-    for (size_t i = 0; i < samples; i++) {
-        sum_squares += static_cast<int64_t>(data[i]) * data[i];
+    if (bytes_read != frame_size_bytes) {
+        underrun_count_++;
+        ESP_LOGW(TAG, "I2S read incomplete: %d/%d bytes", bytes_read, frame_size_bytes);
+        return false;
     }
-    current_audio_level_ = sqrtf(static_cast<float>(sum_squares) / samples) / 32768.0f;
     
-    // Store in back buffer for wake word context
-    if (back_buffer_) {
-        back_buffer_->write(reinterpret_cast<const uint8_t*>(data), 
-                          samples * sizeof(int16_t));
+    // Discarded frames too, so the reference stays one TX frame per mic frame
+    const int64_t captured_us = esp_timer_get_time();
+    cancel_echo(target, bytes_read / sizeof(int16_t), captured_us);
+    
+    if (!frame) {
+        dropped_frame_count_++;
+        if ((dropped_frame_count_ % 50) == 1) {
+            ESP_LOGW(TAG, "Capture frame pool exhausted, %u frames dropped", dropped_frame_count_);
+        }
+        return true;
     }
     
-    // Process with VAD
+    AudioFrame* filled = frame.get();
+    filled->sample_count = bytes_read / sizeof(int16_t);
+    filled->sequence = capture_sequence_++;
+    filled->timestamp_us = captured_us;
+    filled->stats = compute_frame_stats(filled->samples, filled->sample_count);
+    LatencyTrace::record(TraceEvent::I2S_FRAME_READY, static_cast<uint16_t>(filled->sequence));
+    
+    process_audio_frame(frame);
+    
+    samples_captured_ += filled->sample_count;
+    return true;
+}
+
+void AudioManager::process_audio_frame(const AudioFrameRef& frame) {
+    const size_t samples = frame.size();
+    if (!frame.data() || samples == 0) return;
+    
+    // Every per-frame statistic comes from the one pass in capture_frame()
+    const FrameStats& stats = frame.stats();
+    current_audio_level_ = stats.rms();
+    
+    // Process with VAD (state owned by this task)
     bool voice_detected = false;
     if (vad_processor_) {
-        voice_detected = vad_processor_->process_frame(data, samples);
+        voice_detected = vad_processor_->process_frame(stats);
         
         // Call VAD callback if voice state changed
         static bool last_voice_state = false;
@@ -295,15 +496,68 @@ void AudioManager::process_audio_frame(const int16_t* data, size_t samples) {
         }
     }
     
+    // Lock only to retain the frame in the history and sample the stream flag;
+    // a pending pre-roll goes out first, while the ring cannot move under it
+    xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    if (is_streaming_ && preroll_frames_ > 0) {
+        send_preroll();
+    }
+    history_.push(frame);
+    const bool streaming = is_streaming_;
+    xSemaphoreGive(audio_mutex_);
+    
     // Stream audio if active and voice detected
-    bool should_stream = is_streaming_ && (voice_detected || current_audio_level_ > 0.01f);
+    bool should_stream = streaming && (voice_detected || current_audio_level_ > 0.01f);
     
     if (should_stream && audio_data_callback_) {
-        audio_data_callback_(data, samples);
+        audio_data_callback_(frame);
         samples_streamed_ += samples;
     }
     
+    // Wake word gate + MFCC run here, outside the lock
+    if (capture_callback_) {
+        capture_callback_(frame);
+    }
+}
+
+void AudioManager::cancel_echo(int16_t* samples, size_t count, int64_t captured_us) {
+    if (!echo_canceller_) {
+        return;
+    }
+    
+    // The frame was recorded over the DMA period that ended just now
+    const int64_t window_start_us = captured_us - static_cast<int64_t>(config_.frame_ms) * 1000;
+    const int16_t* reference = echo_reference_->peek(window_start_us);
+    echo_canceller_->process(samples, reference, count);
+    if (reference) {
+        echo_reference_->pop();
+    }
+}
+
+void AudioManager::send_preroll() {
+    // Caller holds audio_mutex_; lends the newest frames straight from the
+    // history, as two spans when they wrap
+    const size_t count = preroll_frames_;
+    preroll_frames_ = 0;
+    if (count == 0 || !preroll_callback_) {
+        return;
+    }
+    
+    AudioFrameSpan head;
+    AudioFrameSpan tail;
+    const size_t lent = history_.newest_spans(count, head, tail);
+    if (lent == 0) {
+        return;
+    }
+    preroll_callback_(head, tail);
+    
+    samples_streamed_ += lent * config_.frame_size;
+}
+
+void AudioManager::drop_oldest_back_frame() {
+    xSemaphoreTake(audio_mutex_, portMAX_DELAY);
+    history_.drop_oldest();
     xSemaphoreGive(audio_mutex_);
 }
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
@@ -0,0 +1,259 @@
+#include "audio/audio_playback.hpp"
+#include "core/task_manager.hpp"
+#include "hardware/i2s_driver.hpp"
+#include "network/audio_encoder.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* TAG = "AudioPlayback";
+
+namespace irene {
+
+namespace {
+
+// A full jitter buffer holds the WebSocket task this long per message
+// (TCP then pushes back on the server) before audio is dropped
+constexpr uint32_t kMaxBlockMs = 500;
+
+} // namespace
+
+AudioPlayback::AudioPlayback()
+    : i2s_(nullptr)
+    , stream_valid_(false)
+    , message_capacity_(0)
+    , message_bytes_(0)
+    , decoded_capacity_(0)
+    , task_handle_(nullptr)
+    , running_(false)
+    , streams_(0)
+    , messages_(0)
+    , decode_errors_(0)
+    , oversize_drops_(0)
+    , cancels_(0) {
+}
+
+AudioPlayback::~AudioPlayback() {
+    stop();
+}
+
+ErrorCode AudioPlayback::initialize(const AudioConfig& config, I2SDriver* i2s) {
+    if (!i2s || config.playback_message_bytes == 0) {
+        ESP_LOGE(TAG, "Playback needs the I2S driver and a message size");
+        return ErrorCode::INIT_FAILED;
+    }
+
+    config_ = config;
+    i2s_ = i2s;
+
+    const size_t samples_per_ms = config.sample_rate / 1000;
+    ErrorCode result = jitter_.initialize(config.playback_buffer_ms * samples_per_ms,
+                                          config.playback_prebuffer_ms * samples_per_ms, true);
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+
+    // Decoded scratch for the densest framing (IMA-ADPCM, two samples a byte)
+    message_capacity_ = config.playback_message_bytes;
+    decoded_capacity_ = message_capacity_ * 2;
+    message_.reset(MemoryPlan::allocate_array<uint8_t>(MemoryRegion::PSRAM, message_capacity_, "AudioPlayback"));
+    decoded_.reset(MemoryPlan::allocate_array<int16_t>(MemoryRegion::PSRAM, decoded_capacity_, "AudioPlayback"));
+    frame_.reset(MemoryPlan::allocate_array<int16_t>(MemoryRegion::INTERNAL, config.frame_size, "AudioPlayback"));
+    if (!message_ || !decoded_ || !frame_) {
+        ESP_LOGE(TAG, "Failed to allocate playback buffers");
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    // Until a stream says otherwise, binary audio is raw PCM (the protocol default)
+    decoder_ = create_audio_decoder(AudioCodec::PCM16, config.sample_rate);
+    stream_valid_ = true;
+
+    ESP_LOGI(TAG, "Playback ready: %u ms buffer, %u ms prebuffer, %u byte messages",
+             config.playback_buffer_ms, config.playback_prebuffer_ms, (unsigned)message_capacity_);
+    return ErrorCode::SUCCESS;
+}
+
+ErrorCode AudioPlayback::start() {
+    if (running_) {
+        return ErrorCode::SUCCESS;
+    }
+
+    running_ = true;
+    ErrorCode result = TaskManager::instance().create_task(
+        "audio_playback",
+        playback_task_wrapper,
+        this,
+        config_.playback_stack_size,
+        config_.playback_priority,
+        config_.playback_core < 0 ? tskNO_AFFINITY : config_.playback_core,
+        &task_handle_
+    );
+
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to create playback task");
+        running_ = false;
+        return ErrorCode::AUDIO_FAILED;
+    }
+
+    return ErrorCode::SUCCESS;
+}
+
+void AudioPlayback::stop() {
+    running_ = false;
+
+    if (task_handle_) {
+        TaskManager::instance().delete_task(task_handle_);
+        task_handle_ = nullptr;
+    }
+}
+
+bool AudioPlayback::begin_stream(AudioCodec codec, uint32_t sample_rate) {
+    streams_++;
+    message_bytes_ = 0;
+
+    // I2S TX shares the capture clock: no resampling
+    if (sample_rate != 0 && sample_rate != config_.sample_rate) {
+        ESP_LOGW(TAG, "Cannot play %u Hz audio on the %u Hz I2S clock", sample_rate, config_.sample_rate);
+        stream_valid_ = false;
+        return false;
+    }
+
+    if (!decoder_ || decoder_->codec() != codec) {
+        decoder_ = create_audio_decoder(codec, config_.sample_rate);
+    } else {
+        decoder_->reset();
+    }
+
+    stream_valid_ = decoder_ != nullptr;
+    if (!stream_valid_) {
+        ESP_LOGW(TAG, "No %s decoder, stream ignored", audio_codec_name(codec));
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Playback stream %u: %s", streams_, audio_codec_name(codec));
+    return true;
+}
+
+void AudioPlayback::push(const uint8_t* data, size_t length, size_t offset, size_t total) {
+    if (!data || length == 0 || !stream_valid_) {
+        return;
+    }
+
+    // Common case: the whole message in one piece
+    if (offset == 0 && length >= total) {
+        decode_message(data, length);
+        return;
+    }
+
+    if (total > message_capacity_) {
+        if (offset == 0) {
+            oversize_drops_++;
+            ESP_LOGW(TAG, "Dropping %u byte audio message (max %u)", (unsigned)total, (unsigned)message_capacity_);
+        }
+        return;
+    }
+
+    // Pieces arrive in order; a gap restarts the message
+    if (offset != message_bytes_) {
+        message_bytes_ = 0;
+        if (offset != 0) {
+            return;
+        }
+    }
+
+    memcpy(message_.get() + offset, data, std::min(length, total - offset));
+    message_bytes_ = std::min(offset + length, total);
+    if (message_bytes_ == total) {
+        decode_message(message_.get(), total);
+        message_bytes_ = 0;
+    }
+}
+
+void AudioPlayback::end_stream() {
+    jitter_.end_of_stream();
+    if (task_handle_) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+void AudioPlayback::cancel() {
+    // The rest of the interrupted reply is dropped up to the next begin_stream()
+    stream_valid_ = false;
+    cancels_++;
+    jitter_.flush();
+    if (task_handle_) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+void AudioPlayback::get_stats(PlaybackStats& stats) const {
+    stats.streams = streams_;
+    stats.messages = messages_;
+    stats.decode_errors = decode_errors_;
+    stats.oversize_drops = oversize_drops_;
+    stats.cancels = cancels_;
+    stats.underruns = jitter_.get_underrun_count();
+    stats.overrun_samples = jitter_.get_overrun_samples();
+    stats.played_samples = jitter_.get_played_samples();
+    stats.buffered_samples = static_cast<uint32_t>(jitter_.buffered());
+}
+
+void AudioPlayback::decode_message(const uint8_t* payload, size_t bytes) {
+    const size_t samples = decoder_->decode(payload, bytes, decoded_.get(), decoded_capacity_);
+    if (samples == 0) {
+        decode_errors_++;
+        return;
+    }
+    messages_++;
+
+    // Faster-than-real-time senders wait here for the playback to catch up
+    const int64_t deadline_us = esp_timer_get_time() + static_cast<int64_t>(kMaxBlockMs) * 1000;
+    size_t queued = 0;
+    while (true) {
+        const size_t room = std::min(samples - queued, jitter_.capacity() - jitter_.buffered());
+        queued += jitter_.write(decoded_.get() + queued, room);
+        if (task_handle_) {
+            xTaskNotifyGive(task_handle_);
+        }
+        if (queued == samples || !running_ || !stream_valid_ || esp_timer_get_time() >= deadline_us) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(config_.frame_ms));
+    }
+
+    if (queued < samples && stream_valid_) {
+        jitter_.write(decoded_.get() + queued, samples - queued);  // Counts the overrun
+    }
+}
+
+void AudioPlayback::playback_task_wrapper(void* arg) {
+    static_cast<AudioPlayback*>(arg)->playback_task();
+}
+
+void AudioPlayback::playback_task() {
+    ESP_LOGI(TAG, "Playback task started");
+
+    const size_t frame_bytes = config_.frame_size * sizeof(int16_t);
+    const TickType_t idle_wait = pdMS_TO_TICKS(config_.frame_ms);
+
+    while (running_) {
+        if (!jitter_.read(frame_.get(), config_.frame_size)) {
+            // Buffering or idle: the TX DMA repeats silence; wake on new audio
+            ulTaskNotifyTake(pdTRUE, idle_wait);
+            continue;
+        }
+
+        // Blocks until a TX DMA buffer is free, which paces playback
+        esp_err_t result = i2s_->write_frame(reinterpret_cast<const uint8_t*>(frame_.get()), frame_bytes);
+        if (result != ESP_OK) {
+            ESP_LOGW(TAG, "I2S write failed: %s", esp_err_to_name(result));
+            vTaskDelay(idle_wait);
+        }
+    }
+
+    ESP_LOGI(TAG, "Playback task ended");
+}
+
+} // namespace irene
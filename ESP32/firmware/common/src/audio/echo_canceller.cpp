@@ -0,0 +1,179 @@
+#include "audio/echo_canceller.hpp"
+
+#include "esp_log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const char* TAG = "EchoCanceller";
+
+namespace irene {
+
+namespace {
+
+constexpr float kStepSize = 0.5f;                  // NLMS step, single talk
+constexpr float kDoubleTalkStep = kStepSize / 16;  // Crawl while someone talks over the playback
+constexpr float kRegularization = 100.0f;          // Per tap, a -50 dBFS floor on the reference power
+constexpr float kFarEndPower = 1.0e4f;             // Mean reference power that counts as playing (-30 dBFS)
+constexpr float kNearEndRatio = 4.0f;              // Residual 6 dB over its floor = near-end speech
+constexpr float kFloorSmoothing = 0.1f;            // Per far-end-only frame
+constexpr uint32_t kMaxDoubleTalkSamples = 16000;  // Longer than a phrase: the echo path moved
+constexpr float kResidualGain = 0.25f;             // Suppressor, far end only (-12 dB)
+
+inline int16_t saturate(float value) {
+    return static_cast<int16_t>(std::lrintf(std::max(-32768.0f, std::min(32767.0f, value))));
+}
+
+} // namespace
+
+EchoCanceller::EchoCanceller()
+    : taps_(0)
+    , max_frame_(0)
+    , tail_samples_(0)
+    , residual_floor_(1.0f)
+    , gain_(1.0f)
+    , double_talk_(false)
+    , double_talk_run_(0)
+    , active_frames_(0)
+    , double_talk_frames_(0) {
+}
+
+ErrorCode EchoCanceller::initialize(size_t taps, size_t max_frame) {
+    if (taps < 2 || max_frame == 0) {
+        ESP_LOGE(TAG, "Invalid geometry: %u taps, %u sample frames", (unsigned)taps, (unsigned)max_frame);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    // Sample-by-sample loops over both: internal RAM
+    weights_.reset(MemoryPlan::allocate_array<float>(MemoryRegion::INTERNAL, taps, "EchoCanceller"));
+    history_.reset(MemoryPlan::allocate_array<float>(MemoryRegion::INTERNAL, taps - 1 + max_frame, "EchoCanceller"));
+    if (!weights_ || !history_) {
+        ESP_LOGE(TAG, "Failed to allocate a %u tap filter", (unsigned)taps);
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    taps_ = taps;
+    max_frame_ = max_frame;
+    reset();
+
+    ESP_LOGI(TAG, "Echo canceller: %u taps", (unsigned)taps);
+    return ErrorCode::SUCCESS;
+}
+
+void EchoCanceller::reset() {
+    if (weights_) {
+        std::memset(weights_.get(), 0, taps_ * sizeof(float));
+        std::memset(history_.get(), 0, (taps_ - 1 + max_frame_) * sizeof(float));
+    }
+    tail_samples_ = 0;
+    residual_floor_ = 1.0f;
+    gain_ = 1.0f;
+    double_talk_ = false;
+    double_talk_run_ = 0;
+}
+
+float EchoCanceller::get_erle_db() const {
+    return -10.0f * std::log10(std::max(residual_floor_, 1.0e-6f));
+}
+
+void EchoCanceller::process(int16_t* mic, const int16_t* reference, size_t count) {
+    if (!weights_ || !mic || count == 0 || count > max_frame_) {
+        return;
+    }
+
+    // Nothing playing and the last echo has left the filter window
+    if (!reference && tail_samples_ == 0) {
+        gain_ = 1.0f;
+        double_talk_ = false;
+        double_talk_run_ = 0;
+        return;
+    }
+
+    float* x = history_.get();
+    float* frame = x + taps_ - 1;
+    float reference_energy = 0.0f;
+    if (reference) {
+        for (size_t i = 0; i < count; i++) {
+            frame[i] = reference[i];
+            reference_energy += frame[i] * frame[i];
+        }
+        tail_samples_ = taps_ - 1;
+    } else {
+        std::memset(frame, 0, count * sizeof(float));
+        tail_samples_ = tail_samples_ > count ? tail_samples_ - count : 0;
+    }
+    const bool far_end = reference_energy > kFarEndPower * count;
+
+    float* w = weights_.get();
+    const float step = double_talk_ ? kDoubleTalkStep : kStepSize;
+    const float regularization = kRegularization * taps_;
+
+    // Window n is x[n .. n + taps - 1], newest last; its power is kept running
+    float norm = 0.0f;
+    for (size_t k = 0; k < taps_; k++) {
+        norm += x[k] * x[k];
+    }
+
+    float mic_energy = 0.0f;
+    float error_energy = 0.0f;
+    for (size_t n = 0; n < count; n++) {
+        const float* window = x + n;
+        if (n > 0) {
+            norm = std::max(0.0f, norm + window[taps_ - 1] * window[taps_ - 1] - x[n - 1] * x[n - 1]);
+        }
+
+        float echo = 0.0f;
+        for (size_t k = 0; k < taps_; k++) {
+            echo += w[k] * window[k];
+        }
+
+        const float near = mic[n];
+        const float error = near - echo;
+        if (far_end) {
+            const float g = step * error / (norm + regularization);
+            for (size_t k = 0; k < taps_; k++) {
+                w[k] += g * window[k];
+            }
+        }
+
+        mic_energy += near * near;
+        error_energy += error * error;
+        mic[n] = saturate(error);
+    }
+
+    // Keep the newest taps - 1 reference samples for the next frame
+    std::memmove(x, x + count, (taps_ - 1) * sizeof(float));
+
+    if (far_end) {
+        active_frames_++;
+        const float ratio = error_energy / (mic_energy + 1.0f);
+        if (ratio > kNearEndRatio * residual_floor_) {
+            double_talk_ = true;
+            double_talk_frames_++;
+            double_talk_run_ += count;
+            if (double_talk_run_ > kMaxDoubleTalkSamples) {
+                residual_floor_ = std::min(ratio, 1.0f);  // Re-learn the floor
+                double_talk_run_ = 0;
+            }
+        } else {
+            double_talk_ = false;
+            double_talk_run_ = 0;
+            residual_floor_ += kFloorSmoothing * (std::min(ratio, 1.0f) - residual_floor_);
+        }
+    } else {
+        double_talk_ = false;
+        double_talk_run_ = 0;
+    }
+
+    // Residual echo suppressor, ramped across the frame
+    const float target = (far_end && !double_talk_) ? kResidualGain : 1.0f;
+    if (target != 1.0f || gain_ != 1.0f) {
+        const float slope = (target - gain_) / count;
+        for (size_t n = 0; n < count; n++) {
+            mic[n] = saturate(mic[n] * (gain_ + slope * (n + 1)));
+        }
+    }
+    gain_ = target;
+}
+
+} // namespace irene
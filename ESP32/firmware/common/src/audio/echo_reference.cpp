@@ -0,0 +1,94 @@
+#include "audio/echo_reference.hpp"
+
+#include "esp_log.h"
+#include <cstring>
+
+static const char* TAG = "EchoReference";
+
+namespace irene {
+
+EchoReference::EchoReference()
+    : frame_size_(0)
+    , frames_(0)
+    , head_(0)
+    , tail_(0)
+    , active_(false)
+    , runs_(0)
+    , dropped_frames_(0) {
+}
+
+ErrorCode EchoReference::initialize(size_t frame_size, size_t frames) {
+    if (frame_size == 0 || frames == 0) {
+        ESP_LOGE(TAG, "Invalid geometry: %u x %u samples", (unsigned)frames, (unsigned)frame_size);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    samples_.reset(MemoryPlan::allocate_array<int16_t>(MemoryRegion::PSRAM, frame_size * frames, "EchoReference"));
+    timestamps_.reset(MemoryPlan::allocate_array<int64_t>(MemoryRegion::INTERNAL, frames, "EchoReference"));
+    if (!samples_ || !timestamps_) {
+        ESP_LOGE(TAG, "Failed to allocate %u reference frames", (unsigned)frames);
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    frame_size_ = frame_size;
+    frames_ = frames;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    active_ = false;
+    return ErrorCode::SUCCESS;
+}
+
+void EchoReference::push(const int16_t* samples, size_t count, int64_t timestamp_us) {
+    if (!samples_ || !samples || count != frame_size_) {
+        return;
+    }
+
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= frames_) {
+        dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const size_t slot = head % frames_;
+    std::memcpy(samples_.get() + slot * frame_size_, samples, count * sizeof(int16_t));
+    timestamps_[slot] = timestamp_us;
+    head_.store(head + 1, std::memory_order_release);
+}
+
+const int16_t* EchoReference::peek(int64_t window_start_us) {
+    if (!samples_) {
+        return nullptr;
+    }
+
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) {
+        active_ = false;  // TX ring has played out
+        return nullptr;
+    }
+
+    const size_t slot = tail % frames_;
+    if (!active_) {
+        // Queued during this mic window: it plays from the next one
+        if (timestamps_[slot] > window_start_us) {
+            return nullptr;
+        }
+        active_ = true;
+        runs_++;
+    }
+
+    return samples_.get() + slot * frame_size_;
+}
+
+void EchoReference::pop() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) != tail) {
+        tail_.store(tail + 1, std::memory_order_release);
+    }
+}
+
+void EchoReference::reset() {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    active_ = false;
+}
+
+} // namespace irene
@@ -0,0 +1,106 @@
+#include "audio/feature_queue.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <cstring>
+
+static const char* TAG = "FeatureQueue";
+
+namespace irene {
+
+FeatureQueue::FeatureQueue()
+    : storage_(nullptr)
+    , discontinuity_(nullptr)
+    , slot_bytes_(0)
+    , depth_(0)
+    , head_(0)
+    , tail_(0)
+    , pending_discontinuity_(false)
+    , high_water_(0)
+    , dropped_count_(0) {
+}
+
+FeatureQueue::~FeatureQueue() {
+    MemoryPlan::release(storage_);
+    MemoryPlan::release(discontinuity_);
+}
+
+ErrorCode FeatureQueue::initialize(size_t slot_bytes, size_t depth, bool use_psram) {
+    if (slot_bytes == 0 || depth < 2) {
+        ESP_LOGE(TAG, "Invalid queue geometry: %u bytes x %u slots", (unsigned)slot_bytes, (unsigned)depth);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    storage_ = MemoryPlan::allocate_array<uint8_t>(use_psram ? MemoryRegion::PSRAM : MemoryRegion::INTERNAL,
+                                                   slot_bytes * depth, "FeatureQueue");
+    discontinuity_ = MemoryPlan::allocate_array<bool>(MemoryRegion::INTERNAL, depth, "FeatureQueue");
+
+    if (!storage_ || !discontinuity_) {
+        ESP_LOGE(TAG, "Failed to allocate %u x %u byte feature slots", (unsigned)depth, (unsigned)slot_bytes);
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    std::memset(discontinuity_, 0, depth * sizeof(bool));
+    slot_bytes_ = slot_bytes;
+    depth_ = depth;
+
+    ESP_LOGI(TAG, "Feature queue: %u slots x %u bytes in %s",
+             (unsigned)depth, (unsigned)slot_bytes, use_psram ? "PSRAM" : "internal RAM");
+    return ErrorCode::SUCCESS;
+}
+
+uint8_t* FeatureQueue::acquire_write() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+
+    if (head - tail >= depth_) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+        pending_discontinuity_ = true;
+        return nullptr;
+    }
+
+    return slot_data(head);
+}
+
+void FeatureQueue::commit_write() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    discontinuity_[head % depth_] = pending_discontinuity_;
+    pending_discontinuity_ = false;
+
+    // Publishes the slot contents and its flag to the consumer
+    head_.store(head + 1, std::memory_order_release);
+
+    const uint32_t used = static_cast<uint32_t>(head + 1 - tail_.load(std::memory_order_relaxed));
+    if (used > high_water_) {
+        high_water_ = used;
+    }
+}
+
+void FeatureQueue::mark_discontinuity() {
+    pending_discontinuity_ = true;
+}
+
+const uint8_t* FeatureQueue::acquire_read(bool* discontinuity) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+
+    if (tail == head) {
+        return nullptr;
+    }
+
+    if (discontinuity) {
+        *discontinuity = discontinuity_[tail % depth_];
+    }
+    return slot_data(tail);
+}
+
+void FeatureQueue::release_read() {
+    // Hands the slot back to the producer once the consumer is done with it
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+size_t FeatureQueue::size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+}
+
+} // namespace irene
@@ -0,0 +1,324 @@
+#include "audio/fft_engine.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <cmath>
+#include <cstring>
+
+static const char* TAG = "FFTEngine";
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace irene {
+
+namespace {
+
+inline void complex_mul(float& out_re, float& out_im,
+                        float a_re, float a_im, float b_re, float b_im) {
+    out_re = a_re * b_re - a_im * b_im;
+    out_im = a_re * b_im + a_im * b_re;
+}
+
+} // namespace
+
+FFTEngine::FFTEngine()
+    : initialized_(false)
+    , fft_size_(0)
+    , complex_size_(0)
+    , twiddles_(nullptr)
+    , split_twiddles_(nullptr)
+    , packed_input_(nullptr)
+    , spectrum_(nullptr) {
+    std::memset(factors_, 0, sizeof(factors_));
+}
+
+FFTEngine::~FFTEngine() {
+    MemoryPlan::release(twiddles_);
+    MemoryPlan::release(split_twiddles_);
+    MemoryPlan::release(packed_input_);
+    MemoryPlan::release(spectrum_);
+}
+
+ErrorCode FFTEngine::initialize(size_t fft_size) {
+    if (fft_size < 4 || (fft_size % 2) != 0) {
+        ESP_LOGE(TAG, "FFT size must be even and >= 4 (got %u)", (unsigned)fft_size);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    fft_size_ = fft_size;
+    complex_size_ = fft_size / 2;
+
+    if (!factorize(complex_size_)) {
+        ESP_LOGE(TAG, "FFT size %u has factors other than 2/3/5", (unsigned)fft_size);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    // Hot tables and scratch stay in internal RAM so the butterflies never
+    // stall on the PSRAM cache
+    const MemoryRegion region = MemoryRegion::INTERNAL;
+    const size_t bytes = complex_size_ * sizeof(Complex);
+
+    twiddles_ = MemoryPlan::allocate_array<Complex>(region, complex_size_, "FFTEngine");
+    split_twiddles_ = MemoryPlan::allocate_array<Complex>(region, complex_size_, "FFTEngine");
+    packed_input_ = MemoryPlan::allocate_array<Complex>(region, complex_size_, "FFTEngine");
+    spectrum_ = MemoryPlan::allocate_array<Complex>(region, complex_size_, "FFTEngine");
+
+    if (!twiddles_ || !split_twiddles_ || !packed_input_ || !spectrum_) {
+        ESP_LOGE(TAG, "Failed to allocate FFT tables (%u bytes each)", (unsigned)bytes);
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    for (size_t k = 0; k < complex_size_; k++) {
+        const double phase = -2.0 * M_PI * static_cast<double>(k) / complex_size_;
+        twiddles_[k].re = static_cast<float>(cos(phase));
+        twiddles_[k].im = static_cast<float>(sin(phase));
+
+        const double split_phase = -2.0 * M_PI * static_cast<double>(k) / fft_size_;
+        split_twiddles_[k].re = static_cast<float>(cos(split_phase));
+        split_twiddles_[k].im = static_cast<float>(sin(split_phase));
+    }
+
+    initialized_ = true;
+    ESP_LOGI(TAG, "FFT engine ready: %u-point real via %u-point mixed-radix complex",
+             (unsigned)fft_size_, (unsigned)complex_size_);
+
+    return ErrorCode::SUCCESS;
+}
+
+void FFTEngine::compute_power_spectrum(const float* input, float* power_spec) {
+    if (!initialized_ || !input || !power_spec) {
+        return;
+    }
+
+    // Pack even/odd samples as one complex sequence of half length
+    for (size_t m = 0; m < complex_size_; m++) {
+        packed_input_[m].re = input[2 * m];
+        packed_input_[m].im = input[2 * m + 1];
+    }
+
+    transform(spectrum_, packed_input_, 1, factors_);
+
+    // Split step: X[k] = E[k] + W^k * O[k], with E/O recovered from Z[k], Z[M-k]
+    const size_t half = complex_size_;
+
+    const float dc = spectrum_[0].re + spectrum_[0].im;
+    const float nyquist = spectrum_[0].re - spectrum_[0].im;
+    power_spec[0] = dc * dc;
+    power_spec[half] = nyquist * nyquist;
+
+    for (size_t k = 1; k < half; k++) {
+        const Complex& zk = spectrum_[k];
+        const Complex& zn = spectrum_[half - k];
+
+        // E = (Z[k] + conj(Z[M-k])) / 2, O = (Z[k] - conj(Z[M-k])) / 2i
+        const float even_re = 0.5f * (zk.re + zn.re);
+        const float even_im = 0.5f * (zk.im - zn.im);
+        const float odd_re = 0.5f * (zk.im + zn.im);
+        const float odd_im = -0.5f * (zk.re - zn.re);
+
+        float rot_re, rot_im;
+        complex_mul(rot_re, rot_im, odd_re, odd_im,
+                    split_twiddles_[k].re, split_twiddles_[k].im);
+
+        const float re = even_re + rot_re;
+        const float im = even_im + rot_im;
+        power_spec[k] = re * re + im * im;
+    }
+}
+
+bool FFTEngine::factorize(size_t n) {
+    size_t count = 0;
+    size_t radix = 4;
+
+    while (n > 1) {
+        while (n % radix != 0) {
+            switch (radix) {
+                case 4: radix = 2; break;
+                case 2: radix = 3; break;
+                case 3: radix = 5; break;
+                default: return false;
+            }
+        }
+
+        if (count >= MAX_FACTORS) {
+            return false;
+        }
+
+        n /= radix;
+        factors_[2 * count] = radix;
+        factors_[2 * count + 1] = n;
+        count++;
+    }
+
+    return count > 0;
+}
+
+void FFTEngine::transform(Complex* out, const Complex* in, size_t fstride, const size_t* factors) {
+    const size_t radix = factors[0];
+    const size_t m = factors[1];
+    Complex* const out_begin = out;
+    Complex* const out_end = out + radix * m;
+
+    if (m == 1) {
+        do {
+            *out = *in;
+            in += fstride;
+        } while (++out != out_end);
+    } else {
+        do {
+            transform(out, in, fstride * radix, factors + 2);
+            in += fstride;
+            out += m;
+        } while (out != out_end);
+    }
+
+    switch (radix) {
+        case 2: butterfly2(out_begin, fstride, m); break;
+        case 3: butterfly3(out_begin, fstride, m); break;
+        case 4: butterfly4(out_begin, fstride, m); break;
+        case 5: butterfly5(out_begin, fstride, m); break;
+        default: break;
+    }
+}
+
+void FFTEngine::butterfly2(Complex* out, size_t fstride, size_t m) {
+    Complex* out2 = out + m;
+    const Complex* tw = twiddles_;
+
+    for (size_t k = 0; k < m; k++) {
+        float t_re, t_im;
+        complex_mul(t_re, t_im, out2->re, out2->im, tw->re, tw->im);
+        tw += fstride;
+
+        out2->re = out->re - t_re;
+        out2->im = out->im - t_im;
+        out->re += t_re;
+        out->im += t_im;
+        ++out;
+        ++out2;
+    }
+}
+
+void FFTEngine::butterfly3(Complex* out, size_t fstride, size_t m) {
+    const size_t m2 = 2 * m;
+    const Complex* tw1 = twiddles_;
+    const Complex* tw2 = twiddles_;
+    const float epi3_im = twiddles_[fstride * m].im;
+
+    for (size_t k = 0; k < m; k++) {
+        Complex s1, s2, s3, s0;
+        complex_mul(s1.re, s1.im, out[m].re, out[m].im, tw1->re, tw1->im);
+        complex_mul(s2.re, s2.im, out[m2].re, out[m2].im, tw2->re, tw2->im);
+        tw1 += fstride;
+        tw2 += fstride * 2;
+
+        s3.re = s1.re + s2.re;
+        s3.im = s1.im + s2.im;
+        s0.re = (s1.re - s2.re) * epi3_im;
+        s0.im = (s1.im - s2.im) * epi3_im;
+
+        out[m].re = out->re - 0.5f * s3.re;
+        out[m].im = out->im - 0.5f * s3.im;
+        out->re += s3.re;
+        out->im += s3.im;
+
+        out[m2].re = out[m].re + s0.im;
+        out[m2].im = out[m].im - s0.re;
+        out[m].re -= s0.im;
+        out[m].im += s0.re;
+        ++out;
+    }
+}
+
+void FFTEngine::butterfly4(Complex* out, size_t fstride, size_t m) {
+    const size_t m2 = 2 * m;
+    const size_t m3 = 3 * m;
+    const Complex* tw1 = twiddles_;
+    const Complex* tw2 = twiddles_;
+    const Complex* tw3 = twiddles_;
+
+    for (size_t k = 0; k < m; k++) {
+        Complex s0, s1, s2, s3, s4, s5;
+        complex_mul(s0.re, s0.im, out[m].re, out[m].im, tw1->re, tw1->im);
+        complex_mul(s1.re, s1.im, out[m2].re, out[m2].im, tw2->re, tw2->im);
+        complex_mul(s2.re, s2.im, out[m3].re, out[m3].im, tw3->re, tw3->im);
+        tw1 += fstride;
+        tw2 += fstride * 2;
+        tw3 += fstride * 3;
+
+        s5.re = out->re - s1.re;
+        s5.im = out->im - s1.im;
+        out->re += s1.re;
+        out->im += s1.im;
+
+        s3.re = s0.re + s2.re;
+        s3.im = s0.im + s2.im;
+        s4.re = s0.re - s2.re;
+        s4.im = s0.im - s2.im;
+
+        out[m2].re = out->re - s3.re;
+        out[m2].im = out->im - s3.im;
+        out->re += s3.re;
+        out->im += s3.im;
+
+        out[m].re = s5.re + s4.im;
+        out[m].im = s5.im - s4.re;
+        out[m3].re = s5.re - s4.im;
+        out[m3].im = s5.im + s4.re;
+        ++out;
+    }
+}
+
+void FFTEngine::butterfly5(Complex* out, size_t fstride, size_t m) {
+    const Complex ya = twiddles_[fstride * m];
+    const Complex yb = twiddles_[fstride * 2 * m];
+
+    Complex* out0 = out;
+    Complex* out1 = out + m;
+    Complex* out2 = out + 2 * m;
+    Complex* out3 = out + 3 * m;
+    Complex* out4 = out + 4 * m;
+
+    for (size_t u = 0; u < m; u++) {
+        const Complex s0 = *out0;
+        Complex s1, s2, s3, s4;
+        complex_mul(s1.re, s1.im, out1->re, out1->im, twiddles_[u * fstride].re, twiddles_[u * fstride].im);
+        complex_mul(s2.re, s2.im, out2->re, out2->im, twiddles_[2 * u * fstride].re, twiddles_[2 * u * fstride].im);
+        complex_mul(s3.re, s3.im, out3->re, out3->im, twiddles_[3 * u * fstride].re, twiddles_[3 * u * fstride].im);
+        complex_mul(s4.re, s4.im, out4->re, out4->im, twiddles_[4 * u * fstride].re, twiddles_[4 * u * fstride].im);
+
+        const Complex s7 = {s1.re + s4.re, s1.im + s4.im};
+        const Complex s10 = {s1.re - s4.re, s1.im - s4.im};
+        const Complex s8 = {s2.re + s3.re, s2.im + s3.im};
+        const Complex s9 = {s2.re - s3.re, s2.im - s3.im};
+
+        out0->re = s0.re + s7.re + s8.re;
+        out0->im = s0.im + s7.im + s8.im;
+
+        const Complex s5 = {s0.re + s7.re * ya.re + s8.re * yb.re,
+                            s0.im + s7.im * ya.re + s8.im * yb.re};
+        const Complex s6 = {s10.im * ya.im + s9.im * yb.im,
+                            -s10.re * ya.im - s9.re * yb.im};
+
+        out1->re = s5.re - s6.re;
+        out1->im = s5.im - s6.im;
+        out4->re = s5.re + s6.re;
+        out4->im = s5.im + s6.im;
+
+        const Complex s11 = {s0.re + s7.re * yb.re + s8.re * ya.re,
+                             s0.im + s7.im * yb.re + s8.im * ya.re};
+        const Complex s12 = {-s10.im * yb.im + s9.im * ya.im,
+                             s10.re * yb.im - s9.re * ya.im};
+
+        out2->re = s11.re + s12.re;
+        out2->im = s11.im + s12.im;
+        out3->re = s11.re - s12.re;
+        out3->im = s11.im - s12.im;
+
+        ++out0; ++out1; ++out2; ++out3; ++out4;
+    }
+}
+
+} // namespace irene
@@ -0,0 +1,61 @@
+#include "audio/frame_stats.hpp"
+#include <cmath>
+
+namespace irene {
+
+float FrameStats::rms() const {
+    if (sample_count == 0) return 0.0f;
+    return sqrtf(static_cast<float>(sum_squares) / sample_count) / 32768.0f;
+}
+
+float FrameStats::zcr() const {
+    if (sample_count < 2) return 0.0f;
+    return static_cast<float>(zero_crossings) / (sample_count - 1);
+}
+
+FrameStats compute_frame_stats(const int16_t* samples, size_t count) {
+    FrameStats stats;
+    if (!samples || count == 0) {
+        return stats;
+    }
+    stats.sample_count = static_cast<uint32_t>(count);
+
+    uint64_t sum_squares = 0;
+    uint32_t crossings = 0;
+    uint32_t peak = 0;
+    int32_t previous = samples[0];
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const int32_t a = samples[i];
+        const int32_t b = samples[i + 1];
+
+        // |x| <= 32768, so each square fits 2^30 and the pair 2^31
+        sum_squares += static_cast<uint32_t>(a * a) + static_cast<uint32_t>(b * b);
+
+        // A crossing is a sign-bit change (>= 0 vs < 0)
+        crossings += static_cast<uint32_t>((previous ^ a) < 0) + static_cast<uint32_t>((a ^ b) < 0);
+        previous = b;
+
+        const uint32_t abs_a = static_cast<uint32_t>(a < 0 ? -a : a);
+        const uint32_t abs_b = static_cast<uint32_t>(b < 0 ? -b : b);
+        const uint32_t pair_peak = abs_a > abs_b ? abs_a : abs_b;
+        peak = pair_peak > peak ? pair_peak : peak;
+    }
+
+    // Odd tail
+    if (i < count) {
+        const int32_t a = samples[i];
+        sum_squares += static_cast<uint32_t>(a * a);
+        crossings += static_cast<uint32_t>((previous ^ a) < 0);
+        const uint32_t abs_a = static_cast<uint32_t>(a < 0 ? -a : a);
+        peak = abs_a > peak ? abs_a : peak;
+    }
+
+    stats.sum_squares = sum_squares;
+    stats.zero_crossings = crossings;
+    stats.peak = static_cast<uint16_t>(peak > 32767 ? 32767 : peak);
+    return stats;
+}
+
+} // namespace irene
@@ -0,0 +1,106 @@
+#include "audio/jitter_buffer.hpp"
+
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+static const char* TAG = "JitterBuffer";
+
+namespace irene {
+
+JitterBuffer::JitterBuffer()
+    : prebuffer_(0)
+    , end_of_stream_(false)
+    , flush_requested_(false)
+    , playing_(false)
+    , underruns_(0)
+    , overrun_samples_(0)
+    , played_samples_(0) {
+}
+
+ErrorCode JitterBuffer::initialize(size_t capacity_samples, size_t prebuffer_samples, bool use_psram) {
+    if (capacity_samples == 0 || prebuffer_samples > capacity_samples) {
+        ESP_LOGE(TAG, "Invalid geometry: %u samples, prebuffer %u",
+                 (unsigned)capacity_samples, (unsigned)prebuffer_samples);
+        return ErrorCode::INIT_FAILED;
+    }
+
+    try {
+        ring_ = std::make_unique<SPSCRingBuffer<int16_t>>(capacity_samples, use_psram);
+    } catch (const std::bad_alloc&) {
+        ESP_LOGE(TAG, "Failed to allocate %u sample jitter buffer", (unsigned)capacity_samples);
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    prebuffer_ = std::max<size_t>(prebuffer_samples, 1);
+    return ErrorCode::SUCCESS;
+}
+
+size_t JitterBuffer::write(const int16_t* samples, size_t count) {
+    if (!ring_ || !samples || count == 0) {
+        return 0;
+    }
+
+    end_of_stream_.store(false, std::memory_order_relaxed);
+    const size_t written = ring_->write(samples, count);
+    if (written < count) {
+        overrun_samples_.fetch_add(static_cast<uint32_t>(count - written), std::memory_order_relaxed);
+    }
+    return written;
+}
+
+void JitterBuffer::end_of_stream() {
+    end_of_stream_.store(true, std::memory_order_release);
+}
+
+void JitterBuffer::flush() {
+    flush_requested_.store(true, std::memory_order_release);
+}
+
+bool JitterBuffer::read(int16_t* out, size_t count) {
+    if (!ring_ || !out || count == 0) {
+        return false;
+    }
+
+    if (flush_requested_.exchange(false, std::memory_order_acquire)) {
+        ring_->clear();
+        playing_.store(false, std::memory_order_relaxed);
+    }
+
+    // Read the flag before the level: audio written before end_of_stream()
+    // is then always counted
+    const bool ending = end_of_stream_.load(std::memory_order_acquire);
+    const size_t available = ring_->available();
+
+    if (!playing_.load(std::memory_order_relaxed)) {
+        if (available < prebuffer_ && !(ending && available > 0)) {
+            return false;
+        }
+        playing_.store(true, std::memory_order_relaxed);
+    }
+
+    if (available >= count) {
+        ring_->read(out, count);
+        played_samples_.fetch_add(static_cast<uint32_t>(count), std::memory_order_relaxed);
+        return true;
+    }
+
+    if (ending && available > 0) {
+        // Tail of the stream: pad the last frame with silence
+        ring_->read(out, available);
+        std::memset(out + available, 0, (count - available) * sizeof(int16_t));
+        played_samples_.fetch_add(static_cast<uint32_t>(available), std::memory_order_relaxed);
+        playing_.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Dry: an underrun mid-stream, or the stream is over
+    if (!ending) {
+        underruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+    playing_.store(false, std::memory_order_relaxed);
+    return false;
+}
+
+} // namespace irene
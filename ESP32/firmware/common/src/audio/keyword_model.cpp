@@ -0,0 +1,566 @@
+#include "audio/keyword_model.hpp"
+#include "audio/mfcc_frontend.hpp"
+#include "audio/feature_queue.hpp"
+#include "audio/feature_quantizer.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <cstring>
+#include <algorithm>
+
+#include "tensorflow/lite/schema/schema_utils.h"
+
+static const char* TAG = "KeywordModel";
+
+namespace irene {
+
+namespace {
+
+// Streaming models declare one VAR_HANDLE per resource variable
+int count_resource_variables(const tflite::Model* model) {
+    const auto* opcodes = model->operator_codes();
+    const auto* subgraphs = model->subgraphs();
+    if (!opcodes || !subgraphs) {
+        return 0;
+    }
+
+    int count = 0;
+    for (const auto* subgraph : *subgraphs) {
+        const auto* operators = subgraph->operators();
+        if (!operators) continue;
+
+        for (const auto* op : *operators) {
+            const uint32_t index = op->opcode_index();
+            if (index < opcodes->size() &&
+                tflite::GetBuiltinCode(opcodes->Get(index)) == tflite::BuiltinOperator_VAR_HANDLE) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+KeywordModel::KeywordModel(const KeywordConfig& config, const uint8_t* model_data, size_t model_size)
+    : config_(config)
+    , model_data_(model_data)
+    , model_size_(model_size)
+    , model_(nullptr)
+    , interpreter_(nullptr)
+    , resolver_(nullptr)
+    , resource_variables_(nullptr)
+    , variable_arena_(nullptr)
+    , streaming_model_(false)
+    , model_input_frames_(MFCCFrontend::N_FRAMES)
+    , external_state_count_(0)
+    , int8_features_(false)
+    , next_publish_frame_(0)
+    , publish_interval_frames_(1)
+    , last_block_hops_(1)
+    , last_confidence_(0.0f)
+    , inference_count_(0)
+    , detection_count_(0) {
+}
+
+KeywordModel::~KeywordModel() {
+    destroy_interpreter();
+
+    if (resolver_) {
+        delete resolver_;
+    }
+
+    MemoryPlan::release(variable_arena_);
+}
+
+bool KeywordModel::load() {
+    ESP_LOGI(TAG, "Loading keyword model '%s' (%d bytes)", config_.name, model_size_);
+
+    if (!model_data_ || model_size_ == 0) {
+        ESP_LOGE(TAG, "Invalid model data for '%s'", config_.name);
+        return false;
+    }
+
+    // Load model from embedded data
+    model_ = tflite::GetModel(model_data_);
+    if (model_->version() != TFLITE_SCHEMA_VERSION) {
+        ESP_LOGE(TAG, "Model schema version %d not supported. Supported version is %d",
+                model_->version(), TFLITE_SCHEMA_VERSION);
+        return false;
+    }
+
+    // Streaming models keep their state in resource variables
+    if (count_resource_variables(model_) > 0) {
+        variable_arena_ = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, kVariableArenaSize,
+                                                              "KeywordModel");
+        if (!variable_arena_) {
+            ESP_LOGE(TAG, "Failed to allocate resource variable arena");
+            return false;
+        }
+    }
+
+    // Create and configure operation resolver (optimized for INT8)
+    resolver_ = new tflite::MicroMutableOpResolver<kOpResolverSize>();
+    resolver_->AddConv2D();
+    resolver_->AddMaxPool2D();
+    resolver_->AddReshape();
+    resolver_->AddMean();
+    resolver_->AddFullyConnected();
+    // Removed AddSoftmax() - typically unused for binary classification
+    resolver_->AddDepthwiseConv2D();
+    resolver_->AddAdd();
+    resolver_->AddMul();
+    resolver_->AddQuantize();
+    resolver_->AddDequantize();
+    // Streaming model ops
+    resolver_->AddCallOnce();
+    resolver_->AddVarHandle();
+    resolver_->AddReadVariable();
+    resolver_->AddAssignVariable();
+    resolver_->AddConcatenation();
+    resolver_->AddStridedSlice();
+    resolver_->AddLogistic();
+
+    return true;
+}
+
+bool KeywordModel::create_interpreter(uint8_t* arena, size_t arena_size) {
+    // Resource variables are rebuilt with each interpreter over the same storage
+    const int variable_count = count_resource_variables(model_);
+    if (variable_count > 0) {
+        tflite::MicroAllocator* variable_allocator =
+            tflite::MicroAllocator::Create(variable_arena_, kVariableArenaSize);
+        resource_variables_ = tflite::MicroResourceVariables::Create(variable_allocator, variable_count);
+        if (!resource_variables_) {
+            ESP_LOGE(TAG, "Failed to create %d resource variables", variable_count);
+            return false;
+        }
+
+        ESP_LOGI(TAG, "Model uses %d resource variables", variable_count);
+    }
+
+    interpreter_ = new tflite::MicroInterpreter(
+        model_, *resolver_, arena, arena_size, resource_variables_
+    );
+    return true;
+}
+
+bool KeywordModel::allocate_tensors() {
+    TfLiteStatus allocate_status = interpreter_->AllocateTensors();
+    if (allocate_status != kTfLiteOk) {
+        ESP_LOGW(TAG, "AllocateTensors() failed for '%s' with status: %d", config_.name, allocate_status);
+        return false;
+    }
+    return true;
+}
+
+void KeywordModel::destroy_interpreter() {
+    delete interpreter_;
+    interpreter_ = nullptr;
+    resource_variables_ = nullptr;
+}
+
+size_t KeywordModel::arena_used_bytes() const {
+    return interpreter_ ? interpreter_->arena_used_bytes() : 0;
+}
+
+const TfLiteTensor* KeywordModel::input() const {
+    return interpreter_ ? interpreter_->input(0) : nullptr;
+}
+
+ErrorCode KeywordModel::configure(bool int8_features, bool use_psram, uint32_t publish_interval_frames) {
+    // Log tensor information and validate INT8 types
+    TfLiteTensor* input = interpreter_->input(0);
+    TfLiteTensor* output = interpreter_->output(0);
+
+    ESP_LOGI(TAG, "Model input shape: [%d, %d, %d, %d]",
+             input->dims->data[0], input->dims->data[1],
+             input->dims->data[2], input->dims->data[3]);
+    ESP_LOGI(TAG, "Model input type: %d", input->type);
+    ESP_LOGI(TAG, "Model output shape: [%d]", output->dims->data[0]);
+    ESP_LOGI(TAG, "Model output type: %d", output->type);
+
+    // Validate and log quantization parameters for INT8 model
+    if (input->type == kTfLiteInt8) {
+        ESP_LOGI(TAG, "Input quantization: scale=%f, zero_point=%d",
+                input->params.scale, input->params.zero_point);
+    } else {
+        ESP_LOGW(TAG, "Warning: Expected INT8 input tensor, got type %d", input->type);
+    }
+
+    if (output->type == kTfLiteInt8) {
+        ESP_LOGI(TAG, "Output quantization: scale=%f, zero_point=%d",
+                output->params.scale, output->params.zero_point);
+    } else {
+        ESP_LOGW(TAG, "Warning: Expected INT8 output tensor, got type %d", output->type);
+    }
+
+    // Verify tensor dimensions match expected MFCC input (full window or streaming stride)
+    if (!configure_model_input(input)) {
+        return ErrorCode::WAKE_WORD_FAILED;
+    }
+
+    // Feature queue between the MFCC stage and the inference stage: a
+    // windowed model is double-buffered, a streaming model needs room for a
+    // full backfill burst of stride blocks
+    int8_features_ = int8_features;
+    const size_t element_bytes = int8_features ? sizeof(int8_t) : sizeof(float);
+    const size_t slot_bytes = model_input_frames_ * MFCCFrontend::N_MFCC * element_bytes;
+    const size_t queue_depth = streaming_model_ ?
+        (MFCCFrontend::N_FRAMES + model_input_frames_ - 1) / model_input_frames_ + 2 : 2;
+
+    feature_queue_ = std::make_unique<FeatureQueue>();
+    ErrorCode queue_result = feature_queue_->initialize(slot_bytes, queue_depth,
+                                                        use_psram && !int8_features);
+    if (queue_result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to create feature queue");
+        return queue_result;
+    }
+
+    publish_interval_frames_ = publish_interval_frames;
+
+    // Smoothing window and refractory period as inference and hop counts
+    const uint32_t block_ms = MFCCFrontend::HOP_SIZE_MS *
+        (streaming_model_ ? model_input_frames_ : publish_interval_frames_);
+    const size_t window = (config_.smoothing_ms + block_ms - 1) / block_ms;
+    smoother_.configure(config_.threshold, window, config_.refractory_ms / MFCCFrontend::HOP_SIZE_MS);
+    last_block_hops_ = block_ms / MFCCFrontend::HOP_SIZE_MS;
+
+    ESP_LOGI(TAG, "Keyword '%s': posterior smoothed over %d inference(s), %u ms refractory",
+             config_.name, smoother_.window(), config_.refractory_ms);
+
+    ESP_LOGI(TAG, "Keyword '%s' ready: %dx%d MFCC features, threshold %.3f, priority %u",
+             config_.name, model_input_frames_, MFCCFrontend::N_MFCC, config_.threshold, config_.priority);
+    return ErrorCode::SUCCESS;
+}
+
+bool KeywordModel::configure_model_input(const TfLiteTensor* input) {
+    size_t tensor_elements = 1;
+    for (int i = 0; i < input->dims->size; i++) {
+        tensor_elements *= input->dims->data[i];
+    }
+
+    if (tensor_elements == 0 || tensor_elements % MFCCFrontend::N_MFCC != 0 ||
+        tensor_elements > MFCCFrontend::FEATURE_SIZE) {
+        ESP_LOGE(TAG, "Tensor size mismatch: expected %d (or whole %d-coefficient frames), got %d",
+                MFCCFrontend::FEATURE_SIZE, MFCCFrontend::N_MFCC, tensor_elements);
+        return false;
+    }
+
+    model_input_frames_ = tensor_elements / MFCCFrontend::N_MFCC;
+    if (config_.input_frames != 0 && model_input_frames_ != config_.input_frames) {
+        ESP_LOGE(TAG, "Model takes %u MFCC frames, the node profile declares %u",
+                 (unsigned)model_input_frames_, config_.input_frames);
+        return false;
+    }
+    streaming_model_ = model_input_frames_ < MFCCFrontend::N_FRAMES;
+    external_state_count_ = 0;
+
+    if (!streaming_model_) {
+        return true;
+    }
+
+    // Extra inputs are state tensors fed back from the output of the same index
+    for (size_t i = 1; i < interpreter_->inputs_size(); i++) {
+        if (i >= interpreter_->outputs_size() ||
+            interpreter_->input(i)->bytes != interpreter_->output(i)->bytes) {
+            ESP_LOGE(TAG, "Streaming state input %d has no matching output", i);
+            return false;
+        }
+        external_state_count_++;
+    }
+
+    ESP_LOGI(TAG, "Streaming model: %d frame(s) per invoke, %d external state tensor(s)",
+             model_input_frames_, external_state_count_);
+    return true;
+}
+
+void KeywordModel::reset_model_state() {
+    if (!interpreter_) return;
+
+    // Clears variable tensors and resource variables
+    if (interpreter_->Reset() != kTfLiteOk) {
+        ESP_LOGW(TAG, "Failed to reset model state");
+    }
+
+    for (size_t i = 1; i <= external_state_count_; i++) {
+        TfLiteTensor* state = interpreter_->input(i);
+        const int fill = state->type == kTfLiteInt8 ? state->params.zero_point : 0;
+        std::memset(state->data.raw, fill, state->bytes);
+    }
+}
+
+bool KeywordModel::publish(const MFCCFrontend& frontend) {
+    const uint32_t available = frontend.get_frame_count();
+    bool published = false;
+
+    if (streaming_model_) {
+        // Streaming models consume every new frame, strictly in order
+        while (available - next_publish_frame_ >= model_input_frames_) {
+            published |= publish_frames(frontend, next_publish_frame_, model_input_frames_);
+            next_publish_frame_ += model_input_frames_;
+        }
+    } else if (frontend.has_sufficient_data() &&
+               available - next_publish_frame_ >= publish_interval_frames_) {
+        // Windowed models need a full matrix
+        published = publish_frames(frontend, available - MFCCFrontend::N_FRAMES, MFCCFrontend::N_FRAMES);
+        next_publish_frame_ = available;
+    }
+
+    return published;
+}
+
+bool KeywordModel::publish_frames(const MFCCFrontend& frontend, uint32_t first_frame, size_t n_frames) {
+    uint8_t* slot = feature_queue_->acquire_write();
+    if (!slot) {
+        return false; // Inference stage is behind; counted and flagged by the queue
+    }
+
+    const bool copied = int8_features_ ?
+        frontend.get_frames_int8(first_frame, n_frames, reinterpret_cast<int8_t*>(slot)) :
+        frontend.get_frames(first_frame, n_frames, reinterpret_cast<float*>(slot));
+
+    if (!copied) {
+        return false;
+    }
+
+    feature_queue_->commit_write();
+    return true;
+}
+
+void KeywordModel::restart() {
+    next_publish_frame_ = 0;
+
+    // Streaming state would otherwise continue from audio that is gone;
+    // the inference stage resets it when it sees the flag
+    if (feature_queue_) {
+        feature_queue_->mark_discontinuity();
+    }
+}
+
+bool KeywordModel::has_pending() const {
+    return feature_queue_ && feature_queue_->size() > 0;
+}
+
+bool KeywordModel::score_next(float& confidence) {
+    if (!feature_queue_ || !interpreter_) return false;
+
+    // A windowed model behind schedule only needs the newest matrix; the skipped
+    // hops still count for the smoother, and a gap among them still resets it
+    uint32_t blocks = 1;
+    bool discontinuity = false;
+    if (!streaming_model_) {
+        bool skipped_gap = false;
+        while (feature_queue_->size() > 1 && feature_queue_->acquire_read(&skipped_gap)) {
+            feature_queue_->release_read();
+            discontinuity |= skipped_gap;
+            blocks++;
+        }
+    }
+
+    bool newest_gap = false;
+    const uint8_t* block = feature_queue_->acquire_read(&newest_gap);
+    if (!block) {
+        return false;
+    }
+    discontinuity |= newest_gap;
+
+    // Dropped blocks or a frontend reset break the streaming state and the
+    // posterior sequence
+    if (discontinuity) {
+        if (streaming_model_) {
+            reset_model_state();
+        }
+        smoother_.reset();
+    }
+    last_block_hops_ = blocks * (streaming_model_ ? model_input_frames_ : publish_interval_frames_);
+
+    if (int8_features_) {
+        // Quantized features are copied straight into the input tensor
+        std::memcpy(interpreter_->input(0)->data.int8, block, feature_queue_->slot_bytes());
+        confidence = invoke_model();
+    } else {
+        confidence = run_inference(reinterpret_cast<const float*>(block),
+                                   model_input_frames_ * MFCCFrontend::N_MFCC);
+    }
+
+    feature_queue_->release_read();
+    inference_count_++;
+    last_confidence_ = confidence;
+    return true;
+}
+
+bool KeywordModel::update_detection(float confidence) {
+    // Note: Threshold may need re-tuning for INT8 quantized models
+    // INT8 quantization can shift the confidence score distribution
+    // Consider using trainer-suggested threshold or empirical validation
+    if (!smoother_.update(confidence, last_block_hops_)) {
+        return false;
+    }
+
+    detection_count_++;
+    return true;
+}
+
+void KeywordModel::perform_sanity_checks(size_t arena_size, bool arena_internal) {
+    ESP_LOGI(TAG, "=== Device Sanity Checklist ('%s') ===", config_.name);
+
+    if (!interpreter_) {
+        ESP_LOGE(TAG, "Sanity check failed: No interpreter available");
+        return;
+    }
+
+    // C2.1: Log input/output types + scales/zero points
+    TfLiteTensor* input = interpreter_->input(0);
+    TfLiteTensor* output = interpreter_->output(0);
+
+    ESP_LOGI(TAG, "Input tensor: type=%s, scale=%f, zero_point=%d",
+             input->type == kTfLiteInt8 ? "INT8" :
+             input->type == kTfLiteFloat32 ? "FLOAT32" : "UNKNOWN",
+             input->params.scale, input->params.zero_point);
+
+    ESP_LOGI(TAG, "Output tensor: type=%s, scale=%f, zero_point=%d",
+             output->type == kTfLiteInt8 ? "INT8" :
+             output->type == kTfLiteFloat32 ? "FLOAT32" : "UNKNOWN",
+             output->params.scale, output->params.zero_point);
+
+    // C2.2: Log input dimensions and arena size used vs. reserved
+    ESP_LOGI(TAG, "Input dimensions: [%d, %d, %d, %d] (%d elements)",
+             input->dims->data[0], input->dims->data[1],
+             input->dims->data[2], input->dims->data[3],
+             input->bytes / (input->type == kTfLiteInt8 ? sizeof(int8_t) : sizeof(float)));
+
+    // Calculate actual arena usage
+    const size_t arena_used = interpreter_->arena_used_bytes();
+    ESP_LOGI(TAG, "Tensor arena: %d KB used / %d KB reserved in %s (%.1f%% utilization)",
+             arena_used / 1024, arena_size / 1024,
+             arena_internal ? "internal RAM" : "PSRAM",
+             (arena_used * 100.0f) / arena_size);
+
+    // C2.3: One-off test: feed zeros MFCC and confirm stable low score
+    ESP_LOGI(TAG, "Running zero-input stability test...");
+
+    // Create zero MFCC features
+    const size_t feature_size = MFCCFrontend::N_FRAMES * MFCCFrontend::N_MFCC;
+    PlanArray<float> zero_features(
+        MemoryPlan::allocate_array<float>(MemoryRegion::PSRAM, feature_size, "KeywordModel"));
+    if (!zero_features) {
+        ESP_LOGW(TAG, "No memory for the zero-input test, skipped");
+        return;
+    }
+    std::fill_n(zero_features.get(), feature_size, 0.0f);
+
+    // Run inference with zero input
+    float zero_confidence = run_inference(zero_features.get(), feature_size);
+
+    ESP_LOGI(TAG, "Zero-input confidence: %.6f", zero_confidence);
+
+    // Validate stable low score (should be well below threshold)
+    const float expected_max_zero_confidence = 0.1f; // Conservative threshold
+    if (zero_confidence > expected_max_zero_confidence) {
+        ESP_LOGW(TAG, "Warning: Zero-input confidence (%.6f) higher than expected (%.6f)",
+                zero_confidence, expected_max_zero_confidence);
+        ESP_LOGW(TAG, "This may indicate model bias or quantization issues");
+    } else {
+        ESP_LOGI(TAG, "✓ Zero-input test passed: stable low confidence");
+    }
+
+    // Discard the state the test invoke left behind
+    if (streaming_model_) {
+        reset_model_state();
+    }
+
+    // Additional shape validation
+    size_t expected_input_elements = model_input_frames_ * MFCCFrontend::N_MFCC;
+    size_t actual_input_elements = input->bytes / (input->type == kTfLiteInt8 ? sizeof(int8_t) : sizeof(float));
+
+    if (actual_input_elements != expected_input_elements) {
+        ESP_LOGE(TAG, "Shape error: Expected %d input elements, got %d",
+                expected_input_elements, actual_input_elements);
+    } else {
+        ESP_LOGI(TAG, "✓ Input shape validation passed");
+    }
+
+    ESP_LOGI(TAG, "=== Sanity Check Complete ===");
+}
+
+float KeywordModel::run_inference(const float* mfcc_features, size_t feature_count) {
+    if (!interpreter_ || !mfcc_features || feature_count == 0) {
+        return 0.0f;
+    }
+
+    // Get input tensor
+    TfLiteTensor* input = interpreter_->input(0);
+    if (!input || input->bytes == 0) {
+        ESP_LOGE(TAG, "Invalid input tensor");
+        return 0.0f;
+    }
+
+    // Handle INT8 quantized input
+    if (input->type == kTfLiteInt8) {
+        // Quantize MFCC features to INT8, zero-padding the rest of the tensor
+        quantize_features_int8(mfcc_features, feature_count,
+                               input->data.int8, input->bytes / sizeof(int8_t),
+                               input->params.scale, input->params.zero_point);
+    } else if (input->type == kTfLiteFloat32) {
+        // Fallback to float32 for compatibility
+        float* input_data = input->data.f;
+        size_t input_elements = input->bytes / sizeof(float);
+        size_t copy_elements = std::min(feature_count, input_elements);
+
+        std::memcpy(input_data, mfcc_features, copy_elements * sizeof(float));
+
+        // Zero-pad if necessary
+        for (size_t i = copy_elements; i < input_elements; i++) {
+            input_data[i] = 0.0f;
+        }
+    } else {
+        ESP_LOGE(TAG, "Unsupported input tensor type: %d", input->type);
+        return 0.0f;
+    }
+
+    return invoke_model();
+}
+
+float KeywordModel::invoke_model() {
+    // Run inference
+    TfLiteStatus invoke_status = interpreter_->Invoke();
+    if (invoke_status != kTfLiteOk) {
+        ESP_LOGE(TAG, "Invoke() failed with status: %d", invoke_status);
+        return 0.0f;
+    }
+
+    // Feed streaming state outputs back for the next invoke
+    for (size_t i = 1; i <= external_state_count_; i++) {
+        std::memcpy(interpreter_->input(i)->data.raw, interpreter_->output(i)->data.raw,
+                    interpreter_->input(i)->bytes);
+    }
+
+    // Get output
+    TfLiteTensor* output = interpreter_->output(0);
+    if (!output || output->bytes == 0) {
+        ESP_LOGE(TAG, "Invalid output tensor");
+        return 0.0f;
+    }
+
+    float confidence = 0.0f;
+
+    // Handle INT8 quantized output
+    if (output->type == kTfLiteInt8) {
+        confidence = dequantize_int8(output->data.int8[0], output->params.scale,
+                                     output->params.zero_point);
+    } else if (output->type == kTfLiteFloat32) {
+        // Direct float32 output
+        confidence = output->data.f[0];
+    } else {
+        ESP_LOGE(TAG, "Unsupported output tensor type: %d", output->type);
+        return 0.0f;
+    }
+
+    // Clamp confidence to valid range
+    confidence = std::max(0.0f, std::min(1.0f, confidence));
+
+    return confidence;
+}
+
+} // namespace irene
@@ -1,7 +1,7 @@
 #include "audio/mfcc_frontend.hpp"
 
 #include "esp_log.h"
-#include "esp_heap_caps.h"
+#include "esp_attr.h"
 #include <cmath>
 #include <cstring>
 #include <algorithm>
@@ -15,12 +15,191 @@ static const char* TAG = "MFCCFrontend";
 
 namespace irene {
 
+namespace {
+
+constexpr size_t N_FFT_BINS = MFCCFrontend::WINDOW_SAMPLES / 2 + 1;
+constexpr size_t N_MEL_POINTS = MFCCFrontend::N_MELS + 2;
+
+// Compile-time math for the constant tables (<cmath> is not constexpr in C++17)
+constexpr double CONST_PI = 3.14159265358979323846;
+constexpr double CONST_LN2 = 0.69314718055994530942;
+constexpr double CONST_LN10 = 2.30258509299404568402;
+
+constexpr double const_cos(double x) {
+    while (x > CONST_PI) x -= 2.0 * CONST_PI;
+    while (x < -CONST_PI) x += 2.0 * CONST_PI;
+    
+    const double x2 = x * x;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= -x2 / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double const_exp(double x) {
+    // exp(x) = exp(x / 2^k)^(2^k), series on |x| <= 0.5
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x *= 0.5;
+        halvings++;
+    }
+    
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+constexpr double const_log(double x) {
+    // ln(x) = k*ln2 + 2*atanh((m - 1) / (m + 1)), m in [1, 2)
+    int exponent = 0;
+    while (x >= 2.0) { x *= 0.5; exponent++; }
+    while (x < 1.0) { x *= 2.0; exponent--; }
+    
+    const double y = (x - 1.0) / (x + 1.0);
+    const double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 0; n < 40; n++) {
+        sum += term / (2.0 * n + 1.0);
+        term *= y2;
+    }
+    return 2.0 * sum + exponent * CONST_LN2;
+}
+
+constexpr double const_sqrt(double x) {
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) {
+        r = 0.5 * (r + x / r);
+    }
+    return r;
+}
+
+// Triangular mel filter edges as FFT bin numbers
+struct MelBinPoints {
+    size_t bins[N_MEL_POINTS];
+};
+
+constexpr MelBinPoints make_mel_bin_points() {
+    MelBinPoints points{};
+    const double mel_high = 2595.0 * const_log(1.0 + (MFCCFrontend::SAMPLE_RATE / 2.0) / 700.0) / CONST_LN10;
+    
+    for (size_t i = 0; i < N_MEL_POINTS; i++) {
+        const double mel = mel_high * i / (MFCCFrontend::N_MELS + 1);
+        const double hz = 700.0 * (const_exp(mel / 2595.0 * CONST_LN10) - 1.0);
+        points.bins[i] = static_cast<size_t>((MFCCFrontend::WINDOW_SAMPLES + 1) * hz / MFCCFrontend::SAMPLE_RATE);
+    }
+    return points;
+}
+
+constexpr MelBinPoints MEL_BIN_POINTS = make_mel_bin_points();
+
+constexpr size_t count_mel_weights() {
+    size_t count = 0;
+    for (size_t m = 0; m < MFCCFrontend::N_MELS; m++) {
+        count += MEL_BIN_POINTS.bins[m + 2] - MEL_BIN_POINTS.bins[m];
+    }
+    return count;
+}
+
+constexpr size_t MEL_WEIGHT_COUNT = count_mel_weights();
+
+static_assert(MEL_BIN_POINTS.bins[N_MEL_POINTS - 1] <= N_FFT_BINS, "Mel filters exceed FFT bins");
+
+// Sparse filterbank: each filter is one run of non-zero-support weights
+struct MelRun {
+    uint16_t start_bin;
+    uint16_t length;
+    uint16_t weight_offset;
+};
+
+struct MelFilterbank {
+    MelRun runs[MFCCFrontend::N_MELS];
+    float weights[MEL_WEIGHT_COUNT];
+};
+
+constexpr MelFilterbank make_mel_filterbank() {
+    MelFilterbank filterbank{};
+    size_t offset = 0;
+    
+    for (size_t m = 0; m < MFCCFrontend::N_MELS; m++) {
+        const size_t left = MEL_BIN_POINTS.bins[m];
+        const size_t center = MEL_BIN_POINTS.bins[m + 1];
+        const size_t right = MEL_BIN_POINTS.bins[m + 2];
+        
+        filterbank.runs[m].start_bin = static_cast<uint16_t>(left);
+        filterbank.runs[m].length = static_cast<uint16_t>(right - left);
+        filterbank.runs[m].weight_offset = static_cast<uint16_t>(offset);
+        
+        for (size_t k = left; k < center; k++) {
+            filterbank.weights[offset++] = static_cast<float>(k - left) / static_cast<float>(center - left);
+        }
+        for (size_t k = center; k < right; k++) {
+            filterbank.weights[offset++] = static_cast<float>(right - k) / static_cast<float>(right - center);
+        }
+    }
+    return filterbank;
+}
+
+struct HannWindow {
+    float values[MFCCFrontend::WINDOW_SAMPLES];
+};
+
+constexpr HannWindow make_hann_window() {
+    HannWindow window{};
+    for (size_t i = 0; i < MFCCFrontend::WINDOW_SAMPLES; i++) {
+        // int16 -> [-1, 1) normalisation is folded into the window
+        const double hann = 0.5 * (1.0 - const_cos(2.0 * CONST_PI * i / (MFCCFrontend::WINDOW_SAMPLES - 1)));
+        window.values[i] = static_cast<float>(hann / 32768.0);
+    }
+    return window;
+}
+
+struct DctMatrix {
+    float values[MFCCFrontend::N_MFCC * MFCCFrontend::N_MELS];
+};
+
+constexpr DctMatrix make_dct_matrix() {
+    DctMatrix dct{};
+    for (size_t i = 0; i < MFCCFrontend::N_MFCC; i++) {
+        const double norm = const_sqrt((i == 0 ? 1.0 : 2.0) / MFCCFrontend::N_MELS);
+        for (size_t j = 0; j < MFCCFrontend::N_MELS; j++) {
+            const double basis = const_cos(CONST_PI * i * (j + 0.5) / MFCCFrontend::N_MELS);
+            dct.values[i * MFCCFrontend::N_MELS + j] = static_cast<float>(basis * norm);
+        }
+    }
+    return dct;
+}
+
+// Built at compile time; the filterbank is read every frame, so it lives in
+// internal DRAM, the window and DCT stay in flash .rodata
+DRAM_ATTR constexpr MelFilterbank MEL_FILTERBANK = make_mel_filterbank();
+constexpr HannWindow HANN_WINDOW = make_hann_window();
+constexpr DctMatrix DCT_MATRIX = make_dct_matrix();
+
+} // namespace
+
 MFCCFrontend::MFCCFrontend()
     : initialized_(false)
     , use_psram_(true)
     , buffer_write_pos_(0)
     , samples_available_(0)
-    , feature_frame_count_(0) {
+    , samples_until_frame_(WINDOW_SAMPLES)
+    , feature_write_index_(0)
+    , feature_frame_count_(0)
+    , frame_counter_(0)
+    , int8_output_(false)
+    , output_scale_(1.0f)
+    , output_zero_point_(0) {
 }
 
 MFCCFrontend::~MFCCFrontend() {
@@ -32,8 +211,8 @@ ErrorCode MFCCFrontend::initialize(bool use_psram) {
     
     use_psram_ = use_psram;
     
-    // Allocate audio input buffer
-    size_t audio_buffer_bytes = INPUT_BUFFER_SIZE * sizeof(int16_t);
+    // Allocate audio input buffer (one analysis window of history)
+    size_t audio_buffer_bytes = WINDOW_SAMPLES * sizeof(int16_t);
     audio_buffer_.reset(static_cast<int16_t*>(allocate_buffer(audio_buffer_bytes)));
     if (!audio_buffer_) {
         ESP_LOGE(TAG, "Failed to allocate audio buffer (%d bytes)", audio_buffer_bytes);
@@ -42,13 +221,12 @@ ErrorCode MFCCFrontend::initialize(bool use_psram) {
     
     // Allocate MFCC computation buffers
     windowed_samples_.reset(static_cast<float*>(allocate_buffer(WINDOW_SAMPLES * sizeof(float))));
-    fft_buffer_.reset(static_cast<float*>(allocate_buffer(WINDOW_SAMPLES * 2 * sizeof(float)))); // Complex FFT
     power_spectrum_.reset(static_cast<float*>(allocate_buffer((WINDOW_SAMPLES/2 + 1) * sizeof(float))));
     mel_energies_.reset(static_cast<float*>(allocate_buffer(N_MELS * sizeof(float))));
     log_mel_energies_.reset(static_cast<float*>(allocate_buffer(N_MELS * sizeof(float))));
     mfcc_coeffs_.reset(static_cast<float*>(allocate_buffer(N_MFCC * sizeof(float))));
     
-    if (!windowed_samples_ || !fft_buffer_ || !power_spectrum_ || 
+    if (!windowed_samples_ || !power_spectrum_ || 
         !mel_energies_ || !log_mel_energies_ || !mfcc_coeffs_) {
         ESP_LOGE(TAG, "Failed to allocate MFCC computation buffers");
         return ErrorCode::MEMORY_ERROR;
@@ -61,20 +239,11 @@ ErrorCode MFCCFrontend::initialize(bool use_psram) {
         return ErrorCode::MEMORY_ERROR;
     }
     
-    // Allocate precomputed tables
-    hann_window_.reset(static_cast<float*>(allocate_buffer(WINDOW_SAMPLES * sizeof(float))));
-    mel_filterbank_.reset(static_cast<float*>(allocate_buffer(N_MELS * (WINDOW_SAMPLES/2 + 1) * sizeof(float))));
-    dct_matrix_.reset(static_cast<float*>(allocate_buffer(N_MFCC * N_MELS * sizeof(float))));
-    
-    if (!hann_window_ || !mel_filterbank_ || !dct_matrix_) {
-        ESP_LOGE(TAG, "Failed to allocate precomputed tables");
-        return ErrorCode::MEMORY_ERROR;
-    }
-    
-    // Setup precomputed tables
-    if (!setup_tables()) {
-        ESP_LOGE(TAG, "Failed to setup precomputed tables");
-        return ErrorCode::WAKE_WORD_FAILED;
+    // Setup FFT engine (480-point real transform)
+    ErrorCode fft_result = fft_engine_.initialize(WINDOW_SAMPLES);
+    if (fft_result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to initialize FFT engine");
+        return fft_result;
     }
     
     // Initialize state
@@ -84,6 +253,8 @@ ErrorCode MFCCFrontend::initialize(bool use_psram) {
     ESP_LOGI(TAG, "MFCC frontend initialized successfully");
     ESP_LOGI(TAG, "Parameters: %d Hz, %d ms window, %d ms hop, %d mels, %d MFCCs, %dx%d features",
              SAMPLE_RATE, WINDOW_SIZE_MS, HOP_SIZE_MS, N_MELS, N_MFCC, N_FRAMES, N_MFCC);
+    ESP_LOGI(TAG, "Static tables: %d mel weights (sparse), %d DCT coefficients",
+             MEL_WEIGHT_COUNT, N_MFCC * N_MELS);
     
     return ErrorCode::SUCCESS;
 }
@@ -93,190 +264,220 @@ bool MFCCFrontend::process_samples(const int16_t* audio_data, size_t samples) {
         return false;
     }
     
-    // Add samples to ring buffer
-    for (size_t i = 0; i < samples; i++) {
-        audio_buffer_[buffer_write_pos_] = audio_data[i];
-        buffer_write_pos_ = (buffer_write_pos_ + 1) % INPUT_BUFFER_SIZE;
-        
-        if (samples_available_ < INPUT_BUFFER_SIZE) {
-            samples_available_++;
-        }
-    }
+    bool new_frame = false;
     
-    // Check if we can extract features (need enough data for 49 frames)
-    if (samples_available_ >= INPUT_BUFFER_SIZE) {
-        // Extract MFCC features frame by frame
-        size_t start_pos = (buffer_write_pos_ >= INPUT_BUFFER_SIZE) ? 
-                          (buffer_write_pos_ - INPUT_BUFFER_SIZE) : 
-                          (INPUT_BUFFER_SIZE + buffer_write_pos_ - INPUT_BUFFER_SIZE);
+    // Consume input up to each frame boundary; a frame is computed whenever
+    // a new hop completes a full window, so steady state is one window per hop
+    while (samples > 0) {
+        size_t chunk = std::min(samples, samples_until_frame_);
+        write_samples(audio_data, chunk);
         
-        feature_frame_count_ = 0;
+        audio_data += chunk;
+        samples -= chunk;
+        samples_until_frame_ -= chunk;
         
-        for (size_t frame = 0; frame < N_FRAMES; frame++) {
-            size_t frame_start = start_pos + frame * HOP_SAMPLES;
-            
-            // Extract windowed frame
-            for (size_t i = 0; i < WINDOW_SAMPLES; i++) {
-                size_t pos = (frame_start + i) % INPUT_BUFFER_SIZE;
-                windowed_samples_[i] = static_cast<float>(audio_buffer_[pos]) / 32768.0f;
-            }
-            
-            // Compute power spectrum
-            compute_power_spectrum(windowed_samples_.get(), power_spectrum_.get());
-            
-            // Apply mel filterbank
-            apply_mel_filterbank(power_spectrum_.get(), mel_energies_.get());
-            
-            // Compute MFCC
-            compute_mfcc(mel_energies_.get(), mfcc_coeffs_.get());
-            
-            // Update feature matrix
-            update_feature_matrix(mfcc_coeffs_.get());
+        if (samples_until_frame_ == 0) {
+            compute_frame();
+            samples_until_frame_ = HOP_SAMPLES;
+            new_frame = true;
         }
-        
-        return true; // New features available
     }
     
-    return false;
+    // New features once the circular frame store holds a full matrix
+    return new_frame && feature_frame_count_ == N_FRAMES;
 }
 
 bool MFCCFrontend::get_features(float* features) const {
-    if (!initialized_ || !features || feature_frame_count_ != N_FRAMES) {
+    // Linearize the circular frame store, oldest frame first
+    return get_frames(frame_counter_ - N_FRAMES, N_FRAMES, features);
+}
+
+bool MFCCFrontend::get_features_int8(int8_t* features) const {
+    return get_frames_int8(frame_counter_ - N_FRAMES, N_FRAMES, features);
+}
+
+bool MFCCFrontend::get_frames(uint32_t first_frame, size_t n_frames, float* features) const {
+    size_t slot = 0;
+    if (!initialized_ || int8_output_ || !features || !locate_frames(first_frame, n_frames, slot)) {
         return false;
     }
     
-    std::memcpy(features, features_.get(), FEATURE_SIZE * sizeof(float));
+    const size_t tail_frames = std::min(n_frames, N_FRAMES - slot);
+    std::memcpy(features, &features_[slot * N_MFCC], tail_frames * N_MFCC * sizeof(float));
+    if (n_frames > tail_frames) {
+        std::memcpy(features + tail_frames * N_MFCC, features_.get(), 
+                    (n_frames - tail_frames) * N_MFCC * sizeof(float));
+    }
+    
     return true;
 }
 
+bool MFCCFrontend::get_frames_int8(uint32_t first_frame, size_t n_frames, int8_t* features) const {
+    size_t slot = 0;
+    if (!initialized_ || !int8_output_ || !features || !locate_frames(first_frame, n_frames, slot)) {
+        return false;
+    }
+    
+    const size_t tail_frames = std::min(n_frames, N_FRAMES - slot);
+    std::memcpy(features, &features_int8_[slot * N_MFCC], tail_frames * N_MFCC);
+    if (n_frames > tail_frames) {
+        std::memcpy(features + tail_frames * N_MFCC, features_int8_.get(), 
+                    (n_frames - tail_frames) * N_MFCC);
+    }
+    
+    return true;
+}
+
+bool MFCCFrontend::locate_frames(uint32_t first_frame, size_t n_frames, size_t& slot) const {
+    // Ages are wrap-safe distances back from the newest frame
+    const uint32_t age = frame_counter_ - first_frame;
+    if (n_frames == 0 || age > feature_frame_count_ || n_frames > age) {
+        return false;
+    }
+    
+    slot = (feature_write_index_ + N_FRAMES - age) % N_FRAMES;
+    return true;
+}
+
+ErrorCode MFCCFrontend::enable_int8_output(float scale, int32_t zero_point) {
+    if (!initialized_ || scale <= 0.0f) {
+        ESP_LOGE(TAG, "Cannot enable INT8 output (initialized=%d, scale=%f)", initialized_, scale);
+        return ErrorCode::WAKE_WORD_FAILED;
+    }
+    
+    features_int8_.reset(static_cast<int8_t*>(allocate_buffer(FEATURE_SIZE * sizeof(int8_t))));
+    dct_quant_matrix_.reset(static_cast<float*>(allocate_buffer(N_MFCC * N_MELS * sizeof(float))));
+    
+    if (!features_int8_ || !dct_quant_matrix_) {
+        ESP_LOGE(TAG, "Failed to allocate INT8 feature store");
+        features_int8_.reset();
+        dct_quant_matrix_.reset();
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    // Fold the 1/scale of q = round(f / scale) + zp into the DCT so the
+    // quantizer is a multiply-accumulate and a rounding add
+    const float inv_scale = 1.0f / scale;
+    for (size_t i = 0; i < N_MFCC * N_MELS; i++) {
+        dct_quant_matrix_[i] = DCT_MATRIX.values[i] * inv_scale;
+    }
+    
+    output_scale_ = scale;
+    output_zero_point_ = zero_point;
+    int8_output_ = true;
+    
+    // The float store is no longer written
+    features_.reset();
+    reset();
+    
+    ESP_LOGI(TAG, "INT8 output enabled: scale=%f, zero_point=%d", scale, (int)zero_point);
+    return ErrorCode::SUCCESS;
+}
+
 void MFCCFrontend::reset() {
     buffer_write_pos_ = 0;
     samples_available_ = 0;
+    samples_until_frame_ = WINDOW_SAMPLES;
+    feature_write_index_ = 0;
     feature_frame_count_ = 0;
+    frame_counter_ = 0;
     
     if (audio_buffer_) {
-        std::memset(audio_buffer_.get(), 0, INPUT_BUFFER_SIZE * sizeof(int16_t));
+        std::memset(audio_buffer_.get(), 0, WINDOW_SAMPLES * sizeof(int16_t));
     }
     
     if (features_) {
         std::memset(features_.get(), 0, FEATURE_SIZE * sizeof(float));
     }
+    
+    if (features_int8_) {
+        std::memset(features_int8_.get(), static_cast<int8_t>(output_zero_point_), FEATURE_SIZE);
+    }
 }
 
 bool MFCCFrontend::has_sufficient_data() const {
-    return samples_available_ >= INPUT_BUFFER_SIZE;
+    return feature_frame_count_ == N_FRAMES;
 }
 
-void* MFCCFrontend::allocate_buffer(size_t size) const {
-    uint32_t caps = use_psram_ ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
-    return heap_caps_malloc(size, caps);
+void MFCCFrontend::write_samples(const int16_t* audio_data, size_t samples) {
+    // samples <= WINDOW_SAMPLES: at most one wrap
+    size_t first = std::min(samples, WINDOW_SAMPLES - buffer_write_pos_);
+    std::memcpy(&audio_buffer_[buffer_write_pos_], audio_data, first * sizeof(int16_t));
+    if (samples > first) {
+        std::memcpy(audio_buffer_.get(), audio_data + first, (samples - first) * sizeof(int16_t));
+    }
+    
+    buffer_write_pos_ = (buffer_write_pos_ + samples) % WINDOW_SAMPLES;
+    samples_available_ = std::min(samples_available_ + samples, WINDOW_SAMPLES);
 }
 
-bool MFCCFrontend::setup_tables() {
-    ESP_LOGI(TAG, "Setting up precomputed tables...");
-    
-    // Setup Hann window
-    for (size_t i = 0; i < WINDOW_SAMPLES; i++) {
-        hann_window_[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (WINDOW_SAMPLES - 1)));
-    }
+void MFCCFrontend::compute_frame() {
+    // The ring holds exactly one window; the oldest sample sits at the write position
+    const size_t start = buffer_write_pos_;
+    const size_t first = WINDOW_SAMPLES - start;
     
-    // Setup mel filterbank
-    const float mel_low = 0.0f;
-    const float mel_high = 2595.0f * log10f(1.0f + (SAMPLE_RATE / 2.0f) / 700.0f);
-    const size_t n_fft_bins = WINDOW_SAMPLES / 2 + 1;
+    apply_window(&audio_buffer_[start], 0, first, windowed_samples_.get());
+    apply_window(audio_buffer_.get(), first, start, windowed_samples_.get());
     
-    // Create mel scale points
-    std::vector<float> mel_points(N_MELS + 2);
-    for (size_t i = 0; i < N_MELS + 2; i++) {
-        mel_points[i] = mel_low + (mel_high - mel_low) * i / (N_MELS + 1);
-    }
+    // Compute power spectrum
+    compute_power_spectrum(windowed_samples_.get(), power_spectrum_.get());
     
-    // Convert mel to Hz
-    std::vector<float> hz_points(N_MELS + 2);
-    for (size_t i = 0; i < N_MELS + 2; i++) {
-        hz_points[i] = 700.0f * (powf(10.0f, mel_points[i] / 2595.0f) - 1.0f);
-    }
+    // Apply mel filterbank
+    apply_mel_filterbank(power_spectrum_.get(), mel_energies_.get());
     
-    // Convert Hz to FFT bin numbers
-    std::vector<size_t> bin_points(N_MELS + 2);
-    for (size_t i = 0; i < N_MELS + 2; i++) {
-        bin_points[i] = static_cast<size_t>(floorf((WINDOW_SAMPLES + 1) * hz_points[i] / SAMPLE_RATE));
+    if (mel_tap_) {
+        mel_tap_(mel_energies_.get(), N_MELS);
     }
     
-    // Create triangular mel filters
-    std::memset(mel_filterbank_.get(), 0, N_MELS * n_fft_bins * sizeof(float));
-    
-    for (size_t m = 0; m < N_MELS; m++) {
-        size_t left = bin_points[m];
-        size_t center = bin_points[m + 1];
-        size_t right = bin_points[m + 2];
-        
-        for (size_t k = left; k < center; k++) {
-            if (center > left) {
-                mel_filterbank_[m * n_fft_bins + k] = static_cast<float>(k - left) / (center - left);
-            }
-        }
-        
-        for (size_t k = center; k < right; k++) {
-            if (right > center) {
-                mel_filterbank_[m * n_fft_bins + k] = static_cast<float>(right - k) / (right - center);
-            }
-        }
+    if (int8_output_) {
+        // DCT and quantization straight into the INT8 frame store
+        compute_mfcc_int8(mel_energies_.get(), &features_int8_[feature_write_index_ * N_MFCC]);
+        advance_frame_store();
+        return;
     }
     
-    // Setup DCT matrix
-    for (size_t i = 0; i < N_MFCC; i++) {
-        for (size_t j = 0; j < N_MELS; j++) {
-            dct_matrix_[i * N_MELS + j] = cosf(M_PI * i * (j + 0.5f) / N_MELS);
-            if (i == 0) {
-                dct_matrix_[i * N_MELS + j] *= sqrtf(1.0f / N_MELS);
-            } else {
-                dct_matrix_[i * N_MELS + j] *= sqrtf(2.0f / N_MELS);
-            }
-        }
-    }
+    // Compute MFCC
+    compute_mfcc(mel_energies_.get(), mfcc_coeffs_.get());
     
-    ESP_LOGI(TAG, "Precomputed tables setup complete");
-    return true;
+    // Update feature matrix
+    update_feature_matrix(mfcc_coeffs_.get());
 }
 
-void MFCCFrontend::apply_window(const int16_t* samples, float* windowed_output) {
-    // This method is now unused - windowing is done inline in process_samples
-    // Kept for interface compatibility
-    *windowed_output = static_cast<float>(*samples) / 32768.0f;
+void* MFCCFrontend::allocate_buffer(size_t size) const {
+    return MemoryPlan::allocate(use_psram_ ? MemoryRegion::PSRAM : MemoryRegion::INTERNAL,
+                                size, "MFCCFrontend");
 }
 
-void MFCCFrontend::compute_power_spectrum(const float* windowed_samples, float* power_spec) {
-    // Apply Hann window
-    for (size_t i = 0; i < WINDOW_SAMPLES; i++) {
-        fft_buffer_[2*i] = windowed_samples[i] * hann_window_[i];  // Real part
-        fft_buffer_[2*i + 1] = 0.0f;  // Imaginary part
-    }
-    
-    // Simple DFT implementation (could be optimized with FFT library)
-    const size_t n_fft_bins = WINDOW_SAMPLES / 2 + 1;
-    for (size_t k = 0; k < n_fft_bins; k++) {
-        float real = 0.0f, imag = 0.0f;
-        for (size_t n = 0; n < WINDOW_SAMPLES; n++) {
-            float angle = -2.0f * M_PI * k * n / WINDOW_SAMPLES;
-            real += fft_buffer_[2*n] * cosf(angle);
-            imag += fft_buffer_[2*n] * sinf(angle);
-        }
-        power_spec[k] = real * real + imag * imag;
+void MFCCFrontend::apply_window(const int16_t* samples, size_t offset, size_t count, float* windowed_output) {
+    // Single pass: int16 -> float, normalisation and Hann window
+    const float* window = &HANN_WINDOW.values[offset];
+    float* out = windowed_output + offset;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<float>(samples[i]) * window[i];
     }
 }
 
+void MFCCFrontend::compute_power_spectrum(const float* windowed_samples, float* power_spec) {
+    // Real FFT: bins 0..WINDOW_SAMPLES/2, identical to the direct 480-point DFT
+    fft_engine_.compute_power_spectrum(windowed_samples, power_spec);
+}
+
 void MFCCFrontend::apply_mel_filterbank(const float* power_spec, float* mel_energies) {
-    const size_t n_fft_bins = WINDOW_SAMPLES / 2 + 1;
-    
     for (size_t m = 0; m < N_MELS; m++) {
-        mel_energies[m] = 0.0f;
-        for (size_t k = 0; k < n_fft_bins; k++) {
-            mel_energies[m] += power_spec[k] * mel_filterbank_[m * n_fft_bins + k];
+        // Only the bins under the triangle contribute
+        const MelRun& run = MEL_FILTERBANK.runs[m];
+        const float* spec = power_spec + run.start_bin;
+        const float* weights = &MEL_FILTERBANK.weights[run.weight_offset];
+        
+        float sum = 0.0f;
+        for (size_t k = 0; k < run.length; k++) {
+            sum += spec[k] * weights[k];
         }
         
         // Apply log and ensure minimum value
-        mel_energies[m] = log10f(std::max(mel_energies[m], 1e-10f));
+        // (INT8 output uses the approximation; its error is far below one quantization step)
+        const float energy = std::max(sum, 1e-10f);
+        mel_energies[m] = int8_output_ ? fast_log10f(energy) : log10f(energy);
     }
 }
 
@@ -284,15 +485,53 @@ void MFCCFrontend::compute_mfcc(const float* mel_energies, float* mfcc_coeffs) {
     for (size_t i = 0; i < N_MFCC; i++) {
         mfcc_coeffs[i] = 0.0f;
         for (size_t j = 0; j < N_MELS; j++) {
-            mfcc_coeffs[i] += mel_energies[j] * dct_matrix_[i * N_MELS + j];
+            mfcc_coeffs[i] += mel_energies[j] * DCT_MATRIX.values[i * N_MELS + j];
         }
     }
 }
 
+void MFCCFrontend::compute_mfcc_int8(const float* mel_energies, int8_t* quantized_coeffs) {
+    for (size_t i = 0; i < N_MFCC; i++) {
+        const float* row = &dct_quant_matrix_[i * N_MELS];
+        float acc = 0.0f;
+        for (size_t j = 0; j < N_MELS; j++) {
+            acc += mel_energies[j] * row[j];
+        }
+        
+        // Round half away from zero (matches lroundf), then offset and saturate
+        const int32_t rounded = static_cast<int32_t>(acc + (acc >= 0.0f ? 0.5f : -0.5f));
+        const int32_t quantized = rounded + output_zero_point_;
+        quantized_coeffs[i] = static_cast<int8_t>(std::min(127, std::max(-128, static_cast<int>(quantized))));
+    }
+}
+
+float MFCCFrontend::fast_log10f(float x) {
+    // log2 via exponent extraction + polynomial on the mantissa in [1, 2)
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    std::memcpy(&m, &bits, sizeof(m));
+    
+    // Degree-5 least-squares fit of log2(1 + u), u in [0, 1)
+    const float u = m - 1.0f;
+    const float log2_m = 3.1807275e-05f + u * (1.44126894f + u * (-0.705710979f + u * (0.408734172f +
+                         u * (-0.187732144f + u * 0.0434313237f))));
+    return (static_cast<float>(exponent) + log2_m) * 0.30102999566f;
+}
+
 void MFCCFrontend::update_feature_matrix(const float* mfcc_coeffs) {
+    // Overwrite the oldest slot of the circular frame store
+    std::memcpy(&features_[feature_write_index_ * N_MFCC], mfcc_coeffs, N_MFCC * sizeof(float));
+    advance_frame_store();
+}
+
+void MFCCFrontend::advance_frame_store() {
+    feature_write_index_ = (feature_write_index_ + 1) % N_FRAMES;
+    frame_counter_++;
+    
     if (feature_frame_count_ < N_FRAMES) {
-        size_t offset = feature_frame_count_ * N_MFCC;
-        std::memcpy(&features_[offset], mfcc_coeffs, N_MFCC * sizeof(float));
         feature_frame_count_++;
     }
 }
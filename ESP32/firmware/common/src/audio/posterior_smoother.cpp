@@ -0,0 +1,75 @@
+#include "audio/posterior_smoother.hpp"
+#include <algorithm>
+
+namespace irene {
+
+PosteriorSmoother::PosteriorSmoother()
+    : threshold_(1.0f)
+    , window_(1)
+    , refractory_hops_(0)
+    , history_{}
+    , head_(0)
+    , count_(0)
+    , sum_(0.0f)
+    , armed_(false)
+    , peak_(0.0f)
+    , rising_count_(0)
+    , refractory_remaining_(0) {
+}
+
+void PosteriorSmoother::configure(float threshold, size_t window, uint32_t refractory_hops) {
+    threshold_ = threshold;
+    window_ = std::min(std::max<size_t>(window, 1), MAX_WINDOW);
+    refractory_hops_ = refractory_hops;
+    reset();
+    refractory_remaining_ = 0;
+}
+
+bool PosteriorSmoother::update(float posterior, uint32_t hops) {
+    // Refractory time passes whether or not the scores are high
+    refractory_remaining_ -= std::min(refractory_remaining_, hops);
+
+    if (count_ == window_) {
+        sum_ -= history_[head_];
+    } else {
+        count_++;
+    }
+    history_[head_] = posterior;
+    sum_ += posterior;
+    head_ = (head_ + 1) % window_;
+
+    const float smoothed = sum_ / count_;
+
+    if (!armed_) {
+        // A partial window is just the raw score; wait for it to fill
+        if (count_ < window_ || smoothed < threshold_ || refractory_remaining_ > 0) {
+            return false;
+        }
+        armed_ = true;
+        peak_ = smoothed;
+        rising_count_ = 0;
+        return false;
+    }
+
+    // Still climbing: hold off, but never for longer than one window
+    if (smoothed > peak_ && ++rising_count_ < window_) {
+        peak_ = smoothed;
+        return false;
+    }
+
+    peak_ = std::max(peak_, smoothed);
+    armed_ = false;
+    refractory_remaining_ = refractory_hops_;
+    return true;
+}
+
+void PosteriorSmoother::reset() {
+    head_ = 0;
+    count_ = 0;
+    sum_ = 0.0f;
+    armed_ = false;
+    peak_ = 0.0f;
+    rising_count_ = 0;
+}
+
+} // namespace irene
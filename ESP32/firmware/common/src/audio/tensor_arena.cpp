@@ -0,0 +1,190 @@
+#include "audio/tensor_arena.hpp"
+#include "core/config_manager.hpp"
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char* TAG = "TensorArena";
+
+namespace irene {
+
+TensorArena::TensorArena()
+    : model_count_(0)
+    , margin_bytes_(0)
+    , internal_reserve_(0)
+    , data_(nullptr)
+    , size_(0)
+    , offsets_{}
+    , slice_sizes_{}
+    , used_bytes_{}
+    , internal_(false) {
+}
+
+TensorArena::~TensorArena() {
+    release();
+}
+
+ErrorCode TensorArena::initialize(size_t margin_bytes, size_t internal_reserve) {
+    margin_bytes_ = margin_bytes;
+    internal_reserve_ = internal_reserve;
+
+    config_store_ = std::make_unique<ConfigManager>();
+    if (config_store_->initialize() != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "Config store unavailable, arena needs will not persist");
+        config_store_.reset();
+    }
+
+    return ErrorCode::SUCCESS;
+}
+
+int TensorArena::add_model(const uint8_t* model_data, size_t model_size) {
+    if (model_count_ >= MAX_MODELS) {
+        ESP_LOGE(TAG, "Arena pool full (%d models)", MAX_MODELS);
+        return -1;
+    }
+
+    const size_t index = model_count_++;
+    TensorArenaRecord current;
+    current.model_hash = hash_model(model_data, model_size);
+    current.model_size = static_cast<uint32_t>(model_size);
+
+    TensorArenaRecord stored;
+    if (config_store_ && config_store_->load_arena_record(index, stored) == ErrorCode::SUCCESS &&
+        stored.model_hash == current.model_hash && stored.model_size == current.model_size &&
+        stored.used_bytes > 0) {
+        current.used_bytes = stored.used_bytes;
+        ESP_LOGI(TAG, "Slice %d: stored need for model %08lx is %lu bytes", index,
+                 static_cast<unsigned long>(current.model_hash),
+                 static_cast<unsigned long>(current.used_bytes));
+    } else {
+        ESP_LOGI(TAG, "Slice %d: no record for model %08lx, measuring with %d KB", index,
+                 static_cast<unsigned long>(current.model_hash), MEASURE_SIZE / 1024);
+    }
+
+    records_[index] = current;
+    return static_cast<int>(index);
+}
+
+uint8_t* TensorArena::allocate() {
+    release();
+
+    size_t size = 0;
+    for (size_t i = 0; i < model_count_; i++) {
+        offsets_[i] = size;
+        slice_sizes_[i] = planned_size(i);
+        size += slice_sizes_[i];
+    }
+    if (size == 0) {
+        return nullptr;
+    }
+
+    const bool measuring = is_measuring();
+
+    // Activation scratch wants internal RAM, but never at the expense of the reserve
+    if (!measuring) {
+        const size_t internal_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        const size_t internal_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (internal_block >= size && internal_free >= size + internal_reserve_) {
+            data_ = static_cast<uint8_t*>(
+                heap_caps_aligned_alloc(ALIGNMENT, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+            );
+            internal_ = data_ != nullptr;
+        } else {
+            ESP_LOGW(TAG, "Internal RAM too tight for %d KB arena (%d KB free, %d KB reserved)",
+                     size / 1024, internal_free / 1024, internal_reserve_ / 1024);
+        }
+    }
+
+    if (!data_) {
+        data_ = static_cast<uint8_t*>(
+            heap_caps_aligned_alloc(ALIGNMENT, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+        );
+    }
+
+    // Boards without PSRAM still get a measurement arena if it fits
+    if (!data_ && measuring) {
+        data_ = static_cast<uint8_t*>(
+            heap_caps_aligned_alloc(ALIGNMENT, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+        );
+        internal_ = data_ != nullptr;
+    }
+
+    if (!data_) {
+        ESP_LOGE(TAG, "Failed to allocate %d byte tensor arena", size);
+        return nullptr;
+    }
+
+    size_ = size;
+    ESP_LOGI(TAG, "Tensor arena: %d KB for %d model(s) in %s%s", size_ / 1024, model_count_,
+             internal_ ? "internal RAM" : "PSRAM", measuring ? " (measuring)" : "");
+    return data_;
+}
+
+void TensorArena::release() {
+    if (data_) {
+        heap_caps_free(data_);
+        data_ = nullptr;
+    }
+    size_ = 0;
+    internal_ = false;
+}
+
+void TensorArena::record_usage(size_t index, size_t used_bytes) {
+    used_bytes_[index] = used_bytes;
+
+    TensorArenaRecord& record = records_[index];
+    if (used_bytes != record.used_bytes) {
+        record.used_bytes = static_cast<uint32_t>(used_bytes);
+        if (config_store_ && config_store_->save_arena_record(index, record) != ErrorCode::SUCCESS) {
+            ESP_LOGW(TAG, "Failed to persist arena need");
+        }
+        ESP_LOGI(TAG, "Slice %d: measured need %d bytes", index, used_bytes);
+    }
+}
+
+bool TensorArena::is_oversized() const {
+    for (size_t i = 0; i < model_count_; i++) {
+        if (slice_sizes_[i] > planned_size(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TensorArena::invalidate(size_t index) {
+    ESP_LOGW(TAG, "Slice %d: record for model %08lx is stale, measuring again", index,
+             static_cast<unsigned long>(records_[index].model_hash));
+    records_[index].used_bytes = 0;
+    if (config_store_) {
+        config_store_->clear_arena_record(index);
+    }
+}
+
+bool TensorArena::is_measuring() const {
+    for (size_t i = 0; i < model_count_; i++) {
+        if (is_measuring(i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t TensorArena::planned_size(size_t index) const {
+    if (is_measuring(index)) {
+        return MEASURE_SIZE;
+    }
+
+    const size_t size = records_[index].used_bytes + margin_bytes_;
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+uint32_t TensorArena::hash_model(const uint8_t* data, size_t size) {
+    // FNV-1a over the whole flatbuffer
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace irene
@@ -3,13 +3,22 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <functional>
 
 static const char* TAG = "VADProcessor";
 
 namespace irene {
 
+namespace {
+
+constexpr float kSmoothing = 0.7f;         // Per-hop smoothing of band energies
+constexpr float kFloorBias = 0.15f;        // Minimum statistics underestimate the mean (1.5 dB)
+
+} // namespace
+
 VADProcessor::VADProcessor()
     : sample_rate_(16000)
+    , frame_ms_(20)
     , sensitivity_(0.5f)
     , energy_threshold_(0.01f)
     , silence_duration_ms_(200)
@@ -21,6 +30,19 @@ VADProcessor::VADProcessor()
     , consecutive_silence_frames_(0)
     , frames_for_voice_decision_(5)
     , frames_for_silence_decision_(10)
+    , mode_(VADMode::ENERGY)
+    , bands_(0)
+    , smoothed_{}
+    , current_min_{}
+    , subwindow_min_{}
+    , noise_floor_{}
+    , subwindow_index_(0)
+    , subwindow_hops_(0)
+    , spectral_hops_(0)
+    , spectrum_fresh_(false)
+    , voice_run_ms_(0)
+    , silence_run_ms_(0)
+    , current_snr_db_(0.0f)
     , voice_frames_(0)
     , silence_frames_(0)
     , total_frames_(0) {
@@ -36,15 +58,8 @@ ErrorCode VADProcessor::initialize(uint32_t sample_rate) {
     
     sample_rate_ = sample_rate;
     
-    // Calculate frame decision thresholds based on sample rate and frame size
-    // Assuming 20ms frames
-    uint32_t frames_per_second = 50; // 1000ms / 20ms
-    frames_for_voice_decision_ = (voice_duration_ms_ * frames_per_second) / 1000;
-    frames_for_silence_decision_ = (silence_duration_ms_ * frames_per_second) / 1000;
-    
-    // Ensure minimum thresholds
-    frames_for_voice_decision_ = std::max(frames_for_voice_decision_, 2u);
-    frames_for_silence_decision_ = std::max(frames_for_silence_decision_, 5u);
+    // Decision thresholds assume 20ms frames until the first frame says otherwise
+    update_decision_frames();
     
     ESP_LOGI(TAG, "VAD initialized: %u Hz, voice=%u frames, silence=%u frames",
              sample_rate_, frames_for_voice_decision_, frames_for_silence_decision_);
@@ -56,12 +71,38 @@ bool VADProcessor::process_frame(const int16_t* audio_data, size_t samples) {
     if (!audio_data || samples == 0) {
         return voice_detected_;
     }
+    return process_frame(compute_frame_stats(audio_data, samples));
+}
+
+bool VADProcessor::process_frame(const FrameStats& stats) {
+    if (stats.sample_count == 0) {
+        return voice_detected_;
+    }
     
     total_frames_++;
     
-    // Calculate energy and zero crossing rate
-    float energy = calculate_energy(audio_data, samples);
-    float zcr = calculate_zero_crossing_rate(audio_data, samples);
+    // Capture granularity is configurable (10/20/30 ms); keep the hysteresis in ms
+    const uint32_t frame_ms = static_cast<uint32_t>((stats.sample_count * 1000) / sample_rate_);
+    if (frame_ms > 0 && frame_ms != frame_ms_) {
+        frame_ms_ = frame_ms;
+        update_decision_frames();
+    }
+    
+    // Adaptive mode decided on the hops this frame produced
+    if (mode_ == VADMode::ADAPTIVE && spectrum_fresh_) {
+        spectrum_fresh_ = false;
+        current_energy_ = stats.rms();
+        if (voice_detected_) {
+            voice_frames_++;
+        } else {
+            silence_frames_++;
+        }
+        return voice_detected_;
+    }
+    
+    // Energy and zero crossing rate, measured once at capture
+    float energy = stats.rms();
+    float zcr = stats.zcr();
     
     // Update energy history for smoothing
     energy_history_[history_index_] = energy;
@@ -105,6 +146,110 @@ bool VADProcessor::process_frame(const int16_t* audio_data, size_t samples) {
     return final_detection;
 }
 
+bool VADProcessor::process_spectrum(const float* log_mel, size_t bands, uint32_t hop_ms) {
+    if (mode_ != VADMode::ADAPTIVE || !log_mel || bands == 0) {
+        return voice_detected_;
+    }
+    
+    bands = std::min(bands, MAX_BANDS);
+    update_noise_floor(log_mel, bands);
+    
+    // Mean SNR of the loudest quarter of the bands: voiced speech lights up
+    // a few formant/harmonic bands, which a mean over all of them dilutes
+    float snr[MAX_BANDS];
+    for (size_t b = 0; b < bands; b++) {
+        snr[b] = std::max(0.0f, 10.0f * (smoothed_[b] - noise_floor_[b]));
+    }
+    const size_t top = std::max<size_t>(1, bands / 4);
+    std::nth_element(snr, snr + top - 1, snr + bands, std::greater<float>());
+    float snr_sum = 0.0f;
+    for (size_t b = 0; b < top; b++) {
+        snr_sum += snr[b];
+    }
+    current_snr_db_ = snr_sum / top;
+    
+    // Noise alone sits near 5 dB on this statistic: 11 dB at sensitivity 0, 7 dB at 1
+    const float snr_threshold_db = 7.0f + 4.0f * (1.0f - sensitivity_);
+    spectrum_fresh_ = true;
+    return apply_spectral_hysteresis(current_snr_db_ > snr_threshold_db, hop_ms);
+}
+
+void VADProcessor::set_mode(VADMode mode) {
+    mode_ = mode;
+    spectral_hops_ = 0;
+    spectrum_fresh_ = false;
+    ESP_LOGI(TAG, "VAD mode: %s", mode == VADMode::ADAPTIVE ? "adaptive" : "energy");
+}
+
+float VADProcessor::get_noise_floor_db() const {
+    if (bands_ == 0) return 0.0f;
+    
+    float sum = 0.0f;
+    for (size_t b = 0; b < bands_; b++) {
+        sum += noise_floor_[b];
+    }
+    return 10.0f * sum / bands_;
+}
+
+void VADProcessor::update_noise_floor(const float* log_mel, size_t bands) {
+    // First hop: start every estimate at the current spectrum
+    if (spectral_hops_ == 0 || bands != bands_) {
+        bands_ = bands;
+        for (size_t b = 0; b < bands; b++) {
+            smoothed_[b] = log_mel[b];
+            current_min_[b] = log_mel[b];
+            for (size_t w = 0; w < MIN_SUBWINDOWS; w++) {
+                subwindow_min_[w][b] = log_mel[b];
+            }
+        }
+        subwindow_index_ = 0;
+        subwindow_hops_ = 0;
+    }
+    spectral_hops_++;
+    
+    for (size_t b = 0; b < bands; b++) {
+        smoothed_[b] = kSmoothing * smoothed_[b] + (1.0f - kSmoothing) * log_mel[b];
+        current_min_[b] = std::min(current_min_[b], smoothed_[b]);
+    }
+    
+    // Roll the sub-window: the floor forgets a minimum after MIN_SUBWINDOWS of them
+    if (++subwindow_hops_ >= MIN_SUBWINDOW_HOPS) {
+        std::memcpy(subwindow_min_[subwindow_index_], current_min_, bands * sizeof(float));
+        subwindow_index_ = (subwindow_index_ + 1) % MIN_SUBWINDOWS;
+        std::memcpy(current_min_, smoothed_, bands * sizeof(float));
+        subwindow_hops_ = 0;
+    }
+    
+    for (size_t b = 0; b < bands; b++) {
+        float floor = current_min_[b];
+        for (size_t w = 0; w < MIN_SUBWINDOWS; w++) {
+            floor = std::min(floor, subwindow_min_[w][b]);
+        }
+        noise_floor_[b] = floor + kFloorBias;
+    }
+}
+
+bool VADProcessor::apply_spectral_hysteresis(bool current_detection, uint32_t hop_ms) {
+    // Same onset and hangover as the energy path, counted in hops of hop_ms
+    if (current_detection) {
+        voice_run_ms_ += hop_ms;
+        silence_run_ms_ = 0;
+        if (!voice_detected_ && voice_run_ms_ >= voice_duration_ms_) {
+            voice_detected_ = true;
+            ESP_LOGD(TAG, "Voice detected at %.1f dB SNR", current_snr_db_);
+        }
+    } else {
+        silence_run_ms_ += hop_ms;
+        voice_run_ms_ = 0;
+        if (voice_detected_ && silence_run_ms_ >= silence_duration_ms_) {
+            voice_detected_ = false;
+            ESP_LOGD(TAG, "Silence detected, floor %.1f dB", get_noise_floor_db());
+        }
+    }
+    
+    return voice_detected_;
+}
+
 void VADProcessor::set_sensitivity(float sensitivity) {
     sensitivity_ = std::max(0.0f, std::min(1.0f, sensitivity));
     ESP_LOGD(TAG, "VAD sensitivity set to: %.3f", sensitivity_);
@@ -117,18 +262,14 @@ void VADProcessor::set_energy_threshold(float threshold) {
 
 void VADProcessor::set_silence_duration_ms(uint32_t duration_ms) {
     silence_duration_ms_ = duration_ms;
-    uint32_t frames_per_second = 50; // 20ms frames
-    frames_for_silence_decision_ = (duration_ms * frames_per_second) / 1000;
-    frames_for_silence_decision_ = std::max(frames_for_silence_decision_, 5u);
+    update_decision_frames();
     ESP_LOGD(TAG, "Silence duration set to: %u ms (%u frames)", 
              duration_ms, frames_for_silence_decision_);
 }
 
 void VADProcessor::set_voice_duration_ms(uint32_t duration_ms) {
     voice_duration_ms_ = duration_ms;
-    uint32_t frames_per_second = 50; // 20ms frames
-    frames_for_voice_decision_ = (duration_ms * frames_per_second) / 1000;
-    frames_for_voice_decision_ = std::max(frames_for_voice_decision_, 2u);
+    update_decision_frames();
     ESP_LOGD(TAG, "Voice duration set to: %u ms (%u frames)", 
              duration_ms, frames_for_voice_decision_);
 }
@@ -141,37 +282,19 @@ void VADProcessor::reset_stats() {
     consecutive_silence_frames_ = 0;
     std::memset(energy_history_, 0, sizeof(energy_history_));
     history_index_ = 0;
+    spectral_hops_ = 0;
+    voice_run_ms_ = 0;
+    silence_run_ms_ = 0;
     ESP_LOGI(TAG, "VAD statistics reset");
 }
 
-float VADProcessor::calculate_energy(const int16_t* audio_data, size_t samples) {
-    if (!audio_data || samples == 0) return 0.0f;
+void VADProcessor::update_decision_frames() {
+    frames_for_voice_decision_ = voice_duration_ms_ / frame_ms_;
+    frames_for_silence_decision_ = silence_duration_ms_ / frame_ms_;
     
-    int64_t sum_squares = 0;
-    for (size_t i = 0; i < samples; i++) {
-        int32_t sample = audio_data[i];
-        sum_squares += sample * sample;
-    }
-    
-    // Normalize by sample count and max value
-    float rms = sqrtf(static_cast<float>(sum_squares) / samples) / 32768.0f;
-    return rms;
-}
-
-float VADProcessor::calculate_zero_crossing_rate(const int16_t* audio_data, size_t samples) {
-    if (!audio_data || samples < 2) return 0.0f;
-    
-    uint32_t zero_crossings = 0;
-    
-    for (size_t i = 1; i < samples; i++) {
-        // Check for sign change
-        if ((audio_data[i-1] >= 0 && audio_data[i] < 0) ||
-            (audio_data[i-1] < 0 && audio_data[i] >= 0)) {
-            zero_crossings++;
-        }
-    }
-    
-    return static_cast<float>(zero_crossings) / (samples - 1);
+    // Ensure minimum thresholds
+    frames_for_voice_decision_ = std::max(frames_for_voice_decision_, 2u);
+    frames_for_silence_decision_ = std::max(frames_for_silence_decision_, 5u);
 }
 
 bool VADProcessor::apply_hysteresis(bool current_detection) {
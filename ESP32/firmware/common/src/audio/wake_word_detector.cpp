@@ -1,23 +1,22 @@
 #include "audio/wake_word_detector.hpp"
+#include "core/task_manager.hpp"
 #include "audio/mfcc_frontend.hpp"
-#include "utils/ring_buffer.hpp"
+#include "audio/vad_processor.hpp"
+#include "audio/feature_queue.hpp"
+#include "audio/keyword_model.hpp"
+#include "audio/tensor_arena.hpp"
+#include "audio/audio_history.hpp"
+#include "utils/latency_trace.hpp"
 
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "esp_heap_caps.h"
 #include <cstring>
 #include <algorithm>
 #include <cmath>
 
-// TensorFlow Lite Micro includes
-#include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/schema/schema_generated.h"
-#include "tensorflow/lite/version.h"
-
 static const char* TAG = "WakeWordDetector";
 
 namespace irene {
@@ -25,55 +24,89 @@ namespace irene {
 WakeWordDetector::WakeWordDetector()
     : enabled_(false)
     , initialized_(false)
-    , model_data_(nullptr)
-    , model_size_(0)
-    , model_(nullptr)
-    , interpreter_(nullptr)
-    , resolver_(nullptr)
     , tensor_arena_(nullptr)
-    , inference_buffer_(nullptr)
-    , inference_buffer_size_(0)
+    , gate_open_(false)
+    , hangover_samples_(0)
+    , hangover_remaining_(0)
+    , backfill_samples_(0)
+    , history_(nullptr)
+    , backfilling_(false)
+    , analyzing_(false)
     , last_confidence_(0.0f)
     , last_latency_ms_(0)
-    , detection_start_time_(0)
-    , consecutive_detections_(0)
+    , prearmed_(false)
     , wake_word_task_handle_(nullptr)
-    , audio_queue_(nullptr)
+    , frontend_lock_("ww_frontend")
+    , inference_lock_("ww_infer")
     , detection_count_(0)
     , false_positive_count_(0)
     , total_latency_ms_(0)
     , inference_count_(0)
-    , last_inference_time_(0)
+    , gate_open_count_(0)
+    , gated_samples_(0)
+    , budget_overrun_count_(0)
     , inference_interval_us_(30000) { // 30ms intervals
 }
 
 WakeWordDetector::~WakeWordDetector() {
     disable();
-    cleanup_tf_lite_model();
+    cleanup_tf_lite_models();
+}
+
+ErrorCode WakeWordDetector::add_keyword(const KeywordConfig& config, const uint8_t* model_data,
+                                        size_t model_size, size_t* keyword) {
+    if (initialized_) {
+        ESP_LOGE(TAG, "Keywords must be added before initialize()");
+        return ErrorCode::WAKE_WORD_FAILED;
+    }
+    
+    if (!model_data || model_size == 0) {
+        ESP_LOGE(TAG, "Invalid model data for keyword '%s'", config.name);
+        return ErrorCode::WAKE_WORD_FAILED;
+    }
     
-    if (audio_queue_) {
-        vQueueDelete(audio_queue_);
+    // Slot 0 stays free for the wake word given to initialize()
+    if (keywords_.empty()) {
+        keywords_.emplace_back();
+    }
+    if (keywords_.size() >= TensorArena::MAX_MODELS) {
+        ESP_LOGE(TAG, "Too many keywords (max %d)", TensorArena::MAX_MODELS);
+        return ErrorCode::WAKE_WORD_FAILED;
     }
     
-    if (inference_buffer_) {
-        heap_caps_free(inference_buffer_);
+    if (keyword) {
+        *keyword = keywords_.size();
     }
+    keywords_.push_back(std::make_unique<KeywordModel>(config, model_data, model_size));
+    ESP_LOGI(TAG, "Keyword '%s' registered (%d bytes, priority %u)", config.name, model_size, config.priority);
+    return ErrorCode::SUCCESS;
 }
 
-ErrorCode WakeWordDetector::initialize(const WakeWordConfig& config, 
-                                      const uint8_t* model_data, 
+ErrorCode WakeWordDetector::initialize(const WakeWordConfig& config,
+                                      const uint8_t* model_data,
                                       size_t model_size) {
     ESP_LOGI(TAG, "Initializing wake word detector...");
     
     config_ = config;
-    model_data_ = model_data;
-    model_size_ = model_size;
     
     if (!model_data || model_size == 0) {
         ESP_LOGE(TAG, "Invalid model data");
         return ErrorCode::WAKE_WORD_FAILED;
     }
     
+    // The wake word is keyword 0 and always scored first
+    KeywordConfig wake_word;
+    wake_word.name = "wake_word";
+    wake_word.threshold = config.threshold;
+    wake_word.smoothing_ms = config.smoothing_ms;
+    wake_word.refractory_ms = config.refractory_ms;
+    wake_word.priority = WAKE_WORD_PRIORITY;
+    wake_word.input_frames = config.model_input_frames;
+    if (keywords_.empty()) {
+        keywords_.emplace_back();
+    }
+    keywords_[0] = std::make_unique<KeywordModel>(wake_word, model_data, model_size);
+    
     // Initialize MFCC frontend
     mfcc_frontend_ = std::make_unique<MFCCFrontend>();
     ErrorCode mfcc_result = mfcc_frontend_->initialize(config.use_psram);
@@ -81,100 +114,217 @@ ErrorCode WakeWordDetector::initialize(const WakeWordConfig& config,
         ESP_LOGE(TAG, "Failed to initialize MFCC frontend");
         return mfcc_result;
     }
-    
-    // Allocate feature buffers
-    uint32_t caps = config.use_psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
-    
-    mfcc_features_.reset(static_cast<float*>(
-        heap_caps_malloc(MFCCFrontend::FEATURE_SIZE * sizeof(float), caps)
-    ));
-    
-    quantized_features_.reset(static_cast<int8_t*>(
-        heap_caps_malloc(MFCCFrontend::FEATURE_SIZE * sizeof(int8_t), caps)
-    ));
-    
-    if (!mfcc_features_ || !quantized_features_) {
-        ESP_LOGE(TAG, "Failed to allocate feature buffers");
-        return ErrorCode::MEMORY_ERROR;
+    mfcc_frontend_->set_mel_tap([this](const float* log_mel, size_t bands) {
+        if (!backfilling_ && mel_tap_) {
+            mel_tap_(log_mel, bands);
+        }
+    });
+    
+    // Cascade gate: open quickly, the hangover covers pauses inside the phrase
+    if (config.vad_cascade) {
+        gate_ = std::make_unique<VADProcessor>();
+        ErrorCode gate_result = gate_->initialize(MFCCFrontend::SAMPLE_RATE);
+        if (gate_result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to initialize cascade gate");
+            return gate_result;
+        }
+        gate_->set_voice_duration_ms(40);
+        gate_->set_silence_duration_ms(200);
+        
+        hangover_samples_ = (MFCCFrontend::SAMPLE_RATE * config.cascade_hangover_ms) / 1000;
+        backfill_samples_ = (MFCCFrontend::SAMPLE_RATE * config.cascade_backfill_ms) / 1000;
+        
+        ESP_LOGI(TAG, "VAD cascade enabled: %u ms hangover, %u ms backfill",
+                 config.cascade_hangover_ms, config.cascade_backfill_ms);
     }
     
-    ESP_LOGI(TAG, "Allocated MFCC feature buffers: %dx%d in %s", 
-            MFCCFrontend::N_FRAMES, MFCCFrontend::N_MFCC, 
-            config.use_psram ? "PSRAM" : "IRAM");
-    
-    // Allocate legacy inference buffer (for compatibility)
-    inference_buffer_size_ = 16000; // 1 second at 16kHz
-    inference_buffer_ = static_cast<int16_t*>(
-        heap_caps_malloc(inference_buffer_size_ * sizeof(int16_t), caps)
-    );
-    
-    if (!inference_buffer_) {
-        ESP_LOGE(TAG, "Failed to allocate inference buffer");
-        return ErrorCode::MEMORY_ERROR;
+    // Initialize TensorFlow Lite Micro
+    if (!setup_tf_lite_models()) {
+        ESP_LOGE(TAG, "Failed to setup TensorFlow Lite models");
+        return ErrorCode::WAKE_WORD_FAILED;
     }
     
-    // Create audio buffer for wake word processing
-    try {
-        audio_buffer_ = std::make_unique<RingBuffer>(
-            inference_buffer_size_ * sizeof(int16_t) * 2 // Double buffer
-        );
-    } catch (const std::exception& e) {
-        ESP_LOGE(TAG, "Failed to create audio buffer: %s", e.what());
-        return ErrorCode::MEMORY_ERROR;
+    // Feature path: INT8 frontend when every model takes the same INT8 input,
+    // float features (quantized per model) otherwise
+    const bool int8_features = use_int8_frontend();
+    if (int8_features) {
+        const TfLiteTensor* input = keywords_[0]->input();
+        ErrorCode q_result = mfcc_frontend_->enable_int8_output(input->params.scale,
+                                                                input->params.zero_point);
+        if (q_result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to enable INT8 MFCC output");
+            return q_result;
+        }
+        
+        ESP_LOGI(TAG, "MFCC frontend quantizes straight to INT8 model input");
     }
     
-    // Create audio queue for task communication
-    audio_queue_ = xQueueCreate(16, sizeof(size_t));
-    if (!audio_queue_) {
-        ESP_LOGE(TAG, "Failed to create audio queue");
-        return ErrorCode::WAKE_WORD_FAILED;
+    // Windowed models are scored every inference interval, not every hop
+    const uint32_t publish_interval_frames =
+        std::max<uint32_t>(1, inference_interval_us_ / (MFCCFrontend::HOP_SIZE_MS * 1000));
+    
+    for (size_t i = 0; i < keywords_.size(); i++) {
+        ErrorCode result = keywords_[i]->configure(int8_features, config.use_psram, publish_interval_frames);
+        if (result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to configure keyword '%s'", keywords_[i]->name());
+            return result;
+        }
+        
+        // Device sanity checklist (runs an inference): debug builds and new images only
+        if (config.sanity_checks) {
+            keywords_[i]->perform_sanity_checks(tensor_arena_->slice_size(i), tensor_arena_->is_internal());
+        }
     }
     
-    // Initialize TensorFlow Lite Micro
-    if (!setup_tf_lite_model()) {
-        ESP_LOGE(TAG, "Failed to setup TensorFlow Lite model");
-        return ErrorCode::WAKE_WORD_FAILED;
+    // Scoring order: priority, then registration order
+    schedule_.resize(keywords_.size());
+    for (size_t i = 0; i < schedule_.size(); i++) {
+        schedule_[i] = i;
     }
+    std::stable_sort(schedule_.begin(), schedule_.end(), [this](size_t a, size_t b) {
+        return keywords_[a]->config().priority > keywords_[b]->config().priority;
+    });
     
     initialized_ = true;
     ESP_LOGI(TAG, "Wake word detector initialized successfully");
-    ESP_LOGI(TAG, "Model size: %d bytes, Threshold: %.3f", model_size_, config_.threshold);
-    ESP_LOGI(TAG, "INT8 quantized model with MFCC frontend enabled");
+    ESP_LOGI(TAG, "Model size: %d bytes, Threshold: %.3f, %d keyword(s)",
+             model_size, config_.threshold, keywords_.size());
+    ESP_LOGI(TAG, "INT8 quantized models with shared MFCC frontend enabled");
     
     return ErrorCode::SUCCESS;
 }
 
-bool WakeWordDetector::process_frame(const int16_t* audio_data, size_t samples) {
+bool WakeWordDetector::process_frame(const int16_t* audio_data, size_t samples,
+                                     const FrameStats* stats) {
     if (!enabled_ || !initialized_ || !audio_data || samples == 0) {
         return false;
     }
     
-    // Process audio data through MFCC frontend
-    bool features_ready = mfcc_frontend_->process_samples(audio_data, samples);
+    // Frontend state left by analyze_frame() belongs to other audio
+    if (analyzing_) {
+        analyzing_ = false;
+        reset();
+    }
+    
+    // Stage 1: MFCC and inference only run behind an open gate
+    if (gate_ && !update_gate(audio_data, samples, stats)) {
+        return false;
+    }
+    
+    feed_frontend(audio_data, samples);
     
-    if (features_ready) {
-        // Signal wake word task to process MFCC features
-        size_t signal = 1; // Signal that features are ready
-        if (xQueueSend(audio_queue_, &signal, 0) != pdTRUE) {
-            // Queue full, skip this frame
+    return false; // Actual detection result comes from the task
+}
+
+void WakeWordDetector::analyze_frame(const int16_t* audio_data, size_t samples) {
+    if (!initialized_ || !audio_data || samples == 0) {
+        return;
+    }
+    
+    // Features only, nothing is published for inference
+    analyzing_ = true;
+    mfcc_frontend_->process_samples(audio_data, samples);
+}
+
+bool WakeWordDetector::update_gate(const int16_t* audio_data, size_t samples,
+                                   const FrameStats* stats) {
+    const bool voice = stats ? gate_->process_frame(*stats)
+                             : gate_->process_frame(audio_data, samples);
+    
+    if (voice) {
+        hangover_remaining_ = hangover_samples_;
+    } else {
+        hangover_remaining_ -= std::min(hangover_remaining_, samples);
+    }
+    
+    if (!gate_open_) {
+        if (voice) {
+            // The backfill already contains this frame; without a history
+            // only the live frame is fed
+            open_gate();
+            return history_ == nullptr;
         }
+        
+        gated_samples_ += samples;
+        return false;
     }
     
-    // Also maintain legacy ring buffer for compatibility
-    size_t bytes_written = audio_buffer_->write(
-        reinterpret_cast<const uint8_t*>(audio_data), 
-        samples * sizeof(int16_t)
-    );
+    if (!voice && hangover_remaining_ == 0) {
+        // The smoother belongs to the inference task; open_gate()'s restart
+        // marks the gap, and score_next() resets it there
+        gate_open_ = false;
+        ESP_LOGD(TAG, "Cascade gate closed");
+        
+        gated_samples_ += samples;
+        return false;
+    }
+    
+    return true;
+}
+
+void WakeWordDetector::open_gate() {
+    gate_open_ = true;
+    gate_open_count_++;
     
-    if (bytes_written != samples * sizeof(int16_t)) {
-        ESP_LOGW(TAG, "Audio buffer overflow, data may be lost");
+    // Features from the previous opening are stale; restart on recent audio
+    mfcc_frontend_->reset();
+    for (auto& keyword : keywords_) {
+        keyword->restart();
     }
     
-    return false; // Actual detection result comes from the task
+    if (!history_) {
+        return;
+    }
+    
+    // Walk back from the newest frame until the backfill is covered, then
+    // feed forward straight from the history frames
+    AudioHistory::Cursor cursor = history_->end();
+    size_t covered = 0;
+    while (covered < backfill_samples_ && cursor != history_->begin()) {
+        covered += history_->at(--cursor)->size();
+    }
+    size_t skip = covered > backfill_samples_ ? covered - backfill_samples_ : 0;
+    
+    size_t backfilled = 0;
+    backfilling_ = true;
+    while (const AudioFrameRef* frame = history_->next(cursor)) {
+        const size_t offset = std::min(skip, frame->size());
+        skip -= offset;
+        feed_frontend(frame->data() + offset, frame->size() - offset);
+        backfilled += frame->size() - offset;
+    }
+    backfilling_ = false;
+    
+    ESP_LOGD(TAG, "Cascade gate opened, backfilled %u samples", backfilled);
+}
+
+void WakeWordDetector::feed_frontend(const int16_t* audio_data, size_t samples) {
+    PowerLock::Scope full_clock(frontend_lock_);
+    
+    // One MFCC pass feeds every keyword
+    mfcc_frontend_->process_samples(audio_data, samples);
+    
+    bool published = false;
+    for (auto& keyword : keywords_) {
+        published |= keyword->publish(*mfcc_frontend_);
+    }
+    
+    // Wake the inference stage
+    if (published) {
+        LatencyTrace::record(TraceEvent::MFCC_FRAME_READY,
+                             static_cast<uint16_t>(mfcc_frontend_->get_frame_count()));
+    }
+    TaskHandle_t consumer = wake_word_task_handle_;
+    if (published && consumer) {
+        xTaskNotifyGive(consumer);
+    }
 }
 
 void WakeWordDetector::set_threshold(float threshold) {
     config_.threshold = threshold;
+    if (!keywords_.empty() && keywords_[0]) {
+        keywords_[0]->set_threshold(threshold);
+    }
     ESP_LOGI(TAG, "Wake word threshold set to: %.3f", threshold);
 }
 
@@ -182,6 +332,14 @@ void WakeWordDetector::set_detection_callback(DetectionCallback callback) {
     detection_callback_ = callback;
 }
 
+void WakeWordDetector::set_prearm_callback(PrearmCallback callback) {
+    prearm_callback_ = callback;
+}
+
+void WakeWordDetector::set_keyword_callback(KeywordCallback callback) {
+    keyword_callback_ = callback;
+}
+
 void WakeWordDetector::enable() {
     if (enabled_) return;
     
@@ -192,24 +350,29 @@ void WakeWordDetector::enable() {
         return;
     }
     
-    // Create wake word processing task
-    BaseType_t result = xTaskCreatePinnedToCore(
-        wake_word_task_wrapper,
+    // Inference stage; by default on the core opposite to capture/MFCC
+    enabled_ = true;
+    TaskHandle_t handle = nullptr;
+    ErrorCode result = TaskManager::instance().create_task(
         "wake_word_task",
-        8192, // Stack size for TF Lite inference
+        wake_word_task_wrapper,
         this,
-        9,    // High priority
-        &wake_word_task_handle_,
-        0     // Core 0 for consistent timing
+        config_.inference_stack_size,
+        config_.inference_priority,
+        config_.inference_core < 0 ? tskNO_AFFINITY : config_.inference_core,
+        &handle
     );
+    wake_word_task_handle_ = handle;
     
-    if (result != pdPASS) {
+    if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to create wake word task");
+        enabled_ = false;
+        wake_word_task_handle_ = nullptr;
         return;
     }
     
-    enabled_ = true;
-    ESP_LOGI(TAG, "Wake word detection enabled");
+    ESP_LOGI(TAG, "Wake word detection enabled (inference on core %d, priority %u)",
+             config_.inference_core, config_.inference_priority);
 }
 
 void WakeWordDetector::disable() {
@@ -219,45 +382,46 @@ void WakeWordDetector::disable() {
     
     enabled_ = false;
     
-    // Delete wake word task
-    if (wake_word_task_handle_) {
-        vTaskDelete(wake_word_task_handle_);
-        wake_word_task_handle_ = nullptr;
+    // Delete wake word task (stop the producer notifying it first)
+    TaskHandle_t handle = wake_word_task_handle_;
+    wake_word_task_handle_ = nullptr;
+    if (handle) {
+        TaskManager::instance().delete_task(handle);
     }
     
     ESP_LOGI(TAG, "Wake word detection disabled");
 }
 
 void WakeWordDetector::reset() {
-    consecutive_detections_ = 0;
-    detection_start_time_ = 0;
     last_confidence_ = 0.0f;
+    prearmed_ = false;
+    gate_open_ = false;
+    hangover_remaining_ = 0;
     
     // Reset MFCC frontend
     if (mfcc_frontend_) {
         mfcc_frontend_->reset();
     }
     
-    if (audio_buffer_) {
-        audio_buffer_->clear();
-    }
-    
-    // Clear audio queue
-    if (audio_queue_) {
-        xQueueReset(audio_queue_);
+    // Streaming state and the smoother would otherwise continue from audio
+    // that is gone; the inference task resets both when it sees the gap
+    for (auto& keyword : keywords_) {
+        if (keyword) {
+            keyword->restart();
+        }
     }
 }
 
-uint32_t WakeWordDetector::get_detection_count() const {
-    return detection_count_;
+bool WakeWordDetector::is_streaming_model() const {
+    return !keywords_.empty() && keywords_[0] && keywords_[0]->is_streaming();
 }
 
-uint32_t WakeWordDetector::get_false_positive_count() const {
-    return false_positive_count_;
+const char* WakeWordDetector::get_keyword_name(size_t keyword) const {
+    return keyword < keywords_.size() && keywords_[keyword] ? keywords_[keyword]->name() : nullptr;
 }
 
 float WakeWordDetector::get_average_latency_ms() const {
-    return detection_count_ > 0 ? 
+    return detection_count_ > 0 ?
            static_cast<float>(total_latency_ms_) / detection_count_ : 0.0f;
 }
 
@@ -266,8 +430,19 @@ void WakeWordDetector::log_inference_stats() const {
     ESP_LOGI(TAG, "  Detections: %u", detection_count_);
     ESP_LOGI(TAG, "  False Positives: %u", false_positive_count_);
     ESP_LOGI(TAG, "  Average Latency: %.1f ms", get_average_latency_ms());
-    ESP_LOGI(TAG, "  Inference Count: %u", inference_count_);
+    ESP_LOGI(TAG, "  Inference Count: %u (%u passes over budget)", inference_count_, budget_overrun_count_);
     ESP_LOGI(TAG, "  Last Confidence: %.3f", last_confidence_);
+    for (const auto& keyword : keywords_) {
+        const FeatureQueue* queue = keyword ? keyword->feature_queue() : nullptr;
+        if (!queue) continue;
+        ESP_LOGI(TAG, "  Keyword '%s': %u inferences, %u detections, queue %u dropped, high water %u/%u",
+                 keyword->name(), keyword->get_inference_count(), keyword->get_detection_count(),
+                 queue->get_dropped_count(), queue->get_high_water(), queue->depth());
+    }
+    if (gate_) {
+        ESP_LOGI(TAG, "  Gate Openings: %u, Gated Audio: %llu s",
+                 gate_open_count_, static_cast<unsigned long long>(gated_samples_ / MFCCFrontend::SAMPLE_RATE));
+    }
 }
 
 void WakeWordDetector::wake_word_task_wrapper(void* arg) {
@@ -275,372 +450,188 @@ void WakeWordDetector::wake_word_task_wrapper(void* arg) {
 }
 
 void WakeWordDetector::wake_word_task() {
-    ESP_LOGI(TAG, "Wake word task started");
-    
-    size_t signal;
-    TickType_t last_inference = 0;
-    const TickType_t inference_period = pdMS_TO_TICKS(30); // 30ms intervals
+    ESP_LOGI(TAG, "Wake word task started on core %d", xPortGetCoreID());
     
     while (enabled_) {
-        // Wait for audio data or timeout
-        if (xQueueReceive(audio_queue_, &signal, inference_period) == pdTRUE) {
-            
-            // Throttle inference rate
-            TickType_t current_time = xTaskGetTickCount();
-            if (current_time - last_inference >= inference_period) {
-                process_inference();
-                last_inference = current_time;
-            }
-        }
+        // Woken by the MFCC stage for every published feature block
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+        process_inference();
     }
     
     ESP_LOGI(TAG, "Wake word task ended");
 }
 
 void WakeWordDetector::process_inference() {
-    if (!mfcc_frontend_ || !mfcc_features_) return;
-    
-    uint32_t start_time = esp_timer_get_time();
-    
-    // Get MFCC features from frontend
-    if (!mfcc_frontend_->get_features(mfcc_features_.get())) {
-        return; // No valid features available
+    // One block per keyword per round, highest priority first, until every
+    // queue is drained or the pass has used its inference interval; what is
+    // left waits for the next wake-up
+    bool pending = false;
+    for (const auto& keyword : keywords_) {
+        pending |= keyword->has_pending();
+    }
+    if (!pending) {
+        return;  // Timeout wake-up: stay at the idle clock
     }
     
-    // Perform TensorFlow Lite inference with MFCC features
-    float confidence = run_inference(mfcc_features_.get(), MFCCFrontend::FEATURE_SIZE);
+    const int64_t deadline = esp_timer_get_time() + inference_interval_us_;
+    PowerLock::Scope full_clock(inference_lock_);
     
+    while (pending) {
+        pending = false;
+        for (size_t index : schedule_) {
+            KeywordModel& keyword = *keywords_[index];
+            if (!keyword.has_pending()) continue;
+            
+            if (esp_timer_get_time() >= deadline) {
+                budget_overrun_count_++;
+                return;
+            }
+            
+            uint32_t start_time = esp_timer_get_time();
+            if (index == 0) {
+                LatencyTrace::record(TraceEvent::INFERENCE_START);
+            }
+            
+            float confidence = 0.0f;
+            if (!keyword.score_next(confidence)) continue;
+            
+            if (index == 0) {
+                LatencyTrace::record(TraceEvent::INFERENCE_END, static_cast<uint16_t>(confidence * 1000.0f));
+            }
+            report_inference(index, confidence, start_time);
+            pending |= keyword.has_pending();
+        }
+    }
+}
+
+void WakeWordDetector::report_inference(size_t index, float confidence, uint32_t start_time) {
+    KeywordModel& keyword = *keywords_[index];
     uint32_t inference_time = (esp_timer_get_time() - start_time) / 1000; // Convert to ms
     inference_count_++;
-    last_confidence_ = confidence;
-    
-    // Check for detection
-    if (validate_detection(confidence)) {
-        uint32_t detection_latency = inference_time;
-        last_latency_ms_ = detection_latency;
-        total_latency_ms_ += detection_latency;
-        detection_count_++;
-        
-        ESP_LOGI(TAG, "Wake word detected! Confidence: %.3f, Latency: %u ms", 
-                confidence, detection_latency);
-        
-        if (detection_callback_) {
-            detection_callback_(confidence, detection_latency);
+    
+    // Pre-threshold: give the network a head start on the handshake while
+    // the smoothed posterior is still confirming
+    if (index == 0) {
+        last_confidence_ = confidence;
+        if (config_.prearm_threshold > 0.0f) {
+            const bool above = confidence >= config_.prearm_threshold;
+            if (above && !prearmed_ && prearm_callback_) {
+                prearm_callback_(confidence);
+            }
+            prearmed_ = above;
         }
     }
     
-    // Log performance periodically
-    if (inference_count_ % 100 == 0) {
-        ESP_LOGD(TAG, "Inference #%u: %.3f confidence, %u ms", 
-                inference_count_, confidence, inference_time);
-    }
-}
-
-bool WakeWordDetector::validate_detection(float confidence) {
-    uint32_t current_time = esp_timer_get_time() / 1000;
-    
-    // Note: Threshold may need re-tuning for INT8 quantized models
-    // INT8 quantization can shift the confidence score distribution
-    // Consider using trainer-suggested threshold or empirical validation
-    if (confidence >= config_.threshold) {
-        if (detection_start_time_ == 0) {
-            detection_start_time_ = current_time;
-            consecutive_detections_ = 1;
+    // Check for detection; reported at the smoothed peak
+    if (keyword.update_detection(confidence)) {
+        const float peak = keyword.get_detection_confidence();
+        if (index == 0) {
+            LatencyTrace::record(TraceEvent::WAKE_CONFIRMED, static_cast<uint16_t>(peak * 1000.0f));
+            uint32_t detection_latency = inference_time;
+            last_latency_ms_ = detection_latency;
+            total_latency_ms_ += detection_latency;
+            detection_count_++;
+            
+            ESP_LOGI(TAG, "Wake word detected! Confidence: %.3f, Latency: %u ms",
+                    peak, detection_latency);
+            
+            if (detection_callback_) {
+                detection_callback_(peak, detection_latency);
+            }
         } else {
-            consecutive_detections_++;
+            ESP_LOGI(TAG, "Keyword '%s' detected! Confidence: %.3f", keyword.name(), peak);
         }
         
-        // Check if we've had consistent detections for the required duration
-        uint32_t detection_duration = current_time - detection_start_time_;
-        if (detection_duration >= config_.trigger_duration_ms) {
-            // Reset for next detection
-            detection_start_time_ = 0;
-            consecutive_detections_ = 0;
-            return true;
+        if (keyword_callback_) {
+            keyword_callback_(index, keyword.name(), peak);
         }
-    } else {
-        // Reset if confidence drops below threshold
-        detection_start_time_ = 0;
-        consecutive_detections_ = 0;
-    }
-    
-    return false;
-}
-
-bool WakeWordDetector::setup_tf_lite_model() {
-    ESP_LOGI(TAG, "Setting up TensorFlow Lite model...");
-    
-    // Load model from embedded data
-    model_ = tflite::GetModel(model_data_);
-    if (model_->version() != TFLITE_SCHEMA_VERSION) {
-        ESP_LOGE(TAG, "Model schema version %d not supported. Supported version is %d",
-                model_->version(), TFLITE_SCHEMA_VERSION);
-        return false;
-    }
-    
-    // Allocate tensor arena in PSRAM (optimized for INT8 models)
-    tensor_arena_ = static_cast<uint8_t*>(
-        heap_caps_malloc(kTensorArenaSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
-    );
-    
-    if (!tensor_arena_) {
-        ESP_LOGE(TAG, "Failed to allocate tensor arena (%d bytes) in PSRAM", kTensorArenaSize);
-        return false;
-    }
-    
-    ESP_LOGI(TAG, "Allocated tensor arena: %d KB in PSRAM (optimized for INT8)", kTensorArenaSize / 1024);
-    
-    // Create and configure operation resolver (optimized for INT8)
-    resolver_ = new tflite::MicroMutableOpResolver<10>();
-    resolver_->AddConv2D();
-    resolver_->AddMaxPool2D();
-    resolver_->AddReshape();
-    resolver_->AddMean();
-    resolver_->AddFullyConnected();
-    // Removed AddSoftmax() - typically unused for binary classification
-    resolver_->AddDepthwiseConv2D();
-    resolver_->AddAdd();
-    resolver_->AddMul();
-    resolver_->AddQuantize();
-    resolver_->AddDequantize();
-    
-    // Create interpreter
-    static tflite::MicroInterpreter static_interpreter(
-        model_, *resolver_, tensor_arena_, kTensorArenaSize
-    );
-    interpreter_ = &static_interpreter;
-    
-    // Allocate tensors
-    TfLiteStatus allocate_status = interpreter_->AllocateTensors();
-    if (allocate_status != kTfLiteOk) {
-        ESP_LOGE(TAG, "AllocateTensors() failed with status: %d", allocate_status);
-        return false;
     }
     
-    // Log tensor information and validate INT8 types
-    TfLiteTensor* input = interpreter_->input(0);
-    TfLiteTensor* output = interpreter_->output(0);
-    
-    ESP_LOGI(TAG, "Model input shape: [%d, %d, %d, %d]", 
-             input->dims->data[0], input->dims->data[1], 
-             input->dims->data[2], input->dims->data[3]);
-    ESP_LOGI(TAG, "Model input type: %d", input->type);
-    ESP_LOGI(TAG, "Model output shape: [%d]", output->dims->data[0]);
-    ESP_LOGI(TAG, "Model output type: %d", output->type);
-    
-    // Validate and log quantization parameters for INT8 model
-    if (input->type == kTfLiteInt8) {
-        ESP_LOGI(TAG, "Input quantization: scale=%f, zero_point=%d", 
-                input->params.scale, input->params.zero_point);
-    } else {
-        ESP_LOGW(TAG, "Warning: Expected INT8 input tensor, got type %d", input->type);
-    }
-    
-    if (output->type == kTfLiteInt8) {
-        ESP_LOGI(TAG, "Output quantization: scale=%f, zero_point=%d", 
-                output->params.scale, output->params.zero_point);
-    } else {
-        ESP_LOGW(TAG, "Warning: Expected INT8 output tensor, got type %d", output->type);
-    }
-    
-    // Verify tensor dimensions match expected MFCC input
-    size_t expected_features = MFCCFrontend::N_FRAMES * MFCCFrontend::N_MFCC;
-    size_t tensor_elements = 1;
-    for (int i = 0; i < input->dims->size; i++) {
-        tensor_elements *= input->dims->data[i];
-    }
-    
-    if (tensor_elements != expected_features) {
-        ESP_LOGE(TAG, "Tensor size mismatch: expected %d, got %d", 
-                expected_features, tensor_elements);
-        return false;
-    }
-    
-    ESP_LOGI(TAG, "TensorFlow Lite INT8 model setup complete");
-    ESP_LOGI(TAG, "Model validated for %dx%d MFCC features", 
-             MFCCFrontend::N_FRAMES, MFCCFrontend::N_MFCC);
-    
-    // Device sanity checklist for debugging
-    perform_sanity_checks();
-    
-    return true;
-}
-
-void WakeWordDetector::cleanup_tf_lite_model() {
-    if (resolver_) {
-        delete resolver_;
-        resolver_ = nullptr;
-    }
-    
-    if (tensor_arena_) {
-        heap_caps_free(tensor_arena_);
-        tensor_arena_ = nullptr;
+    // Log performance periodically
+    if (inference_count_ % 100 == 0) {
+        ESP_LOGD(TAG, "Inference #%u ('%s'): %.3f confidence, %u ms",
+                inference_count_, keyword.name(), confidence, inference_time);
     }
-    
-    model_ = nullptr;
-    interpreter_ = nullptr;
 }
 
-void WakeWordDetector::perform_sanity_checks() {
-    ESP_LOGI(TAG, "=== Device Sanity Checklist ===");
-    
-    if (!interpreter_) {
-        ESP_LOGE(TAG, "Sanity check failed: No interpreter available");
-        return;
-    }
-    
-    // C2.1: Log input/output types + scales/zero points
-    TfLiteTensor* input = interpreter_->input(0);
-    TfLiteTensor* output = interpreter_->output(0);
-    
-    ESP_LOGI(TAG, "Input tensor: type=%s, scale=%f, zero_point=%d",
-             input->type == kTfLiteInt8 ? "INT8" : 
-             input->type == kTfLiteFloat32 ? "FLOAT32" : "UNKNOWN",
-             input->params.scale, input->params.zero_point);
-    
-    ESP_LOGI(TAG, "Output tensor: type=%s, scale=%f, zero_point=%d",
-             output->type == kTfLiteInt8 ? "INT8" : 
-             output->type == kTfLiteFloat32 ? "FLOAT32" : "UNKNOWN",
-             output->params.scale, output->params.zero_point);
-    
-    // C2.2: Log input dimensions and arena size used vs. reserved
-    ESP_LOGI(TAG, "Input dimensions: [%d, %d, %d, %d] (%d elements)",
-             input->dims->data[0], input->dims->data[1], 
-             input->dims->data[2], input->dims->data[3],
-             input->bytes / (input->type == kTfLiteInt8 ? sizeof(int8_t) : sizeof(float)));
-    
-    // Calculate actual arena usage
-    size_t arena_used = interpreter_->arena_used_bytes();
-    ESP_LOGI(TAG, "Tensor arena: %d KB used / %d KB reserved (%.1f%% utilization)",
-             arena_used / 1024, kTensorArenaSize / 1024, 
-             (arena_used * 100.0f) / kTensorArenaSize);
-    
-    if (arena_used > kTensorArenaSize * 0.9f) {
-        ESP_LOGW(TAG, "Warning: High arena usage (>90%%), consider increasing size");
-    }
+bool WakeWordDetector::setup_tf_lite_models() {
+    ESP_LOGI(TAG, "Setting up TensorFlow Lite models...");
     
-    // C2.3: One-off test: feed zeros MFCC and confirm stable low score
-    ESP_LOGI(TAG, "Running zero-input stability test...");
+    tensor_arena_ = std::make_unique<TensorArena>();
+    tensor_arena_->initialize(config_.arena_margin_bytes, config_.arena_internal_reserve);
     
-    // Create zero MFCC features
-    const size_t feature_size = MFCCFrontend::N_FRAMES * MFCCFrontend::N_MFCC;
-    std::unique_ptr<float[]> zero_features(new float[feature_size]);
-    std::fill_n(zero_features.get(), feature_size, 0.0f);
-    
-    // Run inference with zero input
-    float zero_confidence = run_inference(zero_features.get(), feature_size);
-    
-    ESP_LOGI(TAG, "Zero-input confidence: %.6f", zero_confidence);
-    
-    // Validate stable low score (should be well below threshold)
-    const float expected_max_zero_confidence = 0.1f; // Conservative threshold
-    if (zero_confidence > expected_max_zero_confidence) {
-        ESP_LOGW(TAG, "Warning: Zero-input confidence (%.6f) higher than expected (%.6f)", 
-                zero_confidence, expected_max_zero_confidence);
-        ESP_LOGW(TAG, "This may indicate model bias or quantization issues");
-    } else {
-        ESP_LOGI(TAG, "✓ Zero-input test passed: stable low confidence");
-    }
-    
-    // Additional shape validation
-    size_t expected_input_elements = MFCCFrontend::N_FRAMES * MFCCFrontend::N_MFCC;
-    size_t actual_input_elements = input->bytes / (input->type == kTfLiteInt8 ? sizeof(int8_t) : sizeof(float));
-    
-    if (actual_input_elements != expected_input_elements) {
-        ESP_LOGE(TAG, "Shape error: Expected %d input elements, got %d", 
-                expected_input_elements, actual_input_elements);
-    } else {
-        ESP_LOGI(TAG, "✓ Input shape validation passed");
-    }
-    
-    ESP_LOGI(TAG, "=== Sanity Check Complete ===");
-}
-
-float WakeWordDetector::run_inference(const float* mfcc_features, size_t feature_count) {
-    if (!interpreter_ || !mfcc_features || feature_count == 0) {
-        return 0.0f;
-    }
-    
-    // Get input tensor
-    TfLiteTensor* input = interpreter_->input(0);
-    if (!input || input->bytes == 0) {
-        ESP_LOGE(TAG, "Invalid input tensor");
-        return 0.0f;
+    for (auto& keyword : keywords_) {
+        if (!keyword->load() ||
+            tensor_arena_->add_model(keyword->model_data(), keyword->model_size()) < 0) {
+            return false;
+        }
     }
     
-    // Handle INT8 quantized input
-    if (input->type == kTfLiteInt8) {
-        int8_t* input_data = input->data.int8;
-        const float scale = input->params.scale;
-        const int zero_point = input->params.zero_point;
-        
-        // Quantize MFCC features to INT8
-        size_t input_elements = input->bytes / sizeof(int8_t);
-        size_t copy_elements = std::min(feature_count, input_elements);
-        
-        for (size_t i = 0; i < copy_elements; i++) {
-            // Quantize: q = round(f / scale) + zero_point
-            const int32_t quantized = static_cast<int32_t>(lroundf(mfcc_features[i] / scale)) + zero_point;
-            input_data[i] = static_cast<int8_t>(std::min(127, std::max(-128, quantized)));
+    // Slices are measured on the first boot with a model, then right-sized.
+    // At most: measure, stale record, right-size
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (!tensor_arena_->allocate()) {
+            return false;
         }
         
-        // Zero-pad if necessary
-        for (size_t i = copy_elements; i < input_elements; i++) {
-            input_data[i] = static_cast<int8_t>(zero_point);
+        bool retry = false;
+        for (size_t i = 0; i < keywords_.size(); i++) {
+            KeywordModel& keyword = *keywords_[i];
+            if (!keyword.create_interpreter(tensor_arena_->slice(i), tensor_arena_->slice_size(i))) {
+                return false;
+            }
+            
+            if (!keyword.allocate_tensors()) {
+                if (tensor_arena_->is_measuring(i)) {
+                    ESP_LOGE(TAG, "Keyword '%s' does not fit a %d KB arena",
+                             keyword.name(), TensorArena::MEASURE_SIZE / 1024);
+                    return false;
+                }
+                tensor_arena_->invalidate(i);
+                retry = true;
+                continue;
+            }
+            
+            tensor_arena_->record_usage(i, keyword.arena_used_bytes());
         }
-    } else if (input->type == kTfLiteFloat32) {
-        // Fallback to float32 for compatibility
-        float* input_data = input->data.f;
-        size_t input_elements = input->bytes / sizeof(float);
-        size_t copy_elements = std::min(feature_count, input_elements);
         
-        std::memcpy(input_data, mfcc_features, copy_elements * sizeof(float));
+        if (!retry && !tensor_arena_->is_oversized()) {
+            return true;
+        }
         
-        // Zero-pad if necessary
-        for (size_t i = copy_elements; i < input_elements; i++) {
-            input_data[i] = 0.0f;
+        // Rebuild every interpreter at the measured sizes
+        for (auto& keyword : keywords_) {
+            keyword->destroy_interpreter();
         }
-    } else {
-        ESP_LOGE(TAG, "Unsupported input tensor type: %d", input->type);
-        return 0.0f;
-    }
-    
-    // Run inference
-    TfLiteStatus invoke_status = interpreter_->Invoke();
-    if (invoke_status != kTfLiteOk) {
-        ESP_LOGE(TAG, "Invoke() failed with status: %d", invoke_status);
-        return 0.0f;
     }
     
-    // Get output
-    TfLiteTensor* output = interpreter_->output(0);
-    if (!output || output->bytes == 0) {
-        ESP_LOGE(TAG, "Invalid output tensor");
-        return 0.0f;
+    ESP_LOGE(TAG, "Failed to settle tensor arena size");
+    return false;
+}
+
+bool WakeWordDetector::use_int8_frontend() const {
+    if (!config_.int8_frontend) {
+        return false;
     }
     
-    float confidence = 0.0f;
-    
-    // Handle INT8 quantized output
-    if (output->type == kTfLiteInt8) {
-        const float out_scale = output->params.scale;
-        const int out_zero_point = output->params.zero_point;
-        const int8_t quantized_output = output->data.int8[0];
-        
-        // Dequantize: f = (q - zero_point) * scale
-        confidence = (quantized_output - out_zero_point) * out_scale;
-    } else if (output->type == kTfLiteFloat32) {
-        // Direct float32 output
-        confidence = output->data.f[0];
-    } else {
-        ESP_LOGE(TAG, "Unsupported output tensor type: %d", output->type);
-        return 0.0f;
+    // One quantized feature stream only fits models with identical input quantization
+    const TfLiteTensor* first = keywords_[0]->input();
+    for (const auto& keyword : keywords_) {
+        const TfLiteTensor* input = keyword->input();
+        if (input->type != kTfLiteInt8 ||
+            input->params.scale != first->params.scale ||
+            input->params.zero_point != first->params.zero_point) {
+            return false;
+        }
     }
-    
-    // Clamp confidence to valid range
-    confidence = std::max(0.0f, std::min(1.0f, confidence));
-    
-    return confidence;
+    return true;
+}
+
+void WakeWordDetector::cleanup_tf_lite_models() {
+    // Interpreters go before the arena they live in
+    keywords_.clear();
+    schedule_.clear();
+    tensor_arena_.reset();
 }
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
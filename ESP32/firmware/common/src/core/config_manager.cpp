@@ -1,22 +1,225 @@
 #include "core/config_manager.hpp"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/timers.h"
 #include <cstring>
+#include <map>
+#include <string>
 
 static const char* TAG = "ConfigManager";
 
 namespace irene {
 
+namespace {
+
+constexpr const char* kNamespace = "irene_config";
+constexpr size_t kMaxKeyLength = NVS_KEY_NAME_MAX_SIZE - 1;
+
+// One NVS entry as cached
+struct Entry {
+    nvs_type_t type;
+    uint32_t number;        // U32, or the bits of an I32
+    std::string bytes;      // STR (without terminator) or BLOB
+    bool dirty;             // Not yet written
+    bool erased;            // Pending nvs_erase_key()
+};
+
+// Shared by every ConfigManager; entries guarded by mutex
+struct Cache {
+    SemaphoreHandle_t mutex = nullptr;
+    TimerHandle_t commit_timer = nullptr;
+    nvs_handle_t handle = 0;
+    bool loaded = false;
+    bool held = false;
+    std::map<std::string, Entry> entries;
+    size_t dirty = 0;
+    uint32_t flushes = 0;
+    uint32_t nvs_writes = 0;
+    uint32_t unchanged_sets = 0;
+};
+
+Cache g_cache;
+
+// One record per arena pool slot: "ww.arena", "ww.arena1", ...
+std::string arena_record_key(size_t slot) {
+    return slot == 0 ? "ww.arena" : "ww.arena" + std::to_string(slot);
+}
+
+// Caller holds the mutex; nullptr if absent, erased or of another type
+const Entry* live_entry(const std::string& key, nvs_type_t type) {
+    auto it = g_cache.entries.find(key);
+    if (it == g_cache.entries.end() || it->second.erased || it->second.type != type) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void load_entry(const char* key, nvs_type_t type) {
+    Entry entry = {type, 0, {}, false, false};
+    esp_err_t err;
+    switch (type) {
+        case NVS_TYPE_U32:
+            err = nvs_get_u32(g_cache.handle, key, &entry.number);
+            break;
+        case NVS_TYPE_I32: {
+            int32_t value = 0;
+            err = nvs_get_i32(g_cache.handle, key, &value);
+            entry.number = static_cast<uint32_t>(value);
+            break;
+        }
+        case NVS_TYPE_STR: {
+            size_t length = 0;
+            err = nvs_get_str(g_cache.handle, key, nullptr, &length);
+            if (err == ESP_OK && length > 0) {
+                entry.bytes.resize(length);
+                err = nvs_get_str(g_cache.handle, key, &entry.bytes[0], &length);
+                entry.bytes.resize(length - 1);
+            }
+            break;
+        }
+        case NVS_TYPE_BLOB: {
+            size_t length = 0;
+            err = nvs_get_blob(g_cache.handle, key, nullptr, &length);
+            if (err == ESP_OK && length > 0) {
+                entry.bytes.resize(length);
+                err = nvs_get_blob(g_cache.handle, key, &entry.bytes[0], &length);
+            }
+            break;
+        }
+        default:
+            return;     // Types this manager never writes
+    }
+    
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to load '%s': %s", key, esp_err_to_name(err));
+        return;
+    }
+    g_cache.entries[key] = std::move(entry);
+}
+
+// The one pass over the namespace at boot
+void load_all() {
+    nvs_iterator_t it = nullptr;
+    esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, kNamespace, NVS_TYPE_ANY, &it);
+    while (err == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        load_entry(info.key, info.type);
+        err = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+}
+
+// Caller holds the mutex. A failed entry stays dirty for the next batch.
+ErrorCode write_dirty() {
+    if (g_cache.dirty == 0) {
+        return ErrorCode::SUCCESS;
+    }
+    
+    ErrorCode result = ErrorCode::SUCCESS;
+    for (auto it = g_cache.entries.begin(); it != g_cache.entries.end();) {
+        Entry& entry = it->second;
+        const char* key = it->first.c_str();
+        if (!entry.dirty) {
+            ++it;
+            continue;
+        }
+        
+        esp_err_t err;
+        if (entry.erased) {
+            err = nvs_erase_key(g_cache.handle, key);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        } else if (entry.type == NVS_TYPE_U32) {
+            err = nvs_set_u32(g_cache.handle, key, entry.number);
+        } else if (entry.type == NVS_TYPE_I32) {
+            err = nvs_set_i32(g_cache.handle, key, static_cast<int32_t>(entry.number));
+        } else if (entry.type == NVS_TYPE_STR) {
+            err = nvs_set_str(g_cache.handle, key, entry.bytes.c_str());
+        } else {
+            err = nvs_set_blob(g_cache.handle, key, entry.bytes.data(), entry.bytes.size());
+        }
+        
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write '%s': %s", key, esp_err_to_name(err));
+            result = ErrorCode::INIT_FAILED;
+            ++it;
+            continue;
+        }
+        
+        g_cache.nvs_writes++;
+        g_cache.dirty--;
+        entry.dirty = false;
+        it = entry.erased ? g_cache.entries.erase(it) : std::next(it);
+    }
+    
+    esp_err_t err = nvs_commit(g_cache.handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to commit changes: %s", esp_err_to_name(err));
+        return ErrorCode::INIT_FAILED;
+    }
+    g_cache.flushes++;
+    return result;
+}
+
+// Timer service task: the batch window closed
+void commit_timer_callback(TimerHandle_t timer) {
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    if (!g_cache.held) {
+        write_dirty();
+    }
+    xSemaphoreGive(g_cache.mutex);
+}
+
+// Caller holds the mutex
+void store(const std::string& key, nvs_type_t type, uint32_t number, const void* data, size_t length) {
+    auto it = g_cache.entries.find(key);
+    if (it != g_cache.entries.end()) {
+        const Entry& cached = it->second;
+        if (!cached.erased && cached.type == type && cached.number == number &&
+            cached.bytes.size() == length &&
+            (length == 0 || std::memcmp(cached.bytes.data(), data, length) == 0)) {
+            g_cache.unchanged_sets++;
+            return;
+        }
+    }
+    
+    Entry& entry = it != g_cache.entries.end() ? it->second : g_cache.entries[key];
+    if (!entry.dirty) {
+        g_cache.dirty++;
+    }
+    entry.type = type;
+    entry.number = number;
+    entry.bytes.assign(static_cast<const char*>(data), length);
+    entry.dirty = true;
+    entry.erased = false;
+}
+
+bool valid_key(const std::string& key) {
+    if (key.empty() || key.size() > kMaxKeyLength) {
+        ESP_LOGE(TAG, "Invalid key '%s': NVS keys are 1 to %u characters", key.c_str(), (unsigned)kMaxKeyLength);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
 ConfigManager::ConfigManager()
-    : nvs_handle_(0)
-    , initialized_(false)
-    , namespace_("irene_config") {
+    : initialized_(false) {
 }
 
 ConfigManager::~ConfigManager() {
-    close_nvs();
 }
 
 ErrorCode ConfigManager::initialize() {
+    if (g_cache.loaded) {
+        initialized_ = true;
+        return ErrorCode::SUCCESS;
+    }
+    
     ESP_LOGI(TAG, "Initializing configuration manager...");
     
     // Initialize NVS
@@ -32,25 +235,35 @@ ErrorCode ConfigManager::initialize() {
         return ErrorCode::INIT_FAILED;
     }
     
-    ErrorCode result = open_nvs();
-    if (result != ErrorCode::SUCCESS) {
-        return result;
+    esp_err_t err = nvs_open(kNamespace, NVS_READWRITE, &g_cache.handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", kNamespace, esp_err_to_name(err));
+        return ErrorCode::INIT_FAILED;
+    }
+    
+    g_cache.mutex = xSemaphoreCreateMutex();
+    g_cache.commit_timer = xTimerCreate("cfg_commit", pdMS_TO_TICKS(COMMIT_DELAY_MS), pdFALSE,
+                                        nullptr, commit_timer_callback);
+    if (!g_cache.mutex || !g_cache.commit_timer) {
+        ESP_LOGE(TAG, "Failed to create commit mutex or timer");
+        return ErrorCode::MEMORY_ERROR;
     }
     
+    load_all();
+    g_cache.loaded = true;
     initialized_ = true;
-    ESP_LOGI(TAG, "Configuration manager initialized");
+    ESP_LOGI(TAG, "Configuration manager initialized, %u entries cached", (unsigned)g_cache.entries.size());
     
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::set_string(const std::string& key, const std::string& value) {
     if (!initialized_) return ErrorCode::INIT_FAILED;
+    if (!valid_key(key)) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_set_str(nvs_handle_, key.c_str(), value.c_str());
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set string '%s': %s", key.c_str(), esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    store(key, NVS_TYPE_STR, 0, value.data(), value.size());
+    xSemaphoreGive(g_cache.mutex);
     
     return ErrorCode::SUCCESS;
 }
@@ -58,37 +271,21 @@ ErrorCode ConfigManager::set_string(const std::string& key, const std::string& v
 std::string ConfigManager::get_string(const std::string& key, const std::string& default_value) {
     if (!initialized_) return default_value;
     
-    size_t required_size = 0;
-    esp_err_t err = nvs_get_str(nvs_handle_, key.c_str(), nullptr, &required_size);
-    
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        return default_value;
-    }
-    
-    if (err != ESP_OK || required_size == 0) {
-        ESP_LOGW(TAG, "Failed to get string size for '%s': %s", key.c_str(), esp_err_to_name(err));
-        return default_value;
-    }
-    
-    std::string value(required_size - 1, '\0'); // -1 for null terminator
-    err = nvs_get_str(nvs_handle_, key.c_str(), &value[0], &required_size);
-    
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to get string '%s': %s", key.c_str(), esp_err_to_name(err));
-        return default_value;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const Entry* entry = live_entry(key, NVS_TYPE_STR);
+    std::string value = entry ? entry->bytes : default_value;
+    xSemaphoreGive(g_cache.mutex);
     
     return value;
 }
 
 ErrorCode ConfigManager::set_int32(const std::string& key, int32_t value) {
     if (!initialized_) return ErrorCode::INIT_FAILED;
+    if (!valid_key(key)) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_set_i32(nvs_handle_, key.c_str(), value);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set int32 '%s': %s", key.c_str(), esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    store(key, NVS_TYPE_I32, static_cast<uint32_t>(value), nullptr, 0);
+    xSemaphoreGive(g_cache.mutex);
     
     return ErrorCode::SUCCESS;
 }
@@ -96,29 +293,21 @@ ErrorCode ConfigManager::set_int32(const std::string& key, int32_t value) {
 int32_t ConfigManager::get_int32(const std::string& key, int32_t default_value) {
     if (!initialized_) return default_value;
     
-    int32_t value;
-    esp_err_t err = nvs_get_i32(nvs_handle_, key.c_str(), &value);
-    
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        return default_value;
-    }
-    
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to get int32 '%s': %s", key.c_str(), esp_err_to_name(err));
-        return default_value;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const Entry* entry = live_entry(key, NVS_TYPE_I32);
+    const int32_t value = entry ? static_cast<int32_t>(entry->number) : default_value;
+    xSemaphoreGive(g_cache.mutex);
     
     return value;
 }
 
 ErrorCode ConfigManager::set_uint32(const std::string& key, uint32_t value) {
     if (!initialized_) return ErrorCode::INIT_FAILED;
+    if (!valid_key(key)) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_set_u32(nvs_handle_, key.c_str(), value);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set uint32 '%s': %s", key.c_str(), esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    store(key, NVS_TYPE_U32, value, nullptr, 0);
+    xSemaphoreGive(g_cache.mutex);
     
     return ErrorCode::SUCCESS;
 }
@@ -126,17 +315,10 @@ ErrorCode ConfigManager::set_uint32(const std::string& key, uint32_t value) {
 uint32_t ConfigManager::get_uint32(const std::string& key, uint32_t default_value) {
     if (!initialized_) return default_value;
     
-    uint32_t value;
-    esp_err_t err = nvs_get_u32(nvs_handle_, key.c_str(), &value);
-    
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        return default_value;
-    }
-    
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to get uint32 '%s': %s", key.c_str(), esp_err_to_name(err));
-        return default_value;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const Entry* entry = live_entry(key, NVS_TYPE_U32);
+    const uint32_t value = entry ? entry->number : default_value;
+    xSemaphoreGive(g_cache.mutex);
     
     return value;
 }
@@ -167,12 +349,11 @@ bool ConfigManager::get_bool(const std::string& key, bool default_value) {
 
 ErrorCode ConfigManager::set_blob(const std::string& key, const void* data, size_t length) {
     if (!initialized_ || !data || length == 0) return ErrorCode::INIT_FAILED;
+    if (!valid_key(key)) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_set_blob(nvs_handle_, key.c_str(), data, length);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set blob '%s': %s", key.c_str(), esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
-    }
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    store(key, NVS_TYPE_BLOB, 0, data, length);
+    xSemaphoreGive(g_cache.mutex);
     
     return ErrorCode::SUCCESS;
 }
@@ -180,49 +361,46 @@ ErrorCode ConfigManager::set_blob(const std::string& key, const void* data, size
 size_t ConfigManager::get_blob(const std::string& key, void* data, size_t max_length) {
     if (!initialized_ || !data || max_length == 0) return 0;
     
-    size_t required_size = 0;
-    esp_err_t err = nvs_get_blob(nvs_handle_, key.c_str(), nullptr, &required_size);
-    
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        return 0;
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const Entry* entry = live_entry(key, NVS_TYPE_BLOB);
+    size_t length = entry ? entry->bytes.size() : 0;
+    if (length > max_length) {
+        ESP_LOGW(TAG, "Blob '%s' too large: %d > %d", key.c_str(), length, max_length);
+        length = 0;
     }
-    
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to get blob size for '%s': %s", key.c_str(), esp_err_to_name(err));
-        return 0;
-    }
-    
-    if (required_size > max_length) {
-        ESP_LOGW(TAG, "Blob '%s' too large: %d > %d", key.c_str(), required_size, max_length);
-        return 0;
+    if (length > 0) {
+        std::memcpy(data, entry->bytes.data(), length);
     }
+    xSemaphoreGive(g_cache.mutex);
     
-    err = nvs_get_blob(nvs_handle_, key.c_str(), data, &required_size);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to get blob '%s': %s", key.c_str(), esp_err_to_name(err));
-        return 0;
-    }
-    
-    return required_size;
+    return length;
 }
 
 bool ConfigManager::has_key(const std::string& key) {
     if (!initialized_) return false;
     
-    size_t required_size = 0;
-    esp_err_t err = nvs_get_blob(nvs_handle_, key.c_str(), nullptr, &required_size);
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    auto it = g_cache.entries.find(key);
+    const bool present = it != g_cache.entries.end() && !it->second.erased;
+    xSemaphoreGive(g_cache.mutex);
     
-    return err != ESP_ERR_NVS_NOT_FOUND;
+    return present;
 }
 
 ErrorCode ConfigManager::remove_key(const std::string& key) {
     if (!initialized_) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_erase_key(nvs_handle_, key.c_str());
-    if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
-        ESP_LOGE(TAG, "Failed to remove key '%s': %s", key.c_str(), esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    auto it = g_cache.entries.find(key);
+    if (it != g_cache.entries.end() && !it->second.erased) {
+        if (!it->second.dirty) {
+            g_cache.dirty++;
+        }
+        it->second.dirty = true;
+        it->second.erased = true;
+        it->second.bytes.clear();
     }
+    xSemaphoreGive(g_cache.mutex);
     
     return ErrorCode::SUCCESS;
 }
@@ -230,124 +408,313 @@ ErrorCode ConfigManager::remove_key(const std::string& key) {
 ErrorCode ConfigManager::clear_all() {
     if (!initialized_) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_erase_all(nvs_handle_);
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    esp_err_t err = nvs_erase_all(g_cache.handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(g_cache.handle);
+    }
+    if (err == ESP_OK) {
+        g_cache.entries.clear();
+        g_cache.dirty = 0;
+    }
+    xSemaphoreGive(g_cache.mutex);
+    
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to clear all keys: %s", esp_err_to_name(err));
         return ErrorCode::INIT_FAILED;
     }
     
-    return commit();
+    return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::commit() {
     if (!initialized_) return ErrorCode::INIT_FAILED;
     
-    esp_err_t err = nvs_commit(nvs_handle_);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to commit changes: %s", esp_err_to_name(err));
-        return ErrorCode::INIT_FAILED;
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const bool pending = g_cache.dirty > 0;
+    xSemaphoreGive(g_cache.mutex);
+    
+    // Opens the batch window; commits inside it ride along
+    if (pending && xTimerIsTimerActive(g_cache.commit_timer) == pdFALSE) {
+        xTimerStart(g_cache.commit_timer, 0);
     }
     
     return ErrorCode::SUCCESS;
 }
 
+ErrorCode ConfigManager::flush() {
+    if (!g_cache.loaded) return ErrorCode::SUCCESS;
+    
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const ErrorCode result = write_dirty();
+    xSemaphoreGive(g_cache.mutex);
+    
+    return result;
+}
+
+void ConfigManager::hold_commits(bool hold) {
+    if (!g_cache.loaded) return;
+    
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    const bool released = g_cache.held && !hold;
+    g_cache.held = hold;
+    if (released) {
+        write_dirty();
+    }
+    xSemaphoreGive(g_cache.mutex);
+}
+
+ConfigManager::CacheStats ConfigManager::get_cache_stats() {
+    CacheStats stats = {};
+    if (!g_cache.loaded) return stats;
+    
+    xSemaphoreTake(g_cache.mutex, portMAX_DELAY);
+    stats.entries = g_cache.entries.size();
+    stats.dirty = g_cache.dirty;
+    stats.flushes = g_cache.flushes;
+    stats.nvs_writes = g_cache.nvs_writes;
+    stats.unchanged_sets = g_cache.unchanged_sets;
+    xSemaphoreGive(g_cache.mutex);
+    
+    return stats;
+}
+
 ErrorCode ConfigManager::load_audio_config(AudioConfig& config) {
-    config.sample_rate = get_uint32("audio.sample_rate", 16000);
+    config.sample_rate = get_uint32("audio.rate", 16000);
     config.channels = static_cast<uint8_t>(get_uint32("audio.channels", 1));
-    config.bits_per_sample = static_cast<uint8_t>(get_uint32("audio.bits_per_sample", 16));
-    config.frame_size = get_uint32("audio.frame_size", 320);
-    config.buffer_count = get_uint32("audio.buffer_count", 8);
+    config.bits_per_sample = static_cast<uint8_t>(get_uint32("audio.bits", 16));
+    config.frame_ms = get_uint32("audio.frame_ms", 20);
+    config.frame_size = get_uint32("audio.frame_len", 320);
+    config.buffer_count = get_uint32("audio.buffers", 8);
+    config.vad_mode = static_cast<VADMode>(
+        get_uint32("audio.vad_mode", static_cast<uint32_t>(VADMode::ADAPTIVE)));
+    config.vad_idle_hangover_ms = get_uint32("audio.vad_idle", 200);
+    config.vad_stream_hangover_ms = get_uint32("audio.vad_strm", 300);
+    config.playback_enabled = get_bool("audio.play", true);
+    config.playback_prebuffer_ms = get_uint32("audio.play_pre", 120);
+    config.playback_buffer_ms = get_uint32("audio.play_buf", 2000);
+    config.barge_in_enabled = get_bool("audio.barge_in", true);
+    config.aec_filter_taps = get_uint32("audio.aec_taps", 128);
     
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::save_audio_config(const AudioConfig& config) {
-    set_uint32("audio.sample_rate", config.sample_rate);
+    set_uint32("audio.rate", config.sample_rate);
     set_uint32("audio.channels", config.channels);
-    set_uint32("audio.bits_per_sample", config.bits_per_sample);
-    set_uint32("audio.frame_size", config.frame_size);
-    set_uint32("audio.buffer_count", config.buffer_count);
+    set_uint32("audio.bits", config.bits_per_sample);
+    set_uint32("audio.frame_ms", config.frame_ms);
+    set_uint32("audio.frame_len", config.frame_size);
+    set_uint32("audio.buffers", config.buffer_count);
+    set_uint32("audio.vad_mode", static_cast<uint32_t>(config.vad_mode));
+    set_uint32("audio.vad_idle", config.vad_idle_hangover_ms);
+    set_uint32("audio.vad_strm", config.vad_stream_hangover_ms);
+    set_bool("audio.play", config.playback_enabled);
+    set_uint32("audio.play_pre", config.playback_prebuffer_ms);
+    set_uint32("audio.play_buf", config.playback_buffer_ms);
+    set_bool("audio.barge_in", config.barge_in_enabled);
+    set_uint32("audio.aec_taps", config.aec_filter_taps);
     
     return commit();
 }
 
 ErrorCode ConfigManager::load_network_config(NetworkConfig& config) {
     config.ssid = get_string("network.ssid", "");
-    config.password = get_string("network.password", "");
-    config.server_uri = get_string("network.server_uri", "wss://assistant.lan/stt");
+    config.password = get_string("network.passwd", "");
+    config.server_uri = get_string("network.uri", "wss://assistant.lan/stt");
     config.node_id = get_string("network.node_id", "unknown");
-    config.reconnect_delay_ms = get_uint32("network.reconnect_delay_ms", 5000);
-    config.max_retry_count = get_uint32("network.max_retry_count", 10);
+    config.reconnect_delay_ms = get_uint32("network.backoff", 5000);
+    config.max_retry_count = get_uint32("network.retries", 10);
+    config.wifi_fast_reconnect = get_bool("wifi.fast", true);
+    config.wifi_idle_profile = static_cast<WiFiPowerProfile>(
+        get_uint32("network.wifi_ps", static_cast<uint32_t>(WiFiPowerProfile::LOW_POWER)));
+    config.wifi_listen_interval = get_uint32("wifi.listen", 3);
+    config.keep_warm = get_bool("network.warm", true);
+    config.keepalive_ping_ms = get_uint32("network.ping_ms", 15000);
+    config.session_connect_wait_ms = get_uint32("network.conn_ms", 1500);
+    config.wake_arbitration = get_bool("network.arb", true);
+    config.arbitration_timeout_ms = get_uint32("network.arb_ms", 250);
+    config.uplink_queue_depth = get_uint32("uplink.depth", 12);
+    config.uplink_overflow_policy = static_cast<UplinkOverflowPolicy>(
+        get_uint32("uplink.policy", static_cast<uint32_t>(UplinkOverflowPolicy::DROP_OLDEST)));
+    config.uplink_block_timeout_ms = get_uint32("uplink.block_ms", 5);
+    config.uplink_preroll_frames = get_uint32("uplink.preroll", 30);
+    config.uplink_batch_ms = get_uint32("uplink.batch_ms", 60);
+    config.uplink_batch_bytes = get_uint32("uplink.batch_sz", 0);
+    config.uplink_codec = static_cast<AudioCodec>(
+        get_uint32("uplink.codec", static_cast<uint32_t>(AudioCodec::PCM16)));
+    config.uplink_opus_bitrate = get_uint32("uplink.opus_bps", 24000);
+    config.ota_rate_limit = get_uint32("ota.rate", 65536);
+    config.ota_checkpoint_bytes = get_uint32("ota.ckpt", 65536);
     
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::save_network_config(const NetworkConfig& config) {
     set_string("network.ssid", config.ssid);
-    set_string("network.password", config.password);
-    set_string("network.server_uri", config.server_uri);
+    set_string("network.passwd", config.password);
+    set_string("network.uri", config.server_uri);
     set_string("network.node_id", config.node_id);
-    set_uint32("network.reconnect_delay_ms", config.reconnect_delay_ms);
-    set_uint32("network.max_retry_count", config.max_retry_count);
+    set_uint32("network.backoff", config.reconnect_delay_ms);
+    set_uint32("network.retries", config.max_retry_count);
+    set_bool("wifi.fast", config.wifi_fast_reconnect);
+    set_uint32("network.wifi_ps", static_cast<uint32_t>(config.wifi_idle_profile));
+    set_uint32("wifi.listen", config.wifi_listen_interval);
+    set_bool("network.warm", config.keep_warm);
+    set_uint32("network.ping_ms", config.keepalive_ping_ms);
+    set_uint32("network.conn_ms", config.session_connect_wait_ms);
+    set_bool("network.arb", config.wake_arbitration);
+    set_uint32("network.arb_ms", config.arbitration_timeout_ms);
+    set_uint32("uplink.depth", config.uplink_queue_depth);
+    set_uint32("uplink.policy", static_cast<uint32_t>(config.uplink_overflow_policy));
+    set_uint32("uplink.block_ms", config.uplink_block_timeout_ms);
+    set_uint32("uplink.preroll", config.uplink_preroll_frames);
+    set_uint32("uplink.batch_ms", config.uplink_batch_ms);
+    set_uint32("uplink.batch_sz", config.uplink_batch_bytes);
+    set_uint32("uplink.codec", static_cast<uint32_t>(config.uplink_codec));
+    set_uint32("uplink.opus_bps", config.uplink_opus_bitrate);
+    set_uint32("ota.rate", config.ota_rate_limit);
+    set_uint32("ota.ckpt", config.ota_checkpoint_bytes);
     
     return commit();
 }
 
 ErrorCode ConfigManager::load_wake_word_config(WakeWordConfig& config) {
     config.threshold = get_float("ww.threshold", 0.9f);
-    config.trigger_duration_ms = get_uint32("ww.trigger_duration_ms", 450);
-    config.back_buffer_ms = get_uint32("ww.back_buffer_ms", 300);
+    config.smoothing_ms = get_uint32("ww.smooth_ms", 150);
+    config.refractory_ms = get_uint32("ww.refract_ms", 1000);
+    config.prearm_threshold = get_float("ww.prearm", 0.5f);
+    config.back_buffer_ms = get_uint32("ww.back_ms", 300);
     config.use_psram = get_bool("ww.use_psram", true);
+    config.int8_frontend = get_bool("ww.int8_fe", true);
+    config.vad_cascade = get_bool("ww.cascade", true);
+    config.cascade_hangover_ms = get_uint32("ww.hangover_ms", 1000);
+    config.cascade_backfill_ms = get_uint32("ww.backfill_ms", 510);
+    config.arena_margin_bytes = get_uint32("ww.arena_margin", 2048);
+    config.arena_internal_reserve = get_uint32("ww.arena_rsv", 65536);
     
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::save_wake_word_config(const WakeWordConfig& config) {
     set_float("ww.threshold", config.threshold);
-    set_uint32("ww.trigger_duration_ms", config.trigger_duration_ms);
-    set_uint32("ww.back_buffer_ms", config.back_buffer_ms);
+    set_uint32("ww.smooth_ms", config.smoothing_ms);
+    set_uint32("ww.refract_ms", config.refractory_ms);
+    set_float("ww.prearm", config.prearm_threshold);
+    set_uint32("ww.back_ms", config.back_buffer_ms);
     set_bool("ww.use_psram", config.use_psram);
+    set_bool("ww.int8_fe", config.int8_frontend);
+    set_bool("ww.cascade", config.vad_cascade);
+    set_uint32("ww.hangover_ms", config.cascade_hangover_ms);
+    set_uint32("ww.backfill_ms", config.cascade_backfill_ms);
+    set_uint32("ww.arena_margin", config.arena_margin_bytes);
+    set_uint32("ww.arena_rsv", config.arena_internal_reserve);
     
     return commit();
 }
 
 ErrorCode ConfigManager::load_ui_config(UIConfig& config) {
-    config.display_width = static_cast<uint16_t>(get_uint32("ui.display_width", 412));
-    config.display_height = static_cast<uint16_t>(get_uint32("ui.display_height", 412));
+    config.display_width = static_cast<uint16_t>(get_uint32("ui.width", 412));
+    config.display_height = static_cast<uint16_t>(get_uint32("ui.height", 412));
     config.brightness = static_cast<uint8_t>(get_uint32("ui.brightness", 80));
-    config.idle_timeout_ms = get_uint32("ui.idle_timeout_ms", 30000);
-    config.show_debug_info = get_bool("ui.show_debug_info", false);
+    config.idle_timeout_ms = get_uint32("ui.idle_ms", 30000);
+    config.show_debug_info = get_bool("ui.debug", false);
     
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode ConfigManager::save_ui_config(const UIConfig& config) {
-    set_uint32("ui.display_width", config.display_width);
-    set_uint32("ui.display_height", config.display_height);
+    set_uint32("ui.width", config.display_width);
+    set_uint32("ui.height", config.display_height);
     set_uint32("ui.brightness", config.brightness);
-    set_uint32("ui.idle_timeout_ms", config.idle_timeout_ms);
-    set_bool("ui.show_debug_info", config.show_debug_info);
+    set_uint32("ui.idle_ms", config.idle_timeout_ms);
+    set_bool("ui.debug", config.show_debug_info);
     
     return commit();
 }
 
-ErrorCode ConfigManager::open_nvs() {
-    esp_err_t err = nvs_open(namespace_.c_str(), NVS_READWRITE, &nvs_handle_);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", 
-                namespace_.c_str(), esp_err_to_name(err));
+ErrorCode ConfigManager::load_wifi_cache(WiFiConnectCache& cache) {
+    WiFiConnectCache stored;
+    if (get_blob("wifi.cache", &stored, sizeof(stored)) != sizeof(stored)) {
         return ErrorCode::INIT_FAILED;
     }
     
+    cache = stored;
     return ErrorCode::SUCCESS;
 }
 
-void ConfigManager::close_nvs() {
-    if (nvs_handle_ != 0) {
-        nvs_close(nvs_handle_);
-        nvs_handle_ = 0;
+ErrorCode ConfigManager::save_wifi_cache(const WiFiConnectCache& cache) {
+    ErrorCode result = set_blob("wifi.cache", &cache, sizeof(cache));
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    
+    return commit();
+}
+
+ErrorCode ConfigManager::clear_wifi_cache() {
+    ErrorCode result = remove_key("wifi.cache");
+    if (result != ErrorCode::SUCCESS) {
+        return result;
     }
-    initialized_ = false;
+    
+    return commit();
+}
+
+ErrorCode ConfigManager::load_arena_record(size_t slot, TensorArenaRecord& record) {
+    TensorArenaRecord stored;
+    if (get_blob(arena_record_key(slot), &stored, sizeof(stored)) != sizeof(stored)) {
+        return ErrorCode::INIT_FAILED;
+    }
+    
+    record = stored;
+    return ErrorCode::SUCCESS;
+}
+
+ErrorCode ConfigManager::save_arena_record(size_t slot, const TensorArenaRecord& record) {
+    ErrorCode result = set_blob(arena_record_key(slot), &record, sizeof(record));
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    
+    return commit();
+}
+
+ErrorCode ConfigManager::clear_arena_record(size_t slot) {
+    ErrorCode result = remove_key(arena_record_key(slot));
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    
+    return commit();
+}
+
+ErrorCode ConfigManager::load_ota_record(OTAResumeRecord& record) {
+    OTAResumeRecord stored;
+    if (get_blob("ota.resume", &stored, sizeof(stored)) != sizeof(stored)) {
+        return ErrorCode::INIT_FAILED;
+    }
+    
+    record = stored;
+    return ErrorCode::SUCCESS;
+}
+
+ErrorCode ConfigManager::save_ota_record(const OTAResumeRecord& record) {
+    ErrorCode result = set_blob("ota.resume", &record, sizeof(record));
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    
+    return commit();
+}
+
+ErrorCode ConfigManager::clear_ota_record() {
+    ErrorCode result = remove_key("ota.resume");
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    
+    return commit();
 }
 
 } // namespace irene 
\ No newline at end of file
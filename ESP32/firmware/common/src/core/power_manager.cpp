@@ -0,0 +1,90 @@
+#include "core/power_manager.hpp"
+#include "esp_log.h"
+
+static const char* TAG = "PowerManager";
+
+namespace irene {
+
+namespace {
+
+bool g_active = false;
+
+} // namespace
+
+ErrorCode PowerManager::initialize(const PowerConfig& config) {
+    if (!config.low_power_listening) {
+        ESP_LOGI(TAG, "Low-power listening off, CPU stays at the boot clock");
+        return ErrorCode::SUCCESS;
+    }
+
+    esp_pm_config_t pm_config = {};
+    pm_config.max_freq_mhz = config.max_cpu_mhz;
+    pm_config.min_freq_mhz = config.min_cpu_mhz;
+    pm_config.light_sleep_enable = config.light_sleep;
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err == ESP_ERR_NOT_SUPPORTED && config.light_sleep) {
+        // Automatic light sleep also needs CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        ESP_LOGW(TAG, "Light sleep not supported by this build, scaling the clock only");
+        pm_config.light_sleep_enable = false;
+        err = esp_pm_configure(&pm_config);
+    }
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGW(TAG, "Power management not in this build (CONFIG_PM_ENABLE), CPU stays at the boot clock");
+        return ErrorCode::SUCCESS;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_pm_configure failed: %s", esp_err_to_name(err));
+        return ErrorCode::INIT_FAILED;
+    }
+
+    g_active = true;
+    ESP_LOGI(TAG, "CPU %u-%u MHz, light sleep %s", config.min_cpu_mhz, config.max_cpu_mhz,
+             pm_config.light_sleep_enable ? "on" : "off");
+    return ErrorCode::SUCCESS;
+}
+
+bool PowerManager::is_active() {
+    return g_active;
+}
+
+PowerLock::PowerLock(const char* name)
+    : handle_(nullptr)
+    , held_(false) {
+    // Fails with ESP_ERR_NOT_SUPPORTED without CONFIG_PM_ENABLE: the lock is then a no-op
+    if (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, name, &handle_) != ESP_OK) {
+        handle_ = nullptr;
+    }
+}
+
+PowerLock::~PowerLock() {
+    if (handle_) {
+        hold(false);
+        esp_pm_lock_delete(handle_);
+    }
+}
+
+void PowerLock::acquire() {
+    if (handle_) {
+        esp_pm_lock_acquire(handle_);
+    }
+}
+
+void PowerLock::release() {
+    if (handle_) {
+        esp_pm_lock_release(handle_);
+    }
+}
+
+void PowerLock::hold(bool on) {
+    if (on == held_) {
+        return;
+    }
+    held_ = on;
+    if (on) {
+        acquire();
+    } else {
+        release();
+    }
+}
+
+} // namespace irene
@@ -1,73 +1,193 @@
 #include "core/state_machine.hpp"
+#include "core/task_manager.hpp"
+#include "core/config_manager.hpp"
+#include "core/capture_route.hpp"
 #include "audio/audio_manager.hpp"
+#include "audio/audio_playback.hpp"
 #include "network/network_manager.hpp"
+#include "ota/ota_manager.hpp"
 #include "ui/ui_controller.hpp"
 #include "audio/wake_word_detector.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/memory_plan.hpp"
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"
+#include "esp_app_desc.h"
+#include "esp_system.h"
+#include <algorithm>
+#include <cstring>
 
 static const char* TAG = "StateMachine";
 
+static constexpr UBaseType_t EVENT_QUEUE_LENGTH = 16;
+static constexpr uint32_t SILENCE_TIMEOUT_MS = 700;
+static constexpr uint32_t MAX_STREAM_MS = 8000;
+static constexpr uint32_t COOLDOWN_MS = 400;
+static constexpr uint32_t ERROR_RECOVERY_MS = 5000;
+static constexpr uint32_t PROFILING_PERIOD_MS = 5000;
+
+// Bring-up tasks: below the audio and inference tasks so listening never waits
+// on them; the network one also runs the first TLS handshake
+static constexpr UBaseType_t BRING_UP_PRIORITY = 4;
+static constexpr uint32_t BRING_UP_NETWORK_STACK = 8192;
+static constexpr uint32_t BRING_UP_UI_STACK = 6144;
+static constexpr uint32_t BRING_UP_RETRY_MS = 10;    // Event queue full
+
 namespace irene {
 
+namespace {
+
+constexpr const char* kImageKey = "boot.image";
+
+// First boot of this firmware image (after an update or a fresh flash):
+// the running image's ELF hash is not the one recorded at the last boot
+bool is_new_image(ConfigManager& store) {
+    const esp_app_desc_t* app = esp_app_get_description();
+    uint8_t recorded[sizeof(app->app_elf_sha256)] = {};
+    return store.get_blob(kImageKey, recorded, sizeof(recorded)) != sizeof(recorded) ||
+           memcmp(recorded, app->app_elf_sha256, sizeof(recorded)) != 0;
+}
+
+void record_image(ConfigManager& store) {
+    const esp_app_desc_t* app = esp_app_get_description();
+    store.set_blob(kImageKey, app->app_elf_sha256, sizeof(app->app_elf_sha256));
+    store.commit();
+}
+
+} // namespace
+
 StateMachine::StateMachine()
     : current_state_(SystemState::IDLE_LISTENING)
     , state_entry_time_(0)
-    , silence_start_time_(0)
+    , event_queue_(nullptr)
+    , dropped_events_(0)
+    , network_bring_up_handle_(nullptr)
+    , capture_network_(nullptr)
+    , bring_ups_pending_(2)
+    , session_lock_("sm_session")
     , stream_start_time_(0)
+    , arbitration_start_time_(0)
     , voice_detected_(false) {
 }
 
-StateMachine::~StateMachine() = default;
+StateMachine::~StateMachine() {
+    // Timers post into the queue; stop them first
+    for (StateTimer* timer : {&state_timer_, &silence_timer_}) {
+        if (timer->handle) {
+            xTimerDelete(timer->handle, portMAX_DELAY);
+        }
+    }
+    
+    if (event_queue_) {
+        vQueueDelete(event_queue_);
+    }
+}
 
 ErrorCode StateMachine::initialize(const AudioConfig& audio_cfg,
                                   const NetworkConfig& network_cfg,
                                   const WakeWordConfig& ww_cfg,
                                   const UIConfig& ui_cfg,
-                                  const TLSConfig& tls_cfg) {
+                                  const TLSConfig& tls_cfg,
+                                  const uint8_t* ww_model_data,
+                                  size_t ww_model_size) {
     ESP_LOGI(TAG, "Initializing state machine...");
     
     // Store configurations
     ww_config_ = ww_cfg;
     network_config_ = network_cfg;
+    ui_config_ = ui_cfg;
+    tls_config_ = tls_cfg;
+    
+    // Buffer regions first: every component below carves its buffers from them
+    if (MemoryPlan::initialize() != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to reserve the memory plan");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    // Event queue and timers first: component callbacks post into them
+    event_queue_ = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(Event));
+    state_timer_.handle = xTimerCreate("sm_state", 1, pdFALSE, this, timer_callback);
+    silence_timer_.handle = xTimerCreate("sm_silence", 1, pdFALSE, this, timer_callback);
+    if (!event_queue_ || !state_timer_.handle || !silence_timer_.handle) {
+        ESP_LOGE(TAG, "Failed to create event queue or timers");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    // Settings cache before anything reads it, and before the bring-up tasks race for it
+    ConfigManager boot_store;
+    const bool new_image = boot_store.initialize() == ErrorCode::SUCCESS && is_new_image(boot_store);
     
     try {
         // Initialize audio manager
+        // The capture history also backs the wake word backfill, and holds
+        // the pre-roll while an arbitration bid is pending
+        AudioConfig audio_config = audio_cfg;
+        audio_config.history_ms = std::max(audio_cfg.history_ms, ww_cfg.cascade_backfill_ms + audio_cfg.frame_ms);
+        const uint32_t preroll_ms = ww_cfg.back_buffer_ms +
+            (network_cfg.wake_arbitration ? network_cfg.arbitration_timeout_ms : 0);
+        audio_config.history_ms = std::max(audio_config.history_ms, preroll_ms + audio_cfg.frame_ms);
         audio_manager_ = std::make_unique<AudioManager>();
-        ErrorCode result = audio_manager_->initialize(audio_cfg);
+        ErrorCode result = audio_manager_->initialize(audio_config);
         if (result != ErrorCode::SUCCESS) {
             ESP_LOGE(TAG, "Failed to initialize audio manager: %d", (int)result);
             return result;
         }
         
-        // Initialize network manager
-        network_manager_ = std::make_unique<NetworkManager>();
-        result = network_manager_->initialize(network_cfg, tls_cfg);
-        if (result != ErrorCode::SUCCESS) {
-            ESP_LOGE(TAG, "Failed to initialize network manager: %d", (int)result);
-            return result;
+        // Initialize wake word detector
+        // The checklist costs an inference per model: debug builds and the
+        // first boot of a new image only
+        wake_word_detector_ = std::make_unique<WakeWordDetector>();
+        const bool has_model = ww_model_data && ww_model_size > 0;
+        if (has_model) {
+            WakeWordConfig detector_config = ww_cfg;
+            detector_config.sanity_checks = ww_cfg.sanity_checks || new_image;
+            result = wake_word_detector_->initialize(detector_config, ww_model_data, ww_model_size);
+            if (result != ErrorCode::SUCCESS) {
+                ESP_LOGE(TAG, "Failed to initialize wake word detector: %d", (int)result);
+                return result;
+            }
+            if (new_image) {
+                record_image(boot_store);
+            }
+        } else {
+            ESP_LOGW(TAG, "No wake word model, push-to-talk only");
         }
         
-        // Initialize UI controller
-        ui_controller_ = std::make_unique<UIController>();
-        result = ui_controller_->initialize(ui_cfg);
-        if (result != ErrorCode::SUCCESS) {
-            ESP_LOGE(TAG, "Failed to initialize UI controller: %d", (int)result);
-            return result;
+        // Set up callbacks
+        setup_audio_callbacks();
+        
+        // Inference task up before capture starts; without it every frame is dropped
+        if (has_model) {
+            wake_word_detector_->enable();
+            if (!wake_word_detector_->is_enabled()) {
+                ESP_LOGE(TAG, "Failed to enable wake word detection");
+                return ErrorCode::INIT_FAILED;
+            }
         }
         
-        // Initialize wake word detector
-        wake_word_detector_ = std::make_unique<WakeWordDetector>();
-        // Note: Model data should be provided by the node-specific implementation
+        // Initialize state: run the IDLE_LISTENING entry actions
+        state_entry_time_ = esp_timer_get_time() / 1000;
+        handle_idle_listening();
+        ESP_LOGI(TAG, "Listening %u ms after boot", (unsigned)(esp_timer_get_time() / 1000));
         
-        // Set up callbacks
-        setup_callbacks();
+        // Uplink pre-roll slots for the longest pre-roll
+        uplink_config_ = network_cfg;
+        uplink_config_.uplink_preroll_frames = std::max<uint32_t>(network_cfg.uplink_preroll_frames,
+            (preroll_ms + audio_cfg.frame_ms - 1) / audio_cfg.frame_ms);
         
-        // Initialize state
-        transition_to(SystemState::IDLE_LISTENING);
+        // Network and UI come up on the core capture does not use
+        const BaseType_t bring_up_core = audio_cfg.capture_core < 0 ? tskNO_AFFINITY :
+                                                                      (audio_cfg.capture_core == 0 ? 1 : 0);
+        result = start_bring_up(bring_up_core);
+        if (result != ErrorCode::SUCCESS) {
+            return result;
+        }
+        
+        // Per-task CPU, stack and heap sampling for get_metrics()
+        TaskManager::instance().start_profiling(PROFILING_PERIOD_MS);
         
         ESP_LOGI(TAG, "State machine initialized successfully");
         return ErrorCode::SUCCESS;
@@ -78,80 +198,390 @@ ErrorCode StateMachine::initialize(const AudioConfig& audio_cfg,
     }
 }
 
+ErrorCode StateMachine::start_bring_up(BaseType_t core) {
+    ErrorCode result = TaskManager::instance().create_task(
+        "boot_net", network_bring_up_task, this, BRING_UP_NETWORK_STACK, BRING_UP_PRIORITY,
+        core, &network_bring_up_handle_);
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to create network bring-up task");
+        return result;
+    }
+    
+    result = TaskManager::instance().create_task(
+        "boot_ui", ui_bring_up_task, this, BRING_UP_UI_STACK, BRING_UP_PRIORITY, core, nullptr);
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to create UI bring-up task");
+        return result;
+    }
+    
+    return ErrorCode::SUCCESS;
+}
+
+void StateMachine::network_bring_up_task(void* arg) {
+    StateMachine* self = static_cast<StateMachine*>(arg);
+    
+    std::unique_ptr<NetworkManager> network = std::make_unique<NetworkManager>();
+    ErrorCode result = network->initialize(self->uplink_config_, self->tls_config_);
+    if (result == ErrorCode::SUCCESS) {
+        // Background firmware updates, offered by the server; optional
+        std::unique_ptr<OTAManager> ota = std::make_unique<OTAManager>();
+        if (ota->initialize(self->uplink_config_) == ErrorCode::SUCCESS) {
+            ota->set_client_certificate(self->tls_config_.client_cert_pem, self->tls_config_.client_key_pem);
+            self->pending_ota_ = std::move(ota);
+        } else {
+            ESP_LOGW(TAG, "OTA manager unavailable");
+        }
+        self->pending_network_ = std::move(network);
+    }
+    
+    // run() adopts the components and wires their callbacks, then lets
+    // this task connect: the handshake's events find everything in place
+    while (!self->post_event(SystemEvent::NETWORK_READY, static_cast<int32_t>(result))) {
+        vTaskDelay(pdMS_TO_TICKS(BRING_UP_RETRY_MS));
+    }
+    if (result == ErrorCode::SUCCESS) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->network_manager_->connect();  // Failures arrive as error events
+    }
+    
+    TaskManager::instance().delete_task(static_cast<TaskHandle_t>(nullptr));
+}
+
+void StateMachine::ui_bring_up_task(void* arg) {
+    StateMachine* self = static_cast<StateMachine*>(arg);
+    
+    std::unique_ptr<UIController> ui = std::make_unique<UIController>();
+    ErrorCode result = ui->initialize(self->ui_config_);
+    if (result == ErrorCode::SUCCESS) {
+        self->pending_ui_ = std::move(ui);
+    }
+    while (!self->post_event(SystemEvent::UI_READY, static_cast<int32_t>(result))) {
+        vTaskDelay(pdMS_TO_TICKS(BRING_UP_RETRY_MS));
+    }
+    
+    TaskManager::instance().delete_task(static_cast<TaskHandle_t>(nullptr));
+}
+
+void StateMachine::handle_network_ready(ErrorCode result) {
+    if (result != ErrorCode::SUCCESS || !pending_network_) {
+        // Same outcome as a failed start before listening came first
+        ESP_LOGE(TAG, "Failed to initialize network manager: %d, restarting", (int)result);
+        ConfigManager::flush();
+        esp_restart();
+    }
+    
+    network_manager_ = std::move(pending_network_);
+    ota_manager_ = std::move(pending_ota_);
+    setup_network_callbacks();
+    // Capture reads it from then on; the release orders the setup above before it
+    capture_network_.store(network_manager_.get(), std::memory_order_release);
+    
+    ESP_LOGI(TAG, "Network up %u ms after boot, connecting", (unsigned)(esp_timer_get_time() / 1000));
+    xTaskNotifyGive(network_bring_up_handle_);
+    finish_bring_up();
+}
+
+void StateMachine::handle_ui_ready(ErrorCode result) {
+    if (result == ErrorCode::SUCCESS && pending_ui_) {
+        ui_controller_ = std::move(pending_ui_);
+        update_ui_for_state();
+        ESP_LOGI(TAG, "UI up %u ms after boot", (unsigned)(esp_timer_get_time() / 1000));
+    } else {
+        // A voice node still works without its screen
+        ESP_LOGE(TAG, "Failed to initialize UI controller: %d, running headless", (int)result);
+    }
+    finish_bring_up();
+}
+
+void StateMachine::finish_bring_up() {
+    if (--bring_ups_pending_ == 0) {
+        MemoryPlan::log_report();
+    }
+}
+
 void StateMachine::run() {
-    uint32_t current_time = esp_timer_get_time() / 1000; // Convert to ms
+    Event event;
     
-    // Handle state-specific logic
-    switch (current_state_) {
-        case SystemState::IDLE_LISTENING:
-            handle_idle_listening();
+    // Sleep until something happens, then handle everything queued
+    if (xQueueReceive(event_queue_, &event, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+    
+    do {
+        dispatch(event);
+    } while (xQueueReceive(event_queue_, &event, 0) == pdTRUE);
+}
+
+bool StateMachine::post_event(SystemEvent event, int32_t payload) {
+    if (!event_queue_) {
+        return false;
+    }
+    
+    Event queued = {event, payload};
+    if (xQueueSend(event_queue_, &queued, 0) != pdTRUE) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGW(TAG, "Event queue full, dropped event %d", (int)event);
+        return false;
+    }
+    
+    return true;
+}
+
+bool StateMachine::post_event_from_isr(SystemEvent event, int32_t payload,
+                                       BaseType_t* higher_priority_task_woken) {
+    if (!event_queue_) {
+        return false;
+    }
+    
+    Event queued = {event, payload};
+    if (xQueueSendFromISR(event_queue_, &queued, higher_priority_task_woken) != pdTRUE) {
+        dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    return true;
+}
+
+void StateMachine::on_wake_word_detected(float confidence) {
+    post_event(SystemEvent::WAKE_WORD_DETECTED, static_cast<int32_t>(confidence * 1000.0f));
+}
+
+void StateMachine::on_voice_activity_detected(bool active) {
+    post_event(SystemEvent::VOICE_ACTIVITY, active ? 1 : 0);
+}
+
+void StateMachine::on_stream_connected() {
+    post_event(SystemEvent::STREAM_STARTED);
+}
+
+void StateMachine::on_stream_disconnected() {
+    post_event(SystemEvent::STREAM_ENDED);
+}
+
+void StateMachine::on_tls_error() {
+    post_event(SystemEvent::TLS_ERROR);
+}
+
+void StateMachine::on_wifi_disconnected() {
+    post_event(SystemEvent::WIFI_DISCONNECTED);
+}
+
+void StateMachine::on_wifi_connected() {
+    post_event(SystemEvent::WIFI_CONNECTED);
+}
+
+void StateMachine::on_ota_event(SystemEvent event, int progress) {
+    post_event(event, progress);
+}
+
+void StateMachine::trigger_push_to_talk() {
+    post_event(SystemEvent::PUSH_TO_TALK);
+}
+
+void StateMachine::trigger_cooldown() {
+    post_event(SystemEvent::COOLDOWN_REQUESTED);
+}
+
+void StateMachine::dispatch(const Event& event) {
+    switch (event.event) {
+        case SystemEvent::WAKE_WORD_DETECTED: {
+            ESP_LOGI(TAG, "Wake word detected!");
+            
+            // Without the echo canceller a detection during playback is the
+            // speaker itself
+            AudioPlayback* playback = audio_manager_ ? audio_manager_->get_playback() : nullptr;
+            if (playback && playback->is_active() && !audio_manager_->get_echo_canceller()) {
+                ESP_LOGI(TAG, "Ignored during playback (barge-in off)");
+                break;
+            }
+            handle_wake_word(event.payload / 1000.0f, network_config_.wake_arbitration);
             break;
-        case SystemState::STREAMING:
-            handle_streaming();
+        }
+            
+        case SystemEvent::PUSH_TO_TALK:
+            ESP_LOGI(TAG, "Push-to-talk triggered");
+            handle_wake_word(1.0f, false);
             break;
-        case SystemState::COOLDOWN:
-            handle_cooldown();
+            
+        case SystemEvent::ARBITRATION_RESULT:
+            handle_arbitration_result(event.payload != 0);
             break;
-        case SystemState::WIFI_RETRY:
-            handle_wifi_retry();
+            
+        case SystemEvent::WAKE_WORD_PREARMED:
+            // Likely wake word: warm the socket up before it is confirmed
+            if (get_current_state() == SystemState::IDLE_LISTENING && network_manager_) {
+                network_manager_->warm_up();
+            }
             break;
-        case SystemState::ERROR:
-            handle_error();
+            
+        case SystemEvent::VOICE_ACTIVITY:
+            handle_voice_activity(event.payload != 0);
+            break;
+            
+        case SystemEvent::STREAM_STARTED:
+            handle_stream_connected();
+            break;
+            
+        case SystemEvent::STREAM_ENDED:
+            handle_stream_disconnected();
+            break;
+            
+        case SystemEvent::TLS_ERROR:
+            handle_tls_error();
+            break;
+            
+        case SystemEvent::WIFI_DISCONNECTED:
+            handle_wifi_disconnected();
+            break;
+            
+        case SystemEvent::WIFI_CONNECTED:
+            handle_wifi_connected();
+            break;
+            
+        case SystemEvent::OTA_STARTED:
+        case SystemEvent::OTA_PROGRESS:
+        case SystemEvent::OTA_FINISHED:
+        case SystemEvent::OTA_ERROR:
+            handle_ota(event.event, event.payload);
+            break;
+            
+        case SystemEvent::COOLDOWN_REQUESTED:
+            if (get_current_state() == SystemState::STREAMING) {
+                transition_to(SystemState::COOLDOWN);
+            }
+            break;
+            
+        case SystemEvent::STATE_TIMEOUT:
+            if (consume_expiry(state_timer_, event.payload)) {
+                handle_state_timeout();
+            }
+            break;
+            
+        case SystemEvent::SILENCE_TIMEOUT:
+            if (consume_expiry(silence_timer_, event.payload) &&
+                get_current_state() == SystemState::STREAMING) {
+                ESP_LOGI(TAG, "Silence timeout, ending stream");
+                transition_to(SystemState::COOLDOWN);
+            }
+            break;
+        
+        case SystemEvent::NETWORK_READY:
+            handle_network_ready(static_cast<ErrorCode>(event.payload));
+            break;
+        
+        case SystemEvent::UI_READY:
+            handle_ui_ready(static_cast<ErrorCode>(event.payload));
             break;
     }
-    
-    // Check for state timeouts
-    handle_state_timeout();
 }
 
-void StateMachine::on_wake_word_detected() {
-    ESP_LOGI(TAG, "Wake word detected!");
+void StateMachine::handle_wake_word(float confidence, bool arbitrate) {
+    if (get_current_state() != SystemState::IDLE_LISTENING) {
+        return;
+    }
     
-    if (current_state_ == SystemState::IDLE_LISTENING) {
-        // Get back buffer audio for context
-        if (audio_manager_) {
-            audio_manager_->start_streaming();
-        }
-        
-        // Start network session
-        if (network_manager_) {
-            network_manager_->start_audio_session(network_config_.node_id);
-        }
-        
-        transition_to(SystemState::STREAMING);
-        
-        if (event_callback_) {
-            event_callback_(SystemEvent::WAKE_WORD_DETECTED);
+    // Still bringing the network up: nowhere to send the audio yet
+    if (!network_manager_) {
+        ESP_LOGW(TAG, "Network not up yet, wake word dropped");
+        return;
+    }
+    
+    // Barge-in: the new request replaces the answer being played
+    AudioPlayback* playback = audio_manager_ ? audio_manager_->get_playback() : nullptr;
+    if (playback && playback->is_active()) {
+        ESP_LOGI(TAG, "Barge-in, stopping playback");
+        playback->cancel();
+    }
+    
+    if (event_callback_) {
+        event_callback_(SystemEvent::WAKE_WORD_DETECTED);
+    }
+    
+    // Other nodes may have heard the same word: bid with the score and the
+    // loudest frame around it, and hold the audio until the server decides.
+    // Without a bid on the wire (no socket) this node just streams.
+    if (arbitrate && network_manager_ && audio_manager_) {
+        const float peak_level = audio_manager_->get_peak_level(ww_config_.back_buffer_ms);
+        if (network_manager_->request_arbitration(confidence, peak_level) == ErrorCode::SUCCESS) {
+            arbitration_start_time_ = esp_timer_get_time() / 1000;
+            transition_to(SystemState::ARBITRATING);
+            return;
         }
+        ESP_LOGW(TAG, "Arbitration bid failed, streaming without it");
     }
+    
+    begin_streaming(ww_config_.back_buffer_ms);
 }
 
-void StateMachine::on_voice_activity_detected(bool active) {
+void StateMachine::handle_arbitration_result(bool won) {
+    if (get_current_state() != SystemState::ARBITRATING) {
+        return;  // Late verdict after a timeout
+    }
+    
+    const uint32_t waited_ms = esp_timer_get_time() / 1000 - arbitration_start_time_;
+    if (!won) {
+        ESP_LOGI(TAG, "Another node won arbitration after %u ms", waited_ms);
+        transition_to(SystemState::IDLE_LISTENING);
+        return;
+    }
+    
+    // The pre-roll also covers the time spent waiting for the verdict
+    ESP_LOGI(TAG, "Won arbitration after %u ms", waited_ms);
+    begin_streaming(ww_config_.back_buffer_ms + waited_ms);
+}
+
+void StateMachine::begin_streaming(uint32_t preroll_ms) {
+    // Start network session
+    if (network_manager_) {
+        network_manager_->start_audio_session(network_config_.node_id);
+    }
+    
+    transition_to(SystemState::STREAMING);
+    
+    // Stream last, once the session accepts audio: the back buffer goes
+    // out first as pre-roll so the server hears the words around the trigger
+    if (audio_manager_) {
+        audio_manager_->start_streaming(preroll_ms);
+    }
+}
+
+void StateMachine::handle_voice_activity(bool active) {
     voice_detected_ = active;
-    uint32_t current_time = esp_timer_get_time() / 1000;
+    SystemState state = get_current_state();
+    
+    // Speech onset while idle: a wake word may follow, so warm the socket up
+    if (active && state == SystemState::IDLE_LISTENING && network_manager_) {
+        network_manager_->warm_up();
+    }
     
-    if (current_state_ == SystemState::STREAMING) {
-        if (!active && silence_start_time_ == 0) {
+    if (state == SystemState::STREAMING) {
+        if (!active && !is_pending(silence_timer_)) {
             // Start silence timer
-            silence_start_time_ = current_time;
+            arm_timer(silence_timer_, SILENCE_TIMEOUT_MS);
         } else if (active) {
             // Reset silence timer
-            silence_start_time_ = 0;
+            cancel_timer(silence_timer_);
         }
     }
 }
 
-void StateMachine::on_stream_connected() {
+void StateMachine::handle_stream_connected() {
     ESP_LOGI(TAG, "Stream connected");
+    if (get_current_state() == SystemState::WIFI_RETRY) {
+        transition_to(SystemState::IDLE_LISTENING);
+    }
+    
     if (event_callback_) {
         event_callback_(SystemEvent::STREAM_STARTED);
     }
 }
 
-void StateMachine::on_stream_disconnected() {
+void StateMachine::handle_stream_disconnected() {
     ESP_LOGI(TAG, "Stream disconnected");
-    if (current_state_ == SystemState::STREAMING) {
+    if (get_current_state() == SystemState::STREAMING) {
         transition_to(SystemState::COOLDOWN);
+    } else if (get_current_state() == SystemState::ARBITRATING) {
+        transition_to(SystemState::IDLE_LISTENING);  // The verdict cannot arrive
     }
     
     if (event_callback_) {
@@ -159,7 +589,7 @@ void StateMachine::on_stream_disconnected() {
     }
 }
 
-void StateMachine::on_tls_error() {
+void StateMachine::handle_tls_error() {
     ESP_LOGE(TAG, "TLS error occurred");
     transition_to(SystemState::WIFI_RETRY);
     
@@ -168,7 +598,7 @@ void StateMachine::on_tls_error() {
     }
 }
 
-void StateMachine::on_wifi_disconnected() {
+void StateMachine::handle_wifi_disconnected() {
     ESP_LOGW(TAG, "WiFi disconnected");
     transition_to(SystemState::WIFI_RETRY);
     
@@ -177,9 +607,9 @@ void StateMachine::on_wifi_disconnected() {
     }
 }
 
-void StateMachine::on_wifi_connected() {
+void StateMachine::handle_wifi_connected() {
     ESP_LOGI(TAG, "WiFi connected");
-    if (current_state_ == SystemState::WIFI_RETRY) {
+    if (get_current_state() == SystemState::WIFI_RETRY) {
         transition_to(SystemState::IDLE_LISTENING);
     }
     
@@ -188,7 +618,7 @@ void StateMachine::on_wifi_connected() {
     }
 }
 
-void StateMachine::on_ota_event(SystemEvent event, int progress) {
+void StateMachine::handle_ota(SystemEvent event, int progress) {
     ESP_LOGI(TAG, "OTA event: %d, progress: %d%%", (int)event, progress);
     
     if (ui_controller_) {
@@ -216,19 +646,6 @@ void StateMachine::on_ota_event(SystemEvent event, int progress) {
     }
 }
 
-void StateMachine::trigger_push_to_talk() {
-    ESP_LOGI(TAG, "Push-to-talk triggered");
-    if (current_state_ == SystemState::IDLE_LISTENING) {
-        on_wake_word_detected();
-    }
-}
-
-void StateMachine::trigger_cooldown() {
-    if (current_state_ == SystemState::STREAMING) {
-        transition_to(SystemState::COOLDOWN);
-    }
-}
-
 void StateMachine::set_state_change_callback(StateChangeCallback callback) {
     state_change_callback_ = callback;
 }
@@ -238,20 +655,63 @@ void StateMachine::set_event_callback(EventCallback callback) {
 }
 
 void StateMachine::transition_to(SystemState new_state) {
-    if (new_state == current_state_) return;
+    SystemState old_state = get_current_state();
+    if (new_state == old_state) return;
     
-    SystemState old_state = current_state_;
-    current_state_ = new_state;
+    current_state_.store(new_state, std::memory_order_release);
     state_entry_time_ = esp_timer_get_time() / 1000;
     
     ESP_LOGI(TAG, "State transition: %d -> %d", (int)old_state, (int)new_state);
+    LatencyTrace::record(TraceEvent::STATE_TRANSITION,
+                         static_cast<uint16_t>((static_cast<uint8_t>(old_state) << 8) |
+                                               static_cast<uint8_t>(new_state)));
     
-    // Reset state-specific variables
-    silence_start_time_ = 0;
+    // Reset state-specific timers
+    cancel_timer(state_timer_);
+    cancel_timer(silence_timer_);
     if (new_state == SystemState::STREAMING) {
         stream_start_time_ = state_entry_time_;
     }
     
+    // Settings changed meanwhile are written once the interaction is over
+    ConfigManager::hold_commits(new_state == SystemState::ARBITRATING ||
+                                new_state == SystemState::STREAMING ||
+                                new_state == SystemState::COOLDOWN);
+    
+    // Full CPU clock for the session too: encoding, TLS and the verdict
+    session_lock_.hold(new_state == SystemState::ARBITRATING || new_state == SystemState::STREAMING);
+    
+    // No radio power save while audio is on the air or a verdict is due
+    if (network_manager_) {
+        if (new_state == SystemState::STREAMING || new_state == SystemState::ARBITRATING) {
+            network_manager_->set_power_profile(WiFiPowerProfile::PERFORMANCE);
+        } else if (new_state == SystemState::IDLE_LISTENING) {
+            network_manager_->set_power_profile(network_config_.wifi_idle_profile);
+        }
+    }
+    
+    // Entry actions and the state's timeout
+    switch (new_state) {
+        case SystemState::IDLE_LISTENING:
+            handle_idle_listening();
+            break;
+        case SystemState::ARBITRATING:
+            handle_arbitrating();
+            break;
+        case SystemState::STREAMING:
+            handle_streaming();
+            break;
+        case SystemState::COOLDOWN:
+            handle_cooldown();
+            break;
+        case SystemState::WIFI_RETRY:
+            handle_wifi_retry();
+            break;
+        case SystemState::ERROR:
+            handle_error();
+            break;
+    }
+    
     // Update UI
     update_ui_for_state();
     
@@ -262,41 +722,37 @@ void StateMachine::transition_to(SystemState new_state) {
 }
 
 void StateMachine::handle_state_timeout() {
-    uint32_t current_time = esp_timer_get_time() / 1000;
-    uint32_t time_in_state = current_time - state_entry_time_;
-    
-    switch (current_state_) {
-        case SystemState::STREAMING:
-            // Check for silence timeout or max stream time
-            if (silence_start_time_ > 0) {
-                uint32_t silence_duration = current_time - silence_start_time_;
-                if (silence_duration >= 700) { // 700ms silence timeout
-                    ESP_LOGI(TAG, "Silence timeout, ending stream");
-                    transition_to(SystemState::COOLDOWN);
-                }
-            }
+    switch (get_current_state()) {
+        case SystemState::ARBITRATING:
+            // A server that does not arbitrate never answers
+            ESP_LOGW(TAG, "No arbitration verdict in %u ms, streaming",
+                     network_config_.arbitration_timeout_ms);
+            begin_streaming(ww_config_.back_buffer_ms + network_config_.arbitration_timeout_ms);
+            break;
             
-            if (time_in_state >= 8000) { // 8 second max stream time
-                ESP_LOGI(TAG, "Max stream time reached, ending stream");
-                transition_to(SystemState::COOLDOWN);
-            }
+        case SystemState::STREAMING:
+            ESP_LOGI(TAG, "Max stream time reached, ending stream");
+            transition_to(SystemState::COOLDOWN);
             break;
             
         case SystemState::COOLDOWN:
-            if (time_in_state >= 400) { // 400ms cooldown
-                transition_to(SystemState::IDLE_LISTENING);
-            }
+            transition_to(SystemState::IDLE_LISTENING);
             break;
             
         case SystemState::WIFI_RETRY:
-            if (time_in_state >= network_config_.reconnect_delay_ms) {
-                // Attempt reconnection
-                if (network_manager_) {
-                    network_manager_->reconnect();
-                }
+            // Runs in the network monitor task; success arrives as an event
+            if (network_manager_) {
+                network_manager_->reconnect();
+            }
+            if (get_current_state() == SystemState::WIFI_RETRY) {
+                arm_timer(state_timer_, network_config_.reconnect_delay_ms);
             }
             break;
             
+        case SystemState::ERROR:
+            transition_to(SystemState::WIFI_RETRY);
+            break;
+            
         default:
             break;
     }
@@ -305,7 +761,7 @@ void StateMachine::handle_state_timeout() {
 void StateMachine::update_ui_for_state() {
     if (!ui_controller_) return;
     
-    ui_controller_->show_system_state(current_state_);
+    ui_controller_->show_system_state(get_current_state());
 }
 
 void StateMachine::handle_idle_listening() {
@@ -316,10 +772,16 @@ void StateMachine::handle_idle_listening() {
     }
 }
 
+void StateMachine::handle_arbitrating() {
+    // Capture keeps filling the history; the verdict or the timeout ends it
+    arm_timer(state_timer_, network_config_.arbitration_timeout_ms);
+}
+
 void StateMachine::handle_streaming() {
     // Audio streaming is handled by the audio manager
     // Network transmission is handled by network manager
-    // We just monitor for end conditions in handle_state_timeout()
+    // End conditions are the silence and max stream timers
+    arm_timer(state_timer_, MAX_STREAM_MS);
 }
 
 void StateMachine::handle_cooldown() {
@@ -332,42 +794,136 @@ void StateMachine::handle_cooldown() {
     if (network_manager_) {
         network_manager_->end_audio_session();
     }
+    
+    arm_timer(state_timer_, COOLDOWN_MS);
 }
 
 void StateMachine::handle_wifi_retry() {
-    // WiFi reconnection logic is handled in handle_state_timeout()
-    // UI should show retry status
+    // Reconnection runs on the state timer; UI shows retry status
+    arm_timer(state_timer_, network_config_.reconnect_delay_ms);
 }
 
 void StateMachine::handle_error() {
-    // Error recovery logic
-    ESP_LOGW(TAG, "In error state - attempting recovery");
-    
-    // Try to restart components
-    uint32_t current_time = esp_timer_get_time() / 1000;
-    uint32_t time_in_state = current_time - state_entry_time_;
+    // Error recovery: try to restart components after a while
+    ESP_LOGW(TAG, "In error state - attempting recovery in %u ms", ERROR_RECOVERY_MS);
+    arm_timer(state_timer_, ERROR_RECOVERY_MS);
+}
+
+void StateMachine::arm_timer(StateTimer& timer, uint32_t timeout_ms) {
+    timer.generation++;
+    timer.pending = true;
     
-    if (time_in_state >= 5000) { // Try recovery after 5 seconds
-        transition_to(SystemState::WIFI_RETRY);
+    // The generation reaches the callback through the timer command queue,
+    // ahead of the restart: an old period expiring before the restart is
+    // processed still posts the old generation
+    xTimerPendFunctionCall(stamp_generation, &timer, timer.generation, portMAX_DELAY);
+    TickType_t period = pdMS_TO_TICKS(timeout_ms);
+    xTimerChangePeriod(timer.handle, period > 0 ? period : 1, portMAX_DELAY);  // Also starts it
+}
+
+void StateMachine::cancel_timer(StateTimer& timer) {
+    // An expiry already queued no longer matches the generation
+    timer.generation++;
+    timer.pending = false;
+    xTimerStop(timer.handle, portMAX_DELAY);
+}
+
+bool StateMachine::consume_expiry(StateTimer& timer, int32_t payload) {
+    if (static_cast<uint32_t>(payload) != timer.generation) {
+        return false;
     }
+    timer.pending = false;
+    return true;
+}
+
+bool StateMachine::is_pending(const StateTimer& timer) {
+    // Armed and neither cancelled, re-armed nor expired since
+    return timer.pending;
 }
 
-void StateMachine::setup_callbacks() {
+void StateMachine::stamp_generation(void* timer, uint32_t generation) {
+    // Timer service task, in order with the timer's commands
+    static_cast<StateTimer*>(timer)->armed = generation;
+}
+
+void StateMachine::timer_callback(TimerHandle_t handle) {
+    // Timer service task: never touch state here, just post
+    StateMachine* self = static_cast<StateMachine*>(pvTimerGetTimerID(handle));
+    StateTimer& timer = handle == self->silence_timer_.handle ? self->silence_timer_ : self->state_timer_;
+    SystemEvent event = &timer == &self->silence_timer_ ? SystemEvent::SILENCE_TIMEOUT :
+                                                          SystemEvent::STATE_TIMEOUT;
+    self->post_event(event, static_cast<int32_t>(timer.armed));
+}
+
+void StateMachine::setup_audio_callbacks() {
     // Set up audio manager callbacks
     if (audio_manager_) {
         audio_manager_->set_vad_callback([this](bool voice_detected) {
             on_voice_activity_detected(voice_detected);
         });
         
-        audio_manager_->set_audio_data_callback([this](const int16_t* data, size_t samples) {
-            // Forward audio data to network manager for streaming
-            if (current_state_ == SystemState::STREAMING && network_manager_) {
-                network_manager_->send_audio_data(reinterpret_cast<const uint8_t*>(data), 
-                                                 samples * sizeof(int16_t));
+        audio_manager_->set_audio_data_callback([this](const AudioFrameRef& frame) {
+            // Hand the frame to the uplink task; capture never waits on the network
+            NetworkManager* network = capture_network_.load(std::memory_order_acquire);
+            if (get_current_state() == SystemState::STREAMING && network) {
+                network->queue_audio_frame(frame);
+            }
+        });
+        
+        audio_manager_->set_preroll_callback([this](const AudioFrameSpan& first, const AudioFrameSpan& second) {
+            // Refs lent from the back buffer; the uplink keeps its own
+            NetworkManager* network = capture_network_.load(std::memory_order_acquire);
+            if (get_current_state() == SystemState::STREAMING && network) {
+                size_t queued = network->queue_preroll(first, second);
+                ESP_LOGD(TAG, "Pre-roll: %u frames queued", (unsigned)queued);
+            }
+        });
+        
+        // Capture stage of the wake word pipeline; inference runs in the detector's task.
+        // The frame is already in the history when the callback runs.
+        if (wake_word_detector_) {
+            wake_word_detector_->set_audio_history(&audio_manager_->get_history());
+            if (audio_manager_->uses_spectral_vad()) {
+                wake_word_detector_->set_mel_tap([this](const float* log_mel, size_t bands) {
+                    audio_manager_->process_vad_spectrum(log_mel, bands);
+                });
+            }
+        }
+        audio_manager_->set_capture_callback([this](const AudioFrameRef& frame) {
+            if (!wake_word_detector_) return;
+            
+            // While streaming the frontend keeps running for the adaptive
+            // VAD's mel energies, without inference
+            switch (route_capture_frame(get_current_state(), wake_word_detector_->is_enabled(),
+                                        audio_manager_->uses_spectral_vad())) {
+                case CaptureRoute::DETECT:
+                    wake_word_detector_->process_frame(frame.data(), frame.size(), &frame.stats());
+                    break;
+                case CaptureRoute::ANALYZE:
+                    wake_word_detector_->analyze_frame(frame.data(), frame.size());
+                    break;
+                case CaptureRoute::NONE:
+                    break;
             }
         });
     }
     
+    // Set up wake word detector callback
+    if (wake_word_detector_) {
+        wake_word_detector_->set_detection_callback([this](float confidence, uint32_t latency_ms) {
+            ESP_LOGI(TAG, "Wake word detected with confidence: %.3f, latency: %u ms", 
+                    confidence, latency_ms);
+            on_wake_word_detected(confidence);
+        });
+        
+        wake_word_detector_->set_prearm_callback([this](float confidence) {
+            ESP_LOGD(TAG, "Wake word pre-threshold at %.3f, warming up connection", confidence);
+            post_event(SystemEvent::WAKE_WORD_PREARMED);
+        });
+    }
+}
+
+void StateMachine::setup_network_callbacks() {
     // Set up network manager callbacks
     if (network_manager_) {
         network_manager_->set_connection_callback([this](bool connected) {
@@ -378,6 +934,12 @@ void StateMachine::setup_callbacks() {
             }
         });
         
+        network_manager_->set_wifi_callback([this](bool connected) {
+            if (connected) {
+                on_wifi_connected();
+            }
+        });
+        
         network_manager_->set_error_callback([this](ErrorCode error, const std::string& details) {
             ESP_LOGE(TAG, "Network error: %d - %s", (int)error, details.c_str());
             if (error == ErrorCode::TLS_FAILED) {
@@ -386,14 +948,56 @@ void StateMachine::setup_callbacks() {
                 on_wifi_disconnected();
             }
         });
+        
+        network_manager_->set_arbitration_callback([this](bool won) {
+            post_event(SystemEvent::ARBITRATION_RESULT, won ? 1 : 0);
+        });
+        
+        // Server audio goes straight to the playback path on the WebSocket task
+        network_manager_->set_playback_callbacks(
+            [this](bool start, AudioCodec codec, uint32_t sample_rate) {
+                AudioPlayback* playback = audio_manager_ ? audio_manager_->get_playback() : nullptr;
+                if (!playback) {
+                    return;
+                }
+                if (start) {
+                    playback->begin_stream(codec, sample_rate);
+                } else {
+                    playback->end_stream();
+                }
+            },
+            [this](const uint8_t* data, size_t length, size_t offset, size_t total) {
+                AudioPlayback* playback = audio_manager_ ? audio_manager_->get_playback() : nullptr;
+                if (playback) {
+                    playback->push(data, length, offset, total);
+                }
+            });
+        
+        network_manager_->set_ota_callback([this](std::string_view url) {
+            if (ota_manager_ && ota_manager_->start_update(std::string(url), tls_config_.ca_cert_pem) == ErrorCode::SUCCESS) {
+                on_ota_event(SystemEvent::OTA_STARTED);
+            }
+        });
     }
     
-    // Set up wake word detector callback
-    if (wake_word_detector_) {
-        wake_word_detector_->set_detection_callback([this](float confidence, uint32_t latency_ms) {
-            ESP_LOGI(TAG, "Wake word detected with confidence: %.3f, latency: %u ms", 
-                    confidence, latency_ms);
-            on_wake_word_detected();
+    // Firmware downloads leave the air to conversations
+    if (ota_manager_) {
+        ota_manager_->set_hold_check([this]() {
+            const SystemState state = get_current_state();
+            AudioPlayback* playback = audio_manager_ ? audio_manager_->get_playback() : nullptr;
+            return state == SystemState::STREAMING || state == SystemState::ARBITRATING ||
+                   (playback && playback->is_active());
+        });
+        
+        ota_manager_->set_progress_callback([this](int percentage) {
+            on_ota_event(SystemEvent::OTA_PROGRESS, percentage);
+        });
+        
+        ota_manager_->set_complete_callback([this](bool success, const std::string& error) {
+            if (!success) {
+                ESP_LOGW(TAG, "Firmware update failed: %s", error.c_str());
+            }
+            on_ota_event(success ? SystemEvent::OTA_FINISHED : SystemEvent::OTA_ERROR);
         });
     }
 }
@@ -1,14 +1,34 @@
 #include "core/task_manager.hpp"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_psram.h"
+#include "esp_timer.h"
+#include "utils/json.hpp"
 #include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 static const char* TAG = "TaskManager";
 
+#if defined(CONFIG_FREERTOS_USE_TRACE_FACILITY) && defined(CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS)
+#define TASK_MANAGER_RUNTIME_STATS 1
+#else
+#define TASK_MANAGER_RUNTIME_STATS 0
+#endif
+
+static constexpr uint32_t PROFILER_STACK_SIZE = 4096;
+static constexpr UBaseType_t PROFILER_PRIORITY = 1;  // Just above idle
+static constexpr const char* PROFILER_NAME = "task_profiler";
+static constexpr uint32_t PROFILER_STOP_POLL_MS = 10;
+
 namespace irene {
 
 TaskManager::TaskManager() 
-    : tasks_mutex_(nullptr) {
+    : tasks_mutex_(nullptr)
+    , profiler_handle_(nullptr)
+    , profile_period_ms_(0)
+    , last_total_runtime_(0)
+    , metrics_valid_(false) {
     
     tasks_mutex_ = xSemaphoreCreateMutex();
     if (!tasks_mutex_) {
@@ -19,6 +39,7 @@ TaskManager::TaskManager()
 }
 
 TaskManager::~TaskManager() {
+    stop_profiling();
     cleanup_all_tasks();
     
     if (tasks_mutex_) {
@@ -26,12 +47,48 @@ TaskManager::~TaskManager() {
     }
 }
 
+TaskManager& TaskManager::instance() {
+    static TaskManager manager;
+    return manager;
+}
+
 ErrorCode TaskManager::create_task(const std::string& name,
                                   TaskFunction task_func,
                                   uint32_t stack_size,
                                   UBaseType_t priority,
-                                  BaseType_t core_id) {
-    
+                                  BaseType_t core_id,
+                                  TaskHandle_t* handle_out) {
+    std::unique_ptr<TaskInfo> task_info(new TaskInfo());
+    task_info->name = name;
+    task_info->function = task_func;
+    task_info->entry = nullptr;
+    task_info->arg = nullptr;
+    task_info->stack_size = stack_size;
+    task_info->priority = priority;
+    task_info->core_id = core_id;
+    
+    return spawn(std::move(task_info), handle_out);
+}
+
+ErrorCode TaskManager::create_task(const std::string& name,
+                                  TaskFunction_t entry,
+                                  void* arg,
+                                  uint32_t stack_size,
+                                  UBaseType_t priority,
+                                  BaseType_t core_id,
+                                  TaskHandle_t* handle_out) {
+    std::unique_ptr<TaskInfo> task_info(new TaskInfo());
+    task_info->name = name;
+    task_info->entry = entry;
+    task_info->arg = arg;
+    task_info->stack_size = stack_size;
+    task_info->priority = priority;
+    task_info->core_id = core_id;
+    
+    return spawn(std::move(task_info), handle_out);
+}
+
+ErrorCode TaskManager::spawn(std::unique_ptr<TaskInfo> task_info, TaskHandle_t* handle_out) {
     if (!tasks_mutex_) {
         ESP_LOGE(TAG, "Task manager not properly initialized");
         return ErrorCode::INIT_FAILED;
@@ -40,59 +97,65 @@ ErrorCode TaskManager::create_task(const std::string& name,
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     // Check if task already exists
+    const std::string& name = task_info->name;
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
     if (it != tasks_.end()) {
         ESP_LOGW(TAG, "Task '%s' already exists", name.c_str());
+        if (handle_out) {
+            *handle_out = (*it)->handle;
+        }
         xSemaphoreGive(tasks_mutex_);
         return ErrorCode::SUCCESS;
     }
     
-    // Create task info
-    TaskInfo task_info;
-    task_info.name = name;
-    task_info.function = task_func;
-    task_info.stack_size = stack_size;
-    task_info.priority = priority;
-    task_info.core_id = core_id;
-    task_info.is_running = false;
+    // The record lives on the heap: the new task may start before we return
+    task_info->owner = this;
+    task_info->handle = nullptr;
+    task_info->is_running = true;
+    TaskInfo* info = task_info.get();
+    
+    // Plain entry points run directly; functions go through the wrapper
+    TaskFunction_t entry = info->entry ? info->entry : task_wrapper;
+    void* arg = info->entry ? info->arg : info;
     
     // Create FreeRTOS task
     BaseType_t result;
-    if (core_id == tskNO_AFFINITY) {
-        result = xTaskCreate(task_wrapper,
-                           name.c_str(),
-                           stack_size,
-                           &task_info,
-                           priority,
-                           &task_info.handle);
+    if (info->core_id == tskNO_AFFINITY) {
+        result = xTaskCreate(entry,
+                           info->name.c_str(),
+                           info->stack_size,
+                           arg,
+                           info->priority,
+                           &info->handle);
     } else {
-        result = xTaskCreatePinnedToCore(task_wrapper,
-                                       name.c_str(),
-                                       stack_size,
-                                       &task_info,
-                                       priority,
-                                       &task_info.handle,
-                                       core_id);
+        result = xTaskCreatePinnedToCore(entry,
+                                       info->name.c_str(),
+                                       info->stack_size,
+                                       arg,
+                                       info->priority,
+                                       &info->handle,
+                                       info->core_id);
     }
     
     if (result != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create task '%s'", name.c_str());
+        ESP_LOGE(TAG, "Failed to create task '%s'", info->name.c_str());
         xSemaphoreGive(tasks_mutex_);
         return ErrorCode::INIT_FAILED;
     }
     
-    task_info.is_running = true;
-    tasks_.push_back(task_info);
+    if (handle_out) {
+        *handle_out = info->handle;
+    }
+    ESP_LOGI(TAG, "Created task '%s': stack=%u, priority=%u, core=%d", 
+             info->name.c_str(), info->stack_size, info->priority, info->core_id);
+    tasks_.push_back(std::move(task_info));
     
     xSemaphoreGive(tasks_mutex_);
     
-    ESP_LOGI(TAG, "Created task '%s': stack=%u, priority=%u, core=%d", 
-             name.c_str(), stack_size, priority, core_id);
-    
     return ErrorCode::SUCCESS;
 }
 
@@ -102,16 +165,45 @@ void TaskManager::delete_task(const std::string& name) {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
+    TaskHandle_t handle = it != tasks_.end() ? (*it)->handle : nullptr;
+    
+    xSemaphoreGive(tasks_mutex_);
+    
+    if (handle) {
+        ESP_LOGI(TAG, "Deleting task '%s'", name.c_str());
+        delete_task(handle);
+    }
+}
+
+void TaskManager::delete_task(TaskHandle_t handle) {
+    if (!handle || handle == xTaskGetCurrentTaskHandle()) {
+        // The calling task: its record goes first, since vTaskDelete() does not return
+        handle = xTaskGetCurrentTaskHandle();
+        forget_task(handle);
+        vTaskDelete(handle);
+        return;
+    }
+    
+    // Another task: stop it before its record, which owns the closure it runs, goes
+    vTaskDelete(handle);
+    forget_task(handle);
+}
+
+void TaskManager::forget_task(TaskHandle_t handle) {
+    if (!tasks_mutex_ || !handle) return;
+    
+    xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
+    
+    auto it = std::find_if(tasks_.begin(), tasks_.end(),
+                          [handle](const std::unique_ptr<TaskInfo>& info) {
+                              return info->handle == handle;
+                          });
     if (it != tasks_.end()) {
-        if (it->handle) {
-            vTaskDelete(it->handle);
-        }
-        
-        ESP_LOGI(TAG, "Deleted task '%s'", name.c_str());
+        ESP_LOGD(TAG, "Task '%s' removed", (*it)->name.c_str());
         tasks_.erase(it);
     }
     
@@ -124,13 +216,13 @@ void TaskManager::suspend_task(const std::string& name) {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
-    if (it != tasks_.end() && it->handle) {
-        vTaskSuspend(it->handle);
-        it->is_running = false;
+    if (it != tasks_.end() && (*it)->handle) {
+        vTaskSuspend((*it)->handle);
+        (*it)->is_running = false;
         ESP_LOGI(TAG, "Suspended task '%s'", name.c_str());
     }
     
@@ -143,13 +235,13 @@ void TaskManager::resume_task(const std::string& name) {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
-    if (it != tasks_.end() && it->handle) {
-        vTaskResume(it->handle);
-        it->is_running = true;
+    if (it != tasks_.end() && (*it)->handle) {
+        vTaskResume((*it)->handle);
+        (*it)->is_running = true;
         ESP_LOGI(TAG, "Resumed task '%s'", name.c_str());
     }
     
@@ -162,11 +254,11 @@ bool TaskManager::is_task_running(const std::string& name) const {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
-    bool running = (it != tasks_.end()) && it->is_running;
+    bool running = (it != tasks_.end()) && (*it)->is_running;
     
     xSemaphoreGive(tasks_mutex_);
     
@@ -179,13 +271,13 @@ uint32_t TaskManager::get_task_stack_free(const std::string& name) const {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
     uint32_t free_stack = 0;
-    if (it != tasks_.end() && it->handle) {
-        free_stack = uxTaskGetStackHighWaterMark(it->handle);
+    if (it != tasks_.end() && (*it)->handle) {
+        free_stack = uxTaskGetStackHighWaterMark((*it)->handle);
     }
     
     xSemaphoreGive(tasks_mutex_);
@@ -199,13 +291,13 @@ UBaseType_t TaskManager::get_task_priority(const std::string& name) const {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     auto it = std::find_if(tasks_.begin(), tasks_.end(),
-                          [&name](const TaskInfo& info) {
-                              return info.name == name;
+                          [&name](const std::unique_ptr<TaskInfo>& info) {
+                              return info->name == name;
                           });
     
     UBaseType_t priority = 0;
-    if (it != tasks_.end() && it->handle) {
-        priority = uxTaskPriorityGet(it->handle);
+    if (it != tasks_.end() && (*it)->handle) {
+        priority = uxTaskPriorityGet((*it)->handle);
     }
     
     xSemaphoreGive(tasks_mutex_);
@@ -215,8 +307,29 @@ UBaseType_t TaskManager::get_task_priority(const std::string& name) const {
 
 void TaskManager::print_task_list() const {
     ESP_LOGI(TAG, "=== Task List ===");
-    ESP_LOGI(TAG, "Name                State  Priority  Stack  Core");
-    ESP_LOGI(TAG, "--------------------------------------------");
+    ESP_LOGI(TAG, "Name                State  Priority  Stack  Core  CPU%%");
+    ESP_LOGI(TAG, "--------------------------------------------------");
+    
+    SystemMetrics metrics;
+    if (get_metrics(metrics)) {
+        // Latest profiler sample: every task, system ones included
+        for (size_t i = 0; i < metrics.task_count; i++) {
+            const TaskMetrics& task = metrics.tasks[i];
+            ESP_LOGI(TAG, "%-20s %-6u %-8u %-6u %-4d %5.1f%s", 
+                    task.name,
+                    task.state,
+                    task.priority,
+                    task.stack_free_min,
+                    task.core,
+                    task.cpu_percent,
+                    task.managed ? "" : " (system)");
+        }
+        for (size_t core = 0; core < SystemMetrics::MAX_CORES; core++) {
+            ESP_LOGI(TAG, "Core %u load: %.1f%%", (unsigned)core, metrics.core_load_percent[core]);
+        }
+        ESP_LOGI(TAG, "=================");
+        return;
+    }
     
     if (!tasks_mutex_) return;
     
@@ -224,16 +337,16 @@ void TaskManager::print_task_list() const {
     
     for (const auto& task : tasks_) {
         uint32_t free_stack = 0;
-        if (task.handle) {
-            free_stack = uxTaskGetStackHighWaterMark(task.handle);
+        if (task->handle) {
+            free_stack = uxTaskGetStackHighWaterMark(task->handle);
         }
         
         ESP_LOGI(TAG, "%-20s %-6s %-8u %-6u %-4d", 
-                task.name.c_str(),
-                task.is_running ? "RUN" : "SUSP",
-                task.priority,
+                task->name.c_str(),
+                task->is_running ? "RUN" : "SUSP",
+                task->priority,
                 free_stack,
-                task.core_id);
+                task->core_id);
     }
     
     xSemaphoreGive(tasks_mutex_);
@@ -251,6 +364,14 @@ void TaskManager::print_heap_stats() const {
     ESP_LOGI(TAG, "Minimum free heap: %u bytes", min_free_heap);
     ESP_LOGI(TAG, "Largest free block: %u bytes", largest_block);
     
+    HeapMetrics heap;
+    fill_heap_metrics(MALLOC_CAP_INTERNAL, heap);
+    ESP_LOGI(TAG, "Internal: %u / %u bytes free (min %u, largest %u)",
+            heap.free_bytes, heap.total_bytes, heap.minimum_free_bytes, heap.largest_free_block);
+    fill_heap_metrics(MALLOC_CAP_DMA, heap);
+    ESP_LOGI(TAG, "DMA: %u / %u bytes free (min %u, largest %u)",
+            heap.free_bytes, heap.total_bytes, heap.minimum_free_bytes, heap.largest_free_block);
+    
     // PSRAM statistics if available
     if (esp_psram_is_initialized()) {
         uint32_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
@@ -277,11 +398,11 @@ void TaskManager::cleanup_all_tasks() {
     xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
     
     for (auto& task : tasks_) {
-        if (task.handle) {
-            ESP_LOGI(TAG, "Deleting task: %s", task.name.c_str());
-            vTaskDelete(task.handle);
-            task.handle = nullptr;
-            task.is_running = false;
+        if (task->handle) {
+            ESP_LOGI(TAG, "Deleting task: %s", task->name.c_str());
+            vTaskDelete(task->handle);
+            task->handle = nullptr;
+            task->is_running = false;
         }
     }
     
@@ -292,6 +413,209 @@ void TaskManager::cleanup_all_tasks() {
     ESP_LOGI(TAG, "All tasks cleaned up");
 }
 
+ErrorCode TaskManager::start_profiling(uint32_t period_ms) {
+    if (profiler_handle_) {
+        return ErrorCode::SUCCESS;
+    }
+    
+#if !TASK_MANAGER_RUNTIME_STATS
+    ESP_LOGW(TAG, "FreeRTOS run-time stats disabled; profiling heap and stacks only");
+#endif
+    
+    profile_period_ms_ = period_ms > 0 ? period_ms : 1000;
+    return create_task(PROFILER_NAME, [this]() { profiler_task(); },
+                       PROFILER_STACK_SIZE, PROFILER_PRIORITY, tskNO_AFFINITY, &profiler_handle_);
+}
+
+void TaskManager::stop_profiling() {
+    if (!profiler_handle_ || !tasks_mutex_) return;
+    
+    // The profiler finishes the sample in progress, frees it and deletes
+    // itself; wait for its record to go so a restart can reuse the name
+    TaskHandle_t handle = profiler_handle_;
+    profiler_handle_ = nullptr;
+    xTaskNotifyGive(handle);
+    while (is_task_running(PROFILER_NAME)) {
+        vTaskDelay(pdMS_TO_TICKS(PROFILER_STOP_POLL_MS));
+    }
+    
+    xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
+    metrics_valid_ = false;
+    xSemaphoreGive(tasks_mutex_);
+}
+
+bool TaskManager::get_metrics(SystemMetrics& metrics) const {
+    if (!tasks_mutex_) return false;
+    
+    xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
+    const bool valid = metrics_valid_;
+    if (valid) {
+        metrics = metrics_;
+    }
+    xSemaphoreGive(tasks_mutex_);
+    
+    return valid;
+}
+
+void TaskManager::profiler_task() {
+    const TickType_t period = pdMS_TO_TICKS(profile_period_ms_);
+    TickType_t next_wake = xTaskGetTickCount() + period;
+    
+    // A notification from stop_profiling() ends the loop between samples;
+    // returning lets the wrapper delete the task
+    while (true) {
+        const TickType_t remaining = next_wake - xTaskGetTickCount();
+        if (ulTaskNotifyTake(pdTRUE, remaining <= period ? remaining : 0) > 0) {
+            return;
+        }
+        next_wake += period;
+        sample_metrics();
+    }
+}
+
+void TaskManager::sample_metrics() {
+    // Built outside the lock, published in one copy
+    std::unique_ptr<SystemMetrics> sample(new SystemMetrics());
+    sample->timestamp_ms = esp_timer_get_time() / 1000;
+    sample->period_ms = profile_period_ms_;
+    
+    fill_heap_metrics(MALLOC_CAP_INTERNAL, sample->heap_internal);
+    fill_heap_metrics(MALLOC_CAP_SPIRAM, sample->heap_psram);
+    fill_heap_metrics(MALLOC_CAP_DMA, sample->heap_dma);
+    
+#if TASK_MANAGER_RUNTIME_STATS
+    std::unique_ptr<TaskStatus_t[]> status(new TaskStatus_t[SystemMetrics::MAX_TASKS]);
+    uint32_t total_runtime = 0;
+    const UBaseType_t count = uxTaskGetSystemState(status.get(), SystemMetrics::MAX_TASKS, &total_runtime);
+    if (count == 0) {
+        ESP_LOGW(TAG, "More than %u tasks, CPU sample skipped", (unsigned)SystemMetrics::MAX_TASKS);
+    }
+    
+    // Run-time counters are per core, so a delta over the period delta is
+    // the share of one core
+    const uint32_t period_runtime = total_runtime - last_total_runtime_;
+    const bool have_previous = last_total_runtime_ != 0 && period_runtime > 0;
+    std::vector<RuntimeSample> runtimes;
+    runtimes.reserve(count);
+    
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t& task = status[i];
+        TaskMetrics& out = sample->tasks[sample->task_count++];
+        
+        std::strncpy(out.name, task.pcTaskName, sizeof(out.name) - 1);
+        out.name[sizeof(out.name) - 1] = '\0';
+        const BaseType_t core = xTaskGetCoreID(task.xHandle);
+        out.core = (core == tskNO_AFFINITY) ? -1 : static_cast<int8_t>(core);
+        out.priority = static_cast<uint8_t>(task.uxCurrentPriority);
+        out.state = static_cast<uint8_t>(task.eCurrentState);
+        out.stack_free_min = task.usStackHighWaterMark;
+        
+        // Counter delta since the previous sample; new tasks count from zero
+        uint32_t previous = 0;
+        for (const RuntimeSample& last : last_runtime_) {
+            if (last.handle == task.xHandle) {
+                previous = last.runtime;
+                break;
+            }
+        }
+        if (have_previous) {
+            out.cpu_percent = 100.0f * (task.ulRunTimeCounter - previous) / period_runtime;
+        }
+        runtimes.push_back({task.xHandle, task.ulRunTimeCounter});
+        
+        for (BaseType_t c = 0; c < static_cast<BaseType_t>(SystemMetrics::MAX_CORES); c++) {
+            if (have_previous && task.xHandle == xTaskGetIdleTaskHandleForCore(c)) {
+                sample->core_load_percent[c] = std::max(0.0f, 100.0f - out.cpu_percent);
+            }
+        }
+    }
+    
+    last_runtime_.swap(runtimes);
+    last_total_runtime_ = total_runtime;
+    sample->cpu_stats_available = have_previous;
+#endif
+    
+    xSemaphoreTake(tasks_mutex_, portMAX_DELAY);
+    
+#if !TASK_MANAGER_RUNTIME_STATS
+    // Managed tasks only
+    for (const auto& task : tasks_) {
+        if (!task->handle || sample->task_count >= SystemMetrics::MAX_TASKS) continue;
+        TaskMetrics& out = sample->tasks[sample->task_count++];
+        std::strncpy(out.name, task->name.c_str(), sizeof(out.name) - 1);
+        out.name[sizeof(out.name) - 1] = '\0';
+        out.core = (task->core_id == tskNO_AFFINITY) ? -1 : static_cast<int8_t>(task->core_id);
+        out.priority = static_cast<uint8_t>(uxTaskPriorityGet(task->handle));
+        out.state = static_cast<uint8_t>(eTaskGetState(task->handle));
+        out.stack_free_min = uxTaskGetStackHighWaterMark(task->handle);
+    }
+#endif
+    
+    // Configured stack sizes are only known for tasks created here
+    for (size_t i = 0; i < sample->task_count; i++) {
+        TaskMetrics& out = sample->tasks[i];
+        for (const auto& task : tasks_) {
+            if (std::strncmp(task->name.c_str(), out.name, sizeof(out.name) - 1) == 0) {
+                out.managed = true;
+                out.stack_size = task->stack_size;
+                break;
+            }
+        }
+    }
+    
+    metrics_ = *sample;
+    metrics_valid_ = true;
+    
+    xSemaphoreGive(tasks_mutex_);
+}
+
+void TaskManager::fill_heap_metrics(uint32_t caps, HeapMetrics& metrics) {
+    metrics.free_bytes = heap_caps_get_free_size(caps);
+    metrics.total_bytes = heap_caps_get_total_size(caps);
+    metrics.largest_free_block = heap_caps_get_largest_free_block(caps);
+    metrics.minimum_free_bytes = heap_caps_get_minimum_free_size(caps);
+}
+
+bool TaskManager::metrics_to_json(const SystemMetrics& metrics, JsonWriter& json) {
+    auto heap_json = [&json](const char* name, const HeapMetrics& heap) {
+        json.begin_object(name)
+            .field("free", heap.free_bytes)
+            .field("total", heap.total_bytes)
+            .field("largest", heap.largest_free_block)
+            .field("min_free", heap.minimum_free_bytes)
+            .end_object();
+    };
+    
+    json.begin_object().begin_object("metrics")
+        .field("t_ms", metrics.timestamp_ms)
+        .field("period_ms", metrics.period_ms)
+        .field("cpu", metrics.cpu_stats_available)
+        .begin_array("core_load");
+    for (size_t core = 0; core < SystemMetrics::MAX_CORES; core++) {
+        json.field(nullptr, metrics.core_load_percent[core], 1);
+    }
+    json.end_array().begin_object("heap");
+    heap_json("internal", metrics.heap_internal);
+    heap_json("psram", metrics.heap_psram);
+    heap_json("dma", metrics.heap_dma);
+    json.end_object().begin_array("tasks");
+    for (size_t i = 0; i < metrics.task_count; i++) {
+        const TaskMetrics& task = metrics.tasks[i];
+        json.begin_object()
+            .field("name", task.name)
+            .field("core", static_cast<int32_t>(task.core))
+            .field("prio", static_cast<uint32_t>(task.priority))
+            .field("state", static_cast<uint32_t>(task.state))
+            .field("cpu", task.cpu_percent, 1)
+            .field("stack", task.stack_size)
+            .field("stack_free", task.stack_free_min)
+            .end_object();
+    }
+    json.end_array().end_object().end_object();
+    
+    return json.ok();
+}
+
 void TaskManager::task_wrapper(void* param) {
     TaskInfo* task_info = static_cast<TaskInfo*>(param);
     
@@ -311,8 +635,12 @@ void TaskManager::task_wrapper(void* param) {
         ESP_LOGI(TAG, "Task '%s' finished", task_info->name.c_str());
     }
     
-    // Task should delete itself if it reaches here
-    vTaskDelete(nullptr);
+    // Task should delete itself if it reaches here; the record goes with it
+    if (task_info) {
+        task_info->owner->delete_task(static_cast<TaskHandle_t>(nullptr));
+    } else {
+        vTaskDelete(nullptr);
+    }
 }
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
@@ -1,4 +1,5 @@
 #include "hardware/i2s_driver.hpp"
+#include "audio/echo_reference.hpp"
 #include "esp_log.h"
 #include "driver/i2s.h"
 #include "driver/gpio.h"
@@ -12,7 +13,11 @@ I2SDriver::I2SDriver()
     : is_running_(false)
     , sample_rate_(16000)
     , frame_size_(320)
-    , i2s_port_(I2S_NUM_0) {
+    , i2s_port_(I2S_NUM_0)
+    , event_queue_(nullptr)
+    , echo_reference_(nullptr)
+    , rx_overflow_count_(0)
+    , dma_error_count_(0) {
 }
 
 I2SDriver::~I2SDriver() {
@@ -63,6 +68,9 @@ ErrorCode I2SDriver::start() {
     
     // Clear any existing data in the DMA buffer
     i2s_zero_dma_buffer(i2s_port_);
+    if (event_queue_) {
+        xQueueReset(event_queue_);
+    }
     
     is_running_ = true;
     ESP_LOGI(TAG, "I2S driver started");
@@ -88,12 +96,46 @@ ErrorCode I2SDriver::stop() {
     return ErrorCode::SUCCESS;
 }
 
-esp_err_t I2SDriver::read_frame(uint8_t* data, size_t length, size_t* bytes_read) {
+bool I2SDriver::wait_for_rx(TickType_t timeout) {
+    if (!is_running_ || !event_queue_) {
+        return false;
+    }
+    
+    // TX completions share the queue; skip them and count RX faults
+    i2s_event_t event;
+    TickType_t start = xTaskGetTickCount();
+    while (xQueueReceive(event_queue_, &event, timeout) == pdTRUE) {
+        switch (event.type) {
+            case I2S_EVENT_RX_DONE:
+                return true;
+            case I2S_EVENT_RX_Q_OVF:
+                rx_overflow_count_++;
+                return true;  // Data is waiting; the oldest buffer was lost
+            case I2S_EVENT_DMA_ERROR:
+                dma_error_count_++;
+                break;
+            default:
+                break;
+        }
+        
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        timeout -= elapsed;
+        start += elapsed;
+    }
+    
+    return false;
+}
+
+esp_err_t I2SDriver::read_frame(uint8_t* data, size_t length, size_t* bytes_read,
+                                TickType_t timeout) {
     if (!is_running_ || !data || length == 0) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    return i2s_read(i2s_port_, data, length, bytes_read, portMAX_DELAY);
+    return i2s_read(i2s_port_, data, length, bytes_read, timeout);
 }
 
 esp_err_t I2SDriver::write_frame(const uint8_t* data, size_t length) {
@@ -102,7 +144,14 @@ esp_err_t I2SDriver::write_frame(const uint8_t* data, size_t length) {
     }
     
     size_t bytes_written = 0;
-    return i2s_write(i2s_port_, data, length, &bytes_written, portMAX_DELAY);
+    esp_err_t result = i2s_write(i2s_port_, data, length, &bytes_written, portMAX_DELAY);
+    
+    // Stamped once it sits in the TX ring: the echo the mic will hear
+    if (result == ESP_OK && echo_reference_) {
+        echo_reference_->push(reinterpret_cast<const int16_t*>(data), bytes_written / sizeof(int16_t),
+                              esp_timer_get_time());
+    }
+    return result;
 }
 
 void I2SDriver::set_gain(int8_t gain_db) {
@@ -138,8 +187,9 @@ void I2SDriver::set_sample_rate(uint32_t sample_rate) {
     sample_rate_ = sample_rate;
     config_.sample_rate = sample_rate;
     
-    // Reconfigure I2S driver
+    // Reconfigure I2S driver (uninstall frees the event queue)
     i2s_driver_uninstall(i2s_port_);
+    event_queue_ = nullptr;
     configure_i2s_driver();
     
     // Restart if it was running
@@ -180,8 +230,10 @@ ErrorCode I2SDriver::configure_i2s_driver() {
     i2s_config_.tx_desc_auto_clear = true;
     i2s_config_.fixed_mclk = 0;
     
-    // Install I2S driver
-    esp_err_t result = i2s_driver_install(i2s_port_, &i2s_config_, 0, nullptr);
+    // Install I2S driver with an event queue deep enough for RX and TX
+    // completions across the whole DMA ring
+    esp_err_t result = i2s_driver_install(i2s_port_, &i2s_config_,
+                                          config_.buffer_count * 2, &event_queue_);
     if (result != ESP_OK) {
         ESP_LOGE(TAG, "Failed to install I2S driver: %s", esp_err_to_name(result));
         return ErrorCode::AUDIO_FAILED;
@@ -0,0 +1,404 @@
+#include "network/audio_encoder.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+
+#if __has_include(<opus.h>)
+#include <opus.h>
+#define IRENE_HAS_OPUS 1
+#else
+#define IRENE_HAS_OPUS 0
+#endif
+
+static const char* TAG = "AudioEncoder";
+
+namespace irene {
+
+namespace {
+
+const int16_t IMA_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+    34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+    157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+    724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+    3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+const int8_t IMA_INDEX_TABLE[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+// Raw little-endian PCM, the protocol default
+class PcmEncoder : public AudioEncoder {
+public:
+    size_t encode(const int16_t* pcm, size_t samples, uint8_t* out, size_t out_capacity) override {
+        const size_t bytes = samples * sizeof(int16_t);
+        if (bytes > out_capacity) {
+            return 0;
+        }
+        memcpy(out, pcm, bytes);
+        return bytes;
+    }
+
+    size_t max_encoded_bytes(size_t samples) const override { return samples * sizeof(int16_t); }
+    AudioCodec codec() const override { return AudioCodec::PCM16; }
+};
+
+/**
+ * IMA-ADPCM, 4 bits per sample
+ * Payload: int16 predictor, uint8 step index, uint8 reserved, then two
+ * samples per byte, low nibble first. The header carries the encoder state
+ * so every message is independently decodable.
+ */
+class ImaAdpcmEncoder : public AudioEncoder {
+public:
+    static constexpr size_t HEADER_BYTES = 4;
+
+    ImaAdpcmEncoder() : predictor_(0), index_(0) {}
+
+    size_t encode(const int16_t* pcm, size_t samples, uint8_t* out, size_t out_capacity) override {
+        const size_t bytes = max_encoded_bytes(samples);
+        if (bytes > out_capacity) {
+            return 0;
+        }
+
+        out[0] = static_cast<uint8_t>(predictor_ & 0xFF);
+        out[1] = static_cast<uint8_t>((predictor_ >> 8) & 0xFF);
+        out[2] = static_cast<uint8_t>(index_);
+        out[3] = 0;
+
+        uint8_t* data = out + HEADER_BYTES;
+        for (size_t i = 0; i < samples; i += 2) {
+            const uint8_t lo = encode_sample(pcm[i]);
+            const uint8_t hi = (i + 1 < samples) ? encode_sample(pcm[i + 1]) : 0;
+            *data++ = static_cast<uint8_t>(lo | (hi << 4));
+        }
+
+        return bytes;
+    }
+
+    size_t max_encoded_bytes(size_t samples) const override { return HEADER_BYTES + (samples + 1) / 2; }
+    void reset() override { predictor_ = 0; index_ = 0; }
+    AudioCodec codec() const override { return AudioCodec::IMA_ADPCM; }
+
+private:
+    uint8_t encode_sample(int16_t sample) {
+        const int32_t step = IMA_STEP_TABLE[index_];
+        int32_t diff = static_cast<int32_t>(sample) - predictor_;
+        uint8_t code = 0;
+        if (diff < 0) {
+            code = 8;
+            diff = -diff;
+        }
+
+        // Quantize and reconstruct exactly as the decoder will
+        int32_t delta = step >> 3;
+        if (diff >= step) { code |= 4; diff -= step; delta += step; }
+        if (diff >= (step >> 1)) { code |= 2; diff -= step >> 1; delta += step >> 1; }
+        if (diff >= (step >> 2)) { code |= 1; delta += step >> 2; }
+
+        int32_t predictor = (code & 8) ? predictor_ - delta : predictor_ + delta;
+        predictor_ = static_cast<int16_t>(std::max<int32_t>(-32768, std::min<int32_t>(32767, predictor)));
+        index_ = std::max(0, std::min(88, index_ + IMA_INDEX_TABLE[code & 7]));
+
+        return code;
+    }
+
+    int16_t predictor_;
+    int index_;
+};
+
+#if IRENE_HAS_OPUS
+/**
+ * Opus (SILK wideband), 20ms packets
+ * Payload: a sequence of uint16 little-endian length + packet, one per
+ * 20ms of the batch. A short final packet (partial batch at EOF or after
+ * the window timeout) is padded with silence.
+ */
+class OpusUplinkEncoder : public AudioEncoder {
+public:
+    static constexpr size_t MAX_PACKET_BYTES = 256;  // Far above 24 kbps * 20ms
+
+    OpusUplinkEncoder(uint32_t sample_rate, uint32_t bitrate)
+        : encoder_(nullptr)
+        , padded_(nullptr)
+        , sample_rate_(sample_rate)
+        , bitrate_(bitrate)
+        , packet_samples_(sample_rate / 50) {
+        encoder_ = static_cast<OpusEncoder*>(
+            MemoryPlan::allocate(MemoryRegion::INTERNAL, opus_encoder_get_size(1), "OpusEncoder"));
+        padded_ = MemoryPlan::allocate_array<int16_t>(MemoryRegion::INTERNAL, packet_samples_, "OpusEncoder");
+        if (encoder_) {
+            configure();
+        }
+    }
+
+    ~OpusUplinkEncoder() override {
+        MemoryPlan::release(encoder_);
+        MemoryPlan::release(padded_);
+    }
+
+    bool is_valid() const { return encoder_ != nullptr && padded_ != nullptr; }
+
+    size_t encode(const int16_t* pcm, size_t samples, uint8_t* out, size_t out_capacity) override {
+        if (!is_valid()) {
+            return 0;
+        }
+
+        size_t written = 0;
+        for (size_t offset = 0; offset < samples; offset += packet_samples_) {
+            if (written + 2 + MAX_PACKET_BYTES > out_capacity) {
+                return 0;
+            }
+
+            const int16_t* packet = pcm + offset;
+            const size_t count = std::min(packet_samples_, samples - offset);
+            if (count < packet_samples_) {
+                memcpy(padded_, packet, count * sizeof(int16_t));
+                memset(padded_ + count, 0, (packet_samples_ - count) * sizeof(int16_t));
+                packet = padded_;
+            }
+
+            const opus_int32 len = opus_encode(encoder_, packet, packet_samples_,
+                                               out + written + 2, MAX_PACKET_BYTES);
+            if (len < 0) {
+                ESP_LOGW(TAG, "opus_encode failed: %d", static_cast<int>(len));
+                return 0;
+            }
+
+            out[written] = static_cast<uint8_t>(len & 0xFF);
+            out[written + 1] = static_cast<uint8_t>((len >> 8) & 0xFF);
+            written += 2 + static_cast<size_t>(len);
+        }
+
+        return written;
+    }
+
+    size_t max_encoded_bytes(size_t samples) const override {
+        return ((samples + packet_samples_ - 1) / packet_samples_) * (2 + MAX_PACKET_BYTES);
+    }
+
+    void reset() override {
+        if (encoder_) {
+            opus_encoder_ctl(encoder_, OPUS_RESET_STATE);
+        }
+    }
+
+    AudioCodec codec() const override { return AudioCodec::OPUS; }
+
+private:
+    void configure() {
+        if (opus_encoder_init(encoder_, sample_rate_, 1, OPUS_APPLICATION_VOIP) != OPUS_OK) {
+            MemoryPlan::release(encoder_);
+            encoder_ = nullptr;
+            return;
+        }
+        opus_encoder_ctl(encoder_, OPUS_SET_BITRATE(bitrate_));
+        opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(3));  // Keeps a 20ms packet well inside one frame period
+        opus_encoder_ctl(encoder_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+    }
+
+    OpusEncoder* encoder_;
+    int16_t* padded_;
+    uint32_t sample_rate_;
+    uint32_t bitrate_;
+    size_t packet_samples_;
+};
+#endif
+
+class PcmDecoder : public AudioDecoder {
+public:
+    size_t decode(const uint8_t* payload, size_t bytes, int16_t* pcm, size_t max_samples) override {
+        const size_t samples = std::min(bytes / sizeof(int16_t), max_samples);
+        memcpy(pcm, payload, samples * sizeof(int16_t));
+        return samples;
+    }
+
+    size_t max_decoded_samples(size_t bytes) const override { return bytes / sizeof(int16_t); }
+    AudioCodec codec() const override { return AudioCodec::PCM16; }
+};
+
+// Reads the ImaAdpcmEncoder payload; the header restarts the state each message
+class ImaAdpcmDecoder : public AudioDecoder {
+public:
+    size_t decode(const uint8_t* payload, size_t bytes, int16_t* pcm, size_t max_samples) override {
+        if (bytes < ImaAdpcmEncoder::HEADER_BYTES) {
+            return 0;
+        }
+
+        int32_t predictor = static_cast<int16_t>(payload[0] | (payload[1] << 8));
+        int index = std::min<int>(payload[2], 88);
+
+        const size_t samples = std::min(max_decoded_samples(bytes), max_samples);
+        const uint8_t* data = payload + ImaAdpcmEncoder::HEADER_BYTES;
+        for (size_t i = 0; i < samples; i++) {
+            const uint8_t code = (i & 1) ? (data[i >> 1] >> 4) : (data[i >> 1] & 0x0F);
+
+            const int32_t step = IMA_STEP_TABLE[index];
+            int32_t delta = step >> 3;
+            if (code & 4) delta += step;
+            if (code & 2) delta += step >> 1;
+            if (code & 1) delta += step >> 2;
+
+            predictor = (code & 8) ? predictor - delta : predictor + delta;
+            predictor = std::max<int32_t>(-32768, std::min<int32_t>(32767, predictor));
+            index = std::max(0, std::min(88, index + IMA_INDEX_TABLE[code & 7]));
+            pcm[i] = static_cast<int16_t>(predictor);
+        }
+
+        return samples;
+    }
+
+    size_t max_decoded_samples(size_t bytes) const override {
+        return bytes > ImaAdpcmEncoder::HEADER_BYTES ? (bytes - ImaAdpcmEncoder::HEADER_BYTES) * 2 : 0;
+    }
+
+    AudioCodec codec() const override { return AudioCodec::IMA_ADPCM; }
+};
+
+#if IRENE_HAS_OPUS
+// Reads the OpusUplinkEncoder payload: uint16 length + packet, repeated
+class OpusDownlinkDecoder : public AudioDecoder {
+public:
+    explicit OpusDownlinkDecoder(uint32_t sample_rate)
+        : decoder_(nullptr)
+        , packet_samples_(sample_rate / 50) {
+        decoder_ = static_cast<OpusDecoder*>(
+            MemoryPlan::allocate(MemoryRegion::INTERNAL, opus_decoder_get_size(1), "OpusDecoder"));
+        if (decoder_ && opus_decoder_init(decoder_, sample_rate, 1) != OPUS_OK) {
+            MemoryPlan::release(decoder_);
+            decoder_ = nullptr;
+        }
+    }
+
+    ~OpusDownlinkDecoder() override {
+        MemoryPlan::release(decoder_);
+    }
+
+    bool is_valid() const { return decoder_ != nullptr; }
+
+    size_t decode(const uint8_t* payload, size_t bytes, int16_t* pcm, size_t max_samples) override {
+        if (!decoder_) {
+            return 0;
+        }
+
+        size_t decoded = 0;
+        size_t offset = 0;
+        while (offset + 2 <= bytes) {
+            const size_t len = payload[offset] | (payload[offset + 1] << 8);
+            offset += 2;
+            if (offset + len > bytes || decoded + packet_samples_ > max_samples) {
+                break;
+            }
+
+            const int samples = opus_decode(decoder_, payload + offset, static_cast<opus_int32>(len),
+                                            pcm + decoded, static_cast<int>(packet_samples_), 0);
+            if (samples < 0) {
+                ESP_LOGW(TAG, "opus_decode failed: %d", samples);
+                break;
+            }
+            decoded += static_cast<size_t>(samples);
+            offset += len;
+        }
+
+        return decoded;
+    }
+
+    size_t max_decoded_samples(size_t bytes) const override {
+        // Every packet costs at least its length prefix and one byte
+        return (bytes / 3) * packet_samples_;
+    }
+
+    void reset() override {
+        if (decoder_) {
+            opus_decoder_ctl(decoder_, OPUS_RESET_STATE);
+        }
+    }
+
+    AudioCodec codec() const override { return AudioCodec::OPUS; }
+
+private:
+    OpusDecoder* decoder_;
+    size_t packet_samples_;
+};
+#endif
+
+} // namespace
+
+const char* audio_codec_name(AudioCodec codec) {
+    switch (codec) {
+        case AudioCodec::PCM16: return "pcm16";
+        case AudioCodec::IMA_ADPCM: return "ima_adpcm";
+        case AudioCodec::OPUS: return "opus";
+        default: return "pcm16";
+    }
+}
+
+bool audio_codec_from_name(std::string_view name, AudioCodec& codec) {
+    for (AudioCodec candidate : {AudioCodec::PCM16, AudioCodec::IMA_ADPCM, AudioCodec::OPUS}) {
+        if (name == audio_codec_name(candidate)) {
+            codec = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+AudioCodec resolve_audio_codec(AudioCodec requested) {
+#if IRENE_HAS_OPUS
+    return requested;
+#else
+    return requested == AudioCodec::OPUS ? AudioCodec::IMA_ADPCM : requested;
+#endif
+}
+
+std::unique_ptr<AudioEncoder> create_audio_encoder(AudioCodec codec, uint32_t sample_rate, uint32_t bitrate) {
+    switch (codec) {
+        case AudioCodec::OPUS: {
+#if IRENE_HAS_OPUS
+            auto opus = std::make_unique<OpusUplinkEncoder>(sample_rate, bitrate);
+            if (opus->is_valid()) {
+                return opus;
+            }
+            ESP_LOGW(TAG, "Opus encoder init failed, falling back to IMA-ADPCM");
+#else
+            ESP_LOGW(TAG, "Opus not compiled in, falling back to IMA-ADPCM");
+#endif
+            return std::make_unique<ImaAdpcmEncoder>();
+        }
+
+        case AudioCodec::IMA_ADPCM:
+            return std::make_unique<ImaAdpcmEncoder>();
+
+        case AudioCodec::PCM16:
+        default:
+            return std::make_unique<PcmEncoder>();
+    }
+}
+
+std::unique_ptr<AudioDecoder> create_audio_decoder(AudioCodec codec, uint32_t sample_rate) {
+    switch (codec) {
+        case AudioCodec::OPUS: {
+#if IRENE_HAS_OPUS
+            auto opus = std::make_unique<OpusDownlinkDecoder>(sample_rate);
+            if (opus->is_valid()) {
+                return opus;
+            }
+            ESP_LOGW(TAG, "Opus decoder init failed");
+#else
+            ESP_LOGW(TAG, "Opus not compiled in, cannot decode the stream");
+#endif
+            return nullptr;
+        }
+
+        case AudioCodec::IMA_ADPCM:
+            return std::make_unique<ImaAdpcmDecoder>();
+
+        case AudioCodec::PCM16:
+        default:
+            return std::make_unique<PcmDecoder>();
+    }
+}
+
+} // namespace irene
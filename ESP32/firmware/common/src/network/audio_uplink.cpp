@@ -0,0 +1,456 @@
+#include "network/audio_uplink.hpp"
+#include "core/task_manager.hpp"
+#include "network/audio_encoder.hpp"
+#include "utils/latency_trace.hpp"
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* TAG = "AudioUplink";
+
+// Largest capture frame (30ms); keeps room to append one past the threshold
+static constexpr size_t MAX_FRAME_BYTES = (irene::AudioUplink::kStreamSampleRate * 30 / 1000) * sizeof(int16_t);
+
+// Opus needs far more stack than the PCM/ADPCM paths
+static constexpr uint32_t OPUS_STACK_SIZE = 24576;
+
+namespace irene {
+
+AudioUplink::AudioUplink()
+    : queue_(nullptr)
+    , task_handle_(nullptr)
+    , drain_done_(nullptr)
+    , batch_buffer_(nullptr)
+    , batch_capacity_(0)
+    , batch_threshold_(0)
+    , batch_bytes_(0)
+    , batch_frames_(0)
+    , batch_first_timestamp_us_(0)
+    , batch_window_us_(0)
+    , batch_has_preroll_(false)
+    , preroll_pending_(0)
+    , encode_buffer_(nullptr)
+    , encode_capacity_(0)
+    , requested_codec_(static_cast<uint8_t>(AudioCodec::PCM16))
+    , session_generation_(0)
+    , encoder_generation_(0)
+    , traced_generation_(0)
+    , enqueued_(0)
+    , preroll_frames_(0)
+    , sent_(0)
+    , messages_(0)
+    , dropped_oldest_(0)
+    , dropped_newest_(0)
+    , send_failures_(0)
+    , pcm_bytes_(0)
+    , encoded_bytes_(0)
+    , high_water_(0)
+    , last_latency_us_(0)
+    , max_latency_us_(0)
+    , total_latency_us_(0) {
+}
+
+AudioUplink::~AudioUplink() {
+    if (task_handle_) {
+        TaskManager::instance().delete_task(task_handle_);
+        task_handle_ = nullptr;
+    }
+
+    if (queue_) {
+        flush();
+        vQueueDelete(queue_);
+    }
+    
+    if (drain_done_) {
+        vSemaphoreDelete(drain_done_);
+    }
+    
+    MemoryPlan::release(batch_buffer_);
+    MemoryPlan::release(encode_buffer_);
+}
+
+ErrorCode AudioUplink::initialize(const NetworkConfig& config, SendCallback send) {
+    config_ = config;
+    send_ = send;
+
+    if (config.uplink_queue_depth == 0 || !send_) {
+        ESP_LOGE(TAG, "Uplink needs a send callback and a non-zero depth");
+        return ErrorCode::INIT_FAILED;
+    }
+
+    // Live depth, the pre-roll burst, and one spare slot so a drain marker
+    // fits even when audio fills the queue
+    queue_ = xQueueCreate(config.uplink_queue_depth + config.uplink_preroll_frames + 1, sizeof(AudioFrame*));
+    drain_done_ = xSemaphoreCreateBinary();
+    if (!queue_ || !drain_done_) {
+        ESP_LOGE(TAG, "Failed to create uplink queue (%u frames)", config.uplink_queue_depth);
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    // Batch size: the aggregation window, capped by the byte threshold
+    const size_t window_bytes = (kStreamSampleRate * config.uplink_batch_ms / 1000) * sizeof(int16_t);
+    batch_threshold_ = window_bytes;
+    if (config.uplink_batch_bytes > 0 && (window_bytes == 0 || config.uplink_batch_bytes < window_bytes)) {
+        batch_threshold_ = config.uplink_batch_bytes;
+    }
+    batch_threshold_ = std::max<size_t>(batch_threshold_, 1);  // 0/0 = one frame per message
+    batch_window_us_ = static_cast<int64_t>(config.uplink_batch_ms) * 1000;
+    batch_capacity_ = batch_threshold_ + MAX_FRAME_BYTES;
+    
+    // Encoded output never exceeds the PCM size plus per-packet Opus framing
+    encode_capacity_ = batch_capacity_ + 512;
+    
+    batch_buffer_ = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, batch_capacity_, "AudioUplink");
+    encode_buffer_ = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, encode_capacity_, "AudioUplink");
+    if (!batch_buffer_ || !encode_buffer_) {
+        ESP_LOGE(TAG, "Failed to allocate uplink buffers (%u + %u bytes)",
+                 (unsigned)batch_capacity_, (unsigned)encode_capacity_);
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    requested_codec_ = static_cast<uint8_t>(resolve_audio_codec(config.uplink_codec));
+    
+    uint32_t stack_size = config.uplink_stack_size;
+    if (config.uplink_codec == AudioCodec::OPUS && stack_size < OPUS_STACK_SIZE) {
+        ESP_LOGW(TAG, "Raising uplink stack to %u bytes for Opus", OPUS_STACK_SIZE);
+        stack_size = OPUS_STACK_SIZE;
+    }
+
+    ErrorCode task_result = TaskManager::instance().create_task(
+        "audio_uplink",
+        uplink_task_wrapper,
+        this,
+        stack_size,
+        config.uplink_priority,
+        config.uplink_core < 0 ? tskNO_AFFINITY : config.uplink_core,
+        &task_handle_
+    );
+
+    if (task_result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to create uplink task");
+        return ErrorCode::INIT_FAILED;
+    }
+
+    ESP_LOGI(TAG, "Audio uplink ready: depth %u frames, policy %u, batch %u ms / %u bytes, codec %s",
+             config.uplink_queue_depth, static_cast<unsigned>(config.uplink_overflow_policy),
+             config.uplink_batch_ms, (unsigned)batch_threshold_, audio_codec_name(get_codec()));
+
+    return ErrorCode::SUCCESS;
+}
+
+void AudioUplink::begin_session(AudioCodec codec) {
+    requested_codec_ = static_cast<uint8_t>(resolve_audio_codec(codec));
+    session_generation_++;
+}
+
+bool AudioUplink::enqueue(const AudioFrameRef& frame) {
+    if (!queue_ || !frame) {
+        return false;
+    }
+
+    // The queue carries a raw pointer; this copy's reference travels with it
+    AudioFrameRef held = frame;
+    AudioFrame* item = held.detach();
+
+    TickType_t wait = 0;
+    if (config_.uplink_overflow_policy == UplinkOverflowPolicy::BLOCK) {
+        wait = pdMS_TO_TICKS(config_.uplink_block_timeout_ms);
+    }
+
+    // Audio never takes the spare slot reserved for the drain marker, and
+    // queued pre-roll does not count against the live depth
+    const auto has_room = [this]() {
+        return uxQueueMessagesWaiting(queue_) < config_.uplink_queue_depth + preroll_pending_.load();
+    };
+    
+    bool queued = false;
+    if (has_room()) {
+        queued = xQueueSend(queue_, &item, wait) == pdTRUE;
+    } else if (wait > 0) {
+        vTaskDelay(wait);
+        queued = has_room() && xQueueSend(queue_, &item, 0) == pdTRUE;
+    }
+
+    if (!queued && config_.uplink_overflow_policy == UplinkOverflowPolicy::DROP_OLDEST) {
+        // Make room by releasing the oldest frame; the network task may race
+        // us to it, either way one slot frees up
+        AudioFrame* oldest = nullptr;
+        if (xQueueReceive(queue_, &oldest, 0) == pdTRUE) {
+            if (oldest) {
+                take_preroll_slot();
+                AudioFrameRef(oldest).reset();
+                dropped_oldest_++;
+            } else {
+                xQueueSendToFront(queue_, &oldest, 0);  // Keep the drain marker
+            }
+        }
+        queued = xQueueSend(queue_, &item, 0) == pdTRUE;
+    }
+
+    if (!queued) {
+        AudioFrameRef(item).reset();
+        dropped_newest_++;
+        return false;
+    }
+
+    enqueued_++;
+    high_water_ = std::max(high_water_, static_cast<uint32_t>(uxQueueMessagesWaiting(queue_)));
+    return true;
+}
+
+size_t AudioUplink::enqueue_preroll(const AudioFrameSpan& first, const AudioFrameSpan& second) {
+    if (!queue_) {
+        return 0;
+    }
+    
+    // Keep the newest frames when the back buffer holds more than the reserve
+    const size_t total = first.count + second.count;
+    size_t skip = total > config_.uplink_preroll_frames ? total - config_.uplink_preroll_frames : 0;
+    size_t queued = 0;
+    
+    for (const AudioFrameSpan& span : {first, second}) {
+        for (size_t i = 0; i < span.count; i++) {
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+            
+            // Counted before it is visible so the network task never sees an
+            // uncounted pre-roll frame
+            AudioFrameRef held = span.frames[i];
+            AudioFrame* item = held.detach();
+            preroll_pending_++;
+            if (xQueueSend(queue_, &item, 0) != pdTRUE) {
+                preroll_pending_--;
+                AudioFrameRef(item).reset();
+                dropped_newest_++;
+                return queued;
+            }
+            queued++;
+        }
+    }
+    
+    enqueued_ += queued;
+    preroll_frames_ += queued;
+    high_water_ = std::max(high_water_, static_cast<uint32_t>(uxQueueMessagesWaiting(queue_)));
+    return queued;
+}
+
+ErrorCode AudioUplink::drain(TickType_t timeout) {
+    if (!queue_) {
+        return ErrorCode::SUCCESS;
+    }
+    
+    // The marker queues behind every frame already accepted
+    xSemaphoreTake(drain_done_, 0);
+    AudioFrame* marker = nullptr;
+    if (xQueueSend(queue_, &marker, timeout) != pdTRUE ||
+        xSemaphoreTake(drain_done_, timeout) != pdTRUE) {
+        ESP_LOGW(TAG, "Uplink drain timed out with %u frames queued", get_depth());
+        return ErrorCode::TIMEOUT_ERROR;
+    }
+    
+    return ErrorCode::SUCCESS;
+}
+
+void AudioUplink::flush() {
+    if (!queue_) {
+        return;
+    }
+
+    AudioFrame* item = nullptr;
+    while (xQueueReceive(queue_, &item, 0) == pdTRUE) {
+        if (item) {
+            take_preroll_slot();
+            AudioFrameRef(item).reset();
+        } else {
+            xSemaphoreGive(drain_done_);  // Nothing left to send for the waiter
+        }
+    }
+}
+
+void AudioUplink::get_stats(UplinkStats& stats) const {
+    stats.enqueued = enqueued_;
+    stats.sent = sent_;
+    stats.messages = messages_;
+    stats.preroll = preroll_frames_;
+    stats.dropped_oldest = dropped_oldest_;
+    stats.dropped_newest = dropped_newest_;
+    stats.send_failures = send_failures_;
+    stats.pcm_bytes = pcm_bytes_;
+    stats.encoded_bytes = encoded_bytes_;
+    stats.depth = get_depth();
+    stats.high_water = high_water_;
+    stats.last_latency_us = last_latency_us_;
+    stats.max_latency_us = max_latency_us_;
+    stats.avg_latency_us = messages_ > 0 ? static_cast<uint32_t>(total_latency_us_ / messages_) : 0;
+}
+
+uint32_t AudioUplink::get_depth() const {
+    return queue_ ? static_cast<uint32_t>(uxQueueMessagesWaiting(queue_)) : 0;
+}
+
+void AudioUplink::reset_stats() {
+    enqueued_ = 0;
+    preroll_frames_ = 0;
+    sent_ = 0;
+    messages_ = 0;
+    dropped_oldest_ = 0;
+    dropped_newest_ = 0;
+    send_failures_ = 0;
+    pcm_bytes_ = 0;
+    encoded_bytes_ = 0;
+    high_water_ = 0;
+    last_latency_us_ = 0;
+    max_latency_us_ = 0;
+    total_latency_us_ = 0;
+}
+
+void AudioUplink::uplink_task_wrapper(void* arg) {
+    static_cast<AudioUplink*>(arg)->uplink_task();
+}
+
+void AudioUplink::uplink_task() {
+    ESP_LOGI(TAG, "Uplink task started");
+    
+    while (true) {
+        // A partial batch waits no longer than its window, counted from the
+        // capture time of its oldest frame
+        TickType_t wait = portMAX_DELAY;
+        if (batch_frames_ > 0) {
+            const int64_t remaining_us = batch_first_timestamp_us_ + batch_window_us_ - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+        }
+        
+        AudioFrame* item = nullptr;
+        if (xQueueReceive(queue_, &item, wait) != pdTRUE) {
+            send_batch();
+            continue;
+        }
+        
+        if (!item) {
+            // End of utterance: everything ahead of the marker is in the batch
+            send_batch();
+            xSemaphoreGive(drain_done_);
+            continue;
+        }
+        
+        if (take_preroll_slot()) {
+            batch_has_preroll_ = true;
+        }
+        append_to_batch(AudioFrameRef(item));
+        
+        if (batch_bytes_ >= batch_threshold_) {
+            send_batch();
+        }
+    }
+}
+
+void AudioUplink::append_to_batch(const AudioFrameRef& frame) {
+    const size_t bytes = frame.size() * sizeof(int16_t);
+    if (batch_bytes_ + bytes > batch_capacity_) {
+        send_batch();
+    }
+    
+    if (bytes > batch_capacity_) {
+        ESP_LOGW(TAG, "Frame of %u bytes exceeds the batch buffer, dropped", (unsigned)bytes);
+        send_failures_++;
+        return;
+    }
+    
+    if (batch_frames_ == 0) {
+        batch_first_timestamp_us_ = frame.timestamp_us();
+    }
+    
+    memcpy(batch_buffer_ + batch_bytes_, frame.data(), bytes);
+    batch_bytes_ += bytes;
+    batch_frames_++;
+}
+
+void AudioUplink::send_batch() {
+    if (batch_frames_ == 0) {
+        return;
+    }
+    
+    // Raw PCM goes out as is; other codecs encode into the preallocated buffer
+    const uint8_t* payload = batch_buffer_;
+    size_t payload_bytes = batch_bytes_;
+    prepare_encoder();
+    if (encoder_->codec() != AudioCodec::PCM16) {
+        payload_bytes = encoder_->encode(reinterpret_cast<const int16_t*>(batch_buffer_),
+                                         batch_bytes_ / sizeof(int16_t),
+                                         encode_buffer_, encode_capacity_);
+        payload = encode_buffer_;
+    }
+    
+    if (payload_bytes == 0) {
+        ESP_LOGW(TAG, "Failed to encode %u bytes of audio", (unsigned)batch_bytes_);
+        send_failures_++;
+        batch_bytes_ = 0;
+        batch_frames_ = 0;
+        batch_has_preroll_ = false;
+        return;
+    }
+    
+    // A stalled send only backs up the queue; capture keeps running
+    ErrorCode result = send_(payload, payload_bytes);
+    if (result == ErrorCode::SUCCESS) {
+        pcm_bytes_ += batch_bytes_;
+        encoded_bytes_ += payload_bytes;
+        if (!batch_has_preroll_) {
+            const int64_t latency = esp_timer_get_time() - batch_first_timestamp_us_;
+            last_latency_us_ = static_cast<uint32_t>(std::max<int64_t>(latency, 0));
+            max_latency_us_ = std::max(max_latency_us_, last_latency_us_);
+            total_latency_us_ += last_latency_us_;
+        }
+        if (traced_generation_ != encoder_generation_) {
+            LatencyTrace::record(TraceEvent::FIRST_UPLINK_FRAME, static_cast<uint16_t>(payload_bytes));
+            traced_generation_ = encoder_generation_;
+        }
+        sent_ += batch_frames_;
+        messages_++;
+    } else {
+        send_failures_++;
+    }
+    
+    batch_bytes_ = 0;
+    batch_frames_ = 0;
+    batch_has_preroll_ = false;
+}
+
+void AudioUplink::prepare_encoder() {
+    // A new session restarts the codec state; a codec change rebuilds it
+    const uint32_t generation = session_generation_.load();
+    const AudioCodec codec = get_codec();
+    
+    if (encoder_ && encoder_generation_ == generation && encoder_->codec() == codec) {
+        return;
+    }
+    
+    if (!encoder_ || encoder_->codec() != codec) {
+        encoder_ = create_audio_encoder(codec, kStreamSampleRate, config_.uplink_opus_bitrate);
+        if (encoder_->max_encoded_bytes(batch_capacity_ / sizeof(int16_t)) > encode_capacity_) {
+            ESP_LOGE(TAG, "Encoder %s output exceeds the uplink buffer", audio_codec_name(codec));
+            encoder_ = create_audio_encoder(AudioCodec::PCM16, kStreamSampleRate, 0);
+        }
+    } else {
+        encoder_->reset();
+    }
+    
+    encoder_generation_ = generation;
+    ESP_LOGI(TAG, "Uplink encoder: %s", audio_codec_name(encoder_->codec()));
+}
+
+bool AudioUplink::take_preroll_slot() {
+    // Pre-roll is queued ahead of live audio, so the first frames taken off
+    // the front while the count is non-zero are pre-roll
+    uint32_t pending = preroll_pending_.load();
+    while (pending > 0 && !preroll_pending_.compare_exchange_weak(pending, pending - 1)) {
+    }
+    return pending > 0;
+}
+
+} // namespace irene
@@ -1,37 +1,66 @@
 #include "network/network_manager.hpp"
+#include "core/task_manager.hpp"
 #include "network/wifi_manager.hpp"
 #include "network/tls_manager.hpp"
 #include "network/websocket_client.hpp"
+#include "network/audio_uplink.hpp"
+#include "network/audio_encoder.hpp"
+#include "utils/json.hpp"
+#include "utils/latency_trace.hpp"
 
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"
-#include <sstream>
-#include <iomanip>
+#include "mbedtls/base64.h"
+#include <sys/time.h>
+#include <cstdlib>
 
 static const char* TAG = "NetworkManager";
 
+static constexpr EventBits_t WS_CONNECTED_BIT = BIT0;
+static constexpr EventBits_t WIFI_GOT_IP_BIT = BIT1;
+
+static constexpr size_t TRACE_CHUNK_BYTES = 1024;  // Raw dump bytes per message
+static constexpr size_t CONTROL_MESSAGE_BYTES = 256;  // Config, wake bid: built on the caller's stack
+static constexpr size_t REPORT_MESSAGE_BYTES = 6144;  // Metrics with every task, a trace chunk
+
 namespace irene {
 
 NetworkManager::NetworkManager()
     : audio_session_active_(false)
     , monitor_task_handle_(nullptr)
+    , ws_events_(nullptr)
+    , ws_connecting_(false)
+    , reconnect_requested_(false)
     , bytes_sent_(0)
     , bytes_received_(0)
     , connection_attempts_(0)
     , reconnection_count_(0)
     , last_reconnect_time_(0)
+    , last_ping_time_(0)
+    , warmup_requests_(0)
+    , warmup_connects_(0)
+    , keepalive_failures_(0)
+    , arbitration_requests_(0)
+    , arbitration_losses_(0)
+    , trace_dump_requested_(false)
+    , metrics_requested_(false)
     , wifi_connected_(false)
     , websocket_connected_(false)
     , connection_start_time_(0) {
 }
 
 NetworkManager::~NetworkManager() {
+    uplink_.reset();
     disconnect();
     
     if (monitor_task_handle_) {
-        vTaskDelete(monitor_task_handle_);
+        TaskManager::instance().delete_task(monitor_task_handle_);
+    }
+    
+    if (ws_events_) {
+        vEventGroupDelete(ws_events_);
     }
 }
 
@@ -49,6 +78,9 @@ ErrorCode NetworkManager::initialize(const NetworkConfig& config, const TLSConfi
             ESP_LOGE(TAG, "Failed to initialize WiFi manager");
             return result;
         }
+        wifi_manager_->set_fast_reconnect(config.wifi_fast_reconnect);
+        wifi_manager_->set_listen_interval(config.wifi_listen_interval);
+        wifi_manager_->set_power_profile(config.wifi_idle_profile);
         
         // Initialize TLS manager
         tls_manager_ = std::make_unique<TLSManager>();
@@ -66,21 +98,44 @@ ErrorCode NetworkManager::initialize(const NetworkConfig& config, const TLSConfi
             return result;
         }
         
+        report_buffer_.reset(MemoryPlan::allocate_array<char>(MemoryRegion::PSRAM, REPORT_MESSAGE_BYTES,
+                                                              "NetworkManager"));
+        if (!report_buffer_) {
+            ESP_LOGE(TAG, "Failed to allocate report buffer");
+            return ErrorCode::MEMORY_ERROR;
+        }
+        
+        ws_events_ = xEventGroupCreate();
+        if (!ws_events_) {
+            ESP_LOGE(TAG, "Failed to create WebSocket event group");
+            return ErrorCode::MEMORY_ERROR;
+        }
+        
         // Set up callbacks
         setup_callbacks();
         
+        // Audio uplink task: the only place audio frames are sent from
+        uplink_ = std::make_unique<AudioUplink>();
+        result = uplink_->initialize(config, [this](const uint8_t* data, size_t length) {
+            return send_audio_data(data, length);
+        });
+        if (result != ErrorCode::SUCCESS) {
+            ESP_LOGE(TAG, "Failed to initialize audio uplink");
+            return result;
+        }
+        
         // Create connection monitor task
-        BaseType_t task_result = xTaskCreatePinnedToCore(
-            connection_monitor_task_wrapper,
+        ErrorCode task_result = TaskManager::instance().create_task(
             "net_monitor",
-            4096,  // Stack size
+            connection_monitor_task_wrapper,
             this,
+            4096,  // Stack size
             5,     // Priority
-            &monitor_task_handle_,
-            1      // Core 1
+            1,     // Core 1
+            &monitor_task_handle_
         );
         
-        if (task_result != pdPASS) {
+        if (task_result != ErrorCode::SUCCESS) {
             ESP_LOGE(TAG, "Failed to create network monitor task");
             return ErrorCode::INIT_FAILED;
         }
@@ -108,27 +163,23 @@ ErrorCode NetworkManager::connect() {
         return result;
     }
     
-    wifi_connected_ = true;
+    // The address arrives with GOT_IP, through the status callback
+    if (!wait_for_ip(pdMS_TO_TICKS(config_.wifi_ip_timeout_ms))) {
+        ESP_LOGE(TAG, "No IP address in %u ms", config_.wifi_ip_timeout_ms);
+        handle_connection_error(ErrorCode::WIFI_FAILED);
+        return ErrorCode::TIMEOUT_ERROR;
+    }
     ESP_LOGI(TAG, "WiFi connected successfully");
     
-    // Wait for IP address
-    vTaskDelay(pdMS_TO_TICKS(2000));
-    
-    // Connect WebSocket with TLS
-    result = websocket_client_->connect_tls(tls_manager_.get());
+    // The monitor may have started the handshake on GOT_IP already; this then waits for it
+    result = connect_websocket();
     if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "WebSocket TLS connection failed");
         handle_connection_error(ErrorCode::TLS_FAILED);
         return result;
     }
     
-    websocket_connected_ = true;
     ESP_LOGI(TAG, "WebSocket TLS connection established");
-    
-    if (connection_callback_) {
-        connection_callback_(true);
-    }
-    
     return ErrorCode::SUCCESS;
 }
 
@@ -144,6 +195,9 @@ void NetworkManager::disconnect() {
     if (websocket_client_) {
         websocket_client_->disconnect();
     }
+    if (ws_events_) {
+        xEventGroupClearBits(ws_events_, WS_CONNECTED_BIT | WIFI_GOT_IP_BIT);
+    }
     websocket_connected_ = false;
     
     // Disconnect WiFi
@@ -160,15 +214,51 @@ void NetworkManager::disconnect() {
 }
 
 ErrorCode NetworkManager::reconnect() {
-    ESP_LOGI(TAG, "Attempting to reconnect...");
+    if (!monitor_task_handle_) {
+        return ErrorCode::INIT_FAILED;
+    }
     
+    // The caller never waits on the reconnect; success arrives as callbacks
+    reconnect_requested_ = true;
+    xTaskNotifyGive(monitor_task_handle_);
+    return ErrorCode::SUCCESS;
+}
+
+void NetworkManager::run_reconnect() {
     reconnection_count_++;
     last_reconnect_time_ = esp_timer_get_time() / 1000;
     
-    disconnect();
-    vTaskDelay(pdMS_TO_TICKS(1000)); // Brief delay before reconnect
+    // Link up (a fast reconnect brought it back, or only the socket
+    // dropped): re-open just the socket
+    if (wifi_manager_->is_connected()) {
+        if (!websocket_client_->is_connected() && connect_websocket() != ErrorCode::SUCCESS) {
+            ESP_LOGW(TAG, "Socket reconnect failed, retrying later");
+        }
+        return;
+    }
     
-    return connect();
+    // Link down and the WiFi manager's own retries are spent: associate
+    // afresh; GOT_IP brings the socket back through the status callback
+    ESP_LOGI(TAG, "Attempting to reconnect...");
+    if (wifi_manager_->reconnect() != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "WiFi reconnect failed, retrying later");
+    }
+}
+
+void NetworkManager::warm_up() {
+    if (!monitor_task_handle_ || !wifi_connected_ || ws_connecting_ || websocket_client_->is_connected()) {
+        return;
+    }
+    
+    // The handshake runs in the monitor task; the caller never waits on it
+    warmup_requests_++;
+    xTaskNotifyGive(monitor_task_handle_);
+}
+
+void NetworkManager::set_power_profile(WiFiPowerProfile profile) {
+    if (wifi_manager_ && wifi_manager_->get_power_profile() != profile) {
+        wifi_manager_->set_power_profile(profile);
+    }
 }
 
 ErrorCode NetworkManager::start_audio_session(const std::string& room_id) {
@@ -177,6 +267,15 @@ ErrorCode NetworkManager::start_audio_session(const std::string& room_id) {
         return ErrorCode::SUCCESS;
     }
     
+    // A handshake started by warm-up is usually nearly done; wait for it
+    // rather than failing the session
+    if (!websocket_connected_ && wifi_connected_) {
+        warm_up();
+        if (wait_for_websocket(pdMS_TO_TICKS(config_.session_connect_wait_ms))) {
+            websocket_connected_ = true;
+        }
+    }
+    
     if (!websocket_connected_) {
         ESP_LOGE(TAG, "Cannot start audio session - WebSocket not connected");
         return ErrorCode::WIFI_FAILED;
@@ -184,14 +283,20 @@ ErrorCode NetworkManager::start_audio_session(const std::string& room_id) {
     
     ESP_LOGI(TAG, "Starting audio session for room: %s", room_id.c_str());
     
+    // Frames queued from here on are encoded with the session codec
+    if (uplink_) {
+        uplink_->begin_session(config_.uplink_codec);
+    }
+    
     // Send configuration message
-    ErrorCode result = send_config_message(room_id, 16000);
+    ErrorCode result = send_config_message(room_id, AudioUplink::kStreamSampleRate);
     if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to send config message");
         return result;
     }
     
     audio_session_active_ = true;
+    LatencyTrace::record(TraceEvent::SESSION_START);
     ESP_LOGI(TAG, "Audio session started");
     
     return ErrorCode::SUCCESS;
@@ -215,6 +320,24 @@ ErrorCode NetworkManager::send_audio_data(const uint8_t* data, size_t length) {
     return result;
 }
 
+bool NetworkManager::queue_audio_frame(const AudioFrameRef& frame) {
+    if (!audio_session_active_.load(std::memory_order_relaxed) ||
+        !websocket_connected_.load(std::memory_order_relaxed) || !uplink_) {
+        return false;
+    }
+    
+    return uplink_->enqueue(frame);
+}
+
+size_t NetworkManager::queue_preroll(const AudioFrameSpan& first, const AudioFrameSpan& second) {
+    if (!audio_session_active_.load(std::memory_order_relaxed) ||
+        !websocket_connected_.load(std::memory_order_relaxed) || !uplink_) {
+        return 0;
+    }
+    
+    return uplink_->enqueue_preroll(first, second);
+}
+
 ErrorCode NetworkManager::end_audio_session() {
     if (!audio_session_active_) {
         return ErrorCode::SUCCESS;
@@ -231,20 +354,68 @@ ErrorCode NetworkManager::end_audio_session() {
     return ErrorCode::SUCCESS;
 }
 
-ErrorCode NetworkManager::send_config_message(const std::string& room_id, uint32_t sample_rate) {
+ErrorCode NetworkManager::request_arbitration(float confidence, float peak_level) {
+    // Same short wait for a warm-up handshake as a session
+    if (!websocket_connected_ && wifi_connected_) {
+        warm_up();
+        if (wait_for_websocket(pdMS_TO_TICKS(config_.session_connect_wait_ms))) {
+            websocket_connected_ = true;
+        }
+    }
+    
     if (!websocket_connected_) {
         return ErrorCode::WIFI_FAILED;
     }
     
-    // Create JSON configuration message
-    std::ostringstream json;
-    json << R"({"config":{"sample_rate":)" << sample_rate 
-         << R"(,"room":")" << room_id << R"("}})";
+    // Wall-clock time when the clock is set, so the server can group bids
+    // from different nodes for one utterance
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    const uint64_t timestamp_ms = static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+    
+    char buffer[CONTROL_MESSAGE_BYTES];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.begin_object().begin_object("wake")
+        .field("node", config_.node_id.c_str())
+        .field("score", confidence, 3)
+        .field("energy", peak_level, 3)
+        .field("ts", timestamp_ms)
+        .end_object().end_object();
+    if (!json.ok()) {
+        ESP_LOGE(TAG, "Arbitration bid does not fit %u bytes", (unsigned)sizeof(buffer));
+        return ErrorCode::MEMORY_ERROR;
+    }
+    ESP_LOGI(TAG, "Arbitration bid: %s", json.data());
     
-    std::string config_msg = json.str();
-    ESP_LOGI(TAG, "Sending config: %s", config_msg.c_str());
+    arbitration_requests_++;
+    return websocket_client_->send_text(json.view());
+}
+
+ErrorCode NetworkManager::send_config_message(const std::string& room_id, uint32_t sample_rate) {
+    if (!websocket_connected_) {
+        return ErrorCode::WIFI_FAILED;
+    }
+    
+    // Create JSON configuration message; the server may answer {"codec":...}
+    // to downgrade to a codec it supports
+    const AudioCodec codec = uplink_ ? uplink_->get_codec() : AudioCodec::PCM16;
+    char buffer[CONTROL_MESSAGE_BYTES];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.begin_object().begin_object("config")
+        .field("sample_rate", sample_rate)
+        .field("room", room_id.c_str())
+        .field("codec", audio_codec_name(codec));
+    if (codec == AudioCodec::OPUS) {
+        json.field("bitrate", config_.uplink_opus_bitrate).field("packet_ms", 20u);
+    }
+    json.end_object().end_object();
+    if (!json.ok()) {
+        ESP_LOGE(TAG, "Config message does not fit %u bytes", (unsigned)sizeof(buffer));
+        return ErrorCode::MEMORY_ERROR;
+    }
+    ESP_LOGI(TAG, "Sending config: %s", json.data());
     
-    return websocket_client_->send_text(config_msg);
+    return websocket_client_->send_text(json.view());
 }
 
 ErrorCode NetworkManager::send_eof_message() {
@@ -252,10 +423,64 @@ ErrorCode NetworkManager::send_eof_message() {
         return ErrorCode::WIFI_FAILED;
     }
     
-    std::string eof_msg = R"({"eof":1})";
+    // Queued audio and the partial batch must reach the server before EOF
+    if (uplink_ && uplink_->drain(pdMS_TO_TICKS(500)) != ErrorCode::SUCCESS) {
+        uplink_->flush();
+    }
+    
     ESP_LOGI(TAG, "Sending EOF message");
     
-    return websocket_client_->send_text(eof_msg);
+    ErrorCode result = websocket_client_->send_text(R"({"eof":1})");
+    LatencyTrace::record(TraceEvent::EOF_SENT);
+    return result;
+}
+
+ErrorCode NetworkManager::send_trace_dump() {
+    if (!websocket_connected_) {
+        return ErrorCode::WIFI_FAILED;
+    }
+    
+    // {"trace":{"offset":N,"data":"<base64>"}} per chunk; the server
+    // concatenates the chunks back into the LatencyTrace binary dump
+    size_t offset = 0;
+    ErrorCode result = LatencyTrace::dump([this, &offset](const uint8_t* data, size_t length) {
+        unsigned char encoded[TRACE_CHUNK_BYTES * 4 / 3 + 4];
+        size_t encoded_len = 0;
+        if (mbedtls_base64_encode(encoded, sizeof(encoded), &encoded_len, data, length) != 0) {
+            return false;
+        }
+        
+        JsonWriter json(report_buffer_.get(), REPORT_MESSAGE_BYTES);
+        json.begin_object().begin_object("trace")
+            .field("offset", static_cast<uint32_t>(offset))
+            .field("data", std::string_view(reinterpret_cast<const char*>(encoded), encoded_len))
+            .end_object().end_object();
+        offset += length;
+        return json.ok() && websocket_client_->send_text(json.view()) == ErrorCode::SUCCESS;
+    }, TRACE_CHUNK_BYTES);
+    
+    ESP_LOGI(TAG, "Trace dump: %u bytes, %s", (unsigned)offset,
+            result == ErrorCode::SUCCESS ? "sent" : "failed");
+    return result;
+}
+
+ErrorCode NetworkManager::send_metrics() {
+    if (!websocket_connected_) {
+        return ErrorCode::WIFI_FAILED;
+    }
+    
+    SystemMetrics metrics;
+    if (!TaskManager::instance().get_metrics(metrics)) {
+        ESP_LOGW(TAG, "No profiling sample yet");
+        return ErrorCode::INIT_FAILED;
+    }
+    
+    JsonWriter json(report_buffer_.get(), REPORT_MESSAGE_BYTES);
+    if (!TaskManager::metrics_to_json(metrics, json)) {
+        ESP_LOGW(TAG, "Metrics do not fit %u bytes", (unsigned)REPORT_MESSAGE_BYTES);
+        return ErrorCode::MEMORY_ERROR;
+    }
+    return websocket_client_->send_text(json.view());
 }
 
 bool NetworkManager::is_wifi_connected() const {
@@ -274,10 +499,22 @@ std::string NetworkManager::get_ip_address() const {
     return wifi_manager_ ? wifi_manager_->get_ip_address() : "0.0.0.0";
 }
 
+void NetworkManager::get_uplink_stats(UplinkStats& stats) const {
+    if (uplink_) {
+        uplink_->get_stats(stats);
+    } else {
+        stats = UplinkStats{};
+    }
+}
+
 void NetworkManager::set_connection_callback(ConnectionCallback callback) {
     connection_callback_ = callback;
 }
 
+void NetworkManager::set_wifi_callback(ConnectionCallback callback) {
+    wifi_callback_ = callback;
+}
+
 void NetworkManager::set_message_callback(MessageCallback callback) {
     message_callback_ = callback;
 }
@@ -286,6 +523,19 @@ void NetworkManager::set_error_callback(ErrorCallback callback) {
     error_callback_ = callback;
 }
 
+void NetworkManager::set_arbitration_callback(ArbitrationCallback callback) {
+    arbitration_callback_ = callback;
+}
+
+void NetworkManager::set_playback_callbacks(PlaybackControlCallback control, PlaybackDataCallback data) {
+    playback_control_callback_ = control;
+    playback_data_callback_ = data;
+}
+
+void NetworkManager::set_ota_callback(OTACallback callback) {
+    ota_callback_ = callback;
+}
+
 void NetworkManager::connection_monitor_task_wrapper(void* arg) {
     static_cast<NetworkManager*>(arg)->connection_monitor_task();
 }
@@ -293,10 +543,32 @@ void NetworkManager::connection_monitor_task_wrapper(void* arg) {
 void NetworkManager::connection_monitor_task() {
     ESP_LOGI(TAG, "Network monitor task started");
     
-    TickType_t last_wake_time = xTaskGetTickCount();
     const TickType_t monitor_period = pdMS_TO_TICKS(5000); // 5 second intervals
+    TickType_t next_check = xTaskGetTickCount() + monitor_period;
     
     while (true) {
+        // Sleep until the next check, or until warm_up() asks for a handshake
+        const TickType_t now = xTaskGetTickCount();
+        const TickType_t wait = static_cast<int32_t>(next_check - now) > 0 ? next_check - now : 0;
+        if (ulTaskNotifyTake(pdTRUE, wait) > 0) {
+            if (trace_dump_requested_.exchange(false)) {
+                send_trace_dump();
+            }
+            if (metrics_requested_.exchange(false)) {
+                send_metrics();
+            }
+            if (reconnect_requested_.exchange(false)) {
+                run_reconnect();
+            } else if (wifi_connected_ && !websocket_client_->is_connected()) {
+                warmup_connects_++;
+                connect_websocket();
+            }
+            // After the socket: the PBKDF2 behind a new association takes a while
+            wifi_manager_->refresh_connect_cache();
+            continue;
+        }
+        next_check += monitor_period;
+        
         // Check WiFi connection status
         bool wifi_status = is_wifi_connected();
         if (wifi_connected_ != wifi_status) {
@@ -314,11 +586,17 @@ void NetworkManager::connection_monitor_task() {
             websocket_connected_ = ws_status;
             ESP_LOGI(TAG, "WebSocket status changed: %s", ws_status ? "connected" : "disconnected");
             
+            // Between sessions, re-open just the socket before escalating to
+            // a full Wi-Fi reconnect
             if (!ws_status && wifi_connected_) {
-                handle_connection_error(ErrorCode::TLS_FAILED);
+                if (audio_session_active_ || !config_.keep_warm || connect_websocket() != ErrorCode::SUCCESS) {
+                    handle_connection_error(ErrorCode::TLS_FAILED);
+                }
             }
         }
         
+        send_keepalive();
+        
         // Log connection statistics periodically
         static uint32_t last_stats_log = 0;
         uint32_t current_time = esp_timer_get_time() / 1000000; // Convert to seconds
@@ -327,14 +605,157 @@ void NetworkManager::connection_monitor_task() {
             last_stats_log = current_time;
         }
         
-        vTaskDelayUntil(&last_wake_time, monitor_period);
     }
 }
 
-void NetworkManager::handle_websocket_message(const std::string& message) {
-    ESP_LOGD(TAG, "Received WebSocket message: %s", message.c_str());
+ErrorCode NetworkManager::connect_websocket() {
+    // One handshake at a time; a second caller just waits for the first
+    bool expected = false;
+    if (!ws_connecting_.compare_exchange_strong(expected, true)) {
+        return wait_for_websocket(pdMS_TO_TICKS(tls_config_.handshake_timeout_ms)) ?
+               ErrorCode::SUCCESS : ErrorCode::TIMEOUT_ERROR;
+    }
+    
+    const int64_t start_us = esp_timer_get_time();
+    
+    // Drop the dead handle but keep Wi-Fi
+    xEventGroupClearBits(ws_events_, WS_CONNECTED_BIT);
+    websocket_client_->disconnect();
+    
+    ErrorCode result = websocket_client_->connect_tls(tls_manager_.get());
+    if (result == ErrorCode::SUCCESS &&
+        !wait_for_websocket(pdMS_TO_TICKS(tls_config_.handshake_timeout_ms))) {
+        result = ErrorCode::TLS_FAILED;
+    }
+    ws_connecting_ = false;
+    
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "WebSocket warm reconnect failed");
+        return result;
+    }
+    
+    websocket_connected_ = true;
+    last_ping_time_ = esp_timer_get_time() / 1000;
+    ESP_LOGI(TAG, "WebSocket re-established in %lld ms", (esp_timer_get_time() - start_us) / 1000);
+    
+    if (connection_callback_) {
+        connection_callback_(true);
+    }
+    
+    return ErrorCode::SUCCESS;
+}
+
+bool NetworkManager::wait_for_websocket(TickType_t timeout) const {
+    if (!ws_events_) {
+        return false;
+    }
+    
+    return (xEventGroupWaitBits(ws_events_, WS_CONNECTED_BIT, pdFALSE, pdTRUE, timeout) & WS_CONNECTED_BIT) != 0;
+}
+
+bool NetworkManager::wait_for_ip(TickType_t timeout) const {
+    if (!ws_events_) {
+        return false;
+    }
+    
+    return (xEventGroupWaitBits(ws_events_, WIFI_GOT_IP_BIT, pdFALSE, pdTRUE, timeout) & WIFI_GOT_IP_BIT) != 0;
+}
+
+void NetworkManager::send_keepalive() {
+    // Sessions keep the socket busy on their own
+    if (!config_.keep_warm || config_.keepalive_ping_ms == 0 || audio_session_active_ || !websocket_connected_) {
+        return;
+    }
+    
+    const uint32_t now = esp_timer_get_time() / 1000;
+    if (now - last_ping_time_ < config_.keepalive_ping_ms) {
+        return;
+    }
+    last_ping_time_ = now;
+    
+    // A failed ping finds a dead socket now instead of at the next wake word
+    if (websocket_client_->send_ping() != ErrorCode::SUCCESS) {
+        keepalive_failures_++;
+        ESP_LOGW(TAG, "Keep-alive ping failed, reconnecting");
+        if (connect_websocket() != ErrorCode::SUCCESS) {
+            handle_connection_error(ErrorCode::TLS_FAILED);
+        }
+    }
+}
+
+void NetworkManager::handle_websocket_message(std::string_view message) {
+    ESP_LOGD(TAG, "Received WebSocket message: %.*s", (int)message.size(), message.data());
     
-    bytes_received_ += message.length();
+    bytes_received_ += message.size();
+    
+    // Control messages are one JSON object; members are read in place
+    const JsonValue root = json_parse(message);
+    if (!root.is_object()) {
+        ESP_LOGW(TAG, "Ignoring %u byte text message that is not a JSON object", (unsigned)message.size());
+        return;
+    }
+    
+    // Codec negotiation reply
+    const JsonValue codec_name = root["codec"];
+    if (codec_name.is_valid() && uplink_) {
+        AudioCodec codec;
+        if (codec_name.is_string() && audio_codec_from_name(codec_name.text(), codec)) {
+            if (codec != uplink_->get_codec()) {
+                ESP_LOGI(TAG, "Server selected codec %s", audio_codec_name(codec));
+                uplink_->begin_session(codec);
+            }
+        } else {
+            ESP_LOGW(TAG, "Server requested an unknown codec, keeping %s",
+                    audio_codec_name(uplink_->get_codec()));
+        }
+    }
+    
+    // Arbitration verdict for the last wake word bid
+    const JsonValue verdict = root["arbitration"];
+    if (verdict.is_string()) {
+        const bool won = verdict.equals("won");
+        if (!won) {
+            arbitration_losses_++;
+        }
+        ESP_LOGI(TAG, "Arbitration %s", won ? "won" : "lost");
+        if (arbitration_callback_) {
+            arbitration_callback_(won);
+        }
+    }
+    
+    // Server audio stream: {"tts":{"format":...,"sample_rate":...}} or {"tts":"end"}
+    const JsonValue tts = root["tts"];
+    if (tts.is_valid() && playback_control_callback_) {
+        if (tts.equals("end")) {
+            playback_control_callback_(false, AudioCodec::PCM16, 0);
+        } else if (tts.is_object()) {
+            AudioCodec codec = AudioCodec::PCM16;
+            const JsonValue format = tts["format"];
+            if (format.is_valid() && !(format.is_string() && audio_codec_from_name(format.text(), codec))) {
+                ESP_LOGW(TAG, "Unknown TTS format, playing as %s", audio_codec_name(codec));
+            }
+            
+            uint32_t sample_rate = 0;
+            tts["sample_rate"].as_uint32(sample_rate);
+            playback_control_callback_(true, codec, sample_rate);
+        }
+    }
+    
+    // Firmware update offer; the download runs in the background
+    const JsonValue ota_url = root["ota"]["url"];
+    if (ota_url.is_string() && ota_callback_) {
+        ota_callback_(ota_url.text());
+    }
+    
+    // Trace dump request; sent from the monitor task, not the socket's
+    if (root["trace_dump"].is_valid() && monitor_task_handle_) {
+        trace_dump_requested_ = true;
+        xTaskNotifyGive(monitor_task_handle_);
+    }
+    if (root["metrics_request"].is_valid() && monitor_task_handle_) {
+        metrics_requested_ = true;
+        xTaskNotifyGive(monitor_task_handle_);
+    }
     
     if (message_callback_) {
         message_callback_(message);
@@ -355,6 +776,9 @@ void NetworkManager::handle_connection_error(ErrorCode error) {
     // End any active session
     if (audio_session_active_) {
         audio_session_active_ = false;
+        if (uplink_) {
+            uplink_->flush();
+        }
     }
     
     // Notify callback
@@ -382,19 +806,48 @@ void NetworkManager::handle_connection_error(ErrorCode error) {
 void NetworkManager::setup_callbacks() {
     // Set up WiFi manager callbacks
     if (wifi_manager_) {
+        // Wi-Fi event task: flags and notifications only, the socket opens in the monitor
         wifi_manager_->set_status_callback([this](bool connected) {
             if (!connected) {
+                xEventGroupClearBits(ws_events_, WIFI_GOT_IP_BIT);
                 handle_connection_error(ErrorCode::WIFI_FAILED);
+                return;
+            }
+            
+            wifi_connected_ = true;
+            xEventGroupSetBits(ws_events_, WIFI_GOT_IP_BIT);
+            if (monitor_task_handle_) {
+                reconnect_requested_ = true;
+                xTaskNotifyGive(monitor_task_handle_);
+            }
+            if (wifi_callback_) {
+                wifi_callback_(true);
             }
         });
     }
     
     // Set up WebSocket client callbacks
     if (websocket_client_) {
-        websocket_client_->set_message_callback([this](const std::string& message) {
+        websocket_client_->set_message_callback([this](std::string_view message) {
             handle_websocket_message(message);
         });
         
+        websocket_client_->set_binary_callback([this](const uint8_t* data, size_t length,
+                                                      size_t offset, size_t total) {
+            bytes_received_ += length;
+            if (playback_data_callback_) {
+                playback_data_callback_(data, length, offset, total);
+            }
+        });
+        
+        websocket_client_->set_connection_callback([this](bool connected) {
+            if (connected) {
+                xEventGroupSetBits(ws_events_, WS_CONNECTED_BIT);
+            } else {
+                xEventGroupClearBits(ws_events_, WS_CONNECTED_BIT);
+            }
+        });
+        
         websocket_client_->set_error_callback([this](const std::string& error) {
             ESP_LOGE(TAG, "WebSocket error: %s", error.c_str());
             handle_connection_error(ErrorCode::TLS_FAILED);
@@ -412,7 +865,28 @@ void NetworkManager::log_connection_stats() const {
     ESP_LOGI(TAG, "  Bytes sent: %u, received: %u", bytes_sent_, bytes_received_);
     ESP_LOGI(TAG, "  Connection attempts: %u, reconnections: %u", 
             connection_attempts_, reconnection_count_);
+    ESP_LOGI(TAG, "  Warm-up: %u requests, %u handshakes, %u failed pings",
+            warmup_requests_, warmup_connects_, keepalive_failures_);
+    ESP_LOGI(TAG, "  Arbitration: %u bids, %u lost", arbitration_requests_, arbitration_losses_);
+    if (wifi_manager_) {
+        ESP_LOGI(TAG, "  WiFi connect: %u ms, %u fast, %u fallbacks",
+                wifi_manager_->get_last_connect_ms(), wifi_manager_->get_fast_connect_count(),
+                wifi_manager_->get_fast_connect_fallbacks());
+    }
     ESP_LOGI(TAG, "  Audio session: %s", audio_session_active_ ? "active" : "inactive");
+    LatencyTrace::log_stage_stats();
+    
+    if (uplink_) {
+        UplinkStats uplink;
+        uplink_->get_stats(uplink);
+        ESP_LOGI(TAG, "  Uplink: sent %u frames (%u pre-roll) in %u messages, dropped %u/%u (oldest/newest), depth %u (max %u)",
+                uplink.sent, uplink.preroll, uplink.messages, uplink.dropped_oldest, uplink.dropped_newest,
+                uplink.depth, uplink.high_water);
+        ESP_LOGI(TAG, "  Uplink latency: last %u us, avg %u us, max %u us",
+                uplink.last_latency_us, uplink.avg_latency_us, uplink.max_latency_us);
+        ESP_LOGI(TAG, "  Uplink codec: %s, %u -> %u bytes",
+                audio_codec_name(uplink_->get_codec()), uplink.pcm_bytes, uplink.encoded_bytes);
+    }
 }
 
 } // namespace irene 
\ No newline at end of file
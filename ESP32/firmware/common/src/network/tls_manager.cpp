@@ -1,24 +1,51 @@
 #include "network/tls_manager.hpp"
+#include "utils/latency_trace.hpp"
 #include "esp_log.h"
 #include "esp_tls.h"
 #include "mbedtls/x509_crt.h"
 #include "mbedtls/pk.h"
 #include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/version.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include <algorithm>
 #include <cstring>
 
 static const char* TAG = "TLSManager";
 
+// Largest DER private key we expect (RSA-4096 is ~2.4 KB)
+static constexpr size_t MAX_KEY_DER_BYTES = 2560;
+
+static int tls_random(void*, unsigned char* output, size_t length) {
+    esp_fill_random(output, length);
+    return 0;
+}
+
 namespace irene {
 
 TLSManager::TLSManager()
     : tls_context_(nullptr)
     , initialized_(false)
     , handshake_timeout_ms_(10000)
-    , verify_peer_(true) {
+    , verify_peer_(true)
+    , client_chain_(nullptr)
+    , client_pk_(nullptr)
+    , client_key_der_(nullptr)
+    , client_key_der_len_(0)
+    , session_(nullptr)
+    , session_mutex_(nullptr)
+    , handshake_count_(0)
+    , resumption_attempts_(0)
+    , last_handshake_ms_(0) {
 }
 
 TLSManager::~TLSManager() {
     cleanup_tls_context();
+    
+    if (session_mutex_) {
+        vSemaphoreDelete(session_mutex_);
+    }
 }
 
 ErrorCode TLSManager::initialize(const TLSConfig& config) {
@@ -26,6 +53,12 @@ ErrorCode TLSManager::initialize(const TLSConfig& config) {
     
     config_ = config;
     
+    session_mutex_ = xSemaphoreCreateMutex();
+    if (!session_mutex_) {
+        ESP_LOGE(TAG, "Failed to create session mutex");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
     // Load certificates
     ErrorCode result = load_ca_certificate(config.ca_cert_pem);
     if (result != ErrorCode::SUCCESS) {
@@ -45,6 +78,13 @@ ErrorCode TLSManager::initialize(const TLSConfig& config) {
         return result;
     }
     
+    // Parse once; handshakes reuse the result
+    result = parse_credentials();
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to parse certificates");
+        return result;
+    }
+    
     // Validate certificates
     if (!validate_certificates()) {
         ESP_LOGE(TAG, "Certificate validation failed");
@@ -52,13 +92,13 @@ ErrorCode TLSManager::initialize(const TLSConfig& config) {
     }
     
     // Setup TLS context
+    handshake_timeout_ms_ = config.handshake_timeout_ms;
     result = setup_tls_context();
     if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to setup TLS context");
         return result;
     }
     
-    handshake_timeout_ms_ = config.handshake_timeout_ms;
     initialized_ = true;
     
     ESP_LOGI(TAG, "TLS manager initialized successfully");
@@ -123,84 +163,103 @@ ErrorCode TLSManager::load_client_private_key(const char* client_key_pem) {
     return ErrorCode::SUCCESS;
 }
 
-bool TLSManager::validate_certificates() const {
-    ESP_LOGI(TAG, "Validating certificates...");
-    
-    // Validate CA certificate
-    mbedtls_x509_crt ca_crt;
-    mbedtls_x509_crt_init(&ca_crt);
-    
-    int ret = mbedtls_x509_crt_parse(&ca_crt, 
-                                    reinterpret_cast<const unsigned char*>(ca_cert_.c_str()),
-                                    ca_cert_.length() + 1);
-    
-    if (ret != 0) {
-        char error_buf[256];
-        mbedtls_strerror(ret, error_buf, sizeof(error_buf));
-        ESP_LOGE(TAG, "CA certificate parsing failed: %s", error_buf);
-        mbedtls_x509_crt_free(&ca_crt);
-        return false;
+ErrorCode TLSManager::parse_credentials() {
+    ESP_LOGI(TAG, "Parsing certificates...");
+    
+    mbedtls_x509_crt* client_chain = static_cast<mbedtls_x509_crt*>(calloc(1, sizeof(mbedtls_x509_crt)));
+    mbedtls_pk_context* client_pk = static_cast<mbedtls_pk_context*>(calloc(1, sizeof(mbedtls_pk_context)));
+    client_chain_ = client_chain;
+    client_pk_ = client_pk;
+    if (!client_chain || !client_pk) {
+        ESP_LOGE(TAG, "Failed to allocate certificate contexts");
+        return ErrorCode::MEMORY_ERROR;
     }
     
-    ESP_LOGI(TAG, "CA certificate validation passed");
-    
-    // Validate client certificate
-    mbedtls_x509_crt client_crt;
-    mbedtls_x509_crt_init(&client_crt);
+    mbedtls_x509_crt_init(client_chain);
+    mbedtls_pk_init(client_pk);
     
-    ret = mbedtls_x509_crt_parse(&client_crt,
+    // The CA is parsed into the esp-tls global store in setup_tls_context()
+    char error_buf[128];
+    int ret = mbedtls_x509_crt_parse(client_chain,
                                 reinterpret_cast<const unsigned char*>(client_cert_.c_str()),
                                 client_cert_.length() + 1);
-    
     if (ret != 0) {
-        char error_buf[256];
         mbedtls_strerror(ret, error_buf, sizeof(error_buf));
         ESP_LOGE(TAG, "Client certificate parsing failed: %s", error_buf);
-        mbedtls_x509_crt_free(&ca_crt);
-        mbedtls_x509_crt_free(&client_crt);
-        return false;
+        last_error_ = error_buf;
+        return ErrorCode::TLS_FAILED;
     }
     
-    ESP_LOGI(TAG, "Client certificate validation passed");
-    
-    // Validate client private key
-    mbedtls_pk_context client_key;
-    mbedtls_pk_init(&client_key);
-    
-    ret = mbedtls_pk_parse_key(&client_key,
+#if MBEDTLS_VERSION_MAJOR >= 3
+    ret = mbedtls_pk_parse_key(client_pk,
+                              reinterpret_cast<const unsigned char*>(client_key_.c_str()),
+                              client_key_.length() + 1,
+                              nullptr, 0, tls_random, nullptr);
+#else
+    ret = mbedtls_pk_parse_key(client_pk,
                               reinterpret_cast<const unsigned char*>(client_key_.c_str()),
                               client_key_.length() + 1,
                               nullptr, 0);
-    
+#endif
     if (ret != 0) {
-        char error_buf[256];
         mbedtls_strerror(ret, error_buf, sizeof(error_buf));
         ESP_LOGE(TAG, "Client private key parsing failed: %s", error_buf);
-        mbedtls_x509_crt_free(&ca_crt);
-        mbedtls_x509_crt_free(&client_crt);
-        mbedtls_pk_free(&client_key);
-        return false;
+        last_error_ = error_buf;
+        return ErrorCode::TLS_FAILED;
+    }
+    
+    // DER key for esp-tls; mbedtls writes it at the end of the buffer
+    uint8_t* der = static_cast<uint8_t*>(malloc(MAX_KEY_DER_BYTES));
+    if (!der) {
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
+    ret = mbedtls_pk_write_key_der(client_pk, der, MAX_KEY_DER_BYTES);
+    if (ret > 0) {
+        client_key_der_ = static_cast<uint8_t*>(malloc(ret));
+        if (client_key_der_) {
+            memcpy(client_key_der_, der + MAX_KEY_DER_BYTES - ret, ret);
+            client_key_der_len_ = ret;
+        }
+    }
+    mbedtls_platform_zeroize(der, MAX_KEY_DER_BYTES);
+    free(der);
+    
+    if (ret <= 0) {
+        ESP_LOGE(TAG, "Client private key DER encoding failed: %d", ret);
+        return ErrorCode::TLS_FAILED;
+    }
+    if (!client_key_der_) {
+        return ErrorCode::MEMORY_ERROR;
     }
     
-    ESP_LOGI(TAG, "Client private key validation passed");
+    ESP_LOGI(TAG, "Certificates parsed: client cert %u bytes DER, key %u bytes DER",
+             (unsigned)client_chain->raw.len, (unsigned)client_key_der_len_);
+    return ErrorCode::SUCCESS;
+}
+
+bool TLSManager::validate_certificates() const {
+    ESP_LOGI(TAG, "Validating certificates...");
+    
+    // Works on the parsed-once contexts; nothing is re-parsed here
+    const mbedtls_x509_crt* client_chain = static_cast<const mbedtls_x509_crt*>(client_chain_);
+    mbedtls_pk_context* client_pk = static_cast<mbedtls_pk_context*>(client_pk_);
+    if (!client_chain || !client_pk || !client_key_der_) {
+        ESP_LOGE(TAG, "Certificates not parsed");
+        return false;
+    }
     
     // Check if client certificate and private key match
-    ret = mbedtls_pk_check_pair(&client_crt.pk, &client_key);
+#if MBEDTLS_VERSION_MAJOR >= 3
+    int ret = mbedtls_pk_check_pair(&client_chain->pk, client_pk, tls_random, nullptr);
+#else
+    int ret = mbedtls_pk_check_pair(&client_chain->pk, client_pk);
+#endif
     if (ret != 0) {
         ESP_LOGE(TAG, "Client certificate and private key do not match");
-        mbedtls_x509_crt_free(&ca_crt);
-        mbedtls_x509_crt_free(&client_crt);
-        mbedtls_pk_free(&client_key);
         return false;
     }
     
-    ESP_LOGI(TAG, "Certificate-key pair validation passed");
-    
-    // Cleanup
-    mbedtls_x509_crt_free(&ca_crt);
-    mbedtls_x509_crt_free(&client_crt);
-    mbedtls_pk_free(&client_key);
-    
     ESP_LOGI(TAG, "All certificates validated successfully");
     return true;
 }
@@ -235,15 +294,23 @@ ErrorCode TLSManager::setup_tls_context() {
         return ErrorCode::MEMORY_ERROR;
     }
     
-    // Configure certificates
-    tls_cfg->cacert_buf = reinterpret_cast<const unsigned char*>(ca_cert_.c_str());
-    tls_cfg->cacert_bytes = ca_cert_.length() + 1;
+    // The CA is parsed once into the global store; the client credentials
+    // are handed over as DER so esp-tls does no PEM decoding per handshake
+    esp_err_t err = esp_tls_set_global_ca_store(reinterpret_cast<const unsigned char*>(ca_cert_.c_str()),
+                                                ca_cert_.length() + 1);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "CA certificate parsing failed: %s", esp_err_to_name(err));
+        free(tls_cfg);
+        return ErrorCode::TLS_FAILED;
+    }
+    tls_cfg->use_global_ca_store = true;
     
-    tls_cfg->clientcert_buf = reinterpret_cast<const unsigned char*>(client_cert_.c_str());
-    tls_cfg->clientcert_bytes = client_cert_.length() + 1;
+    const mbedtls_x509_crt* client_chain = static_cast<const mbedtls_x509_crt*>(client_chain_);
+    tls_cfg->clientcert_buf = client_chain->raw.p;
+    tls_cfg->clientcert_bytes = client_chain->raw.len;
     
-    tls_cfg->clientkey_buf = reinterpret_cast<const unsigned char*>(client_key_.c_str());
-    tls_cfg->clientkey_bytes = client_key_.length() + 1;
+    tls_cfg->clientkey_buf = client_key_der_;
+    tls_cfg->clientkey_bytes = client_key_der_len_;
     
     // Configure verification
     if (verify_peer_) {
@@ -269,6 +336,26 @@ void TLSManager::cleanup_tls_context() {
     if (tls_context_) {
         free(tls_context_);
         tls_context_ = nullptr;
+        esp_tls_free_global_ca_store();
+    }
+    
+    clear_session();
+    
+    if (client_chain_) {
+        mbedtls_x509_crt_free(static_cast<mbedtls_x509_crt*>(client_chain_));
+        free(client_chain_);
+        client_chain_ = nullptr;
+    }
+    if (client_pk_) {
+        mbedtls_pk_free(static_cast<mbedtls_pk_context*>(client_pk_));
+        free(client_pk_);
+        client_pk_ = nullptr;
+    }
+    if (client_key_der_) {
+        mbedtls_platform_zeroize(client_key_der_, client_key_der_len_);
+        free(client_key_der_);
+        client_key_der_ = nullptr;
+        client_key_der_len_ = 0;
     }
     
     // Clear sensitive data
@@ -280,4 +367,84 @@ void TLSManager::cleanup_tls_context() {
     ESP_LOGI(TAG, "TLS context cleaned up");
 }
 
+void* TLSManager::connect(const char* host, int port, uint32_t timeout_ms) {
+    if (!initialized_ || !host) {
+        return nullptr;
+    }
+    
+    esp_tls_t* tls = esp_tls_init();
+    if (!tls) {
+        ESP_LOGE(TAG, "Failed to allocate TLS connection");
+        return nullptr;
+    }
+    
+    esp_tls_cfg_t cfg = *static_cast<const esp_tls_cfg_t*>(tls_context_);
+    cfg.timeout_ms = timeout_ms > 0 ? timeout_ms : handshake_timeout_ms_;
+    
+    // One handshake at a time so the cached session is never swapped mid-use
+    xSemaphoreTake(session_mutex_, portMAX_DELAY);
+    
+    const bool resuming = session_ != nullptr;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    cfg.client_session = static_cast<esp_tls_client_session_t*>(session_);
+#endif
+    if (resuming) {
+        resumption_attempts_++;
+    }
+    
+    const int64_t start_us = esp_timer_get_time();
+    const int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, tls);
+    last_handshake_ms_ = static_cast<uint32_t>((esp_timer_get_time() - start_us) / 1000);
+    handshake_count_++;
+    
+    if (ret != 1) {
+        // Drop the session so a stale ticket cannot fail the next attempt too
+        xSemaphoreGive(session_mutex_);
+        clear_session();
+        esp_tls_conn_destroy(tls);
+        last_error_ = "TLS handshake failed";
+        ESP_LOGW(TAG, "TLS handshake to %s:%d failed after %u ms", host, port, last_handshake_ms_);
+        return nullptr;
+    }
+    
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    // Keep the newest session (a fresh ticket replaces the one just used)
+    esp_tls_client_session_t* fresh = esp_tls_get_client_session(tls);
+    if (fresh) {
+        if (session_) {
+            esp_tls_free_client_session(static_cast<esp_tls_client_session_t*>(session_));
+        }
+        session_ = fresh;
+    }
+#endif
+    
+    xSemaphoreGive(session_mutex_);
+    
+    LatencyTrace::record(TraceEvent::TLS_CONNECTED,
+                         static_cast<uint16_t>(std::min<uint32_t>(last_handshake_ms_, UINT16_MAX)));
+    ESP_LOGI(TAG, "TLS handshake in %u ms (%s)", last_handshake_ms_, resuming ? "resumption offered" : "full");
+    return tls;
+}
+
+void TLSManager::close(void* connection) {
+    if (connection) {
+        esp_tls_conn_destroy(static_cast<esp_tls_t*>(connection));
+    }
+}
+
+void TLSManager::clear_session() {
+    if (!session_mutex_) {
+        return;
+    }
+    
+    xSemaphoreTake(session_mutex_, portMAX_DELAY);
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    if (session_) {
+        esp_tls_free_client_session(static_cast<esp_tls_client_session_t*>(session_));
+    }
+#endif
+    session_ = nullptr;
+    xSemaphoreGive(session_mutex_);
+}
+
 } // namespace irene 
\ No newline at end of file
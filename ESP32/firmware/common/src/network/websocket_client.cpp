@@ -1,22 +1,137 @@
 #include "network/websocket_client.hpp"
 #include "esp_log.h"
 #include "esp_websocket_client.h"
+#include "esp_transport.h"
+#include "esp_transport_ws.h"
+#include "esp_tls.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_timer.h"
+#include <sys/select.h>
+#include <algorithm>
+#include <cstring>
 
 static const char* TAG = "WebSocketClient";
 
 namespace irene {
 
+namespace {
+
+// esp_transport context: the live connection and who opens it
+struct TlsTransportContext {
+    TLSManager* tls_manager;
+    esp_tls_t* connection;
+};
+
+TlsTransportContext* transport_context(esp_transport_handle_t t) {
+    return static_cast<TlsTransportContext*>(esp_transport_get_context_data(t));
+}
+
+int tls_transport_close(esp_transport_handle_t t) {
+    TlsTransportContext* ctx = transport_context(t);
+    if (ctx && ctx->connection) {
+        ctx->tls_manager->close(ctx->connection);
+        ctx->connection = nullptr;
+    }
+    return 0;
+}
+
+int tls_transport_connect(esp_transport_handle_t t, const char* host, int port, int timeout_ms) {
+    TlsTransportContext* ctx = transport_context(t);
+    tls_transport_close(t);
+    
+    // TLSManager offers the cached session and keeps the new one
+    ctx->connection = static_cast<esp_tls_t*>(ctx->tls_manager->connect(host, port, timeout_ms));
+    return ctx->connection ? 0 : -1;
+}
+
+int tls_transport_poll(esp_transport_handle_t t, int timeout_ms, bool for_write) {
+    TlsTransportContext* ctx = transport_context(t);
+    if (!ctx->connection) {
+        return -1;
+    }
+    
+    // Decrypted bytes already buffered in mbedtls never show up on the socket
+    if (!for_write && esp_tls_get_bytes_avail(ctx->connection) > 0) {
+        return 1;
+    }
+    
+    int fd = -1;
+    if (esp_tls_get_conn_sockfd(ctx->connection, &fd) != ESP_OK || fd < 0) {
+        return -1;
+    }
+    
+    fd_set ready;
+    fd_set errors;
+    FD_ZERO(&ready);
+    FD_ZERO(&errors);
+    FD_SET(fd, &ready);
+    FD_SET(fd, &errors);
+    
+    struct timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    int ret = select(fd + 1, for_write ? nullptr : &ready, for_write ? &ready : nullptr, &errors,
+                     timeout_ms < 0 ? nullptr : &timeout);
+    if (ret > 0 && FD_ISSET(fd, &errors)) {
+        return -1;
+    }
+    return ret;
+}
+
+int tls_transport_poll_read(esp_transport_handle_t t, int timeout_ms) {
+    return tls_transport_poll(t, timeout_ms, false);
+}
+
+int tls_transport_poll_write(esp_transport_handle_t t, int timeout_ms) {
+    return tls_transport_poll(t, timeout_ms, true);
+}
+
+int tls_transport_read(esp_transport_handle_t t, char* buffer, int len, int timeout_ms) {
+    const int poll = tls_transport_poll(t, timeout_ms, false);
+    if (poll <= 0) {
+        return poll == 0 ? ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT : ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+    
+    const ssize_t ret = esp_tls_conn_read(transport_context(t)->connection, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if (ret == 0) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    return ret < 0 ? ERR_TCP_TRANSPORT_CONNECTION_FAILED : static_cast<int>(ret);
+}
+
+int tls_transport_write(esp_transport_handle_t t, const char* buffer, int len, int timeout_ms) {
+    const int poll = tls_transport_poll(t, timeout_ms, true);
+    if (poll <= 0) {
+        return poll;
+    }
+    
+    const ssize_t ret = esp_tls_conn_write(transport_context(t)->connection, buffer, len);
+    if (ret == ESP_TLS_ERR_SSL_WANT_READ || ret == ESP_TLS_ERR_SSL_WANT_WRITE) {
+        return 0;
+    }
+    return ret < 0 ? -1 : static_cast<int>(ret);
+}
+
+int tls_transport_destroy(esp_transport_handle_t t) {
+    // The context itself is freed by WebSocketClient::destroy_tls_transport()
+    return tls_transport_close(t);
+}
+
+} // namespace
+
 WebSocketClient::WebSocketClient()
     : websocket_handle_(nullptr)
+    , tls_transport_(nullptr)
+    , ws_transport_(nullptr)
     , tls_manager_(nullptr)
     , connected_(false)
     , tls_enabled_(false)
     , keep_alive_interval_ms_(30000)
     , connection_timeout_ms_(10000)
     , max_message_size_(65536)
+    , text_bytes_(0)
     , bytes_sent_(0)
     , bytes_received_(0)
     , message_count_(0)
@@ -25,6 +140,7 @@ WebSocketClient::WebSocketClient()
 
 WebSocketClient::~WebSocketClient() {
     disconnect();
+    destroy_tls_transport();
 }
 
 ErrorCode WebSocketClient::initialize(const std::string& uri) {
@@ -100,14 +216,13 @@ ErrorCode WebSocketClient::connect_tls(TLSManager* tls_manager) {
     websocket_cfg.network_timeout_ms = connection_timeout_ms_;
     websocket_cfg.buffer_size = max_message_size_;
     
-    // Configure TLS
-    esp_tls_cfg_t* tls_cfg = static_cast<esp_tls_cfg_t*>(tls_manager->get_tls_context());
-    if (tls_cfg) {
-        websocket_cfg.cert_pem = reinterpret_cast<const char*>(tls_cfg->cacert_buf);
-        websocket_cfg.client_cert = reinterpret_cast<const char*>(tls_cfg->clientcert_buf);
-        websocket_cfg.client_key = reinterpret_cast<const char*>(tls_cfg->clientkey_buf);
-        websocket_cfg.skip_cert_common_name_check = false;
+    // TLS is ours: the WebSocket layer runs on a transport whose handshakes
+    // go through TLSManager (parsed credentials, session resumption)
+    if (!create_tls_transport(tls_manager)) {
+        ESP_LOGE(TAG, "Failed to create TLS transport");
+        return ErrorCode::TLS_FAILED;
     }
+    websocket_cfg.ext_transport = static_cast<esp_transport_handle_t>(ws_transport_);
     
     websocket_handle_ = esp_websocket_client_init(&websocket_cfg);
     if (!websocket_handle_) {
@@ -134,6 +249,59 @@ ErrorCode WebSocketClient::connect_tls(TLSManager* tls_manager) {
     return ErrorCode::SUCCESS;
 }
 
+bool WebSocketClient::create_tls_transport(TLSManager* tls_manager) {
+    // Built once and reused by every connection; handshakes happen in connect
+    if (ws_transport_) {
+        static_cast<TlsTransportContext*>(
+            esp_transport_get_context_data(static_cast<esp_transport_handle_t>(tls_transport_)))->tls_manager = tls_manager;
+        return true;
+    }
+    
+    esp_transport_handle_t tls = esp_transport_init();
+    TlsTransportContext* ctx = static_cast<TlsTransportContext*>(calloc(1, sizeof(TlsTransportContext)));
+    if (!tls || !ctx) {
+        if (tls) {
+            esp_transport_destroy(tls);
+        }
+        free(ctx);
+        return false;
+    }
+    
+    ctx->tls_manager = tls_manager;
+    esp_transport_set_context_data(tls, ctx);
+    esp_transport_set_func(tls, tls_transport_connect, tls_transport_read, tls_transport_write,
+                           tls_transport_close, tls_transport_poll_read, tls_transport_poll_write,
+                           tls_transport_destroy);
+    esp_transport_set_default_port(tls, 443);
+    
+    esp_transport_handle_t ws = esp_transport_ws_init(tls);
+    if (!ws) {
+        esp_transport_destroy(tls);
+        free(ctx);
+        return false;
+    }
+    
+    tls_transport_ = tls;
+    ws_transport_ = ws;
+    return true;
+}
+
+void WebSocketClient::destroy_tls_transport() {
+    // The WebSocket client only borrows ext_transport; it is ours to free
+    if (ws_transport_) {
+        esp_transport_destroy(static_cast<esp_transport_handle_t>(ws_transport_));
+        ws_transport_ = nullptr;
+    }
+    
+    if (tls_transport_) {
+        esp_transport_handle_t tls = static_cast<esp_transport_handle_t>(tls_transport_);
+        void* ctx = esp_transport_get_context_data(tls);
+        esp_transport_destroy(tls);
+        free(ctx);
+        tls_transport_ = nullptr;
+    }
+}
+
 void WebSocketClient::disconnect() {
     if (!websocket_handle_) {
         return;
@@ -154,7 +322,7 @@ void WebSocketClient::disconnect() {
     ESP_LOGI(TAG, "WebSocket disconnected");
 }
 
-ErrorCode WebSocketClient::send_text(const std::string& message) {
+ErrorCode WebSocketClient::send_text(std::string_view message) {
     if (!connected_ || !websocket_handle_) {
         ESP_LOGW(TAG, "Cannot send text - WebSocket not connected");
         return ErrorCode::TLS_FAILED;
@@ -164,22 +332,22 @@ ErrorCode WebSocketClient::send_text(const std::string& message) {
         return ErrorCode::SUCCESS;
     }
     
-    if (message.length() > max_message_size_) {
-        ESP_LOGW(TAG, "Message too large: %d > %d", message.length(), max_message_size_);
+    if (message.size() > max_message_size_) {
+        ESP_LOGW(TAG, "Message too large: %d > %d", message.size(), max_message_size_);
         return ErrorCode::TLS_FAILED;
     }
     
     esp_err_t result = esp_websocket_client_send_text(
         static_cast<esp_websocket_client_handle_t>(websocket_handle_),
-        message.c_str(),
-        message.length(),
+        message.data(),
+        message.size(),
         portMAX_DELAY
     );
     
     if (result == ESP_OK) {
-        bytes_sent_ += message.length();
+        bytes_sent_ += message.size();
         message_count_++;
-        ESP_LOGD(TAG, "Sent text message: %d bytes", message.length());
+        ESP_LOGD(TAG, "Sent text message: %d bytes", message.size());
         return ErrorCode::SUCCESS;
     } else {
         ESP_LOGW(TAG, "Failed to send text message: %s", esp_err_to_name(result));
@@ -246,6 +414,45 @@ void WebSocketClient::set_message_callback(MessageCallback callback) {
     message_callback_ = callback;
 }
 
+void WebSocketClient::handle_text_piece(const char* data, size_t length, size_t offset, size_t total) {
+    if (!message_callback_ || !data) {
+        return;
+    }
+    
+    // Whole message: a view of the receive buffer
+    if (offset == 0 && length >= total) {
+        message_callback_(std::string_view(data, length));
+        return;
+    }
+    
+    if (total > MAX_TEXT_MESSAGE) {
+        if (offset == 0) {
+            error_count_++;
+            ESP_LOGW(TAG, "Dropping %u byte text message (max %u)", (unsigned)total, (unsigned)MAX_TEXT_MESSAGE);
+        }
+        return;
+    }
+    
+    // Pieces arrive in order; a gap restarts the message
+    if (offset != text_bytes_) {
+        text_bytes_ = 0;
+        if (offset != 0) {
+            return;
+        }
+    }
+    
+    memcpy(text_message_ + offset, data, std::min(length, total - offset));
+    text_bytes_ = std::min(offset + length, total);
+    if (text_bytes_ == total) {
+        text_bytes_ = 0;
+        message_callback_(std::string_view(text_message_, total));
+    }
+}
+
+void WebSocketClient::set_binary_callback(BinaryCallback callback) {
+    binary_callback_ = callback;
+}
+
 void WebSocketClient::set_error_callback(ErrorCallback callback) {
     error_callback_ = callback;
 }
@@ -305,15 +512,17 @@ void WebSocketClient::handle_websocket_event(int32_t event_id, void* event_data)
                 bytes_received_ += data->data_len;
                 
                 if (data->op_code == 0x1) { // Text frame
-                    std::string message(static_cast<const char*>(data->data_ptr), data->data_len);
                     ESP_LOGD(TAG, "Received text data: %d bytes", data->data_len);
-                    
-                    if (message_callback_) {
-                        message_callback_(message);
-                    }
+                    handle_text_piece(static_cast<const char*>(data->data_ptr), data->data_len,
+                                      data->payload_offset, data->payload_len);
                 } else if (data->op_code == 0x2) { // Binary frame
                     ESP_LOGD(TAG, "Received binary data: %d bytes", data->data_len);
-                    // Binary data handling could be added here if needed
+                    
+                    // Messages over the receive buffer arrive in pieces
+                    if (binary_callback_) {
+                        binary_callback_(reinterpret_cast<const uint8_t*>(data->data_ptr), data->data_len,
+                                         data->payload_offset, data->payload_len);
+                    }
                 } else if (data->op_code == 0x8) { // Close frame
                     ESP_LOGI(TAG, "Received close frame");
                     connected_ = false;
@@ -1,4 +1,5 @@
 #include "network/wifi_manager.hpp"
+#include "core/config_manager.hpp"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -6,6 +7,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_timer.h"
+#include "mbedtls/pkcs5.h"
+#include "mbedtls/version.h"
 #include <cstring>
 
 static const char* TAG = "WiFiManager";
@@ -14,6 +17,8 @@ static const char* TAG = "WiFiManager";
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT BIT1
 
+static constexpr int PMK_ITERATIONS = 4096;  // IEEE 802.11i PSK -> PMK
+
 namespace irene {
 
 WiFiManager::WiFiManager()
@@ -22,19 +27,41 @@ WiFiManager::WiFiManager()
     , auto_reconnect_(true)
     , reconnect_interval_ms_(5000)
     , max_retry_count_(10)
+    , cache_valid_(false)
+    , cache_refresh_pending_(false)
+    , cache_mutex_(nullptr)
+    , fast_reconnect_(true)
+    , directed_attempt_(false)
+    , connect_start_us_(0)
+    , power_profile_(WiFiPowerProfile::BALANCED)
+    , listen_interval_(3)
+    , started_(false)
     , connection_count_(0)
     , disconnection_count_(0)
     , retry_count_(0)
-    , last_disconnect_time_(0) {
+    , last_disconnect_time_(0)
+    , fast_connect_count_(0)
+    , fast_connect_fallbacks_(0)
+    , last_connect_ms_(0) {
+    cache_mutex_ = xSemaphoreCreateMutex();
 }
 
 WiFiManager::~WiFiManager() {
     disconnect();
+    
+    if (cache_mutex_) {
+        vSemaphoreDelete(cache_mutex_);
+    }
 }
 
 ErrorCode WiFiManager::initialize(const std::string& ssid, const std::string& password) {
     ESP_LOGI(TAG, "Initializing WiFi manager...");
     
+    if (!cache_mutex_) {
+        ESP_LOGE(TAG, "Failed to create cache mutex");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
     if (initialized_) {
         ESP_LOGW(TAG, "WiFi manager already initialized");
         return ErrorCode::SUCCESS;
@@ -65,6 +92,15 @@ ErrorCode WiFiManager::initialize(const std::string& ssid, const std::string& pa
     // Set WiFi mode to station
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     
+    // Fast reconnect cache; without NVS every connect is a full scan
+    config_store_ = std::make_unique<ConfigManager>();
+    if (config_store_->initialize() == ErrorCode::SUCCESS &&
+        config_store_->load_wifi_cache(cache_) == ErrorCode::SUCCESS) {
+        cache_valid_ = cache_.credentials_hash == credentials_hash() && cache_.channel != 0;
+        ESP_LOGI(TAG, "Cached AP " MACSTR " ch %u%s", MAC2STR(cache_.bssid), cache_.channel,
+                cache_valid_ ? "" : " (stale, ignored)");
+    }
+    
     initialized_ = true;
     ESP_LOGI(TAG, "WiFi manager initialized for SSID: %s", ssid_.c_str());
     
@@ -84,16 +120,14 @@ ErrorCode WiFiManager::connect() {
     
     ESP_LOGI(TAG, "Connecting to WiFi: %s", ssid_.c_str());
     
-    // Configure WiFi connection
-    wifi_config_t wifi_config = {};
-    std::strncpy(reinterpret_cast<char*>(wifi_config.sta.ssid), 
-                ssid_.c_str(), sizeof(wifi_config.sta.ssid) - 1);
-    std::strncpy(reinterpret_cast<char*>(wifi_config.sta.password), 
-                password_.c_str(), sizeof(wifi_config.sta.password) - 1);
-    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    connect_start_us_ = esp_timer_get_time();
+    if (!apply_station_config(fast_reconnect_ && cache_valid_)) {
+        return ErrorCode::WIFI_FAILED;
+    }
     
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
     ESP_ERROR_CHECK(esp_wifi_start());
+    started_ = true;
+    set_power_profile(power_profile_);
     ESP_ERROR_CHECK(esp_wifi_connect());
     
     connection_count_++;
@@ -110,8 +144,10 @@ void WiFiManager::disconnect() {
     ESP_LOGI(TAG, "Disconnecting WiFi...");
     
     connected_ = false;
+    directed_attempt_ = false;
     esp_wifi_disconnect();
     esp_wifi_stop();
+    started_ = false;
     
     if (connected_) {
         disconnection_count_++;
@@ -198,6 +234,40 @@ void WiFiManager::set_max_retry_count(uint32_t max_retries) {
     ESP_LOGI(TAG, "Max retry count set to: %u", max_retries);
 }
 
+void WiFiManager::set_fast_reconnect(bool enable) {
+    fast_reconnect_ = enable;
+    ESP_LOGI(TAG, "Fast reconnect %s", enable ? "enabled" : "disabled");
+}
+
+void WiFiManager::set_listen_interval(uint8_t beacons) {
+    listen_interval_ = beacons > 0 ? beacons : 1;
+}
+
+ErrorCode WiFiManager::set_power_profile(WiFiPowerProfile profile) {
+    power_profile_ = profile;
+    
+    // Applied at start when the driver is not up yet
+    if (!started_) {
+        return ErrorCode::SUCCESS;
+    }
+    
+    wifi_ps_type_t ps_type = WIFI_PS_MIN_MODEM;
+    switch (profile) {
+        case WiFiPowerProfile::PERFORMANCE: ps_type = WIFI_PS_NONE; break;
+        case WiFiPowerProfile::BALANCED:    ps_type = WIFI_PS_MIN_MODEM; break;
+        case WiFiPowerProfile::LOW_POWER:   ps_type = WIFI_PS_MAX_MODEM; break;
+    }
+    
+    esp_err_t err = esp_wifi_set_ps(ps_type);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set power save %d: %s", (int)ps_type, esp_err_to_name(err));
+        return ErrorCode::WIFI_FAILED;
+    }
+    
+    ESP_LOGD(TAG, "Power save: %d", (int)ps_type);
+    return ErrorCode::SUCCESS;
+}
+
 void WiFiManager::set_status_callback(StatusCallback callback) {
     status_callback_ = callback;
 }
@@ -224,6 +294,7 @@ void WiFiManager::handle_wifi_event(int32_t event_id, void* event_data) {
             
             ESP_LOGW(TAG, "WiFi disconnected, reason: %d", event->reason);
             
+            bool was_connected = connected_;
             connected_ = false;
             disconnection_count_++;
             last_disconnect_time_ = esp_timer_get_time() / 1000;
@@ -232,6 +303,28 @@ void WiFiManager::handle_wifi_event(int32_t event_id, void* event_data) {
                 status_callback_(false);
             }
             
+            // A directed attempt that never got an IP: the AP moved or the
+            // PMK is stale. Drop the cache and rescan right away.
+            if (directed_attempt_) {
+                ESP_LOGW(TAG, "Directed connect failed, falling back to a full scan");
+                fast_connect_fallbacks_++;
+                invalidate_connect_cache();
+                if (auto_reconnect_ && apply_station_config(false)) {
+                    esp_wifi_connect();
+                }
+                break;
+            }
+            
+            // Link loss: retry the same AP at once, back off after that
+            if (was_connected && auto_reconnect_ && fast_reconnect_ && cache_valid_ &&
+                apply_station_config(true)) {
+                ESP_LOGI(TAG, "Fast reconnect to cached AP");
+                connect_start_us_ = esp_timer_get_time();
+                esp_wifi_connect();
+                retry_count_++;
+                break;
+            }
+            
             // Auto-reconnect logic
             if (auto_reconnect_ && retry_count_ < max_retry_count_) {
                 ESP_LOGI(TAG, "Attempting auto-reconnect (%u/%u)...", 
@@ -251,6 +344,15 @@ void WiFiManager::handle_wifi_event(int32_t event_id, void* event_data) {
             
             connected_ = true;
             retry_count_ = 0; // Reset retry count on successful connection
+            last_connect_ms_ = (esp_timer_get_time() - connect_start_us_) / 1000;
+            if (directed_attempt_) {
+                fast_connect_count_++;
+                directed_attempt_ = false;
+            }
+            ESP_LOGI(TAG, "Connected in %u ms", last_connect_ms_);
+            
+            // PBKDF2 and flash stay off the event loop
+            cache_refresh_pending_ = true;
             
             if (status_callback_) {
                 status_callback_(true);
@@ -264,4 +366,169 @@ void WiFiManager::handle_wifi_event(int32_t event_id, void* event_data) {
     }
 }
 
-} // namespace irene 
\ No newline at end of file
+bool WiFiManager::apply_station_config(bool directed) {
+    wifi_config_t wifi_config = {};
+    std::strncpy(reinterpret_cast<char*>(wifi_config.sta.ssid), 
+                ssid_.c_str(), sizeof(wifi_config.sta.ssid) - 1);
+    wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    wifi_config.sta.listen_interval = listen_interval_;
+    
+    // Copied out so the worker can refresh the cache meanwhile
+    WiFiConnectCache cache = {};
+    if (directed) {
+        xSemaphoreTake(cache_mutex_, portMAX_DELAY);
+        cache = cache_;
+        xSemaphoreGive(cache_mutex_);
+        
+        // Known AP: no all-channel scan
+        std::memcpy(wifi_config.sta.bssid, cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.bssid_set = true;
+        wifi_config.sta.channel = cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    
+    if (directed && cache.pmk_valid) {
+        // A 64 hex digit password is taken as the PSK itself, no PBKDF2
+        char* psk = reinterpret_cast<char*>(wifi_config.sta.password);
+        for (size_t i = 0; i < sizeof(cache.pmk); i++) {
+            snprintf(psk + i * 2, 3, "%02x", cache.pmk[i]);
+        }
+    } else {
+        std::strncpy(reinterpret_cast<char*>(wifi_config.sta.password), 
+                    password_.c_str(), sizeof(wifi_config.sta.password) - 1);
+    }
+    
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    std::memset(&wifi_config, 0, sizeof(wifi_config));
+    std::memset(&cache, 0, sizeof(cache));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set station config: %s", esp_err_to_name(err));
+        return false;
+    }
+    
+    directed_attempt_ = directed;
+    return true;
+}
+
+void WiFiManager::update_connect_cache() {
+    if (!config_store_) {
+        return;
+    }
+    
+    wifi_ap_record_t ap_info;
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        return;
+    }
+    
+    const uint32_t hash = credentials_hash();
+    const bool psk = ap_info.authmode == WIFI_AUTH_WPA_PSK ||
+                     ap_info.authmode == WIFI_AUTH_WPA2_PSK ||
+                     ap_info.authmode == WIFI_AUTH_WPA_WPA2_PSK;
+    
+    xSemaphoreTake(cache_mutex_, portMAX_DELAY);
+    WiFiConnectCache previous = cache_;
+    xSemaphoreGive(cache_mutex_);
+    const bool same_credentials = cache_valid_ && previous.credentials_hash == hash;
+    
+    // Unchanged association: skip the flash write
+    if (same_credentials && previous.channel == ap_info.primary &&
+        std::memcmp(previous.bssid, ap_info.bssid, sizeof(previous.bssid)) == 0 &&
+        previous.pmk_valid == psk) {
+        return;
+    }
+    
+    WiFiConnectCache cache;
+    cache.credentials_hash = hash;
+    std::memcpy(cache.bssid, ap_info.bssid, sizeof(cache.bssid));
+    cache.channel = ap_info.primary;
+    
+    // The PMK only depends on SSID + passphrase; derive it once
+    if (psk) {
+        if (same_credentials && previous.pmk_valid) {
+            std::memcpy(cache.pmk, previous.pmk, sizeof(cache.pmk));
+            cache.pmk_valid = true;
+        } else {
+            cache.pmk_valid = derive_pmk(cache.pmk);
+        }
+    }
+    
+    xSemaphoreTake(cache_mutex_, portMAX_DELAY);
+    cache_ = cache;
+    cache_valid_ = true;
+    xSemaphoreGive(cache_mutex_);
+    
+    if (config_store_->save_wifi_cache(cache) != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "Failed to store fast reconnect cache");
+        return;
+    }
+    
+    ESP_LOGI(TAG, "Cached AP " MACSTR " ch %u%s", MAC2STR(cache.bssid), cache.channel,
+            cache.pmk_valid ? " with PMK" : "");
+}
+
+void WiFiManager::refresh_connect_cache() {
+    if (cache_refresh_pending_.exchange(false)) {
+        update_connect_cache();
+    }
+}
+
+void WiFiManager::invalidate_connect_cache() {
+    if (!cache_valid_) {
+        return;
+    }
+    
+    xSemaphoreTake(cache_mutex_, portMAX_DELAY);
+    cache_valid_ = false;
+    std::memset(&cache_, 0, sizeof(cache_));
+    xSemaphoreGive(cache_mutex_);
+    if (config_store_) {
+        config_store_->clear_wifi_cache();
+    }
+}
+
+bool WiFiManager::derive_pmk(uint8_t* pmk) const {
+    const unsigned char* password = reinterpret_cast<const unsigned char*>(password_.data());
+    const unsigned char* ssid = reinterpret_cast<const unsigned char*>(ssid_.data());
+    
+#if MBEDTLS_VERSION_MAJOR >= 3
+    int ret = mbedtls_pkcs5_pbkdf2_hmac_ext(MBEDTLS_MD_SHA1, password, password_.size(),
+                                            ssid, ssid_.size(), PMK_ITERATIONS,
+                                            sizeof(WiFiConnectCache::pmk), pmk);
+#else
+    mbedtls_md_context_t md_ctx;
+    mbedtls_md_init(&md_ctx);
+    int ret = mbedtls_md_setup(&md_ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), 1);
+    if (ret == 0) {
+        ret = mbedtls_pkcs5_pbkdf2_hmac(&md_ctx, password, password_.size(),
+                                        ssid, ssid_.size(), PMK_ITERATIONS,
+                                        sizeof(WiFiConnectCache::pmk), pmk);
+    }
+    mbedtls_md_free(&md_ctx);
+#endif
+    
+    if (ret != 0) {
+        ESP_LOGW(TAG, "PMK derivation failed: -0x%04x", -ret);
+        return false;
+    }
+    
+    return true;
+}
+
+uint32_t WiFiManager::credentials_hash() const {
+    // FNV-1a over SSID, separator, passphrase
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const std::string& text) {
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+    };
+    mix(ssid_);
+    hash = (hash ^ 0xffu) * 16777619u;
+    mix(password_);
+    return hash;
+}
+
+} // namespace irene
@@ -0,0 +1,183 @@
+#include "ota/delta_patch.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace irene {
+
+namespace {
+
+constexpr uint8_t kVersion = 1;
+
+uint32_t read_u32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Op header bytes including the type, 0 for an unknown op
+size_t op_header_size(uint8_t op) {
+    switch (op) {
+        case DeltaPatcher::OP_END:
+            return 1;
+        case DeltaPatcher::OP_COPY:
+            return 9;
+        case DeltaPatcher::OP_INSERT:
+            return 5;
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+DeltaPatcher::DeltaPatcher(SourceReader reader, TargetWriter writer, HeaderCheck check)
+    : reader_(std::move(reader))
+    , writer_(std::move(writer))
+    , check_(std::move(check))
+    , state_{} {
+}
+
+DeltaPatcher::Result DeltaPatcher::feed(const uint8_t* data, size_t length) {
+    size_t used = 0;
+    while (true) {
+        switch (state_.stage) {
+            case DONE:
+                return Result::DONE;
+
+            case HEADER: {
+                const size_t take = std::min(HEADER_SIZE - state_.pending_length, length - used);
+                std::memcpy(state_.pending + state_.pending_length, data + used, take);
+                state_.pending_length += take;
+                used += take;
+                if (state_.pending_length < HEADER_SIZE) {
+                    return Result::NEED_MORE;
+                }
+                const Result result = parse_header();
+                if (result != Result::NEED_MORE) {
+                    return result;
+                }
+                break;
+            }
+
+            case OP: {
+                if (state_.pending_length == 0) {
+                    if (used == length) {
+                        return Result::NEED_MORE;
+                    }
+                    state_.pending[state_.pending_length++] = data[used++];
+                }
+                const size_t needed = op_header_size(state_.pending[0]);
+                if (needed == 0) {
+                    return Result::BAD_PATCH;
+                }
+                const size_t take = std::min(needed - state_.pending_length, length - used);
+                std::memcpy(state_.pending + state_.pending_length, data + used, take);
+                state_.pending_length += take;
+                used += take;
+                if (state_.pending_length < needed) {
+                    return Result::NEED_MORE;
+                }
+                const Result result = run_op();
+                if (result != Result::NEED_MORE) {
+                    return result;
+                }
+                break;
+            }
+
+            case INSERT: {
+                if (used == length) {
+                    return Result::NEED_MORE;
+                }
+                const size_t take = std::min<size_t>(state_.op_remaining, length - used);
+                if (!writer_(data + used, take)) {
+                    return Result::IO_ERROR;
+                }
+                used += take;
+                state_.written += take;
+                state_.op_remaining -= take;
+                if (state_.op_remaining == 0) {
+                    state_.stage = OP;
+                }
+                break;
+            }
+
+            default:
+                return Result::BAD_PATCH;
+        }
+    }
+}
+
+// NEED_MORE here means decoding goes on
+DeltaPatcher::Result DeltaPatcher::parse_header() {
+    const uint8_t* header = state_.pending;
+    if (std::memcmp(header, "IRDP", 4) != 0 || header[4] != kVersion) {
+        return Result::BAD_PATCH;
+    }
+
+    state_.source_size = read_u32(header + 8);
+    state_.target_size = read_u32(header + 12);
+    std::memcpy(state_.source_sha256, header + 16, sizeof(state_.source_sha256));
+    state_.written = 0;
+    state_.pending_length = 0;
+    state_.stage = OP;
+
+    if (check_ && !check_(state_)) {
+        return Result::SOURCE_MISMATCH;
+    }
+    return Result::NEED_MORE;
+}
+
+DeltaPatcher::Result DeltaPatcher::run_op() {
+    const uint8_t* header = state_.pending;
+    state_.pending_length = 0;
+
+    switch (header[0]) {
+        case OP_END:
+            if (state_.written != state_.target_size) {
+                return Result::BAD_PATCH;
+            }
+            state_.stage = DONE;
+            return Result::DONE;
+
+        case OP_COPY: {
+            const uint32_t offset = read_u32(header + 1);
+            const uint32_t length = read_u32(header + 5);
+            if (static_cast<uint64_t>(offset) + length > state_.source_size ||
+                static_cast<uint64_t>(state_.written) + length > state_.target_size) {
+                return Result::BAD_PATCH;
+            }
+            return copy(offset, length);
+        }
+
+        case OP_INSERT: {
+            const uint32_t length = read_u32(header + 1);
+            if (static_cast<uint64_t>(state_.written) + length > state_.target_size) {
+                return Result::BAD_PATCH;
+            }
+            state_.op_remaining = length;
+            if (length > 0) {
+                state_.stage = INSERT;
+            }
+            return Result::NEED_MORE;
+        }
+
+        default:
+            return Result::BAD_PATCH;
+    }
+}
+
+// Whole copies run inside one feed(), so a saved state is never mid-copy
+DeltaPatcher::Result DeltaPatcher::copy(uint32_t offset, uint32_t length) {
+    while (length > 0) {
+        const size_t chunk = std::min<size_t>(length, sizeof(copy_buffer_));
+        if (!reader_(offset, copy_buffer_, chunk) || !writer_(copy_buffer_, chunk)) {
+            return Result::IO_ERROR;
+        }
+        offset += chunk;
+        length -= chunk;
+        state_.written += chunk;
+    }
+    return Result::NEED_MORE;
+}
+
+} // namespace irene
@@ -1,15 +1,88 @@
 #include "ota/ota_manager.hpp"
+#include "ota/delta_patch.hpp"
+#include "core/config_manager.hpp"
+#include "core/task_manager.hpp"
 #include "esp_log.h"
-#include "esp_https_ota.h"
+#include "esp_http_client.h"
 #include "esp_ota_ops.h"
 #include "esp_app_desc.h"
+#include "esp_app_format.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
 
 static const char* TAG = "OTAManager";
 
 namespace irene {
 
+namespace {
+
+constexpr uint32_t kSectorSize = 4096;
+constexpr size_t kReadBytes = 1024;          // Per socket read, on the OTA task stack
+constexpr int kHttpTimeoutMs = 30000;
+constexpr uint32_t kMaxFailures = 5;         // Attempts in a row without progress
+constexpr uint32_t kRetryDelayMs = 2000;     // Times the failure count
+constexpr uint32_t kHoldPollMs = 250;
+constexpr uint32_t kTaskStackSize = 10240;   // TLS handshake plus the read and copy buffers
+
+// Response headers the resume logic needs
+struct ResponseHeaders {
+    char etag[sizeof(OTAResumeRecord::etag)];
+    bool has_range;
+    uint32_t range_start;
+    uint32_t range_total;
+};
+
+esp_err_t http_event_handler(esp_http_client_event_t* event) {
+    if (event->event_id != HTTP_EVENT_ON_HEADER || !event->user_data) {
+        return ESP_OK;
+    }
+    
+    ResponseHeaders* headers = static_cast<ResponseHeaders*>(event->user_data);
+    if (strcasecmp(event->header_key, "ETag") == 0) {
+        // A validator that does not fit is worth less than none: no If-Range
+        if (std::strlen(event->header_value) < sizeof(headers->etag)) {
+            std::strcpy(headers->etag, event->header_value);
+        }
+    } else if (strcasecmp(event->header_key, "Content-Range") == 0) {
+        unsigned long start = 0;
+        unsigned long end = 0;
+        unsigned long total = 0;
+        if (std::sscanf(event->header_value, "bytes %lu-%lu/%lu", &start, &end, &total) == 3) {
+            headers->has_range = true;
+            headers->range_start = start;
+            headers->range_total = total;
+        }
+    }
+    return ESP_OK;
+}
+
+// Closes and frees the client on every path out of a download attempt
+struct ClientGuard {
+    esp_http_client_handle_t client;
+    ~ClientGuard() {
+        if (client) {
+            esp_http_client_close(client);
+            esp_http_client_cleanup(client);
+        }
+    }
+};
+
+uint32_t url_hash(const std::string& url) {
+    // FNV-1a over the URL
+    uint32_t hash = 2166136261u;
+    for (char c : url) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+} // namespace
+
 struct OTATaskParams {
     OTAManager* manager;
     std::string url;
@@ -18,48 +91,77 @@ struct OTATaskParams {
 
 OTAManager::OTAManager()
     : update_in_progress_(false)
-    , update_progress_(0) {
+    , cancel_requested_(false)
+    , held_(false)
+    , update_progress_(0)
+    , resumes_(0)
+    , checkpoint_received_(0)
+    , written_(0)
+    , erased_(0)
+    , target_(nullptr)
+    , patcher_(nullptr)
+    , checkpoint_bytes_(65536)
+    , client_cert_pem_(nullptr)
+    , client_key_pem_(nullptr) {
 }
 
 OTAManager::~OTAManager() {
     cancel_update();
 }
 
-ErrorCode OTAManager::initialize() {
+ErrorCode OTAManager::initialize(const NetworkConfig& config) {
     ESP_LOGI(TAG, "Initializing OTA manager...");
     
+    limiter_.configure(config.ota_rate_limit);
+    checkpoint_bytes_ = std::max<uint32_t>(config.ota_checkpoint_bytes, kSectorSize);
+    
+    // Without NVS downloads still work, they just cannot resume
+    config_store_ = std::make_unique<ConfigManager>();
+    if (config_store_->initialize() != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "No NVS: OTA downloads will not resume");
+        config_store_.reset();
+    } else {
+        OTAResumeRecord pending;
+        if (config_store_->load_ota_record(pending) == ErrorCode::SUCCESS) {
+            ESP_LOGI(TAG, "Interrupted download: %u of %u bytes", pending.received, pending.image_size);
+        }
+    }
+    
     // Print current partition info
     print_partition_info();
     
-    ESP_LOGI(TAG, "OTA manager initialized");
+    ESP_LOGI(TAG, "OTA manager initialized (%u B/s)", config.ota_rate_limit);
     return ErrorCode::SUCCESS;
 }
 
 ErrorCode OTAManager::start_update(const std::string& url, const char* server_cert) {
-    if (update_in_progress_) {
+    bool expected = false;
+    if (!update_in_progress_.compare_exchange_strong(expected, true)) {
         ESP_LOGW(TAG, "OTA update already in progress");
         return ErrorCode::OTA_FAILED;
     }
     
     ESP_LOGI(TAG, "Starting OTA update from: %s", url.c_str());
     
-    update_in_progress_ = true;
+    cancel_requested_ = false;
     update_progress_ = 0;
     
     // Create task parameters
     OTATaskParams* params = new OTATaskParams{this, url, server_cert};
     
     // Create OTA task
-    BaseType_t result = xTaskCreate(
-        ota_task_wrapper,
+    TaskHandle_t handle = nullptr;
+    ErrorCode result = TaskManager::instance().create_task(
         "ota_task",
-        8192,  // Stack size
+        ota_task_wrapper,
         params,
+        kTaskStackSize,
         5,     // Priority
-        nullptr
+        tskNO_AFFINITY,
+        &handle
     );
     
-    if (result != pdPASS) {
+    if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to create OTA task");
         delete params;
         update_in_progress_ = false;
@@ -71,9 +173,9 @@ ErrorCode OTAManager::start_update(const std::string& url, const char* server_ce
 
 void OTAManager::cancel_update() {
     if (update_in_progress_) {
+        // The task stops at its next read and checkpoints
         ESP_LOGI(TAG, "Cancelling OTA update...");
-        update_in_progress_ = false;
-        // Note: Actual cancellation would require more sophisticated task coordination
+        cancel_requested_ = true;
     }
 }
 
@@ -104,6 +206,11 @@ std::string OTAManager::get_current_app_description() const {
     return std::string(app_desc->date) + " " + std::string(app_desc->time);
 }
 
+void OTAManager::set_client_certificate(const char* cert_pem, const char* key_pem) {
+    client_cert_pem_ = cert_pem;
+    client_key_pem_ = key_pem;
+}
+
 void OTAManager::set_progress_callback(ProgressCallback callback) {
     progress_callback_ = callback;
 }
@@ -112,6 +219,10 @@ void OTAManager::set_complete_callback(CompleteCallback callback) {
     complete_callback_ = callback;
 }
 
+void OTAManager::set_hold_check(HoldCheck check) {
+    hold_check_ = check;
+}
+
 void OTAManager::print_partition_info() const {
     ESP_LOGI(TAG, "=== Partition Information ===");
     
@@ -148,66 +259,88 @@ void OTAManager::ota_task_wrapper(void* param) {
     OTATaskParams* params = static_cast<OTATaskParams*>(param);
     params->manager->ota_task(params->url, params->cert);
     delete params;
-    vTaskDelete(nullptr);
+    TaskManager::instance().delete_task(static_cast<TaskHandle_t>(nullptr));
 }
 
 void OTAManager::ota_task(const std::string url, const char* cert) {
     ESP_LOGI(TAG, "OTA task started");
     
-    esp_http_client_config_t config = {};
-    config.url = url.c_str();
-    config.cert_pem = cert;
-    config.timeout_ms = 30000;
-    config.keep_alive_enable = true;
-    
-    esp_https_ota_config_t ota_config = {};
-    ota_config.http_config = &config;
-    
-    esp_https_ota_handle_t https_ota_handle = nullptr;
-    esp_err_t err = esp_https_ota_begin(&ota_config, &https_ota_handle);
-    
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "ESP HTTPS OTA Begin failed: %s", esp_err_to_name(err));
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    target_ = esp_ota_get_next_update_partition(nullptr);
+    if (!target_) {
+        ESP_LOGE(TAG, "No OTA update partition");
         update_in_progress_ = false;
         if (complete_callback_) {
-            complete_callback_(false, "Failed to begin OTA");
+            complete_callback_(false, "No update partition");
         }
         return;
     }
     
-    // Get image size for progress calculation
-    int total_size = esp_https_ota_get_image_size(https_ota_handle);
-    ESP_LOGI(TAG, "OTA image size: %d bytes", total_size);
+    // Delta images rebuild the target from the running partition
+    DeltaPatcher patcher(
+        [running](uint32_t offset, uint8_t* data, size_t length) {
+            return esp_partition_read(running, offset, data, length) == ESP_OK;
+        },
+        [this](const uint8_t* data, size_t length) {
+            return write_target(data, length);
+        },
+        [this](const DeltaPatchState& state) {
+            return check_source(state);
+        });
+    patcher_ = &patcher;
     
-    // Download and write firmware
-    while (update_in_progress_) {
-        err = esp_https_ota_perform(https_ota_handle);
-        
-        if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
+    // Pick up an interrupted download of the same image into the same partition
+    OTAResumeRecord stored;
+    const bool resumable = config_store_ &&
+        config_store_->load_ota_record(stored) == ErrorCode::SUCCESS &&
+        stored.url_hash == url_hash(url) &&
+        stored.partition_address == target_->address &&
+        stored.received > 0 && stored.received < stored.image_size &&
+        (!stored.delta || !DeltaPatcher::has_header(stored.patch) || check_source(stored.patch));
+    if (resumable) {
+        record_ = stored;
+        patcher.restore(stored.patch);
+        written_ = stored.delta ? stored.patch.written : stored.received;
+        // The sector holding the resume point was erased before it was written
+        erased_ = (written_ + kSectorSize - 1) / kSectorSize * kSectorSize;
+        checkpoint_received_ = stored.received;
+        ESP_LOGI(TAG, "Resuming %s download at %u of %u bytes",
+                stored.delta ? "delta" : "image", stored.received, stored.image_size);
+    } else {
+        begin_image(0, "");
+    }
+    record_.url_hash = url_hash(url);
+    record_.partition_address = target_->address;
+    
+    // Retry with back-off while attempts make progress; each one resumes
+    std::string error;
+    Attempt attempt = Attempt::RETRY;
+    uint32_t failures = 0;
+    while (true) {
+        const uint32_t before = record_.received;
+        attempt = download(url, cert, error);
+        if (attempt != Attempt::RETRY) {
             break;
         }
         
-        // Update progress
-        int downloaded = esp_https_ota_get_image_len_read(https_ota_handle);
-        if (total_size > 0) {
-            int progress = (downloaded * 100) / total_size;
-            if (progress != update_progress_) {
-                update_progress_ = progress;
-                ESP_LOGI(TAG, "OTA progress: %d%% (%d/%d bytes)", 
-                        progress, downloaded, total_size);
-                
-                if (progress_callback_) {
-                    progress_callback_(progress);
-                }
-            }
+        save_checkpoint();
+        failures = record_.received > before ? 1 : failures + 1;
+        if (failures > kMaxFailures) {
+            break;
+        }
+        ESP_LOGW(TAG, "Download interrupted at %u of %u bytes (%s), retry in %u ms",
+                record_.received, record_.image_size, error.c_str(), kRetryDelayMs * failures);
+        vTaskDelay(pdMS_TO_TICKS(kRetryDelayMs * failures));
+        if (cancel_requested_) {
+            attempt = Attempt::CANCELLED;
+            break;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(100)); // Small delay
     }
     
-    if (err == ESP_OK) {
-        // Finalize OTA
-        err = esp_https_ota_finish(https_ota_handle);
+    if (attempt == Attempt::COMPLETE) {
+        // Checks the image (and its SHA-256) before selecting it
+        const esp_err_t err = esp_ota_set_boot_partition(target_);
+        discard_resume_point();
         if (err == ESP_OK) {
             ESP_LOGI(TAG, "OTA update successful! Restart required.");
             update_progress_ = 100;
@@ -220,25 +353,267 @@ void OTAManager::ota_task(const std::string url, const char* cert) {
                 complete_callback_(true, "");
             }
             
-            // Mark as valid and restart
-            esp_ota_mark_app_valid_cancel_rollback();
+            // Batched settings (the cleared resume point among them) first
+            ConfigManager::flush();
             vTaskDelay(pdMS_TO_TICKS(1000));
             esp_restart();
-        } else {
-            ESP_LOGE(TAG, "OTA finish failed: %s", esp_err_to_name(err));
         }
+        ESP_LOGE(TAG, "New image rejected: %s", esp_err_to_name(err));
+        error = "Image verification failed";
+    } else if (attempt == Attempt::FATAL) {
+        discard_resume_point();
     } else {
-        ESP_LOGE(TAG, "OTA failed: %s", esp_err_to_name(err));
-        esp_https_ota_abort(https_ota_handle);
+        // Cancelled or out of retries: the next start_update() continues
+        save_checkpoint();
     }
     
+    ESP_LOGE(TAG, "OTA failed: %s", error.c_str());
+    patcher_ = nullptr;
+    held_ = false;
     update_in_progress_ = false;
     
-    if (complete_callback_ && err != ESP_OK) {
-        complete_callback_(false, esp_err_to_name(err));
+    if (complete_callback_) {
+        complete_callback_(false, error);
     }
     
     ESP_LOGI(TAG, "OTA task finished");
 }
 
-} // namespace irene 
\ No newline at end of file
+OTAManager::Attempt OTAManager::download(const std::string& url, const char* cert, std::string& error) {
+    // No handshake in the middle of a conversation either
+    wait_while_held();
+    if (cancel_requested_) {
+        error = "Cancelled";
+        return Attempt::CANCELLED;
+    }
+    
+    ResponseHeaders headers = {};
+    
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.cert_pem = cert;
+    config.client_cert_pem = client_cert_pem_;
+    config.client_key_pem = client_key_pem_;
+    config.timeout_ms = kHttpTimeoutMs;
+    config.keep_alive_enable = true;
+    config.event_handler = http_event_handler;
+    config.user_data = &headers;
+    
+    ClientGuard guard{esp_http_client_init(&config)};
+    if (!guard.client) {
+        error = "HTTP client init failed";
+        return Attempt::RETRY;
+    }
+    
+    // Ask for the rest; If-Range makes a changed image come back whole
+    const bool resuming = record_.received > 0;
+    char range[32];
+    if (resuming) {
+        std::snprintf(range, sizeof(range), "bytes=%u-", record_.received);
+        esp_http_client_set_header(guard.client, "Range", range);
+        if (record_.etag[0]) {
+            esp_http_client_set_header(guard.client, "If-Range", record_.etag);
+        }
+    }
+    
+    esp_err_t err = esp_http_client_open(guard.client, 0);
+    if (err != ESP_OK) {
+        error = esp_err_to_name(err);
+        return Attempt::RETRY;
+    }
+    
+    const int64_t content_length = esp_http_client_fetch_headers(guard.client);
+    const int status = esp_http_client_get_status_code(guard.client);
+    if (status == 206 && resuming && headers.has_range &&
+        headers.range_start == record_.received && headers.range_total == record_.image_size) {
+        resumes_++;
+        ESP_LOGI(TAG, "Server resumed at %u of %u bytes", record_.received, record_.image_size);
+    } else if (status == 200) {
+        if (resuming) {
+            ESP_LOGW(TAG, "Server sent the whole image, starting over");
+        }
+        if (content_length <= 0 || content_length > static_cast<int64_t>(target_->size)) {
+            error = content_length <= 0 ? "Image size unknown" : "Image larger than the update partition";
+            return Attempt::FATAL;
+        }
+        begin_image(static_cast<uint32_t>(content_length), headers.etag);
+    } else if (status == 416) {
+        // Resume point past the end: the image changed under us
+        begin_image(0, "");
+        error = "Range not satisfiable";
+        return Attempt::RETRY;
+    } else {
+        error = "HTTP status " + std::to_string(status);
+        return status >= 400 && status < 500 ? Attempt::FATAL : Attempt::RETRY;
+    }
+    
+    uint8_t buffer[kReadBytes];
+    while (record_.received < record_.image_size) {
+        wait_while_held();
+        if (cancel_requested_) {
+            error = "Cancelled";
+            return Attempt::CANCELLED;
+        }
+        
+        const size_t request = std::min<size_t>(sizeof(buffer), record_.image_size - record_.received);
+        const int length = esp_http_client_read(guard.client, reinterpret_cast<char*>(buffer), request);
+        if (length <= 0) {
+            error = length == 0 ? "Connection closed" : "Read failed";
+            return Attempt::RETRY;
+        }
+        if (!consume(buffer, length, error)) {
+            return Attempt::FATAL;
+        }
+        record_.received += length;
+        
+        // Update progress
+        const int progress = static_cast<int>(static_cast<uint64_t>(record_.received) * 100 / record_.image_size);
+        if (progress != update_progress_) {
+            update_progress_ = progress;
+            ESP_LOGD(TAG, "OTA progress: %d%% (%u/%u bytes)", progress, record_.received, record_.image_size);
+            if (progress_callback_) {
+                progress_callback_(progress);
+            }
+        }
+        
+        if (record_.received - checkpoint_received_ >= checkpoint_bytes_) {
+            save_checkpoint();
+        }
+        
+        // Pace the reads; the server follows through TCP flow control
+        const int64_t wait_us = limiter_.consume(length, esp_timer_get_time());
+        if (wait_us > 0) {
+            vTaskDelay(std::max<TickType_t>(1, pdMS_TO_TICKS((wait_us + 999) / 1000)));
+        }
+    }
+    
+    if (record_.delta && !patcher_->is_done()) {
+        error = "Delta patch ended early";
+        return Attempt::FATAL;
+    }
+    return Attempt::COMPLETE;
+}
+
+void OTAManager::begin_image(uint32_t size, const char* etag) {
+    const uint32_t hash = record_.url_hash;
+    const uint32_t address = record_.partition_address;
+    record_ = OTAResumeRecord{};
+    record_.url_hash = hash;
+    record_.partition_address = address;
+    record_.image_size = size;
+    std::strncpy(record_.etag, etag, sizeof(record_.etag) - 1);
+    
+    patcher_->restore(DeltaPatchState{});
+    written_ = 0;
+    erased_ = 0;
+    checkpoint_received_ = 0;
+}
+
+bool OTAManager::consume(const uint8_t* data, size_t length, std::string& error) {
+    // The first byte tells a delta patch from an app image
+    if (record_.received == 0) {
+        record_.delta = DeltaPatcher::is_patch(data[0]);
+        if (!record_.delta && data[0] != ESP_IMAGE_HEADER_MAGIC) {
+            error = "Not a firmware image";
+            return false;
+        }
+        ESP_LOGI(TAG, "Downloading %s: %u bytes", record_.delta ? "delta patch" : "image", record_.image_size);
+    }
+    
+    if (!record_.delta) {
+        if (!write_target(data, length)) {
+            error = "Flash write failed";
+            return false;
+        }
+        return true;
+    }
+    
+    const DeltaPatcher::Result result = patcher_->feed(data, length);
+    record_.patch = patcher_->state();
+    switch (result) {
+        case DeltaPatcher::Result::NEED_MORE:
+        case DeltaPatcher::Result::DONE:
+            return true;
+        case DeltaPatcher::Result::SOURCE_MISMATCH:
+            error = "Delta does not apply to the running image";
+            return false;
+        case DeltaPatcher::Result::IO_ERROR:
+            error = "Flash access failed";
+            return false;
+        default:
+            error = "Corrupt delta patch";
+            return false;
+    }
+}
+
+bool OTAManager::write_target(const uint8_t* data, size_t length) {
+    if (written_ + length > target_->size) {
+        return false;
+    }
+    
+    // One sector just ahead of the data: each erase stalls flash access briefly
+    while (erased_ < written_ + length) {
+        if (esp_partition_erase_range(target_, erased_, kSectorSize) != ESP_OK) {
+            return false;
+        }
+        erased_ += kSectorSize;
+    }
+    
+    if (esp_partition_write(target_, written_, data, length) != ESP_OK) {
+        return false;
+    }
+    written_ += length;
+    return true;
+}
+
+bool OTAManager::check_source(const DeltaPatchState& state) const {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (state.source_size > running->size || state.target_size > target_->size) {
+        ESP_LOGE(TAG, "Delta sizes do not fit: %u -> %u bytes", state.source_size, state.target_size);
+        return false;
+    }
+    
+    uint8_t sha256[32];
+    if (esp_partition_get_sha256(running, sha256) != ESP_OK ||
+        std::memcmp(sha256, state.source_sha256, sizeof(sha256)) != 0) {
+        ESP_LOGE(TAG, "Delta was made for another image");
+        return false;
+    }
+    return true;
+}
+
+void OTAManager::wait_while_held() {
+    if (!hold_check_ || !hold_check_()) {
+        return;
+    }
+    
+    // A conversation may end in a reboot or a long hold: checkpoint first
+    ESP_LOGI(TAG, "Download held at %u of %u bytes", record_.received, record_.image_size);
+    held_ = true;
+    save_checkpoint();
+    while (hold_check_() && !cancel_requested_) {
+        vTaskDelay(pdMS_TO_TICKS(kHoldPollMs));
+    }
+    held_ = false;
+    ESP_LOGI(TAG, "Download released");
+}
+
+void OTAManager::save_checkpoint() {
+    if (!config_store_ || record_.received == checkpoint_received_ || record_.received == 0) {
+        return;
+    }
+    if (config_store_->save_ota_record(record_) != ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "Failed to save the resume point");
+        return;
+    }
+    checkpoint_received_ = record_.received;
+}
+
+void OTAManager::discard_resume_point() {
+    if (config_store_) {
+        config_store_->clear_ota_record();
+    }
+    checkpoint_received_ = 0;
+}
+
+} // namespace irene
@@ -1,20 +1,235 @@
+#include "ui/display_manager.hpp"
+#include "driver/spi_master.h"
+#include "driver/ledc.h"
+#include "esp_lcd_panel_ops.h"
+#include "esp_lcd_panel_vendor.h"
 #include "esp_log.h"
 
-// Basic display manager stub implementation
-// This is a placeholder for actual display hardware management
-
 static const char* TAG = "DisplayManager";
 
-extern "C" {
-    void display_manager_init(void) {
-        ESP_LOGI(TAG, "Display manager initialized (stub)");
+namespace irene {
+
+namespace {
+
+// SPI panels take RGB565 big-endian: build LVGL with CONFIG_LV_COLOR_16_SWAP
+static_assert(sizeof(lv_color_t) == 2, "Display path expects 16 bpp LVGL colours");
+
+constexpr ledc_mode_t kBacklightMode = LEDC_LOW_SPEED_MODE;
+constexpr ledc_timer_t kBacklightTimer = LEDC_TIMER_0;
+constexpr ledc_channel_t kBacklightChannel = LEDC_CHANNEL_0;
+constexpr ledc_timer_bit_t kBacklightResolution = LEDC_TIMER_10_BIT;
+constexpr uint32_t kBacklightFrequencyHz = 5000;
+constexpr uint32_t kBacklightMaxDuty = (1u << 10) - 1;
+
+// Colour transfers queued on the bus: both draw buffers plus the window commands
+constexpr size_t kTransQueueDepth = 10;
+
+} // namespace
+
+DisplayManager::DisplayManager()
+    : bus_initialized_(false)
+    , backlight_ready_(false)
+    , panel_on_(false)
+    , io_(nullptr)
+    , panel_(nullptr)
+    , draw_buf_{}
+    , disp_drv_{}
+    , display_(nullptr)
+    , flushes_(0)
+    , pixels_(0) {
+}
+
+DisplayManager::~DisplayManager() {
+    if (display_) {
+        lv_disp_remove(display_);
+    }
+    if (panel_) {
+        esp_lcd_panel_del(panel_);
     }
-    
-    void display_manager_update(void) {
-        // Placeholder for display updates
+    if (io_) {
+        esp_lcd_panel_io_del(io_);
     }
-    
-    void display_manager_set_brightness(uint8_t brightness) {
-        ESP_LOGD(TAG, "Set brightness to %d%% (stub)", brightness);
+    if (bus_initialized_) {
+        spi_bus_free(static_cast<spi_host_device_t>(config_.display_spi_host));
+    }
+}
+
+ErrorCode DisplayManager::initialize(const UIConfig& config) {
+    config_ = config;
+
+    ErrorCode result = init_backlight(config);
+    if (result != ErrorCode::SUCCESS) {
+        return result;
     }
-} 
\ No newline at end of file
+    result = init_bus(config);
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+    result = init_panel(config);
+    if (result != ErrorCode::SUCCESS) {
+        return result;
+    }
+
+    // Two partial buffers: LVGL draws into one while the other is on the bus
+    const size_t pixels = static_cast<size_t>(config.display_width) * config.draw_buffer_lines;
+    draw_buffer_a_.reset(MemoryPlan::allocate_array<lv_color_t>(MemoryRegion::DMA, pixels, "lvgl draw A"));
+    draw_buffer_b_.reset(MemoryPlan::allocate_array<lv_color_t>(MemoryRegion::DMA, pixels, "lvgl draw B"));
+    if (!draw_buffer_a_ || !draw_buffer_b_) {
+        ESP_LOGE(TAG, "No DMA memory for the draw buffers");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    lv_disp_draw_buf_init(&draw_buf_, draw_buffer_a_.get(), draw_buffer_b_.get(), pixels);
+
+    lv_disp_drv_init(&disp_drv_);
+    disp_drv_.hor_res = config.display_width;
+    disp_drv_.ver_res = config.display_height;
+    disp_drv_.draw_buf = &draw_buf_;
+    disp_drv_.flush_cb = flush_cb;
+    disp_drv_.full_refresh = 0;     // Render and send dirty areas only
+    disp_drv_.user_data = this;
+    display_ = lv_disp_drv_register(&disp_drv_);
+    if (!display_) {
+        ESP_LOGE(TAG, "LVGL display registration failed");
+        return ErrorCode::DISPLAY_FAILED;
+    }
+
+    set_backlight(config.brightness);
+
+    ESP_LOGI(TAG, "Panel %ux%u on SPI%u at %u MHz, 2 x %u line draw buffers (%u bytes each)",
+             config.display_width, config.display_height, config.display_spi_host + 1,
+             (unsigned)(config.display_pclk_hz / 1000000), config.draw_buffer_lines,
+             (unsigned)(pixels * sizeof(lv_color_t)));
+    return ErrorCode::SUCCESS;
+}
+
+void DisplayManager::set_backlight(uint8_t percentage) {
+    if (percentage > 100) {
+        percentage = 100;
+    }
+
+    // Blank the panel too, so a dark screen does not keep its pixels driven
+    const bool on = percentage > 0;
+    if (panel_ && on != panel_on_) {
+        esp_lcd_panel_disp_on_off(panel_, on);
+        panel_on_ = on;
+    }
+
+    if (!backlight_ready_) {
+        return;
+    }
+    ledc_set_duty(kBacklightMode, kBacklightChannel, kBacklightMaxDuty * percentage / 100);
+    ledc_update_duty(kBacklightMode, kBacklightChannel);
+}
+
+ErrorCode DisplayManager::init_bus(const UIConfig& config) {
+    spi_bus_config_t bus_config = {};
+    bus_config.mosi_io_num = config.display_mosi_io;
+    bus_config.miso_io_num = -1;
+    bus_config.sclk_io_num = config.display_sclk_io;
+    bus_config.quadwp_io_num = -1;
+    bus_config.quadhd_io_num = -1;
+    // One draw buffer per transfer
+    bus_config.max_transfer_sz = config.display_width * config.draw_buffer_lines * sizeof(lv_color_t);
+
+    const spi_host_device_t host = static_cast<spi_host_device_t>(config.display_spi_host);
+    esp_err_t err = spi_bus_initialize(host, &bus_config, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "SPI bus init failed: %s", esp_err_to_name(err));
+        return ErrorCode::DISPLAY_FAILED;
+    }
+    bus_initialized_ = true;
+
+    esp_lcd_panel_io_spi_config_t io_config = {};
+    io_config.cs_gpio_num = config.display_cs_io;
+    io_config.dc_gpio_num = config.display_dc_io;
+    io_config.spi_mode = 0;
+    io_config.pclk_hz = config.display_pclk_hz;
+    io_config.trans_queue_depth = kTransQueueDepth;
+    io_config.on_color_trans_done = on_color_trans_done;
+    io_config.user_ctx = &disp_drv_;
+    io_config.lcd_cmd_bits = 8;
+    io_config.lcd_param_bits = 8;
+
+    err = esp_lcd_new_panel_io_spi(static_cast<esp_lcd_spi_bus_handle_t>(host), &io_config, &io_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Panel IO init failed: %s", esp_err_to_name(err));
+        return ErrorCode::DISPLAY_FAILED;
+    }
+    return ErrorCode::SUCCESS;
+}
+
+// The controller is chosen here; a different panel only changes this function
+ErrorCode DisplayManager::init_panel(const UIConfig& config) {
+    esp_lcd_panel_dev_config_t panel_config = {};
+    panel_config.reset_gpio_num = config.display_rst_io;
+    panel_config.rgb_ele_order = LCD_RGB_ELEMENT_ORDER_RGB;
+    panel_config.bits_per_pixel = 16;
+
+    esp_err_t err = esp_lcd_new_panel_st7789(io_, &panel_config, &panel_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Panel driver init failed: %s", esp_err_to_name(err));
+        return ErrorCode::DISPLAY_FAILED;
+    }
+
+    esp_lcd_panel_reset(panel_);
+    esp_lcd_panel_init(panel_);
+    esp_lcd_panel_invert_color(panel_, true);
+    esp_lcd_panel_disp_on_off(panel_, true);
+    panel_on_ = true;
+    return ErrorCode::SUCCESS;
+}
+
+ErrorCode DisplayManager::init_backlight(const UIConfig& config) {
+    if (config.display_backlight_io < 0) {
+        return ErrorCode::SUCCESS;
+    }
+
+    ledc_timer_config_t timer_config = {};
+    timer_config.speed_mode = kBacklightMode;
+    timer_config.duty_resolution = kBacklightResolution;
+    timer_config.timer_num = kBacklightTimer;
+    timer_config.freq_hz = kBacklightFrequencyHz;
+    timer_config.clk_cfg = LEDC_AUTO_CLK;
+    esp_err_t err = ledc_timer_config(&timer_config);
+    if (err == ESP_OK) {
+        ledc_channel_config_t channel_config = {};
+        channel_config.gpio_num = config.display_backlight_io;
+        channel_config.speed_mode = kBacklightMode;
+        channel_config.channel = kBacklightChannel;
+        channel_config.intr_type = LEDC_INTR_DISABLE;
+        channel_config.timer_sel = kBacklightTimer;
+        channel_config.duty = 0;    // Dark until the first frame is up
+        channel_config.hpoint = 0;
+        err = ledc_channel_config(&channel_config);
+    }
+    if (err != ESP_OK) {
+        // The panel still works at whatever the backlight pin defaults to
+        ESP_LOGW(TAG, "Backlight PWM unavailable: %s", esp_err_to_name(err));
+        return ErrorCode::SUCCESS;
+    }
+    backlight_ready_ = true;
+    return ErrorCode::SUCCESS;
+}
+
+// LVGL task: queue the area and return; the buffer is released by the ISR below
+void DisplayManager::flush_cb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_map) {
+    DisplayManager* self = static_cast<DisplayManager*>(drv->user_data);
+    esp_err_t err = esp_lcd_panel_draw_bitmap(self->panel_, area->x1, area->y1,
+                                              area->x2 + 1, area->y2 + 1, color_map);
+    if (err != ESP_OK) {
+        // Nothing was queued, so no completion interrupt will come
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    self->flushes_++;
+    self->pixels_ += static_cast<uint64_t>(area->x2 - area->x1 + 1) * (area->y2 - area->y1 + 1);
+}
+
+bool DisplayManager::on_color_trans_done(esp_lcd_panel_io_handle_t io,
+                                         esp_lcd_panel_io_event_data_t* edata,
+                                         void* user_ctx) {
+    lv_disp_flush_ready(static_cast<lv_disp_drv_t*>(user_ctx));
+    return false;
+}
+
+} // namespace irene
@@ -1,13 +1,38 @@
 #include "ui/ui_controller.hpp"
+#include "ui/display_manager.hpp"
+#include "core/task_manager.hpp"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 
 static const char* TAG = "UIController";
 
 namespace irene {
 
+namespace {
+
+// LVGL task period with nothing animating: enough for timers and the clock
+constexpr uint32_t kIdlePeriodMs = 1000;
+
+// WiFi icon colour by signal level
+constexpr uint32_t kSignalColors[] = {0xFF0000, 0xFFFF00, 0x00FF00};
+
+int signal_level(int rssi_dbm) {
+    if (rssi_dbm >= -65) {
+        return 2;
+    }
+    return rssi_dbm >= -80 ? 1 : 0;
+}
+
+} // namespace
+
 UIController::UIController()
     : initialized_(false)
     , current_state_(SystemState::IDLE_LISTENING)
@@ -21,11 +46,23 @@ UIController::UIController()
     , wifi_icon_(nullptr)
     , ota_progress_bar_(nullptr)
     , keyword_popup_(nullptr)
+    , popup_timer_(nullptr)
+    , ring_opa_(LV_OPA_COVER)
+    , ring_segments_{}
     , lvgl_task_handle_(nullptr)
+    , lvgl_mutex_(nullptr)
+    , last_tick_us_(0)
     , screen_timeout_enabled_(true)
     , last_activity_time_(0)
+    , wake_requested_(false)
+    , screen_asleep_(false)
     , ota_progress_visible_(false)
-    , last_ota_percentage_(0) {
+    , last_ota_percentage_(0)
+    , shown_minute_of_day_(-1)
+    , shown_temperature_(INT_MIN)
+    , shown_temperature_stale_(false)
+    , shown_rssi_(0)
+    , shown_signal_level_(-1) {
     
     // Initialize default colors
     color_idle_ = lv_color_hex(0x808080);      // Grey
@@ -33,11 +70,19 @@ UIController::UIController()
     color_streaming_ = lv_color_hex(0x00FF80);  // Green
     color_error_ = lv_color_hex(0xFF4040);      // Red
     color_background_ = lv_color_hex(0x000000); // Black
+    
+    ring_color_ = color_idle_;
+    ring_from_ = color_idle_;
+    ring_to_ = color_idle_;
 }
 
 UIController::~UIController() {
     if (lvgl_task_handle_) {
-        vTaskDelete(lvgl_task_handle_);
+        TaskManager::instance().delete_task(lvgl_task_handle_);
+    }
+    display_manager_.reset();
+    if (lvgl_mutex_) {
+        vSemaphoreDelete(lvgl_mutex_);
     }
 }
 
@@ -46,37 +91,50 @@ ErrorCode UIController::initialize(const UIConfig& config) {
     
     config_ = config;
     
-    // Initialize LVGL (placeholder - actual implementation needed)
+    lvgl_mutex_ = xSemaphoreCreateRecursiveMutex();
+    if (!lvgl_mutex_) {
+        ESP_LOGE(TAG, "Failed to create LVGL mutex");
+        return ErrorCode::MEMORY_ERROR;
+    }
+    
     lv_init();
+    last_tick_us_ = esp_timer_get_time();
+    
+    // Panel, draw buffers and flush path
+    display_manager_ = std::make_unique<DisplayManager>();
+    ErrorCode result = display_manager_->initialize(config);
+    if (result != ErrorCode::SUCCESS) {
+        ESP_LOGE(TAG, "Failed to initialize display: %d", (int)result);
+        display_manager_.reset();
+        return ErrorCode::DISPLAY_FAILED;
+    }
+    display_ = display_manager_->get_display();
+    
+    // Create UI elements before the task starts rendering them
+    create_ui_elements();
+    
+    initialized_ = true;
+    current_brightness_ = config.brightness;
     
     // Create LVGL task
-    BaseType_t result = xTaskCreatePinnedToCore(
-        lvgl_task_wrapper,
+    result = TaskManager::instance().create_task(
         "lvgl_task",
-        6144,  // Stack size
+        lvgl_task_wrapper,
         this,
+        6144,  // Stack size
         5,     // Priority
-        &lvgl_task_handle_,
-        1      // Core 1
+        1,     // Core 1
+        &lvgl_task_handle_
     );
     
-    if (result != pdPASS) {
+    if (result != ErrorCode::SUCCESS) {
         ESP_LOGE(TAG, "Failed to create LVGL task");
+        initialized_ = false;
         return ErrorCode::DISPLAY_FAILED;
     }
     
-    // Initialize display driver (placeholder)
-    // In real implementation, this would configure the SPI display
-    display_ = reinterpret_cast<lv_disp_t*>(0x12345678); // Placeholder
-    
-    // Create UI elements
-    create_ui_elements();
-    
-    initialized_ = true;
-    current_brightness_ = config.brightness;
-    
     ESP_LOGI(TAG, "UI controller initialized successfully");
-    ESP_LOGI(TAG, "Display: %dx%d, Brightness: %d%%", 
+    ESP_LOGI(TAG, "Display: %dx%d, Brightness: %d%%",
             config.display_width, config.display_height, config.brightness);
     
     return ErrorCode::SUCCESS;
@@ -86,7 +144,7 @@ void UIController::show_system_state(SystemState state) {
     if (!initialized_) return;
     
     current_state_ = state;
-    last_activity_time_ = xTaskGetTickCount();
+    wake_screen();
     
     // Update state ring color
     lv_color_t ring_color;
@@ -97,6 +155,7 @@ void UIController::show_system_state(SystemState state) {
         case SystemState::STREAMING:
             ring_color = color_streaming_;
             break;
+        case SystemState::ARBITRATING:
         case SystemState::COOLDOWN:
             ring_color = color_listening_;
             break;
@@ -125,7 +184,7 @@ void UIController::show_wake_word_trigger(const std::string& keyword) {
     // Pulse the ring
     pulse_ring(color_listening_, 1000);
     
-    last_activity_time_ = xTaskGetTickCount();
+    wake_screen();
 }
 
 void UIController::show_error_message(const std::string& message) {
@@ -133,18 +192,22 @@ void UIController::show_error_message(const std::string& message) {
     
     ESP_LOGW(TAG, "Showing error message: %s", message.c_str());
     
-    // Show error popup (placeholder implementation)
-    show_keyword_popup("ERROR", 2000);
+    show_keyword_popup(message, 2000);
     set_ring_color(color_error_, 500);
     
-    last_activity_time_ = xTaskGetTickCount();
+    wake_screen();
 }
 
 void UIController::update_clock(uint8_t hour, uint8_t minute) {
     if (!initialized_ || !clock_label_) return;
     
-    // Update clock display (placeholder)
-    // lv_label_set_text_fmt(clock_label_, "%02d:%02d", hour, minute);
+    const int minute_of_day = hour * 60 + minute;
+    if (minute_of_day == shown_minute_of_day_) return;
+    shown_minute_of_day_ = minute_of_day;
+    
+    lock();
+    lv_label_set_text_fmt(clock_label_, "%02d:%02d", hour, minute);
+    unlock();
     
     ESP_LOGD(TAG, "Clock updated: %02d:%02d", hour, minute);
 }
@@ -152,31 +215,38 @@ void UIController::update_clock(uint8_t hour, uint8_t minute) {
 void UIController::update_temperature(float celsius, bool is_stale) {
     if (!initialized_ || !temperature_label_) return;
     
-    // Update temperature display (placeholder)
+    const int degrees = static_cast<int>(lroundf(celsius));
+    if (is_stale == shown_temperature_stale_ && (is_stale || degrees == shown_temperature_)) return;
+    shown_temperature_ = degrees;
+    shown_temperature_stale_ = is_stale;
+    
+    lock();
     if (is_stale) {
-        // lv_label_set_text(temperature_label_, "⛅ -- °C");
+        lv_label_set_text(temperature_label_, "-- C");
         ESP_LOGD(TAG, "Temperature updated: stale");
     } else {
-        // lv_label_set_text_fmt(temperature_label_, "⛅ %.0f °C", celsius);
+        lv_label_set_text_fmt(temperature_label_, "%d C", degrees);
         ESP_LOGD(TAG, "Temperature updated: %.1f°C", celsius);
     }
+    unlock();
 }
 
 void UIController::update_wifi_status(int rssi_dbm, const std::string& ip_address) {
     if (!initialized_ || !wifi_status_label_) return;
     
-    // Determine WiFi signal strength
-    lv_color_t signal_color;
-    if (rssi_dbm >= -65) {
-        signal_color = lv_color_hex(0x00FF00);  // Green
-    } else if (rssi_dbm >= -80) {
-        signal_color = lv_color_hex(0xFFFF00);  // Yellow
-    } else {
-        signal_color = lv_color_hex(0xFF0000);  // Red
-    }
+    // Determine WiFi signal strength; the icon only changes with the level
+    const int level = signal_level(rssi_dbm);
     
-    // Update WiFi status display (placeholder)
-    // lv_label_set_text_fmt(wifi_status_label_, "WiFi %d dBm", rssi_dbm);
+    lock();
+    if (level != shown_signal_level_) {
+        shown_signal_level_ = level;
+        lv_obj_set_style_text_color(wifi_icon_, lv_color_hex(kSignalColors[level]), 0);
+    }
+    if (config_.show_debug_info && rssi_dbm != shown_rssi_) {
+        shown_rssi_ = rssi_dbm;
+        lv_label_set_text_fmt(wifi_status_label_, "%d dBm", rssi_dbm);
+    }
+    unlock();
     
     ESP_LOGD(TAG, "WiFi status updated: %d dBm, IP: %s", rssi_dbm, ip_address.c_str());
 }
@@ -184,16 +254,18 @@ void UIController::update_wifi_status(int rssi_dbm, const std::string& ip_addres
 void UIController::show_ota_progress(int percentage) {
     if (!initialized_) return;
     
+    lock();
     if (!ota_progress_visible_) {
         ota_progress_visible_ = true;
-        // Show OTA progress bar (placeholder)
+        lv_obj_clear_flag(ota_progress_bar_, LV_OBJ_FLAG_HIDDEN);
         ESP_LOGI(TAG, "OTA progress started");
     }
     
-    last_ota_percentage_ = percentage;
-    
-    // Update progress bar (placeholder)
-    // lv_bar_set_value(ota_progress_bar_, percentage, LV_ANIM_ON);
+    if (percentage != last_ota_percentage_) {
+        last_ota_percentage_ = percentage;
+        lv_bar_set_value(ota_progress_bar_, percentage, LV_ANIM_OFF);
+    }
+    unlock();
     
     ESP_LOGD(TAG, "OTA progress: %d%%", percentage);
 }
@@ -203,27 +275,47 @@ void UIController::hide_ota_progress() {
     
     ota_progress_visible_ = false;
     
-    // Hide progress bar (placeholder)
+    lock();
+    lv_obj_add_flag(ota_progress_bar_, LV_OBJ_FLAG_HIDDEN);
+    unlock();
     ESP_LOGI(TAG, "OTA progress hidden");
 }
 
 void UIController::set_brightness(uint8_t percentage) {
     current_brightness_ = percentage;
     
-    // Set display backlight (placeholder - would control GPIO)
+    // A sleeping screen comes back at the new level
+    if (display_manager_ && !screen_asleep_.load(std::memory_order_relaxed)) {
+        lock();
+        display_manager_->set_backlight(percentage);
+        unlock();
+    }
     ESP_LOGD(TAG, "Brightness set to: %d%%", percentage);
 }
 
 void UIController::enable_screen_timeout(bool enable) {
     screen_timeout_enabled_ = enable;
+    if (!enable) {
+        wake_screen();
+    }
     ESP_LOGD(TAG, "Screen timeout %s", enable ? "enabled" : "disabled");
 }
 
 void UIController::wake_screen() {
     last_activity_time_ = xTaskGetTickCount();
     
-    // Wake up display if sleeping (placeholder)
-    ESP_LOGD(TAG, "Screen woken up");
+    // The LVGL task turns the panel back on
+    wake_requested_.store(true, std::memory_order_release);
+    if (lvgl_task_handle_ && xTaskGetCurrentTaskHandle() != lvgl_task_handle_) {
+        xTaskNotifyGive(lvgl_task_handle_);
+    }
+}
+
+void IRAM_ATTR UIController::wake_screen_from_isr(BaseType_t* higher_priority_task_woken) {
+    wake_requested_.store(true, std::memory_order_release);
+    if (lvgl_task_handle_) {
+        vTaskNotifyGiveFromISR(lvgl_task_handle_, higher_priority_task_woken);
+    }
 }
 
 void UIController::set_touch_callback(TouchCallback callback) {
@@ -237,8 +329,17 @@ void UIController::set_button_callback(ButtonCallback callback) {
 void UIController::set_ring_color(lv_color_t color, uint32_t animation_duration_ms) {
     if (!initialized_ || !state_ring_) return;
     
-    // Animate ring color change (placeholder)
-    // lv_obj_set_style_arc_color(state_ring_, color, LV_PART_INDICATOR);
+    lock();
+    lv_anim_del(this, ring_color_anim_callback);
+    ring_from_ = ring_color_;
+    ring_to_ = color;
+    if (animation_duration_ms == 0) {
+        ring_color_anim_callback(this, LV_OPA_COVER);
+    } else {
+        lv_anim_set_time(&ring_anim_, animation_duration_ms);
+        lv_anim_start(&ring_anim_);
+    }
+    unlock();
     
     ESP_LOGD(TAG, "Ring color changed with %u ms animation", animation_duration_ms);
 }
@@ -246,24 +347,55 @@ void UIController::set_ring_color(lv_color_t color, uint32_t animation_duration_
 void UIController::pulse_ring(lv_color_t color, uint32_t duration_ms) {
     if (!initialized_ || !state_ring_) return;
     
-    // Create pulsing animation (placeholder)
+    lock();
+    set_ring_color(color, 150);
+    
+    // Fade down and back every 500 ms for the duration
+    lv_anim_del(this, ring_opa_anim_callback);
+    lv_anim_set_repeat_count(&pulse_anim_, duration_ms > 500 ? duration_ms / 500 : 1);
+    lv_anim_start(&pulse_anim_);
+    unlock();
+    
     ESP_LOGD(TAG, "Ring pulsing for %u ms", duration_ms);
 }
 
 void UIController::show_keyword_popup(const std::string& keyword, uint32_t duration_ms) {
-    if (!initialized_) return;
+    if (!initialized_ || !keyword_popup_) return;
+    
+    lock();
+    lv_label_set_text(keyword_popup_, keyword.c_str());
+    lv_obj_clear_flag(keyword_popup_, LV_OBJ_FLAG_HIDDEN);
+    
+    // One-shot hide; a popup shown meanwhile restarts it
+    if (popup_timer_) {
+        lv_timer_set_period(popup_timer_, duration_ms);
+        lv_timer_reset(popup_timer_);
+    } else {
+        popup_timer_ = lv_timer_create(popup_timer_callback, duration_ms, this);
+        lv_timer_set_repeat_count(popup_timer_, 1);
+    }
+    unlock();
     
-    // Create/update keyword popup (placeholder)
     ESP_LOGD(TAG, "Keyword popup: '%s' for %u ms", keyword.c_str(), duration_ms);
 }
 
 void UIController::apply_dark_theme() {
     color_background_ = lv_color_hex(0x000000);
+    if (screen_) {
+        lock();
+        lv_obj_set_style_bg_color(screen_, color_background_, 0);
+        unlock();
+    }
     ESP_LOGI(TAG, "Dark theme applied");
 }
 
 void UIController::apply_light_theme() {
     color_background_ = lv_color_hex(0xFFFFFF);
+    if (screen_) {
+        lock();
+        lv_obj_set_style_bg_color(screen_, color_background_, 0);
+        unlock();
+    }
     ESP_LOGI(TAG, "Light theme applied");
 }
 
@@ -271,6 +403,11 @@ void UIController::set_custom_colors(lv_color_t primary, lv_color_t secondary, l
     color_listening_ = primary;
     color_streaming_ = secondary;
     color_background_ = background;
+    if (screen_) {
+        lock();
+        lv_obj_set_style_bg_color(screen_, color_background_, 0);
+        unlock();
+    }
     ESP_LOGI(TAG, "Custom colors applied");
 }
 
@@ -278,50 +415,274 @@ void UIController::lvgl_task_wrapper(void* arg) {
     static_cast<UIController*>(arg)->update_animations();
 }
 
+// Also brings the LVGL tick up to date, so animations started here time correctly
+void UIController::lock() {
+    xSemaphoreTakeRecursive(lvgl_mutex_, portMAX_DELAY);
+    
+    const int64_t now_us = esp_timer_get_time();
+    const uint32_t elapsed_ms = static_cast<uint32_t>((now_us - last_tick_us_) / 1000);
+    if (elapsed_ms > 0) {
+        lv_tick_inc(elapsed_ms);
+        last_tick_us_ += static_cast<int64_t>(elapsed_ms) * 1000;
+    }
+}
+
+// From another task: whatever it changed gets rendered now, not at the next idle wake
+void UIController::unlock() {
+    xSemaphoreGiveRecursive(lvgl_mutex_);
+    if (lvgl_task_handle_ && xTaskGetCurrentTaskHandle() != lvgl_task_handle_) {
+        xTaskNotifyGive(lvgl_task_handle_);
+    }
+}
+
 void UIController::create_ui_elements() {
     ESP_LOGI(TAG, "Creating UI elements...");
     
-    // Create main screen (placeholder)
-    screen_ = reinterpret_cast<lv_obj_t*>(0x12345678);
-    
-    // Create state ring (placeholder)
-    state_ring_ = reinterpret_cast<lv_obj_t*>(0x12345679);
-    
-    // Create labels (placeholder)
-    clock_label_ = reinterpret_cast<lv_obj_t*>(0x1234567A);
-    temperature_label_ = reinterpret_cast<lv_obj_t*>(0x1234567B);
-    wifi_status_label_ = reinterpret_cast<lv_obj_t*>(0x1234567C);
-    
-    // Create progress bar (placeholder)
-    ota_progress_bar_ = reinterpret_cast<lv_obj_t*>(0x1234567D);
+    // Main screen: the round panel's background
+    screen_ = lv_disp_get_scr_act(display_);
+    lv_obj_clear_flag(screen_, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_bg_color(screen_, color_background_, 0);
+    lv_obj_set_style_bg_opa(screen_, LV_OPA_COVER, 0);
+    
+    create_state_ring();
+    create_clock_label();
+    create_temperature_label();
+    create_wifi_status();
+    create_ota_progress_bar();
+    
+    // Keyword popup, hidden until a wake word
+    keyword_popup_ = lv_label_create(screen_);
+    lv_label_set_text(keyword_popup_, "");
+    lv_obj_set_style_text_color(keyword_popup_, lv_color_white(), 0);
+    lv_obj_align(keyword_popup_, LV_ALIGN_CENTER, 0, 90);
+    lv_obj_add_flag(keyword_popup_, LV_OBJ_FLAG_HIDDEN);
     
     ESP_LOGI(TAG, "UI elements created");
 }
 
+void UIController::create_state_ring() {
+    // A bare full-screen object: lv_arc would invalidate all of it per change
+    state_ring_ = lv_obj_create(screen_);
+    lv_obj_remove_style_all(state_ring_);
+    lv_obj_set_size(state_ring_, config_.display_width, config_.display_height);
+    lv_obj_center(state_ring_);
+    lv_obj_clear_flag(state_ring_, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(state_ring_, ring_draw_callback, LV_EVENT_DRAW_MAIN, this);
+    
+    compute_ring_segments();
+    
+    // Colour fade: 0..255 mixes ring_from_ into ring_to_
+    lv_anim_init(&ring_anim_);
+    lv_anim_set_var(&ring_anim_, this);
+    lv_anim_set_exec_cb(&ring_anim_, ring_color_anim_callback);
+    lv_anim_set_values(&ring_anim_, LV_OPA_TRANSP, LV_OPA_COVER);
+    lv_anim_set_time(&ring_anim_, 300);
+    
+    // Pulse: opacity down and back
+    lv_anim_init(&pulse_anim_);
+    lv_anim_set_var(&pulse_anim_, this);
+    lv_anim_set_exec_cb(&pulse_anim_, ring_opa_anim_callback);
+    lv_anim_set_values(&pulse_anim_, LV_OPA_COVER, LV_OPA_30);
+    lv_anim_set_time(&pulse_anim_, 250);
+    lv_anim_set_playback_time(&pulse_anim_, 250);
+}
+
+void UIController::create_clock_label() {
+    clock_label_ = lv_label_create(screen_);
+    lv_label_set_text(clock_label_, "--:--");
+#if LV_FONT_MONTSERRAT_48
+    lv_obj_set_style_text_font(clock_label_, &lv_font_montserrat_48, 0);
+#endif
+    lv_obj_set_style_text_color(clock_label_, lv_color_white(), 0);
+    lv_obj_align(clock_label_, LV_ALIGN_CENTER, 0, -20);
+}
+
+void UIController::create_temperature_label() {
+    temperature_label_ = lv_label_create(screen_);
+    lv_label_set_text(temperature_label_, "");
+    lv_obj_set_style_text_color(temperature_label_, lv_color_hex(0xC0C0C0), 0);
+    lv_obj_align(temperature_label_, LV_ALIGN_CENTER, 0, 40);
+}
+
+void UIController::create_wifi_status() {
+    wifi_icon_ = lv_label_create(screen_);
+    lv_label_set_text(wifi_icon_, LV_SYMBOL_WIFI);
+    lv_obj_set_style_text_color(wifi_icon_, color_idle_, 0);
+    lv_obj_align(wifi_icon_, LV_ALIGN_TOP_MID, 0, 40);
+    
+    // RSSI text only with debug info: it changes on nearly every report
+    wifi_status_label_ = lv_label_create(screen_);
+    lv_label_set_text(wifi_status_label_, "");
+    lv_obj_set_style_text_color(wifi_status_label_, lv_color_hex(0x808080), 0);
+    lv_obj_align(wifi_status_label_, LV_ALIGN_TOP_MID, 0, 66);
+    if (!config_.show_debug_info) {
+        lv_obj_add_flag(wifi_status_label_, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+void UIController::create_ota_progress_bar() {
+    ota_progress_bar_ = lv_bar_create(screen_);
+    lv_obj_set_size(ota_progress_bar_, 160, 8);
+    lv_bar_set_range(ota_progress_bar_, 0, 100);
+    lv_obj_align(ota_progress_bar_, LV_ALIGN_BOTTOM_MID, 0, -60);
+    lv_obj_add_flag(ota_progress_bar_, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Bounding box of each RING_SEGMENTS-th of the annulus; the ends of every
+// sector are its extremes, as the axes fall on sector boundaries
+void UIController::compute_ring_segments() {
+    static_assert(RING_SEGMENTS % 4 == 0, "Axes must fall on segment boundaries");
+    
+    const float cx = config_.display_width / 2.0f;
+    const float cy = config_.display_height / 2.0f;
+    const float outer = std::min(cx, cy) - RING_MARGIN;
+    const float inner = outer - RING_WIDTH;
+    constexpr float kStep = 2.0f * static_cast<float>(M_PI) / RING_SEGMENTS;
+    
+    for (size_t i = 0; i < RING_SEGMENTS; i++) {
+        float x_min = cx, x_max = cx, y_min = cy, y_max = cy;
+        bool first = true;
+        for (float angle : {i * kStep, (i + 1) * kStep}) {
+            for (float radius : {inner, outer}) {
+                const float x = cx + radius * cosf(angle);
+                const float y = cy + radius * sinf(angle);
+                x_min = first ? x : std::min(x_min, x);
+                x_max = first ? x : std::max(x_max, x);
+                y_min = first ? y : std::min(y_min, y);
+                y_max = first ? y : std::max(y_max, y);
+                first = false;
+            }
+        }
+        // One pixel of slack for antialiasing
+        ring_segments_[i].x1 = static_cast<lv_coord_t>(floorf(x_min)) - 1;
+        ring_segments_[i].y1 = static_cast<lv_coord_t>(floorf(y_min)) - 1;
+        ring_segments_[i].x2 = static_cast<lv_coord_t>(ceilf(x_max)) + 1;
+        ring_segments_[i].y2 = static_cast<lv_coord_t>(ceilf(y_max)) + 1;
+    }
+}
+
+void UIController::invalidate_ring() {
+    for (const lv_area_t& segment : ring_segments_) {
+        lv_obj_invalidate_area(state_ring_, &segment);
+    }
+}
+
 void UIController::update_animations() {
     ESP_LOGI(TAG, "LVGL task started");
     
-    TickType_t last_wake_time = xTaskGetTickCount();
-    const TickType_t update_period = pdMS_TO_TICKS(50); // 50ms = 20 FPS
+    bool backlight_pending = false;
     
     while (true) {
-        // Update LVGL (placeholder)
-        // lv_timer_handler();
-        
-        // Handle screen timeout
-        if (screen_timeout_enabled_) {
-            TickType_t current_time = xTaskGetTickCount();
-            uint32_t idle_time = (current_time - last_activity_time_) * portTICK_PERIOD_MS;
-            
-            if (idle_time >= config_.idle_timeout_ms) {
-                // Screen should timeout (placeholder)
+        if (wake_requested_.exchange(false, std::memory_order_acquire)) {
+            last_activity_time_ = xTaskGetTickCount();
+            if (screen_asleep_.load(std::memory_order_relaxed)) {
+                // Changes made while asleep are rendered before the light comes on
+                screen_asleep_.store(false, std::memory_order_relaxed);
+                backlight_pending = true;
+                ESP_LOGD(TAG, "Screen woken up");
             }
         }
         
-        vTaskDelayUntil(&last_wake_time, update_period);
+        if (screen_asleep_.load(std::memory_order_relaxed)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        
+        // Render whatever was invalidated since the last pass
+        lock();
+        const uint32_t until_next_timer_ms = lv_timer_handler();
+        const bool rendering = lv_anim_count_running() > 0 || display_->inv_p > 0;
+        if (backlight_pending && display_->inv_p == 0) {
+            display_manager_->set_backlight(current_brightness_);
+            backlight_pending = false;
+        }
+        const uint32_t wait_ms = next_wait_ms(rendering, until_next_timer_ms);
+        unlock();
+        
+        if (wait_ms == 0) {
+            sleep_screen();
+            continue;
+        }
+        
+        // Any update from another task ends the wait early
+        ulTaskNotifyTake(pdTRUE, std::max<TickType_t>(1, pdMS_TO_TICKS(wait_ms)));
     }
 }
 
+// How long the LVGL task may block; 0 to put the screen to sleep
+uint32_t UIController::next_wait_ms(bool rendering, uint32_t until_next_timer_ms) {
+    if (rendering) {
+        return std::max<uint32_t>(1, until_next_timer_ms);
+    }
+    
+    uint32_t wait_ms = kIdlePeriodMs;
+    if (popup_timer_) {
+        const uint32_t since_run = lv_tick_elaps(popup_timer_->last_run);
+        wait_ms = std::min(wait_ms, since_run < popup_timer_->period ? popup_timer_->period - since_run : 1);
+    }
+    
+    // Screen timeout, only on the idle screen
+    const bool idle_screen = current_state_ == SystemState::IDLE_LISTENING && !ota_progress_visible_;
+    if (screen_timeout_enabled_ && config_.idle_timeout_ms > 0 && idle_screen) {
+        const uint32_t idle_time = (xTaskGetTickCount() - last_activity_time_) * portTICK_PERIOD_MS;
+        if (idle_time >= config_.idle_timeout_ms) {
+            return 0;
+        }
+        wait_ms = std::min(wait_ms, config_.idle_timeout_ms - idle_time);
+    } else if (!idle_screen) {
+        last_activity_time_ = xTaskGetTickCount();
+    }
+    return wait_ms;
+}
+
+void UIController::sleep_screen() {
+    lock();
+    display_manager_->set_backlight(0);
+    unlock();
+    screen_asleep_.store(true, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Screen off after %u ms idle", config_.idle_timeout_ms);
+}
+
+void UIController::ring_draw_callback(lv_event_t* event) {
+    UIController* self = static_cast<UIController*>(lv_event_get_user_data(event));
+    lv_obj_t* ring = lv_event_get_target(event);
+    
+    lv_area_t coords;
+    lv_obj_get_coords(ring, &coords);
+    lv_point_t center;
+    center.x = coords.x1 + lv_area_get_width(&coords) / 2;
+    center.y = coords.y1 + lv_area_get_height(&coords) / 2;
+    const lv_coord_t radius = std::min(lv_area_get_width(&coords), lv_area_get_height(&coords)) / 2 - RING_MARGIN;
+    
+    lv_draw_arc_dsc_t arc;
+    lv_draw_arc_dsc_init(&arc);
+    arc.color = self->ring_color_;
+    arc.opa = self->ring_opa_;
+    arc.width = RING_WIDTH;
+    arc.rounded = 0;
+    // Clipped to the area being rendered
+    lv_draw_arc(lv_event_get_draw_ctx(event), &arc, &center, radius, 0, 360);
+}
+
+void UIController::ring_color_anim_callback(void* var, int32_t value) {
+    UIController* self = static_cast<UIController*>(var);
+    self->ring_color_ = lv_color_mix(self->ring_to_, self->ring_from_, static_cast<lv_opa_t>(value));
+    self->invalidate_ring();
+}
+
+void UIController::ring_opa_anim_callback(void* var, int32_t value) {
+    UIController* self = static_cast<UIController*>(var);
+    self->ring_opa_ = static_cast<lv_opa_t>(value);
+    self->invalidate_ring();
+}
+
+void UIController::popup_timer_callback(lv_timer_t* timer) {
+    UIController* self = static_cast<UIController*>(timer->user_data);
+    lv_obj_add_flag(self->keyword_popup_, LV_OBJ_FLAG_HIDDEN);
+    // Last repeat: LVGL deletes the timer after this returns
+    self->popup_timer_ = nullptr;
+}
+
 void UIController::touch_event_callback(lv_event_t* event) {
     // Handle touch events (placeholder)
 }
@@ -345,4 +706,4 @@ void UIController::handle_button_event(int button_id, bool pressed) {
     ESP_LOGD(TAG, "Button %d %s", button_id, pressed ? "pressed" : "released");
 }
 
-} // namespace irene 
\ No newline at end of file
+} // namespace irene
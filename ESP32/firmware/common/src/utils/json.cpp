@@ -0,0 +1,339 @@
+#include "utils/json.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace irene {
+
+namespace {
+
+const char* skip_whitespace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+// p at the opening quote; returns the closing quote, or nullptr
+const char* find_string_end(const char* p, const char* end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// p at '{' or '['; returns one past the matching bracket, or nullptr
+const char* skip_container(const char* p, const char* end) {
+    size_t depth = 0;
+    for (; p < end; p++) {
+        switch (*p) {
+            case '"':
+                p = find_string_end(p, end);
+                if (!p) {
+                    return nullptr;
+                }
+                break;
+            case '{':
+            case '[':
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) {
+                    return p + 1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return nullptr;
+}
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool match_literal(const char* p, const char* end, const char* literal) {
+    const size_t length = std::strlen(literal);
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, literal, length) == 0;
+}
+
+// Value starting at p (no leading whitespace); returns one past it, or nullptr
+const char* parse_value(const char* p, const char* end, JsonValue& value) {
+    if (p >= end) {
+        return nullptr;
+    }
+
+    const char* next = nullptr;
+    switch (*p) {
+        case '{':
+        case '[':
+            next = skip_container(p, end);
+            if (next) {
+                value = JsonValue(*p == '{' ? JsonValue::Type::OBJECT : JsonValue::Type::ARRAY,
+                                  std::string_view(p, next - p));
+            }
+            return next;
+        case '"':
+            next = find_string_end(p, end);
+            if (!next) {
+                return nullptr;
+            }
+            value = JsonValue(JsonValue::Type::STRING, std::string_view(p + 1, next - p - 1));
+            return next + 1;
+        case 't':
+        case 'f':
+        case 'n': {
+            const char* literal = *p == 't' ? "true" : (*p == 'f' ? "false" : "null");
+            if (!match_literal(p, end, literal)) {
+                return nullptr;
+            }
+            const size_t length = std::strlen(literal);
+            value = JsonValue(*p == 'n' ? JsonValue::Type::NUL : JsonValue::Type::BOOL,
+                              std::string_view(p, length));
+            return p + length;
+        }
+        default:
+            next = p;
+            while (next < end && is_number_char(*next)) {
+                next++;
+            }
+            if (next == p) {
+                return nullptr;
+            }
+            value = JsonValue(JsonValue::Type::NUMBER, std::string_view(p, next - p));
+            return next;
+    }
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+    : buffer_(buffer)
+    , capacity_(buffer ? capacity : 0)
+    , length_(0)
+    , depth_(0)
+    , first_{}
+    , ok_(buffer_ && capacity_ > 0) {
+    first_[0] = true;
+    if (ok_) {
+        buffer_[0] = '\0';
+    }
+}
+
+void JsonWriter::put(char c) {
+    // Always leave room for the terminator
+    if (!ok_ || length_ + 1 >= capacity_) {
+        ok_ = false;
+        return;
+    }
+    buffer_[length_++] = c;
+    buffer_[length_] = '\0';
+}
+
+void JsonWriter::put(std::string_view text) {
+    if (!ok_ || length_ + text.size() >= capacity_) {
+        ok_ = false;
+        return;
+    }
+    std::memcpy(buffer_ + length_, text.data(), text.size());
+    length_ += text.size();
+    buffer_[length_] = '\0';
+}
+
+void JsonWriter::put_escaped(std::string_view text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            put(std::string_view(escaped));
+        } else {
+            put(c);
+        }
+    }
+}
+
+void JsonWriter::separator(const char* key) {
+    if (!first_[depth_]) {
+        put(',');
+    }
+    first_[depth_] = false;
+
+    if (key) {
+        put('"');
+        put_escaped(key);
+        put(std::string_view("\":"));
+    }
+}
+
+JsonWriter& JsonWriter::open(const char* key, char bracket) {
+    if (depth_ == MAX_DEPTH) {
+        ok_ = false;
+        return *this;
+    }
+    separator(key);
+    put(bracket);
+    first_[++depth_] = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::close(char bracket) {
+    if (depth_ == 0) {
+        ok_ = false;
+        return *this;
+    }
+    put(bracket);
+    depth_--;
+    return *this;
+}
+
+JsonWriter& JsonWriter::begin_object(const char* key) { return open(key, '{'); }
+JsonWriter& JsonWriter::end_object() { return close('}'); }
+JsonWriter& JsonWriter::begin_array(const char* key) { return open(key, '['); }
+JsonWriter& JsonWriter::end_array() { return close(']'); }
+
+JsonWriter& JsonWriter::field(const char* key, std::string_view value) {
+    separator(key);
+    put('"');
+    put_escaped(value);
+    put('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, uint64_t value) {
+    char number[24];
+    const int length = std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+    separator(key);
+    put(std::string_view(number, length));
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, int32_t value) {
+    char number[16];
+    const int length = std::snprintf(number, sizeof(number), "%ld", static_cast<long>(value));
+    separator(key);
+    put(std::string_view(number, length));
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, float value, int decimals) {
+    // JSON has no NaN or infinity
+    char number[32];
+    const int length = std::snprintf(number, sizeof(number), "%.*f", decimals,
+                                     std::isfinite(value) ? static_cast<double>(value) : 0.0);
+    separator(key);
+    if (length > 0 && static_cast<size_t>(length) < sizeof(number)) {
+        put(std::string_view(number, length));
+    } else {
+        ok_ = false;
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, bool value) {
+    separator(key);
+    put(std::string_view(value ? "true" : "false"));
+    return *this;
+}
+
+JsonValue JsonValue::operator[](std::string_view key) const {
+    if (type_ != Type::OBJECT) {
+        return JsonValue();
+    }
+
+    const char* p = text_.data() + 1;
+    const char* end = text_.data() + text_.size() - 1;   // Closing brace
+    while (true) {
+        p = skip_whitespace(p, end);
+        if (p >= end || *p != '"') {
+            return JsonValue();
+        }
+
+        JsonValue name;
+        p = parse_value(p, end, name);
+        if (!p) {
+            return JsonValue();
+        }
+        p = skip_whitespace(p, end);
+        if (p >= end || *p != ':') {
+            return JsonValue();
+        }
+
+        JsonValue member;
+        p = parse_value(skip_whitespace(p + 1, end), end, member);
+        if (!p) {
+            return JsonValue();
+        }
+        if (name.text() == key) {
+            return member;
+        }
+
+        p = skip_whitespace(p, end);
+        if (p >= end || *p != ',') {
+            return JsonValue();
+        }
+        p++;
+    }
+}
+
+bool JsonValue::as_uint32(uint32_t& value) const {
+    if (type_ != Type::NUMBER || text_.empty()) {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for (char c : text_) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + static_cast<uint64_t>(c - '0');
+        if (result > UINT32_MAX) {
+            return false;
+        }
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+bool JsonValue::as_float(float& value) const {
+    // strtof needs a terminated copy
+    char number[32];
+    if (type_ != Type::NUMBER || text_.size() >= sizeof(number)) {
+        return false;
+    }
+    std::memcpy(number, text_.data(), text_.size());
+    number[text_.size()] = '\0';
+
+    char* parsed_end = nullptr;
+    value = std::strtof(number, &parsed_end);
+    return parsed_end == number + text_.size();
+}
+
+bool JsonValue::as_bool(bool& value) const {
+    if (type_ != Type::BOOL) {
+        return false;
+    }
+    value = text_ == "true";
+    return true;
+}
+
+JsonValue json_parse(std::string_view message) {
+    const char* end = message.data() + message.size();
+    JsonValue value;
+    if (!parse_value(skip_whitespace(message.data(), end), end, value)) {
+        return JsonValue();
+    }
+    return value;
+}
+
+} // namespace irene
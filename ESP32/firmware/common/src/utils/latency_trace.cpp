@@ -0,0 +1,350 @@
+#include "utils/latency_trace.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/base64.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+static const char* TAG = "LatencyTrace";
+
+namespace irene {
+
+namespace {
+
+static_assert((LatencyTrace::CAPACITY & (LatencyTrace::CAPACITY - 1)) == 0,
+              "Trace capacity must be a power of two");
+static_assert(sizeof(TraceRecord) == 12, "Trace record layout is part of the dump format");
+
+// stamp is sequence + 1 once the slot is complete, 0 while it is written
+struct TraceSlot {
+    std::atomic<uint32_t> stamp;
+    uint32_t time_us;
+    uint16_t arg;
+    uint8_t event;
+    uint8_t core;
+};
+
+TraceSlot s_ring[LatencyTrace::CAPACITY];
+std::atomic<uint32_t> s_head{0};
+std::atomic<bool> s_enabled{true};
+
+constexpr size_t LOG_CHUNK_BYTES = 96;  // 128 base64 characters per line
+
+struct StageDefinition {
+    TraceEvent from;
+    TraceEvent to;
+    const char* name;
+};
+
+// Indexed by TraceStage
+constexpr StageDefinition STAGES[] = {
+    {TraceEvent::I2S_FRAME_READY, TraceEvent::MFCC_FRAME_READY, "capture->mfcc"},
+    {TraceEvent::MFCC_FRAME_READY, TraceEvent::INFERENCE_START, "mfcc->inference"},
+    {TraceEvent::INFERENCE_START, TraceEvent::INFERENCE_END, "inference"},
+    {TraceEvent::WAKE_CONFIRMED, TraceEvent::SESSION_START, "wake->session"},
+    {TraceEvent::SESSION_START, TraceEvent::FIRST_UPLINK_FRAME, "session->first audio"},
+    {TraceEvent::WAKE_CONFIRMED, TraceEvent::FIRST_UPLINK_FRAME, "wake->first audio"},
+    {TraceEvent::FIRST_UPLINK_FRAME, TraceEvent::EOF_SENT, "first audio->eof"},
+};
+constexpr size_t STAGE_COUNT = static_cast<size_t>(TraceStage::COUNT);
+static_assert(sizeof(STAGES) / sizeof(STAGES[0]) == STAGE_COUNT, "One definition per stage");
+
+// Log-linear histogram: 4 buckets per power of two, 0 us .. 2^32 us
+constexpr size_t HISTOGRAM_BUCKETS = 128;
+
+struct StageHistogram {
+    std::atomic<uint32_t> start_us;
+    std::atomic<bool> started;
+    std::atomic<uint32_t> count;
+    std::atomic<uint32_t> max_us;
+    std::atomic<uint32_t> buckets[HISTOGRAM_BUCKETS];
+};
+
+StageHistogram s_stages[STAGE_COUNT];
+
+size_t bucket_index(uint32_t value) {
+    if (value < 4) {
+        return value;
+    }
+    const int msb = 31 - __builtin_clz(value);
+    return (msb - 1) * 4 + ((value >> (msb - 2)) & 3);
+}
+
+uint32_t bucket_upper(size_t index) {
+    if (index < 4) {
+        return index;
+    }
+    const int msb = index / 4 + 1;
+    const uint64_t lower = static_cast<uint64_t>(4 + index % 4) << (msb - 2);
+    return static_cast<uint32_t>(std::min<uint64_t>(lower + (1ull << (msb - 2)) - 1, UINT32_MAX));
+}
+
+void add_sample(StageHistogram& stage, uint32_t duration_us) {
+    stage.buckets[bucket_index(duration_us)].fetch_add(1, std::memory_order_relaxed);
+    stage.count.fetch_add(1, std::memory_order_relaxed);
+    
+    uint32_t current = stage.max_us.load(std::memory_order_relaxed);
+    while (duration_us > current &&
+           !stage.max_us.compare_exchange_weak(current, duration_us, std::memory_order_relaxed)) {
+    }
+}
+
+void update_stages(TraceEvent event, uint32_t now_us) {
+    // Close before open: FIRST_UPLINK_FRAME ends one stage and starts another
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        StageHistogram& stage = s_stages[i];
+        if (STAGES[i].to == event && stage.started.exchange(false, std::memory_order_acq_rel)) {
+            add_sample(stage, now_us - stage.start_us.load(std::memory_order_relaxed));
+        }
+    }
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        StageHistogram& stage = s_stages[i];
+        if (STAGES[i].from == event) {
+            stage.start_us.store(now_us, std::memory_order_relaxed);
+            stage.started.store(true, std::memory_order_release);
+        }
+    }
+}
+
+uint32_t histogram_percentile(const uint32_t* buckets, uint32_t count, uint32_t pct) {
+    // Nearest rank
+    const uint64_t rank = std::max<uint64_t>((static_cast<uint64_t>(count) * pct + 99) / 100, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_upper(i);
+        }
+    }
+    return bucket_upper(HISTOGRAM_BUCKETS - 1);
+}
+
+void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xff;
+    out[1] = value >> 8;
+}
+
+void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+} // namespace
+
+void LatencyTrace::record(TraceEvent event, uint16_t arg) {
+    if (!s_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const uint32_t sequence = s_head.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot& slot = s_ring[sequence & (CAPACITY - 1)];
+
+    const uint32_t now_us = static_cast<uint32_t>(esp_timer_get_time());
+
+    slot.stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.time_us = now_us;
+    slot.arg = arg;
+    slot.event = static_cast<uint8_t>(event);
+    slot.core = static_cast<uint8_t>(xPortGetCoreID());
+    slot.stamp.store(sequence + 1, std::memory_order_release);
+
+    update_stages(event, now_us);
+}
+
+void LatencyTrace::set_enabled(bool enable) {
+    s_enabled.store(enable, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Latency tracing %s", enable ? "enabled" : "disabled");
+}
+
+bool LatencyTrace::is_enabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void LatencyTrace::clear() {
+    // Records older than the head no longer match their expected stamp
+    for (TraceSlot& slot : s_ring) {
+        slot.stamp.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyTrace::snapshot(TraceRecord* records, size_t max_records) {
+    if (!records || max_records == 0) {
+        return 0;
+    }
+
+    const uint32_t head = s_head.load(std::memory_order_acquire);
+    const uint32_t available = std::min<uint32_t>(head, CAPACITY);
+    const uint32_t wanted = std::min<uint32_t>(available, max_records);
+
+    size_t count = 0;
+    for (uint32_t sequence = head - wanted; sequence != head; sequence++) {
+        const TraceSlot& slot = s_ring[sequence & (CAPACITY - 1)];
+        if (slot.stamp.load(std::memory_order_acquire) != sequence + 1) {
+            continue;  // Being written, or already overwritten
+        }
+
+        TraceRecord& out = records[count];
+        out.time_us = slot.time_us;
+        out.sequence = sequence;
+        out.arg = slot.arg;
+        out.event = slot.event;
+        out.core = slot.core;
+
+        // Keep the copy only if no writer took the slot meanwhile
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) == sequence + 1) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+size_t LatencyTrace::serialize(uint8_t* buffer, size_t capacity) {
+    if (!buffer || capacity < HEADER_BYTES) {
+        return 0;
+    }
+
+    const size_t max_records = std::min(CAPACITY, (capacity - HEADER_BYTES) / sizeof(TraceRecord));
+    std::unique_ptr<TraceRecord[]> records(new (std::nothrow) TraceRecord[max_records]);
+    if (!records) {
+        return 0;
+    }
+
+    const int64_t now_us = esp_timer_get_time();
+    const size_t count = snapshot(records.get(), max_records);
+
+    // Header: magic, version, record size, count, dump time
+    std::memcpy(buffer, "IRTR", 4);
+    buffer[4] = FORMAT_VERSION;
+    buffer[5] = sizeof(TraceRecord);
+    put_u16(buffer + 6, static_cast<uint16_t>(count));
+    put_u32(buffer + 8, static_cast<uint32_t>(now_us));
+    put_u32(buffer + 12, static_cast<uint32_t>(static_cast<uint64_t>(now_us) >> 32));
+
+    uint8_t* out = buffer + HEADER_BYTES;
+    for (size_t i = 0; i < count; i++, out += sizeof(TraceRecord)) {
+        put_u32(out, records[i].time_us);
+        put_u32(out + 4, records[i].sequence);
+        put_u16(out + 8, records[i].arg);
+        out[10] = records[i].event;
+        out[11] = records[i].core;
+    }
+
+    return HEADER_BYTES + count * sizeof(TraceRecord);
+}
+
+ErrorCode LatencyTrace::dump(const DumpWriter& writer, size_t chunk_bytes) {
+    if (!writer || chunk_bytes == 0) {
+        return ErrorCode::INIT_FAILED;
+    }
+
+    const size_t capacity = serialized_size();
+    std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[capacity]);
+    if (!buffer) {
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    const size_t length = serialize(buffer.get(), capacity);
+    for (size_t offset = 0; offset < length; offset += chunk_bytes) {
+        if (!writer(buffer.get() + offset, std::min(chunk_bytes, length - offset))) {
+            return ErrorCode::WIFI_FAILED;
+        }
+    }
+
+    return ErrorCode::SUCCESS;
+}
+
+void LatencyTrace::dump_to_log() {
+    // Console lines "TRACE <offset> <base64>"; concatenate to rebuild the dump
+    size_t offset = 0;
+    dump([&offset](const uint8_t* data, size_t length) {
+        unsigned char line[LOG_CHUNK_BYTES * 4 / 3 + 4];
+        size_t written = 0;
+        if (mbedtls_base64_encode(line, sizeof(line), &written, data, length) != 0) {
+            return false;
+        }
+        line[written] = '\0';
+        ESP_LOGI(TAG, "TRACE %u %s", (unsigned)offset, reinterpret_cast<const char*>(line));
+        offset += length;
+        return true;
+    }, LOG_CHUNK_BYTES);
+}
+
+void LatencyTrace::get_stage_stats(TraceStage stage, TraceStageStats& stats) {
+    stats = TraceStageStats();
+    if (stage >= TraceStage::COUNT) {
+        return;
+    }
+
+    const StageHistogram& histogram = s_stages[static_cast<size_t>(stage)];
+    uint32_t buckets[HISTOGRAM_BUCKETS];
+    uint32_t count = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    stats.count = count;
+    stats.p50_us = histogram_percentile(buckets, count, 50);
+    stats.p95_us = histogram_percentile(buckets, count, 95);
+    stats.p99_us = histogram_percentile(buckets, count, 99);
+    stats.max_us = histogram.max_us.load(std::memory_order_relaxed);
+}
+
+void LatencyTrace::reset_stage_stats() {
+    for (StageHistogram& stage : s_stages) {
+        stage.count.store(0, std::memory_order_relaxed);
+        stage.max_us.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint32_t>& bucket : stage.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void LatencyTrace::log_stage_stats() {
+    ESP_LOGI(TAG, "Stage latency (us):");
+    for (size_t i = 0; i < STAGE_COUNT; i++) {
+        TraceStageStats stats;
+        get_stage_stats(static_cast<TraceStage>(i), stats);
+        if (stats.count == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-22s n=%u p50=%u p95=%u p99=%u max=%u", STAGES[i].name,
+                stats.count, stats.p50_us, stats.p95_us, stats.p99_us, stats.max_us);
+    }
+}
+
+const char* LatencyTrace::event_name(TraceEvent event) {
+    switch (event) {
+        case TraceEvent::I2S_FRAME_READY:    return "i2s_frame";
+        case TraceEvent::MFCC_FRAME_READY:   return "mfcc_frame";
+        case TraceEvent::INFERENCE_START:    return "inference_start";
+        case TraceEvent::INFERENCE_END:      return "inference_end";
+        case TraceEvent::WAKE_CONFIRMED:     return "wake_confirmed";
+        case TraceEvent::STATE_TRANSITION:   return "state";
+        case TraceEvent::SESSION_START:      return "session_start";
+        case TraceEvent::TLS_CONNECTED:      return "tls_connected";
+        case TraceEvent::FIRST_UPLINK_FRAME: return "first_uplink";
+        case TraceEvent::EOF_SENT:           return "eof";
+        default:                             return "unknown";
+    }
+}
+
+const char* LatencyTrace::stage_name(TraceStage stage) {
+    return stage < TraceStage::COUNT ? STAGES[static_cast<size_t>(stage)].name : "unknown";
+}
+
+} // namespace irene
@@ -0,0 +1,279 @@
+#include "utils/memory_plan.hpp"
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <algorithm>
+
+static const char* TAG = "MemoryPlan";
+
+namespace irene {
+
+namespace {
+
+constexpr size_t kRegionCount = static_cast<size_t>(MemoryRegion::COUNT);
+
+struct Region {
+    const char* name;
+    uint32_t caps;
+    size_t budget;
+    uint8_t* base;
+    size_t top;                        // Carved so far
+    size_t high_water;
+    uint32_t overflow_count;
+    size_t overflow_bytes;
+};
+
+struct Block {
+    const char* owner;
+    uint32_t offset;
+    uint32_t bytes;
+    uint8_t region;
+    bool in_use;
+};
+
+Region g_regions[kRegionCount] = {
+    {"internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MemoryPlan::INTERNAL_BUDGET, nullptr, 0, 0, 0, 0},
+    {"DMA", MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT, MemoryPlan::DMA_BUDGET, nullptr, 0, 0, 0, 0},
+    {"PSRAM", MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MemoryPlan::PSRAM_BUDGET, nullptr, 0, 0, 0, 0},
+};
+
+// In carve order within each region
+Block g_blocks[MemoryPlan::MAX_BLOCKS];
+size_t g_block_count = 0;
+
+SemaphoreHandle_t g_mutex = nullptr;
+
+size_t round_up(size_t bytes) {
+    return (std::max<size_t>(bytes, 1) + MemoryPlan::ALIGNMENT - 1) & ~(MemoryPlan::ALIGNMENT - 1);
+}
+
+void lock() {
+    if (g_mutex) xSemaphoreTake(g_mutex, portMAX_DELAY);
+}
+
+void unlock() {
+    if (g_mutex) xSemaphoreGive(g_mutex);
+}
+
+// Region index holding ptr, or kRegionCount
+size_t find_region(const void* ptr) {
+    const uint8_t* p = static_cast<const uint8_t*>(ptr);
+    for (size_t r = 0; r < kRegionCount; r++) {
+        const Region& region = g_regions[r];
+        if (region.base && p >= region.base && p < region.base + region.budget) {
+            return r;
+        }
+    }
+    return kRegionCount;
+}
+
+void remove_block(size_t index) {
+    std::copy(g_blocks + index + 1, g_blocks + g_block_count, g_blocks + index);
+    g_block_count--;
+}
+
+// Give free blocks at the top of a region back to it
+void trim_region(size_t r) {
+    Region& region = g_regions[r];
+    bool trimmed = true;
+    while (trimmed) {
+        trimmed = false;
+        for (size_t i = 0; i < g_block_count; i++) {
+            const Block& block = g_blocks[i];
+            if (block.region == r && !block.in_use && block.offset + block.bytes == region.top) {
+                region.top = block.offset;
+                remove_block(i);
+                trimmed = true;
+                break;
+            }
+        }
+    }
+}
+
+void* carve(size_t r, size_t bytes, const char* owner) {
+    Region& region = g_regions[r];
+    if (!region.base) {
+        return nullptr;
+    }
+
+    // Best fit among the released blocks
+    Block* best = nullptr;
+    for (size_t i = 0; i < g_block_count; i++) {
+        Block& block = g_blocks[i];
+        if (block.region == r && !block.in_use && block.bytes >= bytes &&
+            (!best || block.bytes < best->bytes)) {
+            best = &block;
+        }
+    }
+    if (best) {
+        best->in_use = true;
+        best->owner = owner;
+        return region.base + best->offset;
+    }
+
+    if (region.top + bytes > region.budget || g_block_count == MemoryPlan::MAX_BLOCKS) {
+        return nullptr;
+    }
+
+    Block& block = g_blocks[g_block_count++];
+    block.owner = owner;
+    block.offset = static_cast<uint32_t>(region.top);
+    block.bytes = static_cast<uint32_t>(bytes);
+    block.region = static_cast<uint8_t>(r);
+    block.in_use = true;
+    region.top += bytes;
+    region.high_water = std::max(region.high_water, region.top);
+    return region.base + block.offset;
+}
+
+} // namespace
+
+ErrorCode MemoryPlan::initialize() {
+    if (g_mutex) {
+        return ErrorCode::SUCCESS;
+    }
+
+    g_mutex = xSemaphoreCreateMutex();
+    if (!g_mutex) {
+        ESP_LOGE(TAG, "Failed to create memory plan mutex");
+        return ErrorCode::MEMORY_ERROR;
+    }
+
+    ErrorCode result = ErrorCode::SUCCESS;
+    for (Region& region : g_regions) {
+        region.base = static_cast<uint8_t*>(heap_caps_aligned_alloc(ALIGNMENT, region.budget, region.caps));
+        if (region.base) {
+            continue;
+        }
+        if (region.caps & MALLOC_CAP_SPIRAM) {
+            // No PSRAM fitted: its buffers come from the heap, internal if need be
+            ESP_LOGW(TAG, "No %u byte %s region; its buffers use the heap",
+                     (unsigned)region.budget, region.name);
+        } else {
+            ESP_LOGE(TAG, "Failed to reserve %u byte %s region", (unsigned)region.budget, region.name);
+            result = ErrorCode::MEMORY_ERROR;
+        }
+    }
+
+    ESP_LOGI(TAG, "Memory plan reserved: internal %u, DMA %u, PSRAM %u bytes",
+             g_regions[0].base ? (unsigned)INTERNAL_BUDGET : 0u,
+             g_regions[1].base ? (unsigned)DMA_BUDGET : 0u,
+             g_regions[2].base ? (unsigned)PSRAM_BUDGET : 0u);
+    return result;
+}
+
+void* MemoryPlan::allocate(MemoryRegion region, size_t bytes, const char* owner) {
+    const size_t r = static_cast<size_t>(region);
+    if (r >= kRegionCount) {
+        return nullptr;
+    }
+    const size_t size = round_up(bytes);
+
+    lock();
+    void* ptr = carve(r, size, owner);
+    if (!ptr && g_mutex) {
+        g_regions[r].overflow_count++;
+        g_regions[r].overflow_bytes += size;
+    }
+    unlock();
+
+    if (ptr) {
+        return ptr;
+    }
+
+    // Outside the plan: before initialize(), or the region is full or absent
+    if (g_mutex) {
+        ESP_LOGW(TAG, "%s: %u bytes do not fit the %s plan, using the heap",
+                 owner, (unsigned)size, g_regions[r].name);
+    }
+    ptr = heap_caps_malloc(size, g_regions[r].caps);
+    if (!ptr && region == MemoryRegion::PSRAM) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+void MemoryPlan::release(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    lock();
+    const size_t r = find_region(ptr);
+    if (r < kRegionCount) {
+        const uint32_t offset = static_cast<uint32_t>(static_cast<uint8_t*>(ptr) - g_regions[r].base);
+        for (size_t i = 0; i < g_block_count; i++) {
+            Block& block = g_blocks[i];
+            if (block.region == r && block.offset == offset) {
+                block.in_use = false;
+                break;
+            }
+        }
+        trim_region(r);
+        unlock();
+        return;
+    }
+    unlock();
+
+    heap_caps_free(ptr);
+}
+
+bool MemoryPlan::owns(const void* ptr) {
+    lock();
+    const bool inside = ptr && find_region(ptr) < kRegionCount;
+    unlock();
+    return inside;
+}
+
+MemoryPlan::RegionStats MemoryPlan::get_region_stats(MemoryRegion region) {
+    RegionStats stats = {};
+    const size_t r = static_cast<size_t>(region);
+    if (r >= kRegionCount) {
+        return stats;
+    }
+
+    lock();
+    const Region& reg = g_regions[r];
+    stats.reserved = reg.base != nullptr;
+    stats.budget = reg.budget;
+    stats.high_water = reg.high_water;
+    stats.overflow_count = reg.overflow_count;
+    stats.overflow_bytes = reg.overflow_bytes;
+    for (size_t i = 0; i < g_block_count; i++) {
+        if (g_blocks[i].region == r) {
+            stats.blocks++;
+            if (g_blocks[i].in_use) {
+                stats.used += g_blocks[i].bytes;
+            }
+        }
+    }
+    unlock();
+    return stats;
+}
+
+void MemoryPlan::log_report() {
+    for (size_t r = 0; r < kRegionCount; r++) {
+        const RegionStats stats = get_region_stats(static_cast<MemoryRegion>(r));
+        if (!stats.reserved) {
+            ESP_LOGI(TAG, "%-8s not reserved, %u requests (%u bytes) from the heap",
+                     g_regions[r].name, stats.overflow_count, (unsigned)stats.overflow_bytes);
+            continue;
+        }
+        ESP_LOGI(TAG, "%-8s %6u / %6u bytes used, high water %u, %u blocks, %u overflows (%u bytes)",
+                 g_regions[r].name, (unsigned)stats.used, (unsigned)stats.budget,
+                 (unsigned)stats.high_water, (unsigned)stats.blocks,
+                 stats.overflow_count, (unsigned)stats.overflow_bytes);
+    }
+
+    lock();
+    for (size_t i = 0; i < g_block_count; i++) {
+        const Block& block = g_blocks[i];
+        ESP_LOGI(TAG, "  %-8s %-20s %6u%s", g_regions[block.region].name, block.owner,
+                 (unsigned)block.bytes, block.in_use ? "" : " (free)");
+    }
+    unlock();
+}
+
+} // namespace irene
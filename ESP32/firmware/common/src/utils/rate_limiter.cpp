@@ -0,0 +1,51 @@
+#include "utils/rate_limiter.hpp"
+
+#include <algorithm>
+
+namespace irene {
+
+namespace {
+
+constexpr int64_t kMicrosPerSecond = 1000000;
+
+} // namespace
+
+RateLimiter::RateLimiter()
+    : rate_(0)
+    , capacity_(0)
+    , tokens_(0)
+    , last_us_(0) {
+}
+
+void RateLimiter::configure(uint32_t bytes_per_second, uint32_t burst_bytes) {
+    rate_ = bytes_per_second;
+    capacity_ = static_cast<int64_t>(burst_bytes ? burst_bytes : bytes_per_second) * kMicrosPerSecond;
+    tokens_ = std::min(tokens_, capacity_);
+}
+
+void RateLimiter::reset(int64_t now_us) {
+    tokens_ = capacity_;
+    last_us_ = now_us;
+}
+
+void RateLimiter::refill(int64_t now_us) {
+    if (now_us > last_us_) {
+        tokens_ = std::min(capacity_, tokens_ + (now_us - last_us_) * rate_);
+    }
+    last_us_ = now_us;
+}
+
+int64_t RateLimiter::consume(size_t bytes, int64_t now_us) {
+    if (rate_ == 0) {
+        return 0;
+    }
+
+    refill(now_us);
+    tokens_ -= static_cast<int64_t>(bytes) * kMicrosPerSecond;
+    if (tokens_ >= 0) {
+        return 0;
+    }
+    return (-tokens_ + rate_ - 1) / rate_;
+}
+
+} // namespace irene
@@ -1,6 +1,6 @@
 #include "utils/ring_buffer.hpp"
+#include "utils/memory_plan.hpp"
 #include "esp_log.h"
-#include "esp_heap_caps.h"
 #include <algorithm>
 #include <cstring>
 
@@ -17,8 +17,8 @@ RingBuffer::RingBuffer(size_t capacity, bool use_psram)
     , mutex_(nullptr) {
     
     // Allocate buffer
-    uint32_t caps = use_psram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_8BIT;
-    buffer_ = static_cast<uint8_t*>(heap_caps_malloc(capacity, caps));
+    buffer_ = MemoryPlan::allocate_array<uint8_t>(use_psram ? MemoryRegion::PSRAM : MemoryRegion::INTERNAL,
+                                                  capacity, "RingBuffer");
     
     if (!buffer_) {
         ESP_LOGE(TAG, "Failed to allocate ring buffer of size %d", capacity);
@@ -28,7 +28,7 @@ RingBuffer::RingBuffer(size_t capacity, bool use_psram)
     // Create mutex for thread safety
     mutex_ = xSemaphoreCreateMutex();
     if (!mutex_) {
-        heap_caps_free(buffer_);
+        MemoryPlan::release(buffer_);
         buffer_ = nullptr;
         ESP_LOGE(TAG, "Failed to create ring buffer mutex");
         throw std::runtime_error("Failed to create mutex");
@@ -39,9 +39,7 @@ RingBuffer::RingBuffer(size_t capacity, bool use_psram)
 }
 
 RingBuffer::~RingBuffer() {
-    if (buffer_) {
-        heap_caps_free(buffer_);
-    }
+    MemoryPlan::release(buffer_);
     
     if (mutex_) {
         vSemaphoreDelete(mutex_);
@@ -53,24 +51,28 @@ size_t RingBuffer::write(const uint8_t* data, size_t length) {
         return 0;
     }
     
+    // Only the newest capacity_ bytes can survive an oversized write
+    const size_t bytes_written = length;
+    if (length > capacity_) {
+        data += length - capacity_;
+        length = capacity_;
+    }
+    
     xSemaphoreTake(mutex_, portMAX_DELAY);
     
-    size_t bytes_written = 0;
-    
-    for (size_t i = 0; i < length; i++) {
-        if (full_) {
-            // Buffer is full, overwrite oldest data
-            tail_ = (tail_ + 1) % capacity_;
-        }
-        
-        buffer_[head_] = data[i];
-        head_ = (head_ + 1) % capacity_;
-        
-        if (head_ == tail_) {
-            full_ = true;
-        }
-        
-        bytes_written++;
+    // Overwrite oldest data when the write does not fit
+    const size_t overflow = length > free_space() ? length - free_space() : 0;
+    
+    const size_t first = std::min(length, capacity_ - head_);
+    memcpy(buffer_ + head_, data, first);
+    memcpy(buffer_, data + first, length - first);
+    head_ = (head_ + length) % capacity_;
+    
+    if (overflow > 0) {
+        tail_ = head_;
+    }
+    if (length > 0 && head_ == tail_) {
+        full_ = true;
     }
     
     xSemaphoreGive(mutex_);
@@ -85,13 +87,10 @@ size_t RingBuffer::read(uint8_t* data, size_t length) {
     
     xSemaphoreTake(mutex_, portMAX_DELAY);
     
-    size_t bytes_read = 0;
-    
-    while (bytes_read < length && !empty()) {
-        data[bytes_read] = buffer_[tail_];
-        tail_ = (tail_ + 1) % capacity_;
+    const size_t bytes_read = copy_out(data, length, 0);
+    if (bytes_read > 0) {
+        tail_ = (tail_ + bytes_read) % capacity_;
         full_ = false;
-        bytes_read++;
     }
     
     xSemaphoreGive(mutex_);
@@ -106,25 +105,28 @@ size_t RingBuffer::peek(uint8_t* data, size_t length, size_t offset) const {
     
     xSemaphoreTake(mutex_, portMAX_DELAY);
     
-    size_t available_data = available();
+    const size_t bytes_read = copy_out(data, length, offset);
+    
+    xSemaphoreGive(mutex_);
+    
+    return bytes_read;
+}
+
+size_t RingBuffer::copy_out(uint8_t* data, size_t length, size_t offset) const {
+    // Caller holds mutex_
+    const size_t available_data = available();
     if (offset >= available_data) {
-        xSemaphoreGive(mutex_);
         return 0;
     }
     
-    size_t bytes_to_read = std::min(length, available_data - offset);
-    size_t read_pos = (tail_ + offset) % capacity_;
-    size_t bytes_read = 0;
+    const size_t bytes_to_read = std::min(length, available_data - offset);
+    const size_t read_pos = (tail_ + offset) % capacity_;
+    const size_t first = std::min(bytes_to_read, capacity_ - read_pos);
     
-    while (bytes_read < bytes_to_read) {
-        data[bytes_read] = buffer_[read_pos];
-        read_pos = (read_pos + 1) % capacity_;
-        bytes_read++;
-    }
-    
-    xSemaphoreGive(mutex_);
+    memcpy(data, buffer_ + read_pos, first);
+    memcpy(data + first, buffer_, bytes_to_read - first);
     
-    return bytes_read;
+    return bytes_to_read;
 }
 
 void RingBuffer::clear() {
@@ -0,0 +1,533 @@
+// Replays WAV corpora through the firmware audio frontend on the host.
+//
+// Reports per-stage ns/unit and throughput, and checks MFCC output against
+// golden features from the training pipeline (or a baseline recorded with
+// --write-golden before an optimisation). Run with --help for options.
+
+#include "audio/feature_quantizer.hpp"
+#include "audio/fft_engine.hpp"
+#include "audio/mfcc_frontend.hpp"
+#include "audio/vad_processor.hpp"
+#include "utils/ring_buffer.hpp"
+
+#include "feature_file.hpp"
+#include "wav_file.hpp"
+
+#include "esp_log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace irene;
+using namespace irene::host;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t HOP = MFCCFrontend::HOP_SAMPLES;
+constexpr size_t N_MFCC = MFCCFrontend::N_MFCC;
+
+enum Stage {
+    STAGE_MFCC_FLOAT,
+    STAGE_MFCC_INT8,
+    STAGE_FFT,
+    STAGE_QUANTIZE,
+    STAGE_VAD,
+    STAGE_RING_BUFFER,
+    STAGE_COUNT
+};
+
+struct StageTiming {
+    const char* name;
+    const char* unit;
+    uint64_t ns;
+    uint64_t units;
+};
+
+StageTiming g_stages[STAGE_COUNT] = {
+    {"mfcc_float",  "frame",  0, 0},
+    {"mfcc_int8",   "frame",  0, 0},
+    {"fft",         "frame",  0, 0},
+    {"quantize",    "matrix", 0, 0},   // 49x40 float -> int8, run_inference path
+    {"vad",         "10 ms",  0, 0},
+    {"ring_buffer", "10 ms",  0, 0},   // write + read of one hop
+};
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string golden_dir;
+    std::string write_golden_dir;
+    double atol = 1e-2;
+    int repeat = 1;
+    double chirp_seconds = 0.0;
+    bool have_int8_params = false;
+    float int8_scale = 0.0f;
+    int32_t int8_zero_point = 0;
+};
+
+struct Clip {
+    std::string name;  // Golden file stem
+    std::vector<int16_t> samples;
+};
+
+// Summary of all golden and INT8 checks
+struct CheckTotals {
+    size_t golden_files = 0;
+    size_t golden_failures = 0;
+    double golden_max_error = 0.0;
+    double golden_sq_error = 0.0;
+    size_t golden_values = 0;
+    size_t int8_frames = 0;
+    int int8_max_lsb = 0;
+};
+
+uint64_t elapsed_ns(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void add_time(Stage stage, uint64_t ns, uint64_t units) {
+    g_stages[stage].ns += ns;
+    g_stages[stage].units += units;
+}
+
+void print_usage(const char* argv0) {
+    std::printf(
+        "Usage: %s [options] <file.wav | directory>...\n"
+        "\n"
+        "Replays 16 kHz PCM16 WAV files (directories are searched recursively)\n"
+        "through MFCCFrontend, FFTEngine, VADProcessor, RingBuffer and the INT8\n"
+        "quantization of KeywordModel::run_inference.\n"
+        "\n"
+        "  --golden DIR          compare float MFCC frames with DIR/<name>.npy\n"
+        "  --write-golden DIR    record float MFCC frames as DIR/<name>.npy\n"
+        "  --atol X              max |error| allowed against golden (default 1e-2)\n"
+        "  --int8 SCALE:ZP       model input quantization (default: fit to each clip)\n"
+        "  --repeat N            replay the corpus N times for timing (default 1)\n"
+        "  --chirp SECONDS       add a synthetic chirp clip named 'chirp'\n"
+        "  --verbose             show firmware INFO logs\n"
+        "\n"
+        "Golden frame i covers samples [i*%u, i*%u + %u). Exit status is 1 when\n"
+        "a golden or INT8 check fails, 2 on usage or input errors.\n",
+        argv0, (unsigned)HOP, (unsigned)HOP, (unsigned)MFCCFrontend::WINDOW_SAMPLES);
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&](const char* flag) -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", flag);
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else if (arg == "--golden") {
+            const char* v = value("--golden");
+            if (!v) return false;
+            options.golden_dir = v;
+        } else if (arg == "--write-golden") {
+            const char* v = value("--write-golden");
+            if (!v) return false;
+            options.write_golden_dir = v;
+        } else if (arg == "--atol") {
+            const char* v = value("--atol");
+            if (!v) return false;
+            options.atol = std::atof(v);
+        } else if (arg == "--int8") {
+            const char* v = value("--int8");
+            if (!v) return false;
+            if (std::sscanf(v, "%f:%d", &options.int8_scale, &options.int8_zero_point) != 2 ||
+                options.int8_scale <= 0.0f) {
+                std::fprintf(stderr, "--int8 expects SCALE:ZP with SCALE > 0\n");
+                return false;
+            }
+            options.have_int8_params = true;
+        } else if (arg == "--repeat") {
+            const char* v = value("--repeat");
+            if (!v) return false;
+            options.repeat = std::max(1, std::atoi(v));
+        } else if (arg == "--chirp") {
+            const char* v = value("--chirp");
+            if (!v) return false;
+            options.chirp_seconds = std::atof(v);
+        } else if (arg == "--verbose") {
+            esp_log_level_set("*", ESP_LOG_INFO);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    return !options.inputs.empty() || options.chirp_seconds > 0.0;
+}
+
+// Exponential sweep 100 Hz -> 7 kHz with low-level noise; deterministic
+std::vector<int16_t> make_chirp(double seconds) {
+    const size_t count = static_cast<size_t>(seconds * MFCCFrontend::SAMPLE_RATE);
+    const double f0 = 100.0;
+    const double f1 = 7000.0;
+    const double k = std::log(f1 / f0) / seconds;
+
+    std::vector<int16_t> samples(count);
+    uint32_t noise = 0x12345678u;
+    for (size_t i = 0; i < count; i++) {
+        const double t = static_cast<double>(i) / MFCCFrontend::SAMPLE_RATE;
+        const double phase = 2.0 * M_PI * f0 * (std::exp(k * t) - 1.0) / k;
+        noise = noise * 1664525u + 1013904223u;
+        const double dither = (static_cast<int32_t>(noise >> 16) - 32768) / 32768.0;
+        samples[i] = static_cast<int16_t>(std::lround(12000.0 * std::sin(phase) + 200.0 * dither));
+    }
+    return samples;
+}
+
+bool collect_clips(const Options& options, std::vector<Clip>& clips) {
+    namespace fs = std::filesystem;
+    std::vector<fs::path> files;
+
+    for (const std::string& input : options.inputs) {
+        std::error_code ec;
+        if (fs::is_directory(input, ec)) {
+            std::vector<fs::path> found;
+            for (const auto& entry : fs::recursive_directory_iterator(input, ec)) {
+                std::string ext = entry.path().extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                if (entry.is_regular_file() && ext == ".wav") {
+                    found.push_back(entry.path());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            files.push_back(input);
+        }
+    }
+
+    bool ok = true;
+    for (const fs::path& file : files) {
+        WavAudio audio;
+        std::string error;
+        if (!read_wav(file.string(), audio, error)) {
+            std::fprintf(stderr, "%s: %s\n", file.string().c_str(), error.c_str());
+            ok = false;
+            continue;
+        }
+        if (audio.sample_rate != MFCCFrontend::SAMPLE_RATE) {
+            // The frontend has no resampler; the corpus must match the capture rate
+            std::fprintf(stderr, "%s: %u Hz (expected %u), skipped\n", file.string().c_str(),
+                        audio.sample_rate, (unsigned)MFCCFrontend::SAMPLE_RATE);
+            ok = false;
+            continue;
+        }
+        clips.push_back({file.stem().string(), std::move(audio.samples)});
+    }
+
+    if (options.chirp_seconds > 0.0) {
+        clips.push_back({"chirp", make_chirp(options.chirp_seconds)});
+    }
+
+    return ok;
+}
+
+// Scale and zero point covering a feature range, as a TFLite converter would
+void fit_int8_params(const FeatureMatrix& features, float& scale, int32_t& zero_point) {
+    float low = 0.0f;
+    float high = 0.0f;
+    for (float v : features.values) {
+        low = std::min(low, v);
+        high = std::max(high, v);
+    }
+    scale = std::max((high - low) / 255.0f, 1e-6f);
+    zero_point = static_cast<int32_t>(std::lround(-128.0f - low / scale));
+}
+
+// Float frontend, hop by hop as AudioManager feeds it; returns every frame
+void run_float_frontend(const Clip& clip, FeatureMatrix& features) {
+    MFCCFrontend frontend;
+    frontend.initialize(false);
+
+    features.coefficients = N_MFCC;
+    features.values.clear();
+    uint32_t frames_read = 0;
+    float row[N_MFCC];
+    uint64_t ns = 0;
+
+    for (size_t offset = 0; offset < clip.samples.size(); offset += HOP) {
+        const size_t count = std::min(HOP, clip.samples.size() - offset);
+        const Clock::time_point start = Clock::now();
+        frontend.process_samples(&clip.samples[offset], count);
+        ns += elapsed_ns(start);
+
+        for (; frames_read < frontend.get_frame_count(); frames_read++) {
+            frontend.get_frames(frames_read, 1, row);
+            features.values.insert(features.values.end(), row, row + N_MFCC);
+        }
+    }
+
+    features.frames = frames_read;
+    add_time(STAGE_MFCC_FLOAT, ns, frames_read);
+}
+
+// INT8 frontend; returns the largest distance in LSB from quantizing the
+// float frames, which only the fast log10 may move by one step
+int run_int8_frontend(const Clip& clip, const FeatureMatrix& reference, float scale, int32_t zero_point) {
+    MFCCFrontend frontend;
+    frontend.initialize(false);
+    frontend.enable_int8_output(scale, zero_point);
+
+    uint32_t frames_read = 0;
+    int8_t row[N_MFCC];
+    uint64_t ns = 0;
+    int max_lsb = 0;
+
+    for (size_t offset = 0; offset < clip.samples.size(); offset += HOP) {
+        const size_t count = std::min(HOP, clip.samples.size() - offset);
+        const Clock::time_point start = Clock::now();
+        frontend.process_samples(&clip.samples[offset], count);
+        ns += elapsed_ns(start);
+
+        for (; frames_read < frontend.get_frame_count(); frames_read++) {
+            frontend.get_frames_int8(frames_read, 1, row);
+            if (frames_read >= reference.frames) continue;
+            for (size_t c = 0; c < N_MFCC; c++) {
+                const int8_t expected = quantize_int8(reference.values[frames_read * N_MFCC + c], scale, zero_point);
+                max_lsb = std::max(max_lsb, std::abs(static_cast<int>(row[c]) - expected));
+            }
+        }
+    }
+
+    add_time(STAGE_MFCC_INT8, ns, frames_read);
+    return max_lsb;
+}
+
+void run_fft(const Clip& clip) {
+    FFTEngine fft;
+    fft.initialize(MFCCFrontend::WINDOW_SAMPLES);
+
+    std::vector<float> frame(MFCCFrontend::WINDOW_SAMPLES);
+    std::vector<float> power(fft.num_bins());
+    uint64_t ns = 0;
+    uint64_t frames = 0;
+
+    for (size_t offset = 0; offset + frame.size() <= clip.samples.size(); offset += HOP) {
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame[i] = clip.samples[offset + i] / 32768.0f;
+        }
+        const Clock::time_point start = Clock::now();
+        fft.compute_power_spectrum(frame.data(), power.data());
+        ns += elapsed_ns(start);
+        frames++;
+    }
+
+    add_time(STAGE_FFT, ns, frames);
+}
+
+// One 49x40 matrix per frame once the store is full, as the float model path does
+void run_quantize(const FeatureMatrix& features, float scale, int32_t zero_point) {
+    const size_t matrix = MFCCFrontend::FEATURE_SIZE;
+    std::vector<int8_t> input(matrix);
+    uint64_t ns = 0;
+    uint64_t matrices = 0;
+
+    for (size_t last = MFCCFrontend::N_FRAMES; last <= features.frames; last++) {
+        const float* window = &features.values[(last - MFCCFrontend::N_FRAMES) * N_MFCC];
+        const Clock::time_point start = Clock::now();
+        quantize_features_int8(window, matrix, input.data(), input.size(), scale, zero_point);
+        ns += elapsed_ns(start);
+        matrices++;
+    }
+
+    add_time(STAGE_QUANTIZE, ns, matrices);
+}
+
+void run_vad(const Clip& clip) {
+    VADProcessor vad;
+    vad.initialize(MFCCFrontend::SAMPLE_RATE);
+
+    uint64_t ns = 0;
+    uint64_t hops = 0;
+    for (size_t offset = 0; offset + HOP <= clip.samples.size(); offset += HOP) {
+        const Clock::time_point start = Clock::now();
+        vad.process_frame(&clip.samples[offset], HOP);
+        ns += elapsed_ns(start);
+        hops++;
+    }
+
+    add_time(STAGE_VAD, ns, hops);
+}
+
+void run_ring_buffer(const Clip& clip) {
+    constexpr size_t HOP_BYTES = HOP * sizeof(int16_t);
+    RingBuffer ring(HOP_BYTES * 8, false);
+    uint8_t out[HOP_BYTES];
+
+    uint64_t ns = 0;
+    uint64_t hops = 0;
+    for (size_t offset = 0; offset + HOP <= clip.samples.size(); offset += HOP) {
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(&clip.samples[offset]);
+        const Clock::time_point start = Clock::now();
+        ring.write(in, HOP_BYTES);
+        ring.read(out, HOP_BYTES);
+        ns += elapsed_ns(start);
+        hops++;
+    }
+
+    add_time(STAGE_RING_BUFFER, ns, hops);
+}
+
+bool compare_golden(const Options& options, const Clip& clip, const FeatureMatrix& features,
+                    CheckTotals& totals) {
+    const std::string path = options.golden_dir + "/" + clip.name + ".npy";
+    if (!std::filesystem::exists(path)) {
+        std::printf("  %-24s no golden features (%s)\n", clip.name.c_str(), path.c_str());
+        return true;
+    }
+
+    FeatureMatrix golden;
+    std::string error;
+    if (!read_npy(path, golden, error)) {
+        std::printf("  %-24s %s: %s\n", clip.name.c_str(), path.c_str(), error.c_str());
+        totals.golden_failures++;
+        return false;
+    }
+    if (golden.coefficients != N_MFCC) {
+        std::printf("  %-24s golden has %u coefficients per frame (expected %u)\n", clip.name.c_str(),
+                   (unsigned)golden.coefficients, (unsigned)N_MFCC);
+        totals.golden_failures++;
+        return false;
+    }
+
+    const size_t frames = std::min(golden.frames, features.frames);
+    double max_error = 0.0;
+    double sq_error = 0.0;
+    size_t worst_frame = 0;
+    for (size_t i = 0; i < frames * N_MFCC; i++) {
+        const double e = std::fabs(static_cast<double>(features.values[i]) - golden.values[i]);
+        sq_error += e * e;
+        if (e > max_error) {
+            max_error = e;
+            worst_frame = i / N_MFCC;
+        }
+    }
+
+    const bool pass = max_error <= options.atol && frames > 0;
+    std::printf("  %-24s %zu frames, max |err| %.3g (frame %zu), rms %.3g%s%s\n", clip.name.c_str(),
+               frames, max_error, worst_frame, frames ? std::sqrt(sq_error / (frames * N_MFCC)) : 0.0,
+               golden.frames != features.frames ? " [frame count differs]" : "",
+               pass ? "" : "  FAIL");
+
+    totals.golden_files++;
+    totals.golden_max_error = std::max(totals.golden_max_error, max_error);
+    totals.golden_sq_error += sq_error;
+    totals.golden_values += frames * N_MFCC;
+    if (!pass) totals.golden_failures++;
+    return pass;
+}
+
+void print_timings(double audio_seconds) {
+    std::printf("\n%-12s %12s %12s  %s\n", "stage", "units", "ns/unit", "unit");
+    for (const StageTiming& stage : g_stages) {
+        const double per_unit = stage.units ? static_cast<double>(stage.ns) / stage.units : 0.0;
+        std::printf("%-12s %12llu %12.1f  %s\n", stage.name,
+                   static_cast<unsigned long long>(stage.units), per_unit, stage.unit);
+    }
+
+    const StageTiming& mfcc = g_stages[STAGE_MFCC_FLOAT];
+    if (mfcc.ns > 0) {
+        const double seconds = mfcc.ns / 1e9;
+        std::printf("\nThroughput: %.0f frames/s, %.0fx realtime (mfcc_float over %.1f s of audio)\n",
+                   mfcc.units / seconds, audio_seconds / seconds, audio_seconds);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Clip> clips;
+    const bool inputs_ok = collect_clips(options, clips);
+    if (clips.empty()) {
+        std::fprintf(stderr, "Nothing to replay\n");
+        return 2;
+    }
+
+    if (!options.write_golden_dir.empty()) {
+        std::filesystem::create_directories(options.write_golden_dir);
+    }
+
+    CheckTotals totals;
+    double audio_seconds = 0.0;
+    std::printf("Replaying %zu clip(s), %d pass(es)\n", clips.size(), options.repeat);
+
+    for (int pass = 0; pass < options.repeat; pass++) {
+        for (const Clip& clip : clips) {
+            audio_seconds += static_cast<double>(clip.samples.size()) / MFCCFrontend::SAMPLE_RATE;
+
+            FeatureMatrix features;
+            run_float_frontend(clip, features);
+
+            float scale = options.int8_scale;
+            int32_t zero_point = options.int8_zero_point;
+            if (!options.have_int8_params) {
+                fit_int8_params(features, scale, zero_point);
+            }
+            const int int8_lsb = run_int8_frontend(clip, features, scale, zero_point);
+            run_fft(clip);
+            run_quantize(features, scale, zero_point);
+            run_vad(clip);
+            run_ring_buffer(clip);
+
+            // Checks and recording on the first pass only
+            if (pass > 0) continue;
+
+            totals.int8_frames += features.frames;
+            totals.int8_max_lsb = std::max(totals.int8_max_lsb, int8_lsb);
+
+            if (!options.golden_dir.empty()) {
+                compare_golden(options, clip, features, totals);
+            }
+            if (!options.write_golden_dir.empty()) {
+                const std::string path = options.write_golden_dir + "/" + clip.name + ".npy";
+                if (!write_npy(path, features)) {
+                    std::fprintf(stderr, "Failed to write %s\n", path.c_str());
+                    return 2;
+                }
+            }
+        }
+    }
+
+    print_timings(audio_seconds);
+
+    bool failed = false;
+    std::printf("INT8 frontend: %zu frames, max %d LSB from quantized float%s\n",
+               totals.int8_frames, totals.int8_max_lsb, totals.int8_max_lsb > 1 ? "  FAIL" : "");
+    failed |= totals.int8_max_lsb > 1;
+
+    if (!options.golden_dir.empty()) {
+        const double rms = totals.golden_values ? std::sqrt(totals.golden_sq_error / totals.golden_values) : 0.0;
+        std::printf("Golden: %zu clip(s) compared, max |err| %.3g, rms %.3g, atol %.3g: %s\n",
+                   totals.golden_files, totals.golden_max_error, rms, options.atol,
+                   totals.golden_failures ? "FAIL" : "PASS");
+        failed |= totals.golden_failures > 0;
+    }
+
+    if (failed) return 1;
+    return inputs_ok ? 0 : 2;
+}
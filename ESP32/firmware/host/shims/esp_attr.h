@@ -0,0 +1,9 @@
+#pragma once
+
+// Host shim: placement attributes have no meaning off target
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
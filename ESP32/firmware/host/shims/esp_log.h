@@ -0,0 +1,37 @@
+#pragma once
+
+// Host shim: ESP_LOGx to stderr, filtered by esp_log_level_set()
+
+#include <cstdio>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+inline esp_log_level_t& esp_log_host_level() {
+    static esp_log_level_t level = ESP_LOG_WARN;
+    return level;
+}
+
+// Tag filtering is not modelled; the level applies to every tag
+inline void esp_log_level_set(const char* /*tag*/, esp_log_level_t level) {
+    esp_log_host_level() = level;
+}
+
+#define ESP_HOST_LOG(level, letter, tag, format, ...)                              \
+    do {                                                                           \
+        if (esp_log_host_level() >= (level)) {                                     \
+            std::fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__); \
+        }                                                                          \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_HOST_LOG(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_HOST_LOG(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_HOST_LOG(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_HOST_LOG(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_HOST_LOG(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
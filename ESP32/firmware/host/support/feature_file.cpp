@@ -0,0 +1,164 @@
+#include "feature_file.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+namespace irene {
+namespace host {
+
+namespace {
+
+const char NPY_MAGIC[] = "\x93NUMPY";
+constexpr size_t NPY_MAGIC_LEN = 6;
+
+// Value of 'key': ... in the header dict, up to the next ',' or '}' outside brackets
+std::string header_field(const std::string& header, const std::string& key) {
+    const size_t pos = header.find("'" + key + "'");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t start = header.find(':', pos);
+    if (start == std::string::npos) {
+        return "";
+    }
+    start++;
+    
+    int depth = 0;
+    size_t end = start;
+    for (; end < header.size(); end++) {
+        const char c = header[end];
+        if (c == '(') depth++;
+        if (c == ')') depth--;
+        if (depth == 0 && (c == ',' || c == '}')) break;
+        if (depth < 0) break;
+    }
+    if (end < header.size() && header[end] == ')') end++;
+    
+    std::string value = header.substr(start, end - start);
+    const size_t first = value.find_first_not_of(" '");
+    const size_t last = value.find_last_not_of(" '");
+    return first == std::string::npos ? "" : value.substr(first, last - first + 1);
+}
+
+} // namespace
+
+bool read_npy(const std::string& path, FeatureMatrix& matrix, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open";
+        return false;
+    }
+    
+    char preamble[10];
+    if (!in.read(preamble, sizeof(preamble)) || std::memcmp(preamble, NPY_MAGIC, NPY_MAGIC_LEN) != 0) {
+        error = "not a .npy file";
+        return false;
+    }
+    
+    // Version 1 has a 16-bit header length, versions 2 and 3 a 32-bit one
+    const uint8_t major = static_cast<uint8_t>(preamble[6]);
+    size_t header_len = static_cast<uint8_t>(preamble[8]) | (static_cast<uint8_t>(preamble[9]) << 8);
+    if (major >= 2) {
+        char extra[2];
+        if (!in.read(extra, 2)) {
+            error = "truncated header";
+            return false;
+        }
+        header_len |= (static_cast<size_t>(static_cast<uint8_t>(extra[0])) << 16) |
+                      (static_cast<size_t>(static_cast<uint8_t>(extra[1])) << 24);
+    }
+    
+    std::string header(header_len, '\0');
+    if (!in.read(&header[0], header_len)) {
+        error = "truncated header";
+        return false;
+    }
+    
+    const std::string descr = header_field(header, "descr");
+    const bool is_f4 = descr == "<f4";
+    const bool is_f8 = descr == "<f8";
+    if (!is_f4 && !is_f8) {
+        error = "dtype " + descr + " (expected <f4 or <f8)";
+        return false;
+    }
+    if (header_field(header, "fortran_order") != "False") {
+        error = "Fortran-ordered arrays are not supported";
+        return false;
+    }
+    
+    // Shape "(N, C)"; a 1-D array is one frame
+    const std::string shape = header_field(header, "shape");
+    size_t dims[2] = {0, 0};
+    size_t dim_count = 0;
+    for (size_t i = 0; i < shape.size() && dim_count < 3; ) {
+        if (shape[i] >= '0' && shape[i] <= '9') {
+            size_t value = 0;
+            while (i < shape.size() && shape[i] >= '0' && shape[i] <= '9') {
+                value = value * 10 + (shape[i++] - '0');
+            }
+            if (dim_count < 2) dims[dim_count] = value;
+            dim_count++;
+        } else {
+            i++;
+        }
+    }
+    if (dim_count == 1) {
+        dims[1] = dims[0];
+        dims[0] = 1;
+    } else if (dim_count != 2) {
+        error = "shape " + shape + " (expected 2-D)";
+        return false;
+    }
+    
+    matrix.frames = dims[0];
+    matrix.coefficients = dims[1];
+    const size_t count = matrix.frames * matrix.coefficients;
+    matrix.values.resize(count);
+    
+    if (is_f4) {
+        if (!in.read(reinterpret_cast<char*>(matrix.values.data()), count * sizeof(float))) {
+            error = "truncated data";
+            return false;
+        }
+    } else {
+        std::vector<double> values(count);
+        if (!in.read(reinterpret_cast<char*>(values.data()), count * sizeof(double))) {
+            error = "truncated data";
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            matrix.values[i] = static_cast<float>(values[i]);
+        }
+    }
+    
+    return true;
+}
+
+bool write_npy(const std::string& path, const FeatureMatrix& matrix) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    
+    std::string header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" +
+                         std::to_string(matrix.frames) + ", " + std::to_string(matrix.coefficients) + "), }";
+    // Pad so the data starts on a 64-byte boundary, newline terminated
+    const size_t total = NPY_MAGIC_LEN + 4 + header.size() + 1;
+    header.append((64 - total % 64) % 64, ' ');
+    header += '\n';
+    
+    out.write(NPY_MAGIC, NPY_MAGIC_LEN);
+    const char version[2] = {1, 0};
+    out.write(version, 2);
+    const uint16_t header_len = static_cast<uint16_t>(header.size());
+    const char len_bytes[2] = {static_cast<char>(header_len & 0xFF), static_cast<char>(header_len >> 8)};
+    out.write(len_bytes, 2);
+    out.write(header.data(), header.size());
+    out.write(reinterpret_cast<const char*>(matrix.values.data()), matrix.values.size() * sizeof(float));
+    
+    return static_cast<bool>(out);
+}
+
+} // namespace host
+} // namespace irene
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace irene {
+namespace host {
+
+// A [frames][coefficients] float matrix, row-major
+struct FeatureMatrix {
+    size_t frames = 0;
+    size_t coefficients = 0;
+    std::vector<float> values;
+};
+
+// Golden features are NumPy .npy files (float32 or float64, C order, 2-D),
+// as written by numpy.save() in the training pipeline
+bool read_npy(const std::string& path, FeatureMatrix& matrix, std::string& error);
+
+// Writes float32, so recorded baselines load back with numpy.load()
+bool write_npy(const std::string& path, const FeatureMatrix& matrix);
+
+} // namespace host
+} // namespace irene
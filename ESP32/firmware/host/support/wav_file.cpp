@@ -0,0 +1,127 @@
+#include "wav_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace irene {
+namespace host {
+
+namespace {
+
+uint32_t read_le32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t read_le16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+void put_le32(std::ofstream& out, uint32_t value) {
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+        static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)
+    };
+    out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+void put_le16(std::ofstream& out, uint16_t value) {
+    const uint8_t bytes[2] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+    out.write(reinterpret_cast<const char*>(bytes), 2);
+}
+
+} // namespace
+
+bool read_wav(const std::string& path, WavAudio& audio, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open";
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    
+    if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 ||
+        std::memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+    
+    uint16_t format = 0;
+    uint16_t bits = 0;
+    bool have_format = false;
+    size_t offset = 12;
+    
+    // Walk the chunks; "data" may come before or after odd extras (LIST, fact)
+    while (offset + 8 <= data.size()) {
+        const uint8_t* chunk = data.data() + offset;
+        const size_t size = read_le32(chunk + 4);
+        const size_t body = offset + 8;
+        if (body + size > data.size() && std::memcmp(chunk, "data", 4) != 0) {
+            break;
+        }
+        
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            format = read_le16(data.data() + body);
+            audio.channels = read_le16(data.data() + body + 2);
+            audio.sample_rate = read_le32(data.data() + body + 4);
+            bits = read_le16(data.data() + body + 14);
+            have_format = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                error = "data chunk before fmt chunk";
+                return false;
+            }
+            // WAVE_FORMAT_PCM or WAVE_FORMAT_EXTENSIBLE carrying PCM16
+            if ((format != 1 && format != 0xFFFE) || bits != 16 || audio.channels == 0) {
+                error = "only 16-bit PCM is supported";
+                return false;
+            }
+            
+            // Truncated files (interrupted recordings) keep what is there
+            const size_t available = std::min(size, data.size() - body);
+            const size_t frame_bytes = 2u * audio.channels;
+            const size_t frames = available / frame_bytes;
+            audio.samples.resize(frames);
+            for (size_t i = 0; i < frames; i++) {
+                audio.samples[i] = static_cast<int16_t>(read_le16(data.data() + body + i * frame_bytes));
+            }
+            return true;
+        }
+        
+        offset = body + size + (size & 1);  // Chunks are word aligned
+    }
+    
+    error = "no data chunk";
+    return false;
+}
+
+bool write_wav(const std::string& path, const int16_t* samples, size_t count, uint32_t sample_rate) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        return false;
+    }
+    
+    const uint32_t data_bytes = static_cast<uint32_t>(count * sizeof(int16_t));
+    out.write("RIFF", 4);
+    put_le32(out, 36 + data_bytes);
+    out.write("WAVE", 4);
+    out.write("fmt ", 4);
+    put_le32(out, 16);
+    put_le16(out, 1);                // PCM
+    put_le16(out, 1);                // Mono
+    put_le32(out, sample_rate);
+    put_le32(out, sample_rate * 2);  // Byte rate
+    put_le16(out, 2);                // Block align
+    put_le16(out, 16);
+    out.write("data", 4);
+    put_le32(out, data_bytes);
+    for (size_t i = 0; i < count; i++) {
+        put_le16(out, static_cast<uint16_t>(samples[i]));
+    }
+    
+    return static_cast<bool>(out);
+}
+
+} // namespace host
+} // namespace irene
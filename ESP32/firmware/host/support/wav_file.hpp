@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace irene {
+namespace host {
+
+// 16-bit PCM audio as replayed into the frontend
+struct WavAudio {
+    uint32_t sample_rate = 0;
+    uint16_t channels = 0;
+    std::vector<int16_t> samples;  // First channel only
+};
+
+// Read a PCM16 RIFF/WAVE file; multi-channel files keep channel 0.
+// Returns false with a reason in error.
+bool read_wav(const std::string& path, WavAudio& audio, std::string& error);
+
+// Write mono PCM16
+bool write_wav(const std::string& path, const int16_t* samples, size_t count, uint32_t sample_rate);
+
+} // namespace host
+} // namespace irene
@@ -0,0 +1,969 @@
+// Host checks for the audio frontend modules built by frontend_bench.
+// Plain asserts; each failure prints its location and the run exits non-zero.
+
+#include "audio/audio_history.hpp"
+#include "audio/echo_canceller.hpp"
+#include "audio/echo_reference.hpp"
+#include "audio/feature_quantizer.hpp"
+#include "audio/fft_engine.hpp"
+#include "audio/frame_stats.hpp"
+#include "audio/jitter_buffer.hpp"
+#include "audio/mfcc_frontend.hpp"
+#include "audio/posterior_smoother.hpp"
+#include "audio/vad_processor.hpp"
+#include "core/capture_route.hpp"
+#include "core/node_profile.hpp"
+#include "network/audio_encoder.hpp"
+#include "ota/delta_patch.hpp"
+#include "utils/json.hpp"
+#include "utils/memory_plan.hpp"
+#include "utils/rate_limiter.hpp"
+#include "utils/ring_buffer.hpp"
+
+#include "feature_file.hpp"
+#include "wav_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+using namespace irene;
+using namespace irene::host;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                         #condition);                                             \
+            g_failures++;                                                         \
+        }                                                                         \
+    } while (0)
+
+std::vector<int16_t> make_signal(size_t count, uint32_t seed) {
+    std::vector<int16_t> samples(count);
+    uint32_t state = seed;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 1664525u + 1013904223u;
+        const double tone = 8000.0 * std::sin(2.0 * M_PI * 440.0 * i / 16000.0) +
+                            3000.0 * std::sin(2.0 * M_PI * 2900.0 * i / 16000.0);
+        samples[i] = static_cast<int16_t>(tone + (static_cast<int32_t>(state >> 16) - 32768) / 16);
+    }
+    return samples;
+}
+
+// Spec the model was trained on, in double precision: symmetric Hann, power
+// spectrum, triangular mel filters on floor((N+1)*hz/sr) bins, log10 and an
+// orthonormal DCT-II
+std::vector<double> reference_mfcc(const int16_t* window_samples) {
+    const size_t n = MFCCFrontend::WINDOW_SAMPLES;
+    const size_t bins = n / 2 + 1;
+
+    std::vector<double> power(bins);
+    for (size_t k = 0; k < bins; k++) {
+        double re = 0.0;
+        double im = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            const double hann = 0.5 * (1.0 - std::cos(2.0 * M_PI * i / (n - 1)));
+            const double x = window_samples[i] / 32768.0 * hann;
+            re += x * std::cos(2.0 * M_PI * k * i / n);
+            im -= x * std::sin(2.0 * M_PI * k * i / n);
+        }
+        power[k] = re * re + im * im;
+    }
+
+    const size_t n_mels = MFCCFrontend::N_MELS;
+    std::vector<size_t> points(n_mels + 2);
+    const double mel_high = 2595.0 * std::log10(1.0 + 8000.0 / 700.0);
+    for (size_t i = 0; i < points.size(); i++) {
+        const double hz = 700.0 * (std::pow(10.0, mel_high * i / (n_mels + 1) / 2595.0) - 1.0);
+        points[i] = static_cast<size_t>((n + 1) * hz / 16000.0);
+    }
+
+    std::vector<double> log_mel(n_mels);
+    for (size_t m = 0; m < n_mels; m++) {
+        double sum = 0.0;
+        for (size_t k = points[m]; k < points[m + 1]; k++) {
+            sum += power[k] * (k - points[m]) / double(points[m + 1] - points[m]);
+        }
+        for (size_t k = points[m + 1]; k < points[m + 2]; k++) {
+            sum += power[k] * (points[m + 2] - k) / double(points[m + 2] - points[m + 1]);
+        }
+        log_mel[m] = std::log10(std::max(sum, 1e-10));
+    }
+
+    std::vector<double> mfcc(MFCCFrontend::N_MFCC);
+    for (size_t i = 0; i < mfcc.size(); i++) {
+        const double norm = std::sqrt((i == 0 ? 1.0 : 2.0) / n_mels);
+        for (size_t j = 0; j < n_mels; j++) {
+            mfcc[i] += log_mel[j] * std::cos(M_PI * i * (j + 0.5) / n_mels) * norm;
+        }
+    }
+    return mfcc;
+}
+
+// Every frame the frontend produces for samples fed in chunks of chunk
+std::vector<float> run_frontend(const std::vector<int16_t>& samples, size_t chunk) {
+    MFCCFrontend frontend;
+    CHECK(frontend.initialize(false) == ErrorCode::SUCCESS);
+
+    std::vector<float> frames;
+    std::vector<float> row(MFCCFrontend::N_MFCC);
+    uint32_t read = 0;
+    for (size_t offset = 0; offset < samples.size(); offset += chunk) {
+        frontend.process_samples(&samples[offset], std::min(chunk, samples.size() - offset));
+        for (; read < frontend.get_frame_count(); read++) {
+            CHECK(frontend.get_frames(read, 1, row.data()));
+            frames.insert(frames.end(), row.begin(), row.end());
+        }
+    }
+    return frames;
+}
+
+void test_fft_matches_dft() {
+    FFTEngine fft;
+    CHECK(fft.initialize(MFCCFrontend::WINDOW_SAMPLES) == ErrorCode::SUCCESS);
+    CHECK(fft.num_bins() == MFCCFrontend::WINDOW_SAMPLES / 2 + 1);
+
+    const std::vector<int16_t> signal = make_signal(MFCCFrontend::WINDOW_SAMPLES, 7);
+    std::vector<float> input(signal.size());
+    for (size_t i = 0; i < signal.size(); i++) {
+        input[i] = signal[i] / 32768.0f;
+    }
+    std::vector<float> power(fft.num_bins());
+    fft.compute_power_spectrum(input.data(), power.data());
+
+    double peak = 0.0;
+    double max_error = 0.0;
+    const size_t n = input.size();
+    for (size_t k = 0; k < power.size(); k++) {
+        double re = 0.0;
+        double im = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            re += input[i] * std::cos(2.0 * M_PI * k * i / n);
+            im -= input[i] * std::sin(2.0 * M_PI * k * i / n);
+        }
+        const double expected = re * re + im * im;
+        peak = std::max(peak, expected);
+        max_error = std::max(max_error, std::fabs(power[k] - expected));
+    }
+    CHECK(max_error <= 1e-4 * peak);
+}
+
+void test_frame_timing() {
+    MFCCFrontend frontend;
+    CHECK(frontend.initialize(false) == ErrorCode::SUCCESS);
+
+    const std::vector<int16_t> signal = make_signal(MFCCFrontend::INPUT_BUFFER_SIZE, 1);
+
+    // The first frame needs a full window, then one per hop
+    CHECK(!frontend.process_samples(signal.data(), MFCCFrontend::WINDOW_SAMPLES - 1));
+    CHECK(frontend.get_frame_count() == 0);
+    frontend.process_samples(&signal[MFCCFrontend::WINDOW_SAMPLES - 1], 1);
+    CHECK(frontend.get_frame_count() == 1);
+
+    const size_t rest = signal.size() - MFCCFrontend::WINDOW_SAMPLES;
+    CHECK(frontend.process_samples(&signal[MFCCFrontend::WINDOW_SAMPLES], rest));
+    CHECK(frontend.get_frame_count() == MFCCFrontend::N_FRAMES);
+    CHECK(frontend.has_sufficient_data());
+
+    std::vector<float> features(MFCCFrontend::FEATURE_SIZE);
+    CHECK(frontend.get_features(features.data()));
+    CHECK(!frontend.get_frames(0, MFCCFrontend::N_FRAMES + 1, features.data()));
+}
+
+void test_chunking_invariance() {
+    const std::vector<int16_t> signal = make_signal(16000, 3);
+    const std::vector<float> by_hop = run_frontend(signal, MFCCFrontend::HOP_SAMPLES);
+    const std::vector<float> odd = run_frontend(signal, 37);
+    CHECK(by_hop.size() == (1 + (signal.size() - MFCCFrontend::WINDOW_SAMPLES) / MFCCFrontend::HOP_SAMPLES) *
+                           MFCCFrontend::N_MFCC);
+    CHECK(by_hop == odd);
+
+    // One large write keeps only the newest N_FRAMES
+    MFCCFrontend frontend;
+    CHECK(frontend.initialize(false) == ErrorCode::SUCCESS);
+    CHECK(frontend.process_samples(signal.data(), signal.size()));
+    std::vector<float> whole(MFCCFrontend::FEATURE_SIZE);
+    CHECK(frontend.get_features(whole.data()));
+    CHECK(std::equal(whole.begin(), whole.end(), by_hop.end() - MFCCFrontend::FEATURE_SIZE));
+}
+
+void test_matches_reference() {
+    const std::vector<int16_t> signal = make_signal(MFCCFrontend::WINDOW_SAMPLES + 4 * MFCCFrontend::HOP_SAMPLES, 5);
+    const std::vector<float> frames = run_frontend(signal, MFCCFrontend::HOP_SAMPLES);
+    CHECK(frames.size() == 5 * MFCCFrontend::N_MFCC);
+
+    double max_error = 0.0;
+    for (size_t f = 0; f < 5; f++) {
+        const std::vector<double> expected = reference_mfcc(&signal[f * MFCCFrontend::HOP_SAMPLES]);
+        for (size_t c = 0; c < MFCCFrontend::N_MFCC; c++) {
+            max_error = std::max(max_error, std::fabs(frames[f * MFCCFrontend::N_MFCC + c] - expected[c]));
+        }
+    }
+    CHECK(max_error < 1e-3);
+}
+
+void test_int8_output() {
+    const std::vector<int16_t> signal = make_signal(16000, 9);
+    const std::vector<float> reference = run_frontend(signal, MFCCFrontend::HOP_SAMPLES);
+    const float scale = 0.05f;
+    const int32_t zero_point = -20;
+
+    MFCCFrontend frontend;
+    CHECK(frontend.initialize(false) == ErrorCode::SUCCESS);
+    CHECK(frontend.enable_int8_output(scale, zero_point) == ErrorCode::SUCCESS);
+    CHECK(frontend.is_int8_output());
+
+    std::vector<int8_t> row(MFCCFrontend::N_MFCC);
+    uint32_t read = 0;
+    int max_lsb = 0;
+    for (size_t offset = 0; offset < signal.size(); offset += MFCCFrontend::HOP_SAMPLES) {
+        frontend.process_samples(&signal[offset], MFCCFrontend::HOP_SAMPLES);
+        for (; read < frontend.get_frame_count(); read++) {
+            CHECK(frontend.get_frames_int8(read, 1, row.data()));
+            for (size_t c = 0; c < row.size(); c++) {
+                const int8_t expected = quantize_int8(reference[read * MFCCFrontend::N_MFCC + c], scale, zero_point);
+                max_lsb = std::max(max_lsb, std::abs(row[c] - expected));
+            }
+        }
+    }
+    CHECK(read * MFCCFrontend::N_MFCC == reference.size());
+    CHECK(max_lsb <= 1);
+}
+
+void test_quantizer() {
+    CHECK(quantize_int8(0.0f, 0.5f, 3) == 3);
+    CHECK(quantize_int8(1.25f, 0.5f, 0) == 3);    // Half away from zero
+    CHECK(quantize_int8(-1.25f, 0.5f, 0) == -3);
+    CHECK(quantize_int8(1000.0f, 0.5f, 0) == 127);
+    CHECK(quantize_int8(-1000.0f, 0.5f, 0) == -128);
+    CHECK(dequantize_int8(7, 0.25f, 3) == 1.0f);
+
+    const float features[3] = {0.5f, -0.5f, 2.0f};
+    int8_t output[5];
+    std::memset(output, 0x55, sizeof(output));
+    quantize_features_int8(features, 3, output, 5, 0.5f, -4);
+    CHECK(output[0] == -3 && output[1] == -5 && output[2] == 0);
+    CHECK(output[3] == -4 && output[4] == -4);    // Padded with the zero point
+}
+
+void test_ring_buffer() {
+    RingBuffer ring(8, false);
+    const uint8_t data[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    uint8_t out[12] = {};
+
+    CHECK(ring.empty());
+    CHECK(ring.write(data, 6) == 6);
+    CHECK(ring.read(out, 4) == 4 && out[0] == 1 && out[3] == 4);
+
+    // Wraps, then overwrites the oldest bytes when full
+    CHECK(ring.write(data + 6, 6) == 6);
+    CHECK(ring.full());
+    CHECK(ring.peek(out, 2, 1) == 2 && out[0] == 6 && out[1] == 7);
+    CHECK(ring.read(out, 12) == 8 && out[0] == 5 && out[7] == 12);
+    CHECK(ring.empty());
+}
+
+void test_frame_stats() {
+    // Odd length for the tail, and the full-scale extremes
+    std::vector<int16_t> frame = make_signal(321, 5);
+    frame[17] = -32768;
+    frame[18] = 32767;
+    frame[19] = 0;
+
+    int64_t sum_squares = 0;
+    uint32_t crossings = 0;
+    int32_t peak = 0;
+    for (size_t i = 0; i < frame.size(); i++) {
+        sum_squares += static_cast<int64_t>(frame[i]) * frame[i];
+        peak = std::max(peak, std::abs(static_cast<int32_t>(frame[i])));
+        if (i > 0 && ((frame[i - 1] >= 0) != (frame[i] >= 0))) {
+            crossings++;
+        }
+    }
+
+    const FrameStats stats = compute_frame_stats(frame.data(), frame.size());
+    CHECK(stats.sample_count == frame.size());
+    CHECK(stats.sum_squares == static_cast<uint64_t>(sum_squares));
+    CHECK(stats.zero_crossings == crossings);
+    CHECK(stats.peak == std::min(peak, 32767));
+    CHECK(std::fabs(stats.rms() - std::sqrt(static_cast<float>(sum_squares) / frame.size()) / 32768.0f) < 1e-6f);
+    CHECK(std::fabs(stats.zcr() - static_cast<float>(crossings) / (frame.size() - 1)) < 1e-6f);
+
+    const FrameStats empty = compute_frame_stats(nullptr, 0);
+    CHECK(empty.sample_count == 0 && empty.rms() == 0.0f && empty.zcr() == 0.0f);
+}
+
+void test_vad() {
+    VADProcessor vad;
+    CHECK(vad.initialize(16000) == ErrorCode::SUCCESS);
+
+    const std::vector<int16_t> silence(MFCCFrontend::HOP_SAMPLES, 0);
+    for (int i = 0; i < 50; i++) {
+        CHECK(!vad.process_frame(silence.data(), silence.size()));
+    }
+
+    const std::vector<int16_t> speech = make_signal(16000, 11);
+    bool detected = false;
+    for (size_t offset = 0; offset + MFCCFrontend::HOP_SAMPLES <= speech.size(); offset += MFCCFrontend::HOP_SAMPLES) {
+        detected |= vad.process_frame(&speech[offset], MFCCFrontend::HOP_SAMPLES);
+    }
+    CHECK(detected);
+}
+
+void test_adaptive_vad() {
+    // The VAD fed the way the capture task feeds it: 20 ms frames, with the
+    // mel energies of each frame arriving through the frontend's tap
+    MFCCFrontend frontend;
+    CHECK(frontend.initialize(false) == ErrorCode::SUCCESS);
+    VADProcessor vad;
+    CHECK(vad.initialize(16000) == ErrorCode::SUCCESS);
+    vad.set_mode(VADMode::ADAPTIVE);
+    vad.set_voice_duration_ms(60);
+    vad.set_silence_duration_ms(300);
+    frontend.set_mel_tap([&vad](const float* log_mel, size_t bands) {
+        vad.process_spectrum(log_mel, bands, MFCCFrontend::HOP_SIZE_MS);
+    });
+
+    uint32_t state = 7;
+    auto noise = [&state](double amplitude) {
+        state = state * 1664525u + 1013904223u;
+        return amplitude * ((static_cast<int32_t>(state >> 16) - 32768) / 32768.0);
+    };
+
+    const size_t frame = 320;
+    size_t t = 0;
+    int voice_frames = 0;
+    auto run = [&](double seconds, double noise_amplitude, double tone_amplitude) {
+        voice_frames = 0;
+        std::vector<int16_t> samples(frame);
+        for (size_t n = 0; n < static_cast<size_t>(seconds * 50); n++) {
+            for (size_t i = 0; i < frame; i++, t++) {
+                const double tone = tone_amplitude * (std::sin(2.0 * M_PI * 300.0 * t / 16000.0) +
+                                                      0.6 * std::sin(2.0 * M_PI * 1100.0 * t / 16000.0) +
+                                                      0.3 * std::sin(2.0 * M_PI * 2400.0 * t / 16000.0));
+                samples[i] = static_cast<int16_t>(tone + noise(noise_amplitude));
+            }
+            voice_frames += vad.process_frame(samples.data(), frame) ? 1 : 0;
+            frontend.process_samples(samples.data(), frame);
+        }
+        return vad.is_voice_detected();
+    };
+
+    // Quiet room, then an extractor fan 12 dB louder: the floor catches up
+    CHECK(!run(2.0, 300.0, 0.0));
+    CHECK(voice_frames < 10);
+    run(3.0, 1200.0, 0.0);
+    CHECK(!run(2.0, 1200.0, 0.0));
+    CHECK(voice_frames == 0);
+    const float fan_floor = vad.get_noise_floor_db();
+
+    // Speech over the fan is heard, and ends one hangover after it stops
+    CHECK(run(0.6, 1200.0, 3000.0));
+    CHECK(vad.get_snr_db() > 12.0f);
+    CHECK(run(0.2, 1200.0, 0.0));
+    CHECK(!run(0.3, 1200.0, 0.0));
+    CHECK(std::fabs(vad.get_noise_floor_db() - fan_floor) < 3.0f);
+}
+
+void test_memory_plan() {
+    // Before initialize() requests are served by the heap
+    void* early = MemoryPlan::allocate(MemoryRegion::INTERNAL, 64, "test");
+    CHECK(early && !MemoryPlan::owns(early));
+    MemoryPlan::release(early);
+
+    CHECK(MemoryPlan::initialize() == ErrorCode::SUCCESS);
+    const MemoryPlan::RegionStats before = MemoryPlan::get_region_stats(MemoryRegion::INTERNAL);
+    CHECK(before.reserved && before.budget == MemoryPlan::INTERNAL_BUDGET);
+
+    uint8_t* a = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, 100, "test");
+    uint8_t* b = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, 200, "test");
+    CHECK(MemoryPlan::owns(a) && MemoryPlan::owns(b));
+    CHECK(reinterpret_cast<uintptr_t>(a) % MemoryPlan::ALIGNMENT == 0);
+    CHECK(b - a == 112);
+
+    // A released block goes to the next request it fits
+    MemoryPlan::release(a);
+    uint8_t* c = MemoryPlan::allocate_array<uint8_t>(MemoryRegion::INTERNAL, 50, "test");
+    CHECK(c == a);
+
+    // Releasing from the top gives the space back to the region
+    MemoryPlan::release(b);
+    MemoryPlan::release(c);
+    const MemoryPlan::RegionStats after = MemoryPlan::get_region_stats(MemoryRegion::INTERNAL);
+    CHECK(after.used == before.used && after.blocks == before.blocks);
+    CHECK(after.high_water >= 112 + 208);
+
+    // Over budget: served by the heap and counted
+    void* big = MemoryPlan::allocate(MemoryRegion::INTERNAL, MemoryPlan::INTERNAL_BUDGET + 1, "test");
+    CHECK(big && !MemoryPlan::owns(big));
+    CHECK(MemoryPlan::get_region_stats(MemoryRegion::INTERNAL).overflow_count == before.overflow_count + 1);
+    MemoryPlan::release(big);
+}
+
+void test_audio_history() {
+    AudioFramePool pool;
+    CHECK(pool.initialize(4, 6) == ErrorCode::SUCCESS);
+    AudioHistory history;
+    CHECK(history.initialize(4) == ErrorCode::SUCCESS);
+
+    AudioHistory::Cursor reader = history.end();
+    CHECK(history.next(reader) == nullptr);
+
+    for (uint32_t i = 0; i < 6; i++) {
+        AudioFrameRef frame = pool.acquire();
+        CHECK(frame);
+        frame.get()->sample_count = 4;
+        frame.get()->sequence = i;
+        history.push(frame);
+    }
+
+    // Full ring keeps the newest four; evicted frames went back to the pool
+    CHECK(history.size() == 4);
+    CHECK(pool.free_count() == 2);
+    CHECK(history.at(history.end()) == nullptr);
+    CHECK(history.at(history.end() - 1)->sequence() == 5);
+
+    // A lagging cursor resumes at the oldest retained frame
+    const AudioFrameRef* frame = history.next(reader);
+    CHECK(frame && frame->sequence() == 2);
+
+    // Independent cursors do not consume each other's frames
+    AudioHistory::Cursor other = history.rewind(2);
+    CHECK(history.next(other)->sequence() == 4);
+    CHECK(history.next(reader)->sequence() == 3);
+
+    AudioFrameSpan first;
+    AudioFrameSpan second;
+    CHECK(history.newest_spans(3, first, second) == 3);
+    CHECK(first.count + second.count == 3);
+    CHECK(first.frames[0].sequence() == 3);
+    CHECK((second.count ? second.frames[second.count - 1] : first.frames[first.count - 1]).sequence() == 5);
+
+    history.drop_oldest();
+    CHECK(history.size() == 3 && history.at(history.begin())->sequence() == 3);
+    history.clear();
+    CHECK(history.size() == 0 && pool.free_count() == 6);
+}
+
+void test_posterior_smoother() {
+    // Window of 3 inferences, 100 hop (1 s) refractory, 3 hops per inference
+    PosteriorSmoother smoother;
+    smoother.configure(0.8f, 3, 100);
+
+    // One spike is averaged away, and nothing arms before the window fills
+    CHECK(!smoother.update(1.0f, 3));
+    CHECK(!smoother.update(0.1f, 3));
+    CHECK(!smoother.update(0.1f, 3));
+    CHECK(smoother.smoothed() < 0.8f);
+
+    // A sustained rise fires once, at the first inference past the peak
+    const float word[] = {0.9f, 0.95f, 1.0f, 1.0f, 0.9f, 0.5f, 0.2f};
+    int fired_at = -1;
+    for (int i = 0; i < 7; i++) {
+        if (smoother.update(word[i], 3)) {
+            CHECK(fired_at < 0);
+            fired_at = i;
+        }
+    }
+    CHECK(fired_at == 4);
+    CHECK(std::fabs(smoother.peak() - (0.95f + 1.0f + 1.0f) / 3.0f) < 1e-6f);
+    CHECK(smoother.in_refractory());
+
+    // Refractory counts hops, so one large skip ends it
+    for (int i = 0; i < 3; i++) {
+        CHECK(!smoother.update(1.0f, 3));
+    }
+    CHECK(!smoother.update(1.0f, 100));
+    CHECK(!smoother.in_refractory());
+    bool fired = false;
+    for (int i = 0; i < 4 && !fired; i++) {
+        fired = smoother.update(1.0f, 3);
+    }
+    CHECK(fired);  // A flat plateau fires after one window of waiting
+
+    // Reset drops a pending peak
+    smoother.configure(0.5f, 1, 0);
+    CHECK(!smoother.update(0.9f, 1));
+    smoother.reset();
+    CHECK(!smoother.update(0.1f, 1));
+    CHECK(smoother.smoothed() < 0.5f);
+}
+
+void test_jitter_buffer() {
+    JitterBuffer jitter;
+    CHECK(jitter.initialize(64, 32, false) == ErrorCode::SUCCESS);
+    CHECK(jitter.capacity() == 64);
+
+    std::vector<int16_t> samples(64);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = static_cast<int16_t>(i + 1);
+    }
+    int16_t frame[16];
+
+    // Nothing plays until the prebuffer is queued
+    CHECK(jitter.write(samples.data(), 24) == 24);
+    CHECK(!jitter.read(frame, 16) && !jitter.is_playing());
+    CHECK(jitter.write(samples.data() + 24, 8) == 8);
+    CHECK(jitter.read(frame, 16) && jitter.is_playing());
+    CHECK(frame[0] == 1 && frame[15] == 16);
+    CHECK(jitter.read(frame, 16) && frame[0] == 17);
+
+    // Running dry mid-stream is an underrun and re-buffers
+    CHECK(!jitter.read(frame, 16));
+    CHECK(jitter.get_underrun_count() == 1 && !jitter.is_playing());
+    CHECK(jitter.write(samples.data(), 20) == 20);
+    CHECK(!jitter.read(frame, 16));
+    CHECK(jitter.get_underrun_count() == 1);
+
+    // The end of a stream plays out below the prebuffer, padded with silence
+    jitter.end_of_stream();
+    CHECK(jitter.read(frame, 16) && frame[0] == 1);
+    CHECK(jitter.read(frame, 16) && frame[0] == 17 && frame[3] == 20 && frame[4] == 0 && frame[15] == 0);
+    CHECK(!jitter.read(frame, 16));
+    CHECK(jitter.get_underrun_count() == 1 && jitter.get_played_samples() == 52);
+
+    // A full ring drops the excess, and a flush empties it
+    CHECK(jitter.write(samples.data(), 64) == 64);
+    CHECK(jitter.write(samples.data(), 8) == 0);
+    CHECK(jitter.get_overrun_samples() == 8);
+    jitter.flush();
+    CHECK(!jitter.read(frame, 16) && jitter.buffered() == 0);
+}
+
+void test_downlink_codecs() {
+    const std::vector<int16_t> signal = make_signal(480, 7);
+    std::vector<uint8_t> payload(4096);
+    std::vector<int16_t> decoded(1024);
+
+    for (AudioCodec codec : {AudioCodec::PCM16, AudioCodec::IMA_ADPCM}) {
+        std::unique_ptr<AudioEncoder> encoder = create_audio_encoder(codec, 16000, 0);
+        std::unique_ptr<AudioDecoder> decoder = create_audio_decoder(codec, 16000);
+        CHECK(encoder && decoder && decoder->codec() == codec);
+        if (!encoder || !decoder) {
+            continue;
+        }
+
+        // Two messages in a row, as a stream would send them
+        double error = 0.0, power = 0.0;
+        for (size_t half = 0; half < 2; half++) {
+            const int16_t* pcm = signal.data() + half * 240;
+            const size_t bytes = encoder->encode(pcm, 240, payload.data(), payload.size());
+            CHECK(bytes > 0 && bytes <= encoder->max_encoded_bytes(240));
+            const size_t samples = decoder->decode(payload.data(), bytes, decoded.data(), decoded.size());
+            CHECK(samples == 240 && samples <= decoder->max_decoded_samples(bytes));
+            for (size_t i = 0; i < 240; i++) {
+                const double diff = static_cast<double>(decoded[i]) - pcm[i];
+                error += diff * diff;
+                power += static_cast<double>(pcm[i]) * pcm[i];
+            }
+        }
+        if (codec == AudioCodec::PCM16) {
+            CHECK(error == 0.0);
+        } else {
+            CHECK(10.0 * std::log10(power / std::max(error, 1.0)) > 15.0);  // SNR in dB
+        }
+
+        // Truncated payloads are rejected, not read past
+        CHECK(decoder->decode(payload.data(), 1, decoded.data(), decoded.size()) == 0);
+    }
+}
+
+void test_echo_reference() {
+    EchoReference reference;
+    CHECK(reference.initialize(4, 3) == ErrorCode::SUCCESS);
+    const int16_t a[4] = {1, 2, 3, 4};
+    const int16_t b[4] = {5, 6, 7, 8};
+
+    // Nothing queued: silence
+    CHECK(reference.peek(0) == nullptr && !reference.is_active());
+
+    // A frame queued inside a mic window plays from the next one
+    reference.push(a, 4, 1500);
+    CHECK(reference.peek(1000) == nullptr);
+    const int16_t* frame = reference.peek(2000);
+    CHECK(frame && frame[0] == 1 && reference.is_active());
+    reference.pop();
+
+    // Within a run frames follow one per mic frame, whatever their stamps
+    reference.push(b, 4, 2900);
+    frame = reference.peek(2500);
+    CHECK(frame && frame[0] == 5);
+    reference.pop();
+
+    // Running dry ends the run; a full queue drops the newest frame
+    CHECK(reference.peek(3000) == nullptr && !reference.is_active());
+    for (int i = 0; i < 4; i++) {
+        reference.push(a, 4, 4000);
+    }
+    CHECK(reference.get_dropped_frames() == 1 && reference.get_runs() == 1);
+    reference.push(b, 3, 4000);  // Not a whole frame: ignored
+    reference.reset();
+    CHECK(reference.peek(5000) == nullptr);
+}
+
+void test_echo_canceller() {
+    constexpr size_t kFrame = 320;
+    EchoCanceller aec;
+    CHECK(aec.initialize(128, kFrame) == ErrorCode::SUCCESS);
+
+    // Speaker-to-mic path: a few reflections inside the filter tail
+    auto echo_of = [](const std::vector<int16_t>& x, size_t n) {
+        auto at = [&](size_t delay) { return n >= delay ? static_cast<float>(x[n - delay]) : 0.0f; };
+        return 0.4f * at(5) - 0.2f * at(6) + 0.1f * at(20) + 0.05f * at(90);
+    };
+
+    const size_t frames = 150;
+    const std::vector<int16_t> far = make_signal(frames * kFrame, 3);
+    std::vector<int16_t> mic(kFrame);
+    double echo_energy = 0.0, residual_energy = 0.0;
+    for (size_t f = 0; f < frames; f++) {
+        double frame_echo = 0.0;
+        for (size_t i = 0; i < kFrame; i++) {
+            const float echo = echo_of(far, f * kFrame + i);
+            mic[i] = static_cast<int16_t>(std::lrintf(echo));
+            frame_echo += static_cast<double>(echo) * echo;
+        }
+        aec.process(mic.data(), far.data() + f * kFrame, kFrame);
+        if (f >= frames - 25) {
+            echo_energy += frame_echo;
+            for (int16_t s : mic) {
+                residual_energy += static_cast<double>(s) * s;
+            }
+            CHECK(!aec.is_double_talk());
+        }
+    }
+    CHECK(10.0 * std::log10(echo_energy / std::max(residual_energy, 1.0)) > 30.0);
+    CHECK(aec.get_erle_db() > 15.0f);
+
+    // Talk over the playback is detected and comes through
+    double near_energy = 0.0, out_energy = 0.0;
+    for (size_t f = 0; f < 10; f++) {
+        for (size_t i = 0; i < kFrame; i++) {
+            const float near = 6000.0f * std::sin(2.0f * static_cast<float>(M_PI) * 300.0f * (f * kFrame + i) / 16000.0f);
+            mic[i] = static_cast<int16_t>(std::lrintf(echo_of(far, (f % 50) * kFrame + i) + near));
+            near_energy += static_cast<double>(near) * near;
+        }
+        aec.process(mic.data(), far.data() + (f % 50) * kFrame, kFrame);
+        CHECK(aec.is_double_talk());
+        for (int16_t s : mic) {
+            out_energy += static_cast<double>(s) * s;
+        }
+    }
+    CHECK(out_energy > 0.5 * near_energy && out_energy < 2.0 * near_energy);
+
+    // With the speaker silent the mic passes through once the tail has left
+    const std::vector<int16_t> quiet = make_signal(kFrame, 11);
+    mic = quiet;
+    aec.process(mic.data(), nullptr, kFrame);
+    mic = quiet;
+    aec.process(mic.data(), nullptr, kFrame);
+    CHECK(mic == quiet && !aec.is_double_talk());
+}
+
+void test_json() {
+    // Commas follow the nesting; strings are escaped
+    char buffer[160];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.begin_object().begin_object("config")
+        .field("sample_rate", 16000u)
+        .field("room", "kit\"chen")
+        .field("score", 0.9534f, 3)
+        .field("live", true)
+        .begin_array("load").field(nullptr, 12.34f, 1).field(nullptr, -3).end_array()
+        .end_object().end_object();
+    CHECK(json.ok());
+    CHECK(json.view() == R"({"config":{"sample_rate":16000,"room":"kit\"chen","score":0.953,"live":true,"load":[12.3,-3]}})");
+    CHECK(std::strlen(json.data()) == json.size());
+
+    // Truncation and unbalanced nesting are reported, and stay terminated
+    char small[16];
+    JsonWriter tight(small, sizeof(small));
+    tight.begin_object().field("room", "a long room name").end_object();
+    CHECK(!tight.ok() && std::strlen(small) < sizeof(small));
+    JsonWriter open(buffer, sizeof(buffer));
+    open.begin_object().field("eof", 1u);
+    CHECK(!open.ok());
+
+    // Members are looked up in place, at their own level only
+    const JsonValue root = json_parse(R"( {"partial":"say \"codec\":\"opus\"","tts":{"format":"ima_adpcm",)"
+                                      R"("sample_rate":16000,"extra":[1,{"a":"}"}]},"arbitration":"won","n":null} )");
+    CHECK(root.is_object());
+    CHECK(!root["codec"].is_valid() && !root["format"].is_valid());
+    CHECK(root["arbitration"].equals("won"));
+    const JsonValue tts = root["tts"];
+    CHECK(tts.is_object() && tts["format"].equals("ima_adpcm"));
+    uint32_t rate = 0;
+    CHECK(tts["sample_rate"].as_uint32(rate) && rate == 16000);
+    CHECK(tts["extra"].type() == JsonValue::Type::ARRAY);
+    CHECK(root["n"].type() == JsonValue::Type::NUL);
+
+    float score = 0.0f;
+    bool flag = false;
+    CHECK(json_parse(R"({"s":-0.5e1,"b":false})")["s"].as_float(score) && score == -5.0f);
+    CHECK(json_parse(R"({"s":-0.5e1,"b":false})")["b"].as_bool(flag) && !flag);
+    CHECK(!json_parse(R"({"s":-1})")["s"].as_uint32(rate));
+
+    // Malformed input never reads past the view
+    CHECK(!json_parse(R"({"tts":{"format":"opus")").is_valid());
+    CHECK(!json_parse(std::string_view("{\"a\":1}", 5)).is_valid());
+    CHECK(!json_parse("").is_valid());
+    CHECK(!json_parse(R"({"a" 1})")["a"].is_valid());
+}
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+std::vector<uint8_t> patch_header(uint32_t source_size, uint32_t target_size, uint8_t sha_byte) {
+    std::vector<uint8_t> patch = {'I', 'R', 'D', 'P', 1, 0, 0, 0};
+    put_u32(patch, source_size);
+    put_u32(patch, target_size);
+    patch.insert(patch.end(), 32, sha_byte);
+    return patch;
+}
+
+void test_delta_patch() {
+    // Target: source tail, a literal, source head
+    std::vector<uint8_t> source(3000);
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = static_cast<uint8_t>(i * 7 + i / 256);
+    }
+    const std::vector<uint8_t> literal = {'n', 'e', 'w', ' ', 'c', 'o', 'd', 'e'};
+    std::vector<uint8_t> expected(source.begin() + 1000, source.end());
+    expected.insert(expected.end(), literal.begin(), literal.end());
+    expected.insert(expected.end(), source.begin(), source.begin() + 700);
+
+    std::vector<uint8_t> patch = patch_header(source.size(), expected.size(), 0xAB);
+    CHECK(patch.size() == DeltaPatcher::HEADER_SIZE && DeltaPatcher::is_patch(patch[0]));
+    patch.push_back(DeltaPatcher::OP_COPY);
+    put_u32(patch, 1000);
+    put_u32(patch, 2000);
+    patch.push_back(DeltaPatcher::OP_INSERT);
+    put_u32(patch, literal.size());
+    patch.insert(patch.end(), literal.begin(), literal.end());
+    patch.push_back(DeltaPatcher::OP_COPY);
+    put_u32(patch, 0);
+    put_u32(patch, 700);
+    patch.push_back(DeltaPatcher::OP_END);
+
+    std::vector<uint8_t> target;
+    auto reader = [&](uint32_t offset, uint8_t* data, size_t length) {
+        std::memcpy(data, source.data() + offset, length);
+        return true;
+    };
+    auto writer = [&](const uint8_t* data, size_t length) {
+        target.insert(target.end(), data, data + length);
+        return true;
+    };
+    uint32_t checked_size = 0;
+    auto check = [&](const DeltaPatchState& state) {
+        checked_size = state.target_size;
+        return state.source_sha256[0] == 0xAB;
+    };
+
+    // Any split of the stream decodes the same; resume from the state
+    // between feeds, as a checkpoint would
+    for (size_t chunk : {1u, 3u, 5u, 49u, 4096u}) {
+        target.clear();
+        DeltaPatcher first(reader, writer, check);
+        DeltaPatcher::Result result = DeltaPatcher::Result::NEED_MORE;
+        size_t offset = 0;
+        const size_t half = patch.size() / 2;
+        for (; offset < half; offset += std::min(chunk, half - offset)) {
+            result = first.feed(patch.data() + offset, std::min(chunk, half - offset));
+            CHECK(result == DeltaPatcher::Result::NEED_MORE);
+        }
+        const DeltaPatchState saved = first.state();
+
+        DeltaPatcher resumed(reader, writer, check);
+        resumed.restore(saved);
+        CHECK(resumed.state().written == target.size());
+        for (; offset < patch.size(); offset += chunk) {
+            result = resumed.feed(patch.data() + offset, std::min(chunk, patch.size() - offset));
+        }
+        CHECK(result == DeltaPatcher::Result::DONE && resumed.is_done());
+        CHECK(target == expected);
+        CHECK(checked_size == expected.size());
+    }
+
+    // Rejected header, ops outside the source or target, early END
+    auto run = [&](const std::vector<uint8_t>& bytes) {
+        target.clear();
+        DeltaPatcher patcher(reader, writer, check);
+        return patcher.feed(bytes.data(), bytes.size());
+    };
+    CHECK(run(patch_header(source.size(), 10, 0x00)) == DeltaPatcher::Result::SOURCE_MISMATCH);
+    std::vector<uint8_t> bad = patch_header(source.size(), 10, 0xAB);
+    bad.push_back(DeltaPatcher::OP_COPY);
+    put_u32(bad, 2995);
+    put_u32(bad, 10);
+    CHECK(run(bad) == DeltaPatcher::Result::BAD_PATCH);
+    bad = patch_header(source.size(), 4, 0xAB);
+    bad.push_back(DeltaPatcher::OP_INSERT);
+    put_u32(bad, 8);
+    CHECK(run(bad) == DeltaPatcher::Result::BAD_PATCH);
+    bad = patch_header(source.size(), 4, 0xAB);
+    bad.push_back(DeltaPatcher::OP_END);
+    CHECK(run(bad) == DeltaPatcher::Result::BAD_PATCH);
+    bad = patch_header(source.size(), 4, 0xAB);
+    bad[4] = 2;
+    CHECK(run(bad) == DeltaPatcher::Result::BAD_PATCH);
+    bad = patch_header(source.size(), 4, 0xAB);
+    bad.push_back(0x7f);
+    CHECK(run(bad) == DeltaPatcher::Result::BAD_PATCH);
+}
+
+void test_rate_limiter() {
+    RateLimiter limiter;
+    limiter.configure(10000, 2000);
+    limiter.reset(0);
+
+    // The burst goes at once, then the rate holds
+    CHECK(limiter.consume(2000, 0) == 0);
+    CHECK(limiter.consume(1000, 0) == 100000);
+    CHECK(limiter.consume(1000, 100000) == 100000);
+
+    // A second of steady 1 kB reads at 10 kB/s waits 100 ms each
+    int64_t now = 200000;
+    int64_t waited = 0;
+    for (int i = 0; i < 10; i++) {
+        const int64_t wait = limiter.consume(1000, now);
+        waited += wait;
+        now += wait;
+    }
+    CHECK(waited == 1000000);
+
+    // Idle time refills only up to the burst
+    CHECK(limiter.consume(2000, now + 10000000) == 0);
+    CHECK(limiter.consume(1, now + 10000000) > 0);
+
+    RateLimiter unlimited;
+    CHECK(unlimited.consume(1 << 20, 0) == 0);
+}
+
+void test_capture_route() {
+    // Idle frames reach the detector's gate once it is enabled, spectral VAD or not
+    CHECK(route_capture_frame(SystemState::IDLE_LISTENING, true, false) == CaptureRoute::DETECT);
+    CHECK(route_capture_frame(SystemState::IDLE_LISTENING, true, true) == CaptureRoute::DETECT);
+
+    // A disabled detector drops frames in process_frame(): only the mel tap is fed
+    CHECK(route_capture_frame(SystemState::IDLE_LISTENING, false, true) == CaptureRoute::ANALYZE);
+    CHECK(route_capture_frame(SystemState::IDLE_LISTENING, false, false) == CaptureRoute::NONE);
+
+    // No detection outside IDLE_LISTENING
+    CHECK(route_capture_frame(SystemState::STREAMING, true, true) == CaptureRoute::ANALYZE);
+    CHECK(route_capture_frame(SystemState::STREAMING, true, false) == CaptureRoute::NONE);
+    CHECK(route_capture_frame(SystemState::ARBITRATING, true, true) == CaptureRoute::NONE);
+    CHECK(route_capture_frame(SystemState::COOLDOWN, true, true) == CaptureRoute::NONE);
+}
+
+// A streaming-model node: 30 ms frames, 3 MFCC frames per invoke, a small panel
+struct StreamingSpec : NodeSpec {
+    static constexpr uint32_t frame_ms = 30;
+    static constexpr uint32_t model_input_frames = 3;
+    static constexpr uint16_t display_width = 240;
+    static constexpr uint16_t display_height = 240;
+    static constexpr uint16_t draw_buffer_lines = 24;
+    static constexpr TaskSlot capture = {0, 12, 4096};
+};
+
+void test_node_profile() {
+    using Profile = NodeProfile<StreamingSpec>;
+    static_assert(Profile::frame_samples == 480, "30 ms at 16 kHz");
+    static_assert(Profile::frame_bytes == 960, "int16_t mono");
+    static_assert(Profile::model_input_elements == 3 * MFCCFrontend::N_MFCC, "3 frames of features");
+    static_assert(NodeProfile<NodeSpec>::model_input_elements == MFCCFrontend::FEATURE_SIZE,
+                  "The default model takes the whole feature window");
+
+    AudioConfig audio;
+    audio.history_ms = 500;
+    Profile::apply(audio);
+    CHECK(audio.frame_ms == 30 && audio.frame_size == 480);
+    CHECK(audio.capture_core == 0 && audio.capture_priority == 12 && audio.capture_stack_size == 4096);
+    CHECK(audio.history_ms == 500);
+
+    // Slots the spec does not redefine keep the defaults
+    WakeWordConfig wake_word;
+    Profile::apply(wake_word);
+    CHECK(wake_word.model_input_frames == 3);
+    CHECK(wake_word.inference_core == NodeSpec::inference.core);
+    CHECK(wake_word.inference_priority == NodeSpec::inference.priority);
+
+    UIConfig ui;
+    Profile::apply(ui);
+    CHECK(ui.display_width == 240 && ui.draw_buffer_lines == 24);
+}
+
+void test_files_roundtrip() {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "irene_frontend_tests";
+    std::filesystem::create_directories(dir);
+
+    const std::vector<int16_t> signal = make_signal(1234, 13);
+    const std::string wav_path = (dir / "clip.wav").string();
+    CHECK(write_wav(wav_path, signal.data(), signal.size(), 16000));
+
+    WavAudio audio;
+    std::string error;
+    CHECK(read_wav(wav_path, audio, error));
+    CHECK(audio.sample_rate == 16000 && audio.channels == 1);
+    CHECK(audio.samples == signal);
+
+    FeatureMatrix matrix;
+    matrix.frames = 3;
+    matrix.coefficients = 2;
+    matrix.values = {1.0f, -2.0f, 3.5f, 0.25f, -0.0f, 1e-7f};
+    const std::string npy_path = (dir / "features.npy").string();
+    CHECK(write_npy(npy_path, matrix));
+
+    FeatureMatrix loaded;
+    CHECK(read_npy(npy_path, loaded, error));
+    CHECK(loaded.frames == 3 && loaded.coefficients == 2);
+    CHECK(loaded.values == matrix.values);
+
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace
+
+int main() {
+    test_fft_matches_dft();
+    test_frame_timing();
+    test_chunking_invariance();
+    test_matches_reference();
+    test_int8_output();
+    test_quantizer();
+    test_ring_buffer();
+    test_frame_stats();
+    test_vad();
+    test_adaptive_vad();
+    test_memory_plan();
+    test_audio_history();
+    test_posterior_smoother();
+    test_jitter_buffer();
+    test_downlink_codecs();
+    test_echo_reference();
+    test_echo_canceller();
+    test_json();
+    test_delta_patch();
+    test_rate_limiter();
+    test_node_profile();
+    test_capture_route();
+    test_files_roundtrip();
+
+    if (g_failures) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("All frontend checks passed\n");
+    return 0;
+}
@@ -0,0 +1,400 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_idf_version.h"
+#include "esp_psram.h"
+#include "esp_websocket_client.h"
+#include "nvs_flash.h"
+
+#include "audio/mfcc_frontend.hpp"
+#include "audio/vad_processor.hpp"
+#include "network/wifi_manager.hpp"
+#include "utils/ring_buffer.hpp"
+#include "node_config.h"
+#include "ww_model.h"
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_resource_variable.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static const char* TAG = "bench_node";
+
+// Report format version; bump when columns change so diffs stay meaningful
+#define BENCH_REPORT_VERSION 1
+
+namespace {
+
+enum class Placement {
+    INTERNAL,
+    PSRAM
+};
+
+const char* placement_name(Placement placement) {
+    return placement == Placement::INTERNAL ? "internal" : "psram";
+}
+
+uint32_t placement_caps(Placement placement) {
+    return placement == Placement::INTERNAL ? (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+                                            : (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+// Kernel buffer in the placement under test
+struct BenchBuffer {
+    BenchBuffer(size_t bytes, Placement placement)
+        : data(heap_caps_aligned_alloc(16, bytes, placement_caps(placement)))
+        , size(bytes) {}
+    ~BenchBuffer() { heap_caps_free(data); }
+    BenchBuffer(const BenchBuffer&) = delete;
+    BenchBuffer& operator=(const BenchBuffer&) = delete;
+
+    template <typename T>
+    T* as() const { return static_cast<T*>(data); }
+
+    void* data;
+    size_t size;
+};
+
+// Kernels in report order, for rows skipped as a group
+const char* const KERNELS[] = {
+    "power_spectrum", "mel_filterbank", "mfcc_dct", "ring_buffer_write", "ring_buffer_read",
+    "vad_process_frame", "tflite_invoke", "ws_send_bin"
+};
+
+// One CSV row from per-iteration cycle counts; "first" is the cold-cache run
+void report(const char* kernel, Placement placement, std::vector<uint32_t>& cycles, const char* note = "") {
+    if (cycles.empty()) {
+        std::printf("%s,%s,0,,,,,,%s\n", kernel, placement_name(placement), note);
+        return;
+    }
+
+    const uint32_t first = cycles.front();
+    std::sort(cycles.begin(), cycles.end());
+    const uint32_t median = cycles[cycles.size() / 2];
+    std::printf("%s,%s,%u,%lu,%lu,%lu,%lu,%.2f,%s\n", kernel, placement_name(placement),
+                (unsigned)cycles.size(), (unsigned long)first, (unsigned long)cycles.front(),
+                (unsigned long)median, (unsigned long)cycles.back(),
+                median / static_cast<float>(CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), note);
+}
+
+void report_skipped(const char* kernel, Placement placement, const char* reason) {
+    std::vector<uint32_t> none;
+    char note[64];
+    std::snprintf(note, sizeof(note), "skipped: %s", reason);
+    report(kernel, placement, none, note);
+}
+
+template <typename Fn>
+void measure(const char* kernel, Placement placement, uint32_t iterations, Fn&& fn,
+             const char* note = "") {
+    std::vector<uint32_t> cycles;
+    cycles.reserve(iterations);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        const esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        if (!fn()) {
+            break;
+        }
+        cycles.push_back(esp_cpu_get_cycle_count() - start);
+    }
+
+    report(kernel, placement, cycles, note);
+}
+
+// Speech-like input: two tones plus noise at about -12 dBFS
+void fill_audio(int16_t* samples, size_t count) {
+    uint32_t noise = 0x2545F491u;
+    for (size_t i = 0; i < count; i++) {
+        noise = noise * 1664525u + 1013904223u;
+        const float tone = 6000.0f * sinf(2.0f * static_cast<float>(M_PI) * 310.0f * i / 16000.0f) +
+                           2000.0f * sinf(2.0f * static_cast<float>(M_PI) * 2300.0f * i / 16000.0f);
+        samples[i] = static_cast<int16_t>(tone + (static_cast<int32_t>(noise >> 16) - 32768) / 32);
+    }
+}
+
+void bench_frontend(Placement placement) {
+    using irene::MFCCFrontend;
+
+    // The frontend's own buffers follow the placement; FFT twiddles are always internal
+    MFCCFrontend frontend;
+    if (frontend.initialize(placement == Placement::PSRAM) != irene::ErrorCode::SUCCESS) {
+        for (const char* kernel : {"power_spectrum", "mel_filterbank", "mfcc_dct"}) {
+            report_skipped(kernel, placement, "frontend init failed");
+        }
+        return;
+    }
+
+    BenchBuffer windowed(MFCCFrontend::WINDOW_SAMPLES * sizeof(float), placement);
+    BenchBuffer power((MFCCFrontend::WINDOW_SAMPLES / 2 + 1) * sizeof(float), placement);
+    BenchBuffer mel(MFCCFrontend::N_MELS * sizeof(float), placement);
+    BenchBuffer mfcc(MFCCFrontend::N_MFCC * sizeof(float), placement);
+    if (!windowed.data || !power.data || !mel.data || !mfcc.data) {
+        for (const char* kernel : {"power_spectrum", "mel_filterbank", "mfcc_dct"}) {
+            report_skipped(kernel, placement, "buffer allocation failed");
+        }
+        return;
+    }
+
+    std::vector<int16_t> audio(MFCCFrontend::WINDOW_SAMPLES);
+    fill_audio(audio.data(), audio.size());
+    for (size_t i = 0; i < audio.size(); i++) {
+        const float hann = 0.5f * (1.0f - cosf(2.0f * static_cast<float>(M_PI) * i / (audio.size() - 1)));
+        windowed.as<float>()[i] = audio[i] / 32768.0f * hann;
+    }
+
+    measure("power_spectrum", placement, BENCH_ITERATIONS, [&]() {
+        frontend.compute_power_spectrum(windowed.as<float>(), power.as<float>());
+        return true;
+    });
+    measure("mel_filterbank", placement, BENCH_ITERATIONS, [&]() {
+        frontend.apply_mel_filterbank(power.as<float>(), mel.as<float>());
+        return true;
+    });
+    measure("mfcc_dct", placement, BENCH_ITERATIONS, [&]() {
+        frontend.compute_mfcc(mel.as<float>(), mfcc.as<float>());
+        return true;
+    });
+}
+
+void bench_ring_buffer(Placement placement) {
+    constexpr size_t FRAME_BYTES = BENCH_AUDIO_FRAME_SAMPLES * sizeof(int16_t);
+
+    // Capacity as the capture path sizes it: a handful of frames
+    irene::RingBuffer ring(FRAME_BYTES * 8, placement == Placement::PSRAM);
+    BenchBuffer frame(FRAME_BYTES, Placement::INTERNAL);
+    if (!frame.data) {
+        report_skipped("ring_buffer_write", placement, "buffer allocation failed");
+        report_skipped("ring_buffer_read", placement, "buffer allocation failed");
+        return;
+    }
+    fill_audio(frame.as<int16_t>(), BENCH_AUDIO_FRAME_SAMPLES);
+
+    // Alternate so every write and read moves one full frame
+    std::vector<uint32_t> write_cycles;
+    std::vector<uint32_t> read_cycles;
+    write_cycles.reserve(BENCH_ITERATIONS);
+    read_cycles.reserve(BENCH_ITERATIONS);
+    for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        ring.write(frame.as<uint8_t>(), FRAME_BYTES);
+        write_cycles.push_back(esp_cpu_get_cycle_count() - start);
+
+        start = esp_cpu_get_cycle_count();
+        ring.read(frame.as<uint8_t>(), FRAME_BYTES);
+        read_cycles.push_back(esp_cpu_get_cycle_count() - start);
+    }
+
+    report("ring_buffer_write", placement, write_cycles);
+    report("ring_buffer_read", placement, read_cycles);
+}
+
+void bench_vad(Placement placement) {
+    BenchBuffer frame(BENCH_AUDIO_FRAME_SAMPLES * sizeof(int16_t), placement);
+    if (!frame.data) {
+        report_skipped("vad_process_frame", placement, "buffer allocation failed");
+        return;
+    }
+    fill_audio(frame.as<int16_t>(), BENCH_AUDIO_FRAME_SAMPLES);
+
+    irene::VADProcessor vad;
+    vad.initialize(16000);
+    measure("vad_process_frame", placement, BENCH_ITERATIONS, [&]() {
+        vad.process_frame(frame.as<int16_t>(), BENCH_AUDIO_FRAME_SAMPLES);
+        return true;
+    });
+}
+
+void bench_invoke(Placement placement) {
+    // Same op set as KeywordModel::load()
+    static tflite::MicroMutableOpResolver<17> resolver;
+    static bool resolver_ready = false;
+    if (!resolver_ready) {
+        resolver.AddConv2D();
+        resolver.AddMaxPool2D();
+        resolver.AddReshape();
+        resolver.AddMean();
+        resolver.AddFullyConnected();
+        resolver.AddDepthwiseConv2D();
+        resolver.AddAdd();
+        resolver.AddMul();
+        resolver.AddQuantize();
+        resolver.AddDequantize();
+        resolver.AddCallOnce();
+        resolver.AddVarHandle();
+        resolver.AddReadVariable();
+        resolver.AddAssignVariable();
+        resolver.AddConcatenation();
+        resolver.AddStridedSlice();
+        resolver.AddLogistic();
+        resolver_ready = true;
+    }
+
+    const tflite::Model* model = tflite::GetModel(wake_word_model_data);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+        report_skipped("tflite_invoke", placement, "model schema mismatch");
+        return;
+    }
+
+    BenchBuffer arena(BENCH_TENSOR_ARENA_SIZE, placement);
+    BenchBuffer variable_arena(1024, Placement::INTERNAL);
+    if (!arena.data || !variable_arena.data) {
+        report_skipped("tflite_invoke", placement, "arena allocation failed");
+        return;
+    }
+
+    // Streaming models keep state in resource variables
+    tflite::MicroAllocator* variable_allocator =
+        tflite::MicroAllocator::Create(variable_arena.as<uint8_t>(), variable_arena.size);
+    tflite::MicroResourceVariables* variables = tflite::MicroResourceVariables::Create(variable_allocator, 16);
+
+    std::unique_ptr<tflite::MicroInterpreter> interpreter(new tflite::MicroInterpreter(
+        model, resolver, arena.as<uint8_t>(), arena.size, variables));
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+        report_skipped("tflite_invoke", placement, "AllocateTensors failed");
+        return;
+    }
+
+    TfLiteTensor* input = interpreter->input(0);
+    if (input->type == kTfLiteInt8) {
+        std::memset(input->data.int8, input->params.zero_point, input->bytes);
+    } else {
+        std::memset(input->data.raw, 0, input->bytes);
+    }
+
+    char note[32];
+    std::snprintf(note, sizeof(note), "arena_used=%u", (unsigned)interpreter->arena_used_bytes());
+    measure("tflite_invoke", placement, BENCH_INVOKE_ITERATIONS, [&]() {
+        return interpreter->Invoke() == kTfLiteOk;
+    }, note);
+}
+
+void bench_websocket(esp_websocket_client_handle_t client, Placement placement) {
+    BenchBuffer payload(BENCH_WS_PAYLOAD_BYTES, placement);
+    if (!payload.data) {
+        report_skipped("ws_send_bin", placement, "buffer allocation failed");
+        return;
+    }
+    fill_audio(payload.as<int16_t>(), BENCH_WS_PAYLOAD_BYTES / sizeof(int16_t));
+
+    // Includes TLS record encryption (wss) and lwIP copy; blocks on TCP window
+    measure("ws_send_bin", placement, BENCH_WS_ITERATIONS, [&]() {
+        return esp_websocket_client_send_bin(client, payload.as<const char>(),
+                                             BENCH_WS_PAYLOAD_BYTES, portMAX_DELAY) >= 0;
+    });
+}
+
+esp_websocket_client_handle_t connect_websocket() {
+    static const char uri[] = BENCH_WS_URI;
+    if (uri[0] == '\0') {
+        return nullptr;
+    }
+
+    static irene::WiFiManager wifi;
+    if (wifi.initialize(WIFI_SSID, WIFI_PASSWORD) != irene::ErrorCode::SUCCESS ||
+        wifi.connect() != irene::ErrorCode::SUCCESS) {
+        return nullptr;
+    }
+    for (uint32_t waited = 0; !wifi.is_connected() && waited < BENCH_WIFI_TIMEOUT_MS; waited += 100) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    if (!wifi.is_connected()) {
+        ESP_LOGW(TAG, "Wi-Fi not connected after %u ms", (unsigned)BENCH_WIFI_TIMEOUT_MS);
+        return nullptr;
+    }
+    // Performance profile, as while streaming
+    wifi.set_power_profile(irene::WiFiPowerProfile::PERFORMANCE);
+
+    esp_websocket_client_config_t config = {};
+    config.uri = uri;
+    esp_websocket_client_handle_t client = esp_websocket_client_init(&config);
+    if (!client || esp_websocket_client_start(client) != ESP_OK) {
+        return nullptr;
+    }
+    for (uint32_t waited = 0; !esp_websocket_client_is_connected(client) && waited < BENCH_WIFI_TIMEOUT_MS;
+         waited += 100) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    if (!esp_websocket_client_is_connected(client)) {
+        ESP_LOGW(TAG, "WebSocket %s not connected", uri);
+        esp_websocket_client_destroy(client);
+        return nullptr;
+    }
+    return client;
+}
+
+void bench_task(void* arg) {
+    const Placement placements[] = {Placement::INTERNAL, Placement::PSRAM};
+
+    // Network first, so its log noise ends before the report starts
+    esp_websocket_client_handle_t client = connect_websocket();
+    const bool have_psram = esp_psram_get_size() > 0;
+
+    // Component INFO logs would interleave with the report rows
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    // One machine-readable block; diff it between firmware versions
+    std::printf("IRENE_BENCH_BEGIN version=%d node=%s fw=%s idf=%s cpu_mhz=%d psram_bytes=%u\n",
+                BENCH_REPORT_VERSION, NODE_ID, NODE_FIRMWARE_VERSION, esp_get_idf_version(),
+                CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, (unsigned)esp_psram_get_size());
+    std::printf("kernel,placement,iterations,first_cycles,min_cycles,median_cycles,max_cycles,median_us,note\n");
+
+    for (Placement placement : placements) {
+        if (placement == Placement::PSRAM && !have_psram) {
+            for (const char* kernel : KERNELS) {
+                report_skipped(kernel, placement, "no PSRAM");
+            }
+            continue;
+        }
+
+        bench_frontend(placement);
+        bench_ring_buffer(placement);
+        bench_vad(placement);
+        bench_invoke(placement);
+        if (client) {
+            bench_websocket(client, placement);
+        } else {
+            report_skipped("ws_send_bin", placement, "no connection (set BENCH_WS_URI)");
+        }
+    }
+
+    std::printf("IRENE_BENCH_END\n");
+    esp_log_level_set("*", ESP_LOG_INFO);
+
+    if (client) {
+        esp_websocket_client_close(client, pdMS_TO_TICKS(1000));
+        esp_websocket_client_destroy(client);
+    }
+
+    ESP_LOGI(TAG, "Benchmark complete");
+    vTaskDelete(nullptr);
+}
+
+} // namespace
+
+extern "C" void app_main() {
+    ESP_LOGI(TAG, "Starting Irene Voice Assistant - Bench Node");
+    ESP_LOGI(TAG, "Firmware Version: %s", NODE_FIRMWARE_VERSION);
+
+    // Initialize NVS (Wi-Fi calibration and the connect cache)
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_ERROR_CHECK(nvs_flash_erase());
+        ret = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK(ret);
+
+    // Pinned away from the Wi-Fi stack at a priority above the system tasks
+    xTaskCreatePinnedToCore(bench_task, "bench", STACK_SIZE_BENCH_TASK, nullptr,
+                            PRIORITY_BENCH_TASK, nullptr, CORE_BENCH_TASK);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Bench Node Configuration
+#define NODE_ID "bench"
+#define NODE_FIRMWARE_VERSION "1.0.0"
+#define NODE_HARDWARE_VERSION "ESP32-S3-R8"
+
+// Network Configuration (websocket kernel only; leave BENCH_WS_URI empty to skip it)
+#define WIFI_SSID "YourHomeNetwork"
+#define WIFI_PASSWORD "YourWiFiPassword"
+#define BENCH_WS_URI ""                // e.g. "ws://192.168.1.10:8765" (any sink that accepts binary frames)
+#define BENCH_WIFI_TIMEOUT_MS 15000
+
+// Iterations per kernel and placement
+#define BENCH_ITERATIONS 1000
+#define BENCH_INVOKE_ITERATIONS 100
+#define BENCH_WS_ITERATIONS 200
+
+// Payload sizes, matching the kitchen node
+#define BENCH_AUDIO_FRAME_SAMPLES 320  // 20 ms capture frame
+#define BENCH_WS_PAYLOAD_BYTES 1920    // 60 ms uplink batch of PCM16
+#define BENCH_TENSOR_ARENA_SIZE (160 * 1024)
+
+// Task Configuration
+#define CORE_BENCH_TASK 1              // Away from the Wi-Fi stack on core 0
+#define PRIORITY_BENCH_TASK 10
+#define STACK_SIZE_BENCH_TASK 8192
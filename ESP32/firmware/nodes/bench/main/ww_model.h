@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Kitchen node model, embedded for the TFLite Invoke kernel
+extern const uint8_t wake_word_model_data[] asm("_binary_jarvis_medium_tflite_start");
+extern const uint8_t wake_word_model_data_end[] asm("_binary_jarvis_medium_tflite_end");
+
+#define WW_MODEL_WAKE_WORD "jarvis"
+#define WW_MODEL_TYPE "medium-12-bn"
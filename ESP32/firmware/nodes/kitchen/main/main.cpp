@@ -4,9 +4,13 @@
 #include "esp_system.h"
 #include "esp_psram.h"
 #include "nvs_flash.h"
+#include "driver/gpio.h"
+#include "driver/spi_common.h"
 
 #include "core/state_machine.hpp"
+#include "core/power_manager.hpp"
 #include "node_config.h"
+#include "node_profile.hpp"
 #include "certificates.h"
 #include "ww_model.h"
 
@@ -33,13 +37,15 @@ extern "C" void app_main() {
 
     ESP_LOGI(TAG, "PSRAM initialized: %d KB available", esp_psram_get_size() / 1024);
 
-    // Create configuration structures
+    // Idle listening at a scaled-down clock; full speed under PowerLocks only
+    irene::PowerConfig power_config;
+    if (irene::PowerManager::initialize(power_config) != irene::ErrorCode::SUCCESS) {
+        ESP_LOGW(TAG, "Power management unavailable, running at full clock");
+    }
+
+    // Create configuration structures; format, geometry and task map come from the profile
     irene::AudioConfig audio_config;
-    audio_config.sample_rate = 16000;
-    audio_config.channels = 1;
-    audio_config.bits_per_sample = 16;
-    audio_config.frame_size = 320;  // 20ms
-    audio_config.buffer_count = 8;
+    KitchenProfile::apply(audio_config);
 
     irene::NetworkConfig network_config;
     network_config.ssid = WIFI_SSID;
@@ -48,19 +54,33 @@ extern "C" void app_main() {
     network_config.node_id = NODE_ID;
     network_config.reconnect_delay_ms = 5000;
     network_config.max_retry_count = 10;
+    network_config.uplink_queue_depth = 12;  // 240ms of audio
+    network_config.uplink_overflow_policy = irene::UplinkOverflowPolicy::DROP_OLDEST;
+    network_config.uplink_batch_ms = 60;      // 3 frames per WebSocket message
+    network_config.uplink_codec = irene::AudioCodec::PCM16;  // Until the server decodes ADPCM/Opus
+    KitchenProfile::apply(network_config);
 
     irene::WakeWordConfig ww_config;
     ww_config.threshold = WAKE_WORD_THRESHOLD;
-    ww_config.trigger_duration_ms = 450;
+    ww_config.smoothing_ms = 150;
+    ww_config.refractory_ms = 1000;
     ww_config.back_buffer_ms = 300;
     ww_config.use_psram = true;
+    KitchenProfile::apply(ww_config);
+    ww_config.sanity_checks = WAKE_WORD_SANITY_CHECKS;
 
     irene::UIConfig ui_config;
-    ui_config.display_width = 412;
-    ui_config.display_height = 412;
+    KitchenProfile::apply(ui_config);
     ui_config.brightness = 80;
     ui_config.idle_timeout_ms = 30000;
     ui_config.show_debug_info = false;
+    ui_config.display_spi_host = DISPLAY_SPI_HOST;
+    ui_config.display_mosi_io = DISPLAY_MOSI_IO;
+    ui_config.display_sclk_io = DISPLAY_SCLK_IO;
+    ui_config.display_cs_io = DISPLAY_CS_IO;
+    ui_config.display_dc_io = DISPLAY_DC_IO;
+    ui_config.display_rst_io = DISPLAY_RST_IO;
+    ui_config.display_backlight_io = DISPLAY_BL_IO;
 
     irene::TLSConfig tls_config;
     tls_config.ca_cert_pem = ca_pem_start;
@@ -76,7 +96,9 @@ extern "C" void app_main() {
         network_config, 
         ww_config, 
         ui_config, 
-        tls_config
+        tls_config,
+        wake_word_model_data,
+        get_wake_word_model_size()
     );
 
     if (result != irene::ErrorCode::SUCCESS) {
@@ -93,11 +115,11 @@ extern "C" void app_main() {
         ESP_LOGI(TAG, "System event: %d", (int)event);
     });
 
+    // Listening already; network and UI finish in the background
     ESP_LOGI(TAG, "Initialization complete. Starting main loop...");
 
-    // Main state machine loop
+    // Main state machine loop: sleeps until an event or timeout arrives
     while (true) {
         state_machine.run();
-        vTaskDelay(pdMS_TO_TICKS(10)); // 10ms loop
     }
 } 
\ No newline at end of file
@@ -14,14 +14,9 @@
 #define WAKE_WORD "jarvis"
 #define WAKE_WORD_THRESHOLD 0.9f
 #define WAKE_WORD_MODEL_SIZE 140000  // ~140KB medium model
+#define WAKE_WORD_SANITY_CHECKS 0    // 1 = model checklist every boot, not just a new image's first
 
-// Audio Configuration
-#define AUDIO_SAMPLE_RATE 16000
-#define AUDIO_CHANNELS 1
-#define AUDIO_BITS_PER_SAMPLE 16
-#define AUDIO_FRAME_SIZE_MS 20
-#define AUDIO_FRAME_SIZE_SAMPLES (AUDIO_SAMPLE_RATE * AUDIO_FRAME_SIZE_MS / 1000)
-#define AUDIO_FRAME_SIZE_BYTES (AUDIO_FRAME_SIZE_SAMPLES * AUDIO_CHANNELS * AUDIO_BITS_PER_SAMPLE / 8)
+// Capture format, model input shape, display size and the task map: node_profile.hpp
 
 // Hardware Configuration
 #define I2S_NUM I2S_NUM_0
@@ -36,8 +31,6 @@
 #define ES8311_I2C_ADDR 0x18
 
 // Display Configuration
-#define DISPLAY_WIDTH 412
-#define DISPLAY_HEIGHT 412
 #define DISPLAY_SPI_HOST SPI2_HOST
 #define DISPLAY_MOSI_IO GPIO_NUM_11
 #define DISPLAY_SCLK_IO GPIO_NUM_12
@@ -64,25 +57,6 @@
 // LED Configuration
 #define STATUS_LED_IO GPIO_NUM_21
 
-// Performance Configuration
-#define CORE_AUDIO_TASK 0
-#define CORE_NETWORK_TASK 1
-#define CORE_UI_TASK 1
-#define CORE_WAKE_WORD_TASK 0
-
-#define PRIORITY_AUDIO_TASK 10
-#define PRIORITY_WAKE_WORD_TASK 9
-#define PRIORITY_NETWORK_TASK 8
-#define PRIORITY_UI_TASK 5
-#define PRIORITY_MONITOR_TASK 3
-
-// Memory Configuration
-#define STACK_SIZE_AUDIO_TASK 4096
-#define STACK_SIZE_WAKE_WORD_TASK 8192
-#define STACK_SIZE_NETWORK_TASK 8192
-#define STACK_SIZE_UI_TASK 6144
-#define STACK_SIZE_MONITOR_TASK 2048
-
 // Timing Configuration
 #define WAKE_WORD_DETECTION_INTERVAL_MS 30
 #define AUDIO_BUFFER_DURATION_MS 20
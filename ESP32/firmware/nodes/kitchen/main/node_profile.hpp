@@ -0,0 +1,27 @@
+#pragma once
+
+#include "core/node_profile.hpp"
+#include "ww_model.h"
+
+// Kitchen node pipeline, checked at compile time by irene::NodeProfile
+struct KitchenSpec : irene::NodeSpec {
+    // Capture: 20 ms frames
+    static constexpr uint32_t sample_rate = WW_MODEL_SAMPLE_RATE;
+    static constexpr uint32_t frame_ms = 20;
+    static constexpr uint32_t dma_buffers = 8;
+
+    // Input tensor of the converted model
+    static constexpr uint32_t model_input_frames = WW_MODEL_INPUT_FRAMES;
+    static constexpr uint32_t model_input_features = WW_MODEL_INPUT_FEATURES;
+
+    // 1.46" round panel
+    static constexpr uint16_t display_width = 412;
+    static constexpr uint16_t display_height = 412;
+
+    // Capture + MFCC on core 0, inference and the uplink on core 1
+    static constexpr irene::TaskSlot capture = {0, 10, 6144};
+    static constexpr irene::TaskSlot inference = {1, 9, 8192};
+    static constexpr irene::TaskSlot uplink = {1, 8, 8192};
+};
+
+using KitchenProfile = irene::NodeProfile<KitchenSpec>;
@@ -20,6 +20,8 @@ extern const uint8_t wake_word_model_data_end[] asm("_binary_jarvis_medium_tflit
 #define WW_MODEL_WINDOW_SIZE_MS 1000
 #define WW_MODEL_STRIDE_MS 30
 #define WW_MODEL_INPUT_SIZE 16000  // 1 second at 16kHz
+#define WW_MODEL_INPUT_FRAMES 49   // Input tensor 1x49x40: MFCC frames per invoke
+#define WW_MODEL_INPUT_FEATURES 40
 #define WW_MODEL_OUTPUT_SIZE 1     // Binary classification
 
 // Performance characteristics
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+
+"""
+Delta OTA image builder for Irene Voice Assistant ESP32 Firmware
+Writes a patch that rebuilds NEW from OLD, the image the node is running.
+The node applies it on the fly (common/include/ota/delta_patch.hpp); serve
+the .delta file instead of the .bin to nodes known to run OLD.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = b"IRDP"
+VERSION = 1
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+BLOCK = 32        # Shortest COPY worth its 9 byte op
+INDEX_STEP = 4    # Source offsets indexed; matches longer than BLOCK + STEP are always found
+
+
+def image_digest(image: bytes) -> bytes:
+    """SHA-256 as esp_partition_get_sha256() reports it for an app partition."""
+    if len(image) > 32 and hashlib.sha256(image[:-32]).digest() == image[-32:]:
+        return image[-32:]
+    return hashlib.sha256(image).digest()
+
+
+def build_ops(old: bytes, new: bytes):
+    """Greedy matcher: COPY every run of BLOCK or more bytes found in OLD."""
+    index = {}
+    for offset in range(0, len(old) - BLOCK + 1, INDEX_STEP):
+        index.setdefault(old[offset:offset + BLOCK], offset)
+
+    ops = []
+    literal_start = 0
+    i = 0
+    while i + BLOCK <= len(new):
+        source = index.get(new[i:i + BLOCK])
+        if source is None:
+            i += 1
+            continue
+
+        # Extend forwards, then backwards into the pending literal
+        length = BLOCK
+        while i + length < len(new) and source + length < len(old) and new[i + length] == old[source + length]:
+            length += 1
+        while i > literal_start and source > 0 and new[i - 1] == old[source - 1]:
+            i -= 1
+            source -= 1
+            length += 1
+
+        if i > literal_start:
+            ops.append((OP_INSERT, new[literal_start:i]))
+        ops.append((OP_COPY, source, length))
+        i += length
+        literal_start = i
+
+    if literal_start < len(new):
+        ops.append((OP_INSERT, new[literal_start:]))
+    return ops
+
+
+def encode(old: bytes, new: bytes, ops) -> bytes:
+    out = bytearray(MAGIC)
+    out += struct.pack("<B3xII", VERSION, len(old), len(new))
+    out += image_digest(old)
+    for op in ops:
+        if op[0] == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack("<BI", OP_INSERT, len(op[1]))
+            out += op[1]
+    out += bytes([OP_END])
+    return bytes(out)
+
+
+def apply(old: bytes, patch: bytes) -> bytes:
+    """Reference decoder, used to check every patch written."""
+    assert patch[:4] == MAGIC and patch[4] == VERSION
+    _, source_size, target_size = struct.unpack_from("<B3xII", patch, 4)
+    assert source_size == len(old) and patch[16:48] == image_digest(old)
+    out = bytearray()
+    pos = 48
+    while True:
+        op = patch[pos]
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            offset, length = struct.unpack_from("<II", patch, pos + 1)
+            out += old[offset:offset + length]
+            pos += 9
+        elif op == OP_INSERT:
+            (length,) = struct.unpack_from("<I", patch, pos + 1)
+            out += patch[pos + 5:pos + 5 + length]
+            pos += 5 + length
+        else:
+            raise ValueError(f"unknown op {op:#x}")
+    assert len(out) == target_size
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a delta OTA image")
+    parser.add_argument("old", type=Path, help="image the nodes are running (.bin)")
+    parser.add_argument("new", type=Path, help="image to update them to (.bin)")
+    parser.add_argument("-o", "--output", type=Path, help="patch file (default: NEW.delta)")
+    args = parser.parse_args()
+
+    old = args.old.read_bytes()
+    new = args.new.read_bytes()
+    if not new or new[0] != 0xE9:
+        sys.exit(f"{args.new} is not an ESP app image")
+
+    patch = encode(old, new, build_ops(old, new))
+    if apply(old, patch) != new:
+        sys.exit("internal error: patch does not rebuild the new image")
+
+    output = args.output or args.new.with_suffix(".delta")
+    output.write_bytes(patch)
+    print(f"{output}: {len(patch)} bytes, {100.0 * len(patch) / len(new):.1f}% of {len(new)}")
+    if len(patch) >= len(new):
+        print("Patch is no smaller than the image; serve the full image instead")
+
+
+if __name__ == "__main__":
+    main()
@@ -280,6 +280,8 @@ extern const uint8_t wake_word_model_data_end[] asm("_binary_{self.config['wake_
 #define WW_MODEL_WINDOW_SIZE_MS 1000
 #define WW_MODEL_STRIDE_MS 30
 #define WW_MODEL_INPUT_SIZE 16000  // 1 second at 16kHz
+#define WW_MODEL_INPUT_FRAMES 49   // Input tensor 1x49x40: MFCC frames per invoke
+#define WW_MODEL_INPUT_FEATURES 40
 #define WW_MODEL_OUTPUT_SIZE 1     // Binary classification
 
 // Performance characteristics
@@ -396,7 +398,8 @@ extern "C" void app_main() {{
 
     irene::WakeWordConfig ww_config;
     ww_config.threshold = WAKE_WORD_THRESHOLD;
-    ww_config.trigger_duration_ms = 450;
+    ww_config.smoothing_ms = 150;
+    ww_config.refractory_ms = 1000;
     ww_config.back_buffer_ms = 300;
     ww_config.use_psram = true;
 